@@ -0,0 +1,95 @@
+#ifndef ASSET_BUNDLE_H
+#define ASSET_BUNDLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Asset bundle file format
+//
+//   Header   (ASSET_BUNDLE_HEADER_SIZE bytes) magic, version, entry count
+//   Entries  table of contents, sorted by name for binary search
+//   Data     one blob per entry, each starting on an ASSET_BUNDLE_ALIGN boundary
+//
+// The bundle is a build product for the machine that packs it: the header and
+// entries are stored in native layout and every blob is already in the form
+// the client hands to raylib (interleaved PCM samples, raw pixels), so a mapped
+// bundle is used in place with no parsing, decoding or copying.
+#define ASSET_BUNDLE_MAGIC 0x31424150u     // "PAB1"
+#define ASSET_BUNDLE_VERSION 1
+#define ASSET_BUNDLE_HEADER_SIZE 64
+#define ASSET_BUNDLE_ALIGN 64
+
+// Longest asset name, including the terminating NUL
+#define ASSET_NAME_SIZE 32
+
+// raylib's PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 (tools do not include raylib)
+#define ASSET_PIXEL_FORMAT_RGBA8 7
+
+// Baked block atlas: one tile per block color, left to right in BlockType bit order
+#define ASSET_BLOCK_ATLAS "blocks"
+#define ASSET_BLOCK_TILE_SIZE 44
+
+typedef enum {
+    ASSET_KIND_WAVE = 1,        // Sound effect: PCM played from memory
+    ASSET_KIND_MUSIC = 2,       // Long PCM track, streamed while it plays
+    ASSET_KIND_IMAGE = 3        // Raw pixels for a texture
+} AssetKind;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t fileSize;
+    uint8_t padding[ASSET_BUNDLE_HEADER_SIZE - 24];
+} AssetBundleHeader;
+
+typedef struct {
+    char name[ASSET_NAME_SIZE];         // NUL-padded
+    uint64_t offset;                    // From the start of the bundle
+    uint64_t size;                      // Bytes of data
+    uint32_t kind;                      // AssetKind
+    union {
+        struct {
+            uint32_t width;
+            uint32_t height;
+            uint32_t pixelFormat;       // raylib PixelFormat value
+        } image;
+        struct {
+            uint32_t sampleRate;
+            uint32_t sampleSize;        // Bits per sample: 8, 16 or 32 (float)
+            uint32_t channels;
+        } audio;
+    };
+} AssetEntry;
+
+_Static_assert(sizeof(AssetBundleHeader) == ASSET_BUNDLE_HEADER_SIZE, "bundle header layout");
+_Static_assert(sizeof(AssetEntry) == 64, "bundle entry layout");
+
+// Read-only, memory-mapped bundle
+typedef struct {
+    int fd;
+    const uint8_t* base;
+    size_t size;
+    const AssetEntry* entries;
+    uint32_t entryCount;
+} AssetBundle;
+
+// Map a bundle and check its header and table of contents
+bool AssetBundle_Open(AssetBundle* bundle, const char* path);
+void AssetBundle_Close(AssetBundle* bundle);
+
+// Entry by name, or NULL
+const AssetEntry* AssetBundle_Find(const AssetBundle* bundle, const char* name);
+
+// An entry's data, valid while the bundle is open
+static inline const void* AssetBundle_Data(const AssetBundle* bundle, const AssetEntry* entry)
+{
+    return bundle->base + entry->offset;
+}
+
+// Start reading an entry's pages in the background (e.g. before it is needed)
+void AssetBundle_Prefetch(const AssetBundle* bundle, const AssetEntry* entry, size_t offset, size_t length);
+
+#endif // ASSET_BUNDLE_H
@@ -0,0 +1,68 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "asset_bundle.h"
+#include "raylib.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Frames handed to a music stream per update
+#define MUSIC_CHUNK_FRAMES 4096
+
+// How far ahead of the playhead the loader keeps music paged in (seconds)
+#define MUSIC_LOOKAHEAD_SECONDS 2
+
+// Client view of the packed asset bundle
+//
+// The bundle is mapped, not read: waves and images are raylib structs whose
+// data points straight into the mapping, so loading one costs no decoding
+// and no copy. Only textures the first frame draws are uploaded at load.
+typedef struct {
+    AssetBundle bundle;
+    bool loaded;
+    Texture2D blockAtlas;       // id 0 if the bundle has none
+} Assets;
+
+// Map the bundle and upload the block atlas; false if it cannot be opened
+bool Assets_Load(Assets* assets, const char* path);
+void Assets_Unload(Assets* assets);
+
+// Wave whose samples live in the mapping; valid until Assets_Unload
+// Pass it to LoadSoundFromWave, but never to UnloadWave
+bool Assets_GetWave(const Assets* assets, const char* name, Wave* wave);
+
+// Image whose pixels live in the mapping (same rules as Assets_GetWave)
+bool Assets_GetImage(const Assets* assets, const char* name, Image* image);
+
+// First music track in the bundle, or NULL
+const AssetEntry* Assets_FindMusic(const Assets* assets);
+
+// Looping music track streamed from the mapping
+//
+// The main thread feeds chunks straight from the mapping to an AudioStream.
+// A loader thread keeps the next MUSIC_LOOKAHEAD_SECONDS paged in ahead of
+// it, so the frame never stalls on a page fault, however large the track.
+typedef struct {
+    const AssetBundle* bundle;
+    const AssetEntry* entry;
+    AudioStream stream;
+    size_t frameBytes;
+    size_t cursor;                      // Next byte fed to the stream (main thread)
+    uint8_t* wrapChunk;                 // Joins the end of the track to its start
+
+    atomic_size_t playhead;             // cursor, published to the loader
+    atomic_bool running;
+    pthread_t loader;
+    bool active;
+} MusicStreamer;
+
+// Start looping a music entry; the audio device must be initialized
+bool MusicStreamer_Start(MusicStreamer* music, const Assets* assets, const AssetEntry* entry);
+
+// Refill the stream's processed buffers (call once per frame)
+void MusicStreamer_Update(MusicStreamer* music);
+
+void MusicStreamer_Stop(MusicStreamer* music);
+
+#endif // ASSETS_H
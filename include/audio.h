@@ -0,0 +1,60 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include "assets.h"
+#include "audio_mixer.h"
+#include "raylib.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Sound effects, registered with the mixer in this order
+// X(id, asset name, voice limit)
+#define AUDIO_SOUNDS(X) \
+    X(SWAP,  "swap",  2) \
+    X(LAND,  "land",  4) \
+    X(CLEAR, "clear", 4) \
+    X(CHAIN, "chain", 4)
+
+typedef enum {
+#define AUDIO_SOUND_ID(name, asset, voices) AUDIO_SOUND_##name,
+    AUDIO_SOUNDS(AUDIO_SOUND_ID)
+#undef AUDIO_SOUND_ID
+    AUDIO_SOUND_COUNT
+} AudioSoundId;
+
+// Sound effects played off the game loop
+//
+// The game loop only pushes AudioEvents into the mixer's lock-free ring.
+// A mixer thread drains it and fills a raylib AudioStream one block at a
+// time, so no sound costs the frame more than a 16-byte push. On a headless
+// machine raylib's null backend consumes the stream in real time like a
+// sound card; if no device opens at all, the thread paces itself on the
+// clock and discards the output, so the event path and costs are the same.
+typedef struct {
+    AudioMixer mixer;
+    AudioStream stream;
+    bool streaming;             // Feeding a device (false: clock-paced)
+    int chain;                  // Cascade depth, raises the chain sound's pitch
+
+    pthread_t thread;
+    atomic_bool running;
+    bool active;
+} Audio;
+
+// Register the bundle's sound effects and start the mixer thread
+// Call after InitAudioDevice (a device that failed to open is fine)
+bool Audio_Start(Audio* audio, const Assets* assets);
+
+// Queue sounds for the GAME_EVENT_* bits returned by GameState_Update
+void Audio_PlayGameEvents(Audio* audio, int events, double time);
+
+// Queue one sound at a clock time (seconds, CLOCK_MONOTONIC)
+void Audio_Play(Audio* audio, AudioSoundId sound, double time, float volume, float pan, float rate);
+
+// Log the mixer's per-callback cost and voice counters
+void Audio_LogStats(const Audio* audio);
+
+void Audio_Stop(Audio* audio);
+
+#endif // AUDIO_H
@@ -0,0 +1,162 @@
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Output format: interleaved stereo float, what a 32-bit raylib AudioStream plays
+#define AUDIO_MIX_RATE 44100
+#define AUDIO_MIX_CHANNELS 2
+
+// Frames mixed per callback (11.6 ms at 44.1 kHz)
+#define AUDIO_MIX_BLOCK_FRAMES 512
+
+// Events are scheduled this far behind their timestamps, so an event pushed
+// during one block still lands at its exact offset in a later one
+#define AUDIO_MIX_LATENCY_FRAMES (2 * AUDIO_MIX_BLOCK_FRAMES)
+
+#define AUDIO_MAX_SAMPLES 16
+#define AUDIO_MAX_VOICES 32
+
+// Events in flight between the game loop and the mixer (power of two)
+#define AUDIO_EVENT_CAPACITY 256
+
+// Playback rate of 1.0 in AudioEvent.rate
+#define AUDIO_RATE_ONE 256
+
+// One sound to start, pushed by the game loop
+typedef struct {
+    uint64_t time;              // When it should be heard (CLOCK_MONOTONIC ns)
+    uint8_t sample;             // Registered sample id
+    uint8_t volume;             // 255 = full
+    int8_t pan;                 // -127 left .. 127 right
+    uint8_t reserved;
+    uint32_t rate;              // Playback rate, AUDIO_RATE_ONE = original pitch
+} AudioEvent;
+
+_Static_assert(sizeof(AudioEvent) == 16, "audio event layout");
+
+// Lock-free single-producer/single-consumer ring of audio events
+// The producer and consumer each keep a cached copy of the other's index,
+// so neither touches the other's cache line until the ring looks full/empty.
+typedef struct {
+    _Alignas(64) _Atomic uint32_t head;     // Next slot to write (producer)
+    uint32_t cachedTail;
+    uint32_t dropped;                       // Pushes refused while full
+    _Alignas(64) _Atomic uint32_t tail;     // Next slot to read (consumer)
+    uint32_t cachedHead;
+    _Alignas(64) AudioEvent slots[AUDIO_EVENT_CAPACITY];
+} AudioEventQueue;
+
+static inline void AudioEventQueue_Init(AudioEventQueue* queue)
+{
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    queue->cachedTail = 0;
+    queue->cachedHead = 0;
+    queue->dropped = 0;
+}
+
+// Producer only; false (and counted) if the ring is full
+static inline bool AudioEventQueue_Push(AudioEventQueue* queue, const AudioEvent* event)
+{
+    uint32_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    if (head - queue->cachedTail == AUDIO_EVENT_CAPACITY) {
+        queue->cachedTail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        if (head - queue->cachedTail == AUDIO_EVENT_CAPACITY) {
+            queue->dropped++;
+            return false;
+        }
+    }
+    queue->slots[head & (AUDIO_EVENT_CAPACITY - 1)] = *event;
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+// Consumer only; false if the ring is empty
+static inline bool AudioEventQueue_Pop(AudioEventQueue* queue, AudioEvent* event)
+{
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    if (tail == queue->cachedHead) {
+        queue->cachedHead = atomic_load_explicit(&queue->head, memory_order_acquire);
+        if (tail == queue->cachedHead) {
+            return false;
+        }
+    }
+    *event = queue->slots[tail & (AUDIO_EVENT_CAPACITY - 1)];
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// PCM data a voice plays, not owned by the mixer (e.g. a mapped bundle entry)
+typedef struct {
+    const void* data;
+    uint32_t frameCount;
+    uint32_t sampleRate;
+    uint8_t sampleSize;         // Bits per sample: 8 (unsigned), 16 or 32 (float)
+    uint8_t channels;           // 1 or 2
+    uint8_t maxVoices;          // Voices this sample may use at once
+} AudioSample;
+
+typedef struct {
+    bool active;
+    uint8_t sample;
+    uint64_t startFrame;        // Output frame its first frame lands on
+    uint64_t position;          // Source frame, 32.32 fixed point
+    uint64_t step;              // Source frames per output frame, 32.32
+    float gainLeft;
+    float gainRight;
+    uint64_t serial;            // Start order, for stealing the oldest
+} AudioVoice;
+
+// Mixer cost and voice accounting, written by the mixing thread
+typedef struct {
+    _Atomic uint64_t callbacks;
+    _Atomic uint64_t mixNanos;          // Total time spent in AudioMixer_Mix
+    _Atomic uint64_t mixNanosMax;
+    _Atomic uint64_t lastMixNanos;
+    _Atomic uint64_t eventsStarted;
+    _Atomic uint64_t eventsLate;        // Scheduled before the block being mixed
+    _Atomic uint64_t voicesStolen;
+    _Atomic uint32_t voicesActive;
+} AudioMixerStats;
+
+// Software mixer for short sound effects
+//
+// The game loop pushes AudioEvents; whichever thread feeds the audio device
+// calls AudioMixer_Mix once per block. Each event's timestamp is mapped onto
+// the output frame clock, so sounds keep their exact relative timing no
+// matter how events bunch up in the frame that produced them.
+typedef struct {
+    AudioEventQueue events;
+    AudioSample samples[AUDIO_MAX_SAMPLES];
+    uint8_t sampleCount;
+
+    AudioVoice voices[AUDIO_MAX_VOICES];
+    uint8_t voicesPerSample[AUDIO_MAX_SAMPLES];
+    uint64_t nextSerial;
+
+    uint64_t streamFrame;       // Output frames mixed so far
+    uint64_t anchorTime;        // Clock time of anchorFrame (ns; 0 = unset)
+    uint64_t anchorFrame;
+
+    AudioMixerStats stats;
+} AudioMixer;
+
+void AudioMixer_Init(AudioMixer* mixer);
+
+// Register a sample before mixing starts; returns its id, or -1 if full
+int AudioMixer_AddSample(AudioMixer* mixer, const AudioSample* sample);
+
+// Queue a sound (game loop thread); false if the event queue is full
+static inline bool AudioMixer_Play(AudioMixer* mixer, const AudioEvent* event)
+{
+    return AudioEventQueue_Push(&mixer->events, event);
+}
+
+// Mix the next block into out (frames * AUDIO_MIX_CHANNELS floats)
+// now is the clock time (ns) at which the block's first frame is produced
+void AudioMixer_Mix(AudioMixer* mixer, float* out, uint32_t frames, uint64_t now);
+
+#endif // AUDIO_MIXER_H
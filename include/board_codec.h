@@ -0,0 +1,50 @@
+#ifndef BOARD_CODEC_H
+#define BOARD_CODEC_H
+
+#include "game_board.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Compact wire format for boards
+//
+// Each cell packs into one byte: color index (0 = empty, 1-6) in bits 0-2
+// and the BlockState bits in 3-5. A keyframe is the score, combo and every
+// cell. A delta against a previous board is the score, combo, a bitmask of
+// changed cells and the packed bytes of just those cells.
+// The wire format covers classic-mode boards (BOARD_SIZE cells).
+//
+// Garbage slabs travel in their own section: a count byte, then three bytes
+// per slab (x | (width - 1) << 3, y | (height - 1) << 4, state), whatever
+// area they cover. A keyframe reads back as a board without garbage; the
+// slab section follows it where garbage is sent. A delta ends with the
+// section when the slabs changed, or with BOARD_SLABS_UNCHANGED. The colors
+// a slab will reveal are not sent; they arrive as cell changes.
+#define BOARD_CHANGED_MASK_SIZE ((BOARD_SIZE + 7) / 8)
+#define BOARD_KEYFRAME_SIZE (8 + BOARD_SIZE)
+#define BOARD_SLAB_SIZE 3
+#define BOARD_SLABS_MAX_SIZE (1 + GARBAGE_MAX_SLABS * BOARD_SLAB_SIZE)
+#define BOARD_SLABS_UNCHANGED 0xFF
+#define BOARD_DELTA_MAX_SIZE (8 + BOARD_CHANGED_MASK_SIZE + BOARD_SIZE + BOARD_SLABS_MAX_SIZE)
+
+uint8_t BoardCodec_PackCell(uint16_t cell);
+uint16_t BoardCodec_UnpackCell(uint8_t packed);
+
+// Write a full board; returns bytes written (BOARD_KEYFRAME_SIZE)
+size_t BoardCodec_WriteKeyframe(const GameBoard* board, uint8_t* out);
+
+// Read a full board; returns bytes consumed, 0 if malformed
+size_t BoardCodec_ReadKeyframe(GameBoard* board, const uint8_t* in, size_t length);
+
+// Write the garbage slab section; returns bytes written
+size_t BoardCodec_WriteSlabs(const GameBoard* board, uint8_t* out);
+
+// Read a slab section into the board; returns bytes consumed, 0 if malformed
+size_t BoardCodec_ReadSlabs(GameBoard* board, const uint8_t* in, size_t length);
+
+// Write the changes from prev to cur; returns bytes written
+size_t BoardCodec_WriteDelta(const GameBoard* prev, const GameBoard* cur, uint8_t* out);
+
+// Apply a delta in place; returns bytes consumed, 0 if malformed
+size_t BoardCodec_ApplyDelta(GameBoard* board, const uint8_t* in, size_t length);
+
+#endif // BOARD_CODEC_H
@@ -0,0 +1,55 @@
+#ifndef BOARD_MODE_H
+#define BOARD_MODE_H
+
+#include "game_board.h"
+#include "match_detection.h"
+#include "physics.h"
+
+// Kernels are written once against constant dimensions and instantiated per
+// geometry in BOARD_GEOMETRIES; forcing them inline into each instance makes
+// the width and height compile-time constants, and the unroll pragma fully
+// unrolls the loops over a row or column
+#if defined(__GNUC__) || defined(__clang__)
+#define BOARD_KERNEL static inline __attribute__((always_inline))
+#define BOARD_UNROLL _Pragma("GCC unroll 16")
+#else
+#define BOARD_KERNEL static inline
+#define BOARD_UNROLL
+#endif
+
+typedef int (*DetectMatchesFn)(GameBoard* board, MatchList* matches);
+typedef bool (*ApplyGravityFn)(GameBoard* board, GravityAnimation* anim);
+
+// Geometry, colors and the kernels specialized for them
+// Look the mode up once per match and call through the table
+typedef struct {
+    const char* name;
+    uint8_t id;                 // BoardModeId
+    uint8_t width;
+    uint8_t height;
+    uint8_t colorCount;
+    uint8_t geometry;           // Index into BOARD_GEOMETRIES
+    DetectMatchesFn detectMatches;
+    ApplyGravityFn applyGravity;
+} BoardMode;
+
+#define BOARD_GEOMETRY_ENUM(tag, width, height) BOARD_GEOMETRY_##tag,
+typedef enum {
+    BOARD_GEOMETRIES(BOARD_GEOMETRY_ENUM)
+    BOARD_GEOMETRY_COUNT
+} BoardGeometryId;
+#undef BOARD_GEOMETRY_ENUM
+
+// Mode by id (out-of-range ids fall back to classic)
+const BoardMode* BoardMode_Get(BoardModeId id);
+
+// Mode by name, or NULL
+const BoardMode* BoardMode_Find(const char* name);
+
+// Mode of a board
+static inline const BoardMode* BoardMode_Of(const GameBoard* board)
+{
+    return BoardMode_Get((BoardModeId)board->mode);
+}
+
+#endif // BOARD_MODE_H
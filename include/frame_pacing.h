@@ -0,0 +1,73 @@
+#ifndef FRAME_PACING_H
+#define FRAME_PACING_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Frame pacing modes
+typedef enum {
+    FRAME_PACING_DEFAULT,       // raylib SetTargetFPS: sleep at the end of the frame
+    FRAME_PACING_LOW_LATENCY    // Sleep first, then sample input just before drawing
+} FramePacingMode;
+
+// Safety margin bounds for low-latency mode (seconds)
+#define FRAME_PACING_MIN_MARGIN 0.0005
+#define FRAME_PACING_MAX_MARGIN 0.0080
+
+// Frame pacing and input-to-present latency tracking
+//
+// In low-latency mode the frame is laid out as:
+//   [sleep] [poll input] [update + draw] [EndDrawing: swap blocks on vsync]
+// The sleep is sized from the measured update+draw time plus an adaptive
+// safety margin, so input is sampled as late as possible while the swap
+// still lands before the next vertical blank.
+//
+// Latency is estimated as the time between the input sample and the return
+// of EndDrawing (the swap has completed by then). In default mode raylib
+// polls input as the last step of EndDrawing, so the sample time is the
+// previous frame's EndDrawing return.
+typedef struct {
+    FramePacingMode mode;
+    bool vsync;
+    double period;          // Target frame period in seconds
+
+    double lastPresent;     // EndDrawing return time of the previous frame
+    double sampleTime;      // When input was sampled for the current frame
+    double drawStart;       // When the current frame's update started
+    double sleepTime;       // Time slept before sampling this frame
+
+    double work;            // Update+draw time of the current frame
+    double workAvg;         // Smoothed update+draw time
+    double workPeak;        // Decaying peak of update+draw time
+    double margin;          // Adaptive safety margin
+
+    double latency;         // Latest input-to-present estimate
+    double latencyAvg;      // Smoothed input-to-present estimate
+    unsigned long frame;
+    unsigned long missedFrames;
+
+    FILE* log;              // Optional per-frame CSV log (NULL if disabled)
+} FramePacing;
+
+// Initialize pacing state; call BEFORE InitWindow (sets the vsync flag)
+// csvPath may be NULL to disable the per-frame latency log
+void FramePacing_Init(FramePacing* pacing, FramePacingMode mode, int targetFPS,
+                      bool vsync, const char* csvPath);
+
+// Apply the target frame rate; call AFTER InitWindow
+void FramePacing_Start(FramePacing* pacing);
+
+// Begin a frame: in low-latency mode sleeps, then polls input
+// Call Input_Latch() first so presses from the previous poll are kept
+void FramePacing_BeginFrame(FramePacing* pacing);
+
+// Record the end of update+draw; call immediately before EndDrawing()
+void FramePacing_BeforePresent(FramePacing* pacing);
+
+// Record the present; call immediately after EndDrawing()
+void FramePacing_EndFrame(FramePacing* pacing);
+
+// Close the CSV log
+void FramePacing_Shutdown(FramePacing* pacing);
+
+#endif // FRAME_PACING_H
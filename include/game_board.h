@@ -4,10 +4,15 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-// Board dimensions
+// Board dimensions of the classic mode (network codec, replays and rows
+// default to these; other modes are listed in BOARD_MODES below)
 #define BOARD_WIDTH  6
 #define BOARD_HEIGHT 12
 
+// Largest board any mode uses; GameBoard storage is sized for it
+#define BOARD_MAX_WIDTH  8
+#define BOARD_MAX_HEIGHT 12
+
 // Block types (lower byte - bitfield values)
 typedef enum {
     BLOCK_EMPTY  = 0x00,
@@ -15,11 +20,13 @@ typedef enum {
     BLOCK_BLUE   = 0x02,
     BLOCK_GREEN  = 0x04,
     BLOCK_YELLOW = 0x08,
-    BLOCK_PURPLE = 0x10
+    BLOCK_PURPLE = 0x10,
+    BLOCK_CYAN   = 0x20     // Only used by modes with six colors
 } BlockType;
 
-// Number of colored block types (excludes EMPTY)
+// Number of colored block types in the classic mode (excludes EMPTY)
 #define BLOCK_TYPE_COUNT 5
+#define BLOCK_MAX_TYPE_COUNT 6
 
 // Block states (upper byte)
 typedef enum {
@@ -34,19 +41,58 @@ typedef enum {
 #define BLOCK_STATE(cell) ((BlockState)(((cell) >> 8) & 0xFF))
 #define MAKE_BLOCK(type, state) ((uint16_t)(((state) << 8) | (type)))
 
-// Grid indexing
+// Grid indexing (classic mode; a mode's grid is packed with its own width)
 #define BOARD_SIZE (BOARD_WIDTH * BOARD_HEIGHT)
+#define BOARD_MAX_SIZE (BOARD_MAX_WIDTH * BOARD_MAX_HEIGHT)
 #define GRID_INDEX(x, y) ((y) * BOARD_WIDTH + (x))
 
+// Board sizes with their own specialized kernels: X(tag, width, height)
+#define BOARD_GEOMETRIES(X) \
+    X(W6H12, 6, 12)         \
+    X(W8H12, 8, 12)         \
+    X(W6H8,  6, 8)
+
+// Game modes: X(id, name, geometry tag, colors)
+#define BOARD_MODES(X)                          \
+    X(CLASSIC, "classic", W6H12, 5)             \
+    X(HARD,    "hard",    W6H12, 6)             \
+    X(WIDE,    "wide",    W8H12, 5)             \
+    X(PUZZLE,  "puzzle",  W6H8,  5)
+
+#define BOARD_MODE_ENUM(id, name, geometry, colors) BOARD_MODE_##id,
+typedef enum {
+    BOARD_MODES(BOARD_MODE_ENUM)
+    BOARD_MODE_COUNT
+} BoardModeId;
+#undef BOARD_MODE_ENUM
+
+// Most garbage slabs a board holds at once
+#define GARBAGE_MAX_SLABS 8
+
+// A multi-cell garbage block, stored once instead of once per covered cell
+// The cells it covers stay BLOCK_EMPTY in the grid; see garbage.h
+typedef struct {
+    uint8_t x, y;           // Top-left cell
+    uint8_t width, height;  // Size in cells
+    uint8_t state;          // BlockState: STATE_FALLING until it lands
+    uint8_t reveal[3];      // Color index (1-6) per column, 3 bits each, for the blocks it turns into
+} GarbageSlab;
+
 // Game board structure
+// Cells are row-major with the mode's width as the stride; a zeroed board
+// is a classic one with no garbage
 typedef struct {
-    uint16_t grid[BOARD_SIZE];
+    uint16_t grid[BOARD_MAX_SIZE];
     int score;
     int combo;
+    uint8_t mode;           // BoardModeId
+    uint8_t slabCount;      // Garbage slabs in use
+    GarbageSlab slabs[GARBAGE_MAX_SLABS];
 } GameBoard;
 
 // Function declarations
 void GameBoard_Init(GameBoard* board);
+void GameBoard_InitMode(GameBoard* board, BoardModeId mode);
 void GameBoard_Clear(GameBoard* board);
 uint16_t GameBoard_GetCell(const GameBoard* board, int x, int y);
 void GameBoard_SetCell(GameBoard* board, int x, int y, uint16_t value);
@@ -54,7 +100,15 @@ void GameBoard_SetBlockType(GameBoard* board, int x, int y, BlockType type);
 void GameBoard_SetBlockState(GameBoard* board, int x, int y, BlockState state);
 bool GameBoard_IsValidPosition(int x, int y);
 
+// Whether (x, y) lies on this board (for its mode's size)
+bool GameBoard_Contains(const GameBoard* board, int x, int y);
+int GameBoard_Width(const GameBoard* board);
+int GameBoard_Height(const GameBoard* board);
+
 // Board initialization (fills with random blocks, no initial matches)
 void GameBoard_FillRandom(GameBoard* board);
 
+// Same as GameBoard_FillRandom, but reproducible from a match seed
+void GameBoard_FillSeeded(GameBoard* board, uint64_t seed);
+
 #endif // GAME_BOARD_H
@@ -2,6 +2,7 @@
 #define GAME_LOGIC_H
 
 #include "game_board.h"
+#include "match_detection.h"
 #include <stdbool.h>
 
 // Swap animation state
@@ -32,9 +33,43 @@ bool SwapBlocks(GameBoard* board, int x, int y);
 #define SCORE_BONUS_4_MATCH 20
 #define SCORE_BONUS_5_PLUS_MATCH 50
 
-// Clear all blocks marked as MATCHED
-// Sets them to BLOCK_EMPTY and adds to score
+// Clear the blocks covered by the runs from the last DetectMatches
+// Sets them to BLOCK_EMPTY and adds to score (per block, plus a bonus
+// for each run of 4 or 5+)
 // Returns the number of blocks cleared
-int ClearMatches(GameBoard* board);
+int ClearMatches(GameBoard* board, const MatchList* matches);
+
+// Per-column bitmasks hold one bit per row
+#if BOARD_MAX_HEIGHT > 16
+#error "CascadeStep column masks assume BOARD_MAX_HEIGHT <= 16"
+#endif
+
+// Each cascade step clears at least a full match, bounding the chain length
+#define MAX_CASCADE_STEPS (BOARD_MAX_SIZE / 3)
+
+// One step of a resolved cascade (a single clear followed by gravity)
+typedef struct {
+    uint16_t clearedMask[BOARD_MAX_WIDTH];  // Bit y of column x set = cell (x, y) cleared
+    uint8_t chain;                      // Chain depth (1 = the match that started it)
+    uint8_t cleared;                    // Number of blocks cleared in this step
+    int16_t scoreDelta;                 // Score added by this step
+} CascadeStep;
+
+// Compact record of a whole cascade, for replaying it as animation later
+typedef struct {
+    int stepCount;
+    int totalCleared;
+    int totalScore;
+    CascadeStep steps[MAX_CASCADE_STEPS];
+} CascadeEvents;
+
+// Resolve a whole cascade in one call, without animation state
+// Settles the board first (so it can be called right after a swap), then
+// repeats DetectMatches -> ClearMatches (converting any garbage the runs
+// touch) -> gravity until the board settles,
+// updating the board and score exactly as the frame-stepped loop would
+// out_events may be NULL when only the final board is needed
+// Returns the number of steps (chain depth); 0 if nothing matched
+int ResolveCascade(GameBoard* board, CascadeEvents* out_events);
 
 #endif // GAME_LOGIC_H
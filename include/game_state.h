@@ -0,0 +1,81 @@
+#ifndef GAME_STATE_H
+#define GAME_STATE_H
+
+#include "board_mode.h"
+#include "game_board.h"
+#include "game_logic.h"
+#include "match_detection.h"
+#include "physics.h"
+#include "row_queue.h"
+#include <stdbool.h>
+
+// Fixed simulation rate used by the server and headless tools
+#define GAME_TICK_RATE 60
+#define GAME_TICK_SECONDS (1.0f / GAME_TICK_RATE)
+
+// Input flags
+#define GAME_INPUT_SWAP  0x01   // Swap the pair at (x, y) and (x+1, y)
+#define GAME_INPUT_RAISE 0x02   // Raise the stack by one row
+#define GAME_INPUT_GARBAGE 0x04 // An attack landed: queue an (x+1) x (y+1) garbage slab
+
+// One frame of player input
+typedef struct {
+    uint8_t x, y;               // Cursor position (left block of the pair)
+    uint8_t flags;              // GAME_INPUT_* bits
+} GameInput;
+
+// Events reported by GameState_Update (bitmask)
+#define GAME_EVENT_SWAP  0x01   // A swap started
+#define GAME_EVENT_RAISE 0x02   // The stack rose by one row
+#define GAME_EVENT_MATCH 0x04   // New matches were detected
+#define GAME_EVENT_CLEAR 0x08   // Matched blocks were cleared
+#define GAME_EVENT_LAND  0x10   // Falling blocks landed
+#define GAME_EVENT_REVEAL 0x20  // Garbage next to a clear turned into blocks
+#define GAME_EVENT_GARBAGE 0x40 // A garbage slab dropped onto the board
+
+// Attacks that can wait for the board to settle; more are refused
+#define GAME_PENDING_GARBAGE_MAX 8
+
+// An attack waiting to drop
+typedef struct {
+    uint8_t width, height;
+} PendingGarbage;
+
+// Complete simulation state for one player's board
+// Updating it is independent of rendering, so the client, the server and
+// headless tools all step the same logic
+typedef struct {
+    GameBoard board;
+    const BoardMode* mode;      // Kernels for the board's mode, chosen at init
+    SwapAnimation swapAnim;
+    GravityAnimation gravityAnim;
+    MatchList matches;
+    float clearTimer;
+    bool waitingToClear;
+    int lastMatchCount;
+    int lastClearCount;
+    PendingGarbage pendingGarbage[GAME_PENDING_GARBAGE_MAX];   // Oldest first
+    int pendingGarbageCount;
+    RowQueue* rows;             // Rising rows (NULL disables raising)
+} GameState;
+
+// Initialize the state with a classic board generated from the match seed
+void GameState_Init(GameState* state, uint64_t seed, RowQueue* rows);
+
+// Same for a given mode; rows should come from RowQueue_InitMode with it
+void GameState_InitMode(GameState* state, BoardModeId mode, uint64_t seed, RowQueue* rows);
+
+// Queue a width x height garbage slab from an attack; returns false if the
+// queue is full or the size does not fit the board
+// GameState_Update drops the oldest queued slab (revealing the colors of
+// the next garbage template from the row queue) on the first tick the board
+// is settled and its top rows are clear, so an attack that lands mid-combo
+// waits rather than being lost. GAME_INPUT_GARBAGE queues through here,
+// which is how attacks reach the board in recorded and rolled-back inputs.
+bool GameState_QueueGarbage(GameState* state, int width, int height);
+
+// Advance the simulation by one frame
+// Returns the GAME_EVENT_* bits for what happened this frame
+int GameState_Update(GameState* state, const GameInput* input, float deltaTime);
+
+#endif // GAME_STATE_H
@@ -0,0 +1,43 @@
+#ifndef GARBAGE_H
+#define GARBAGE_H
+
+#include "game_board.h"
+#include "match_detection.h"
+#include "row_queue.h"
+#include <stdbool.h>
+
+// Garbage slabs
+//
+// An attack drops a garbage block that spans several cells. The board keeps
+// it as one GarbageSlab in a small table rather than as the cells it
+// covers (which stay empty in the grid), so it falls, rests and converts as
+// a unit: gravity moves a slab with one row update, a clear next to it is
+// found with one rectangle test per run, and drawing and the wire format
+// handle one entry per slab. None of them visit the covered cells, so their
+// cost follows the number of slabs rather than the area of garbage.
+//
+// A run cleared next to a slab sets it off, along with every slab touching
+// one that went off. Each converts its bottom row into blocks of the colors
+// it was dropped with and shrinks by a row; a slab with no rows left leaves
+// the table.
+
+// Drop a width x height slab into the top rows, at the template's column
+// (moved left as needed to fit), to reveal the template's colors
+// Returns false (board unchanged) if those cells are not clear or the
+// table is full
+bool Garbage_Spawn(GameBoard* board, const GarbageTemplate* garbage, int width, int height);
+
+// Index of the slab covering (x, y), or -1
+int Garbage_SlabAt(const GameBoard* board, int x, int y);
+
+// Convert the slabs set off by the runs of a detection pass
+// Call before ClearMatches; returns the number of blocks revealed
+int Garbage_React(GameBoard* board, const MatchList* matches);
+
+// Mark every slab as resting (once the gravity animation has landed them)
+void Garbage_Land(GameBoard* board);
+
+// Block type the slab reveals in its column i
+BlockType GarbageSlab_Reveal(const GarbageSlab* slab, int i);
+
+#endif // GARBAGE_H
@@ -7,11 +7,16 @@
 typedef struct {
     int x;
     int y;
+    int boardWidth;     // Bounds of the board the cursor moves on
+    int boardHeight;
 } Cursor;
 
-// Initialize cursor to default position
+// Initialize cursor to default position on a classic board
 void Cursor_Init(Cursor* cursor);
 
+// Initialize cursor for a board of the given size
+void Cursor_InitSized(Cursor* cursor, int boardWidth, int boardHeight);
+
 // Handle input and update cursor position
 // Returns true if cursor moved
 bool Cursor_HandleInput(Cursor* cursor);
@@ -22,4 +27,14 @@ void Cursor_Clamp(Cursor* cursor);
 // Check if swap key (SPACE) was pressed
 bool Input_SwapPressed(void);
 
+// Check if raise key (either SHIFT) was pressed
+bool Input_RaisePressed(void);
+
+// Latch key presses from the most recent input poll so they survive an
+// extra PollInputEvents() call before the update (see frame_pacing.h)
+void Input_Latch(void);
+
+// Drop latched key presses once the frame's update has consumed them
+void Input_ClearLatch(void);
+
 #endif // INPUT_H
@@ -0,0 +1,91 @@
+#ifndef LINK_EMULATOR_H
+#define LINK_EMULATOR_H
+
+#include "rng.h"
+#include "transport.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Datagrams one emulator can hold in flight
+#define LINK_EMULATOR_CAPACITY 1024
+
+// Conditions of one direction of a link
+// Times are in seconds, probabilities in [0, 1]
+typedef struct {
+    double latency;         // Base one-way delay
+    double jitter;          // Each datagram gets +/- up to this much extra delay
+    double loss;            // Chance a datagram is dropped
+    double duplicate;       // Chance a datagram is delivered twice
+    double reorder;         // Chance a datagram is held back by reorderDelay
+    double reorderDelay;
+    double bandwidth;       // Bytes per second (0 = unlimited)
+    double queueLimit;      // Longest a datagram may wait for bandwidth before tail drop
+} LinkConditions;
+
+// Receives datagrams when they come out of the emulated link
+typedef void (*LinkDeliverFn)(void* context, const uint8_t* data, size_t length, double now);
+
+typedef struct {
+    uint64_t sent;
+    uint64_t delivered;
+    uint64_t lost;
+    uint64_t duplicated;
+    uint64_t reordered;
+    uint64_t queueDrops;    // Over the bandwidth queue limit or capacity
+    uint64_t oversized;     // Larger than TRANSPORT_MTU, dropped as a real link would
+    uint64_t bytesSent;
+    uint64_t bytesDelivered;
+} LinkStats;
+
+typedef struct {
+    double deliverAt;
+    uint64_t order;         // Ties deliver in send order
+    uint16_t length;
+    uint8_t data[TRANSPORT_MTU];
+} LinkPacket;
+
+// One direction of an emulated network link
+//
+// Datagrams go in through LinkEmulator_Send (usable directly as a
+// TransportSendFn) and come out of the deliver callback from
+// LinkEmulator_Advance once their delivery time has passed. Every random
+// decision comes from a seeded RNG and time only moves in Advance, so a run
+// driven by a virtual clock is exactly reproducible. Packets live in a fixed
+// pool ordered by a binary heap; nothing is allocated while running.
+typedef struct {
+    LinkConditions conditions;
+    Rng rng;
+    LinkDeliverFn deliver;
+    void* deliverContext;
+
+    double now;             // Time of the last Advance; sends are stamped with it
+    double linkFreeAt;      // When the bandwidth-limited link finishes its queue
+    uint64_t nextOrder;
+
+    LinkPacket packets[LINK_EMULATOR_CAPACITY];
+    uint16_t freeList[LINK_EMULATOR_CAPACITY];
+    int freeCount;
+    uint16_t heap[LINK_EMULATOR_CAPACITY];  // Indices into packets, earliest first
+    int heapCount;
+
+    LinkStats stats;
+} LinkEmulator;
+
+void LinkEmulator_Init(LinkEmulator* link, const LinkConditions* conditions, uint64_t seed,
+                       LinkDeliverFn deliver, void* deliverContext);
+
+// Change conditions mid-run (datagrams already in flight keep their timing)
+void LinkEmulator_SetConditions(LinkEmulator* link, const LinkConditions* conditions);
+
+// TransportSendFn: put a datagram on the link at the current time
+// A datagram over TRANSPORT_MTU is dropped whole, never cut short
+void LinkEmulator_Send(void* link, const uint8_t* data, size_t length);
+
+// Move time forward and deliver everything due by then
+void LinkEmulator_Advance(LinkEmulator* link, double now);
+
+// Datagrams still in flight
+int LinkEmulator_Pending(const LinkEmulator* link);
+
+#endif // LINK_EMULATOR_H
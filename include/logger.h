@@ -0,0 +1,196 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Levels (named apart from raylib's LOG_* trace levels)
+#define LOGGER_DEBUG 0
+#define LOGGER_INFO  1
+#define LOGGER_WARN  2
+#define LOGGER_ERROR 3
+
+// Messages below this level compile to nothing (the Makefile sets LOG_LEVEL)
+#ifndef LOGGER_MIN_LEVEL
+#define LOGGER_MIN_LEVEL LOGGER_INFO
+#endif
+
+// Message definitions: X(id, level, printf format)
+// Arguments are integers or floating point (no strings or pointers), one to
+// LOGGER_MAX_ARGS of them; the decoder formats them from this table
+#define LOGGER_MESSAGES(X) \
+    X(LOGGER_STARTED,     LOGGER_INFO,  "logging started by pid %d") \
+    X(ROOM_CREATED,       LOGGER_INFO,  "room %u created on shard %d") \
+    X(ROOM_FINISHED,      LOGGER_INFO,  "room %u finished after %u ticks") \
+    X(ROOM_MIGRATED,      LOGGER_DEBUG, "room %u moved from shard %d to shard %d") \
+    X(TICK_OVERRUN,       LOGGER_WARN,  "room %u tick %u started %u periods late") \
+    X(TICKS_DROPPED,      LOGGER_WARN,  "room %u resynced to the clock, %u ticks dropped") \
+    X(BLOCKS_CLEARED,     LOGGER_DEBUG, "cleared %d blocks, combo %d, score %d") \
+    X(DATAGRAM_REJECTED,  LOGGER_WARN,  "rejected %zu byte datagram") \
+    X(PACKET_LOST,        LOGGER_DEBUG, "packet %u lost, rtt %.1f ms") \
+    X(FRAME_SLOW,         LOGGER_WARN,  "frame %u took %.2f ms") \
+    X(SESSION_STARTED,    LOGGER_INFO,  "client session: mode %u, seed %llu") \
+    X(BENCH_SAMPLE,       LOGGER_INFO,  "bench sample %u of %d, value %.3f")
+
+#define LOGGER_MESSAGE_ENUM(id, level, format) LOG_MSG_##id,
+typedef enum { LOGGER_MESSAGES(LOGGER_MESSAGE_ENUM) LOG_MSG_COUNT } LogMessage;
+#undef LOGGER_MESSAGE_ENUM
+
+// Compile-time level of each message, for filtering in LOG_EVENT
+#define LOGGER_LEVEL_ENUM(id, level, format) LOG_LEVEL_OF_##id = level,
+enum { LOGGER_MESSAGES(LOGGER_LEVEL_ENUM) };
+#undef LOGGER_LEVEL_ENUM
+
+#define LOGGER_MAX_ARGS 6
+
+// Records per thread ring (power of two); 64 bytes each
+#define LOGGER_RING_RECORDS 4096
+
+// One record: a cache line, copied raw to the file
+typedef struct {
+    uint64_t ticks;                 // Logger_Ticks() at the call
+    uint16_t message;               // LogMessage, or a LOGGER_RECORD_* marker
+    uint8_t argCount;
+    uint8_t thread;                 // Registration index
+    uint32_t reserved;
+    uint64_t args[LOGGER_MAX_ARGS]; // Integers as int64, floating point as double bits
+} LogRecord;
+
+// Markers the drain thread writes alongside messages
+#define LOGGER_RECORD_THREAD  0xFFFF   // args: thread name (NUL-padded bytes)
+#define LOGGER_RECORD_CLOCK   0xFFFE   // args[0] monotonic ns at ticks, args[1] wall clock ns
+#define LOGGER_RECORD_DROPPED 0xFFFD   // args[0] records dropped since the last report
+
+// File layout: LogFileHeader, then LogRecords in drain order
+#define LOGGER_FILE_MAGIC "PALOG001"
+
+typedef struct {
+    char magic[8];
+    uint32_t recordSize;
+    uint32_t messageCount;
+    uint64_t tableHash;             // FNV-1a of every level and format; decoders must match
+} LogFileHeader;
+
+// A thread's ring: it writes head, the drain thread writes tail
+typedef struct LogRing {
+    _Alignas(64) _Atomic uint32_t head;
+    uint32_t cachedTail;
+    _Atomic uint64_t dropped;
+    _Alignas(64) _Atomic uint32_t tail;
+    uint64_t reportedDropped;
+    bool announced;
+    uint8_t index;
+    char name[LOGGER_MAX_ARGS * sizeof(uint64_t)];
+    struct LogRing* next;
+    _Alignas(64) LogRecord records[LOGGER_RING_RECORDS];
+} LogRing;
+
+// Set by Logger_RegisterThread; NULL makes LOG_EVENT a no-op
+extern _Thread_local LogRing* loggerRing;
+
+// Asynchronous binary logger
+//
+// A log call never formats or does I/O: it copies a timestamp, the message
+// id and the raw arguments into the calling thread's own ring, then
+// publishes it with one release store. A background thread drains every ring
+// to a file, and tools/logs decodes the file to text with the format strings
+// from LOGGER_MESSAGES. When a ring is full the record is dropped and
+// counted, so a stalled disk never stalls the game or a shard.
+
+// Open the file and start the drain thread; false if the file cannot be created
+bool Logger_Start(const char* path);
+
+// Drain what is left, close the file and stop (rings stay valid)
+void Logger_Stop(void);
+
+// Give the calling thread a ring (no-op while the logger is stopped)
+void Logger_RegisterThread(const char* name);
+
+// Timestamp source: the TSC on x86, monotonic nanoseconds elsewhere
+// (the drain thread writes clock records that map ticks to time)
+#if defined(__x86_64__) || defined(__i386__)
+static inline uint64_t Logger_Ticks(void)
+{
+    return __rdtsc();
+}
+#else
+uint64_t Logger_Ticks(void);
+#endif
+
+static inline uint64_t Logger_Integer(int64_t value)
+{
+    return (uint64_t)value;
+}
+
+static inline uint64_t Logger_Double(double value)
+{
+    uint64_t bits;
+    __builtin_memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline void Logger_Write(LogRing* ring, LogMessage message, const uint64_t* args, int argCount)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head - ring->cachedTail >= LOGGER_RING_RECORDS) {
+        ring->cachedTail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head - ring->cachedTail >= LOGGER_RING_RECORDS) {
+            atomic_store_explicit(&ring->dropped,
+                                  atomic_load_explicit(&ring->dropped, memory_order_relaxed) + 1,
+                                  memory_order_relaxed);
+            return;
+        }
+    }
+    LogRecord* record = &ring->records[head & (LOGGER_RING_RECORDS - 1)];
+    record->ticks = Logger_Ticks();
+    record->message = (uint16_t)message;
+    record->argCount = (uint8_t)argCount;
+    record->thread = ring->index;
+    for (int i = 0; i < argCount; i++) {
+        record->args[i] = args[i];
+    }
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// Argument packing: each argument becomes one 64-bit word
+#define LOGGER_ARG(x) _Generic((x), float: Logger_Double, double: Logger_Double, default: Logger_Integer)(x)
+#define LOGGER_ARGS_1(a) LOGGER_ARG(a)
+#define LOGGER_ARGS_2(a, b) LOGGER_ARG(a), LOGGER_ARG(b)
+#define LOGGER_ARGS_3(a, b, c) LOGGER_ARGS_2(a, b), LOGGER_ARG(c)
+#define LOGGER_ARGS_4(a, b, c, d) LOGGER_ARGS_3(a, b, c), LOGGER_ARG(d)
+#define LOGGER_ARGS_5(a, b, c, d, e) LOGGER_ARGS_4(a, b, c, d), LOGGER_ARG(e)
+#define LOGGER_ARGS_6(a, b, c, d, e, f) LOGGER_ARGS_5(a, b, c, d, e), LOGGER_ARG(f)
+#define LOGGER_PICK(a, b, c, d, e, f, name, ...) name
+#define LOGGER_ARGS(...) \
+    LOGGER_PICK(__VA_ARGS__, LOGGER_ARGS_6, LOGGER_ARGS_5, LOGGER_ARGS_4, \
+                LOGGER_ARGS_3, LOGGER_ARGS_2, LOGGER_ARGS_1, unused)(__VA_ARGS__)
+
+// Log a message from LOGGER_MESSAGES, e.g. LOG_EVENT(ROOM_CREATED, id, shard)
+// Messages below LOGGER_MIN_LEVEL vanish at compile time; unregistered
+// threads pay one thread-local load
+#define LOG_EVENT(id, ...)                                                              \
+    do {                                                                                \
+        if (LOG_LEVEL_OF_##id >= LOGGER_MIN_LEVEL) {                                    \
+            LogRing* logRing_ = loggerRing;                                             \
+            if (logRing_) {                                                             \
+                const uint64_t logArgs_[] = { LOGGER_ARGS(__VA_ARGS__) };               \
+                Logger_Write(logRing_, LOG_MSG_##id, logArgs_,                          \
+                             (int)(sizeof(logArgs_) / sizeof(logArgs_[0])));            \
+            }                                                                           \
+        }                                                                               \
+    } while (0)
+
+// Level, format and name of a message (for the decoder)
+int Logger_MessageLevel(int message);
+const char* Logger_MessageFormat(int message);
+const char* Logger_MessageName(int message);
+const char* Logger_LevelName(int level);
+
+// Hash written to the file header
+uint64_t Logger_TableHash(void);
+
+#endif // LOGGER_H
@@ -0,0 +1,58 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include "game_state.h"
+#include "match_arena.h"
+#include "row_queue.h"
+
+// Players per match
+#define MATCH_PLAYERS 2
+
+// Ticks of input kept per player (power of two); covers late and resent inputs
+#define MATCH_INPUT_HISTORY 128
+
+// Recent full-state snapshots kept for resyncing clients (power of two)
+#define MATCH_SNAPSHOT_COUNT 4
+
+// Size of each packet buffer carved from the match arena
+#define MATCH_PACKET_SIZE 1200
+
+// Saved state of both players at a tick
+typedef struct {
+    uint32_t tick;
+    uint32_t rowsConsumed[MATCH_PLAYERS];
+    GameState players[MATCH_PLAYERS];
+} MatchSnapshot;
+
+// Server-side state of one 1v1 match
+struct Match {
+    uint32_t id;
+    uint32_t tick;
+    uint64_t seed;
+    int32_t poolNext;                   // Free list link while the slab is unused
+
+    GameState players[MATCH_PLAYERS];
+    RowQueue rows[MATCH_PLAYERS];
+    GameInput inputs[MATCH_PLAYERS][MATCH_INPUT_HISTORY];
+    MatchSnapshot snapshots[MATCH_SNAPSHOT_COUNT];
+
+    uint8_t* sendBuffers[MATCH_PLAYERS];
+    uint8_t* recvBuffers[MATCH_PLAYERS];
+    MatchArena arena;                   // Backed by the rest of the slab
+};
+
+// Initialize a match in place; arenaMemory is the slab space after the Match
+void Match_Init(Match* match, uint32_t id, uint64_t seed, void* arenaMemory, size_t arenaSize);
+
+// Record a player's input for a tick (ignored if outside the history window)
+// GAME_INPUT_GARBAGE is stripped: clients cannot send or refuse attacks
+void Match_SubmitInput(Match* match, int player, uint32_t tick, const GameInput* input);
+
+// Advance both players by one fixed tick using the recorded inputs, then
+// queue the garbage each player's clears send to the other
+void Match_Tick(Match* match);
+
+// Save both players' state into the snapshot ring
+void Match_Snapshot(Match* match);
+
+#endif // MATCH_H
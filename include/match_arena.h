@@ -0,0 +1,60 @@
+#ifndef MATCH_ARENA_H
+#define MATCH_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bytes of per-match scratch memory (packet buffers and the like)
+#define MATCH_ARENA_SIZE (8 * 1024)
+
+// Allocation alignment inside an arena and slab alignment inside a pool
+#define MATCH_ARENA_ALIGN 16
+#define MATCH_SLAB_ALIGN  64
+
+// Bump allocator over a fixed region owned by one match
+// Everything is released at once with MatchArena_Reset when the match ends
+typedef struct {
+    uint8_t* base;
+    size_t size;
+    size_t used;
+} MatchArena;
+
+void MatchArena_Init(MatchArena* arena, void* memory, size_t size);
+
+// Returns NULL when the arena is exhausted
+void* MatchArena_Alloc(MatchArena* arena, size_t size);
+
+void MatchArena_Reset(MatchArena* arena);
+
+typedef struct Match Match;
+
+// Fixed-size slabs for Match objects, allocated once up front
+// Each slab holds a Match followed by its arena region. Released slabs go on
+// an intrusive free list and are handed out again, so steady-state play
+// performs no malloc/free. A pool is owned by a single thread.
+typedef struct {
+    uint8_t* memory;
+    size_t slabSize;
+    int capacity;
+    int active;
+    int freeHead;           // Index of the first free slab (-1 if none)
+} MatchPool;
+
+// Size of one slab (Match + arena, rounded to MATCH_SLAB_ALIGN)
+size_t MatchPool_SlabSize(void);
+
+// Reserve capacity slabs; the only allocation the pool ever makes
+bool MatchPool_Init(MatchPool* pool, int capacity);
+void MatchPool_Destroy(MatchPool* pool);
+
+// Take a slab and initialize a match in it; NULL if the pool is full
+Match* MatchPool_Acquire(MatchPool* pool, uint32_t matchId, uint64_t seed);
+
+// Slab index of a match acquired from this pool
+int MatchPool_IndexOf(const MatchPool* pool, const Match* match);
+
+// Return a match's slab to the free list
+void MatchPool_Release(MatchPool* pool, Match* match);
+
+#endif // MATCH_ARENA_H
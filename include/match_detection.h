@@ -6,12 +6,48 @@
 // Minimum number of blocks required for a match
 #define MIN_MATCH_LENGTH 3
 
+// Upper bound on runs found in one pass on any board: each row fits at most
+// width / MIN_MATCH_LENGTH horizontal runs, each column at most
+// height / MIN_MATCH_LENGTH vertical runs
+#define MAX_MATCH_RUNS (BOARD_MAX_HEIGHT * (BOARD_MAX_WIDTH / MIN_MATCH_LENGTH) + \
+                        BOARD_MAX_WIDTH * (BOARD_MAX_HEIGHT / MIN_MATCH_LENGTH))
+
+// Run orientation
+typedef enum {
+    MATCH_HORIZONTAL = 0,
+    MATCH_VERTICAL   = 1
+} MatchOrientation;
+
+// A single straight run of 3+ same-colored blocks
+typedef struct {
+    uint8_t type;           // BlockType of the run
+    uint8_t x, y;           // First cell (leftmost or topmost)
+    uint8_t length;         // Number of blocks in the run
+    uint8_t orientation;    // MatchOrientation
+    uint8_t group;          // Runs sharing a cell (L, T and + shapes) share a group
+} MatchRun;
+
+// All runs found by one detection pass
+typedef struct {
+    int runCount;
+    int groupCount;
+    int matchedCount;       // Unique blocks covered by the runs
+    MatchRun runs[MAX_MATCH_RUNS];
+} MatchList;
+
 // Detect all matches on the board
-// Marks matched blocks with STATE_MATCHED
+// Marks matched blocks with STATE_MATCHED and fills the run list
 // Returns the number of blocks matched (0 if no matches)
-int DetectMatches(GameBoard* board);
+// Dispatches on the board's mode; hot paths call the mode's kernel directly
+int DetectMatches(GameBoard* board, MatchList* matches);
+
+// DetectMatches specialized for each board geometry
+#define DECLARE_DETECT_MATCHES(tag, width, height) \
+    int DetectMatches_##tag(GameBoard* board, MatchList* matches);
+BOARD_GEOMETRIES(DECLARE_DETECT_MATCHES)
+#undef DECLARE_DETECT_MATCHES
 
-// Check if any blocks are currently marked as matched
-bool HasMatchedBlocks(const GameBoard* board);
+// Check if a detection pass found any matches
+bool HasMatchedBlocks(const MatchList* matches);
 
 #endif // MATCH_DETECTION_H
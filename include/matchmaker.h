@@ -0,0 +1,128 @@
+#ifndef MATCHMAKER_H
+#define MATCHMAKER_H
+
+#include "mpsc_queue.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Ratings are clamped into [0, MATCHMAKER_RATING_MAX)
+#define MATCHMAKER_RATING_MAX 4096
+
+// Width of one rating bucket; players in the same bucket always accept each other
+#define MATCHMAKER_BUCKET_WIDTH 32
+#define MATCHMAKER_BUCKETS (MATCHMAKER_RATING_MAX / MATCHMAKER_BUCKET_WIDTH)
+
+// Search window (rating difference accepted) as a function of time waited
+#define MATCHMAKER_INITIAL_WINDOW 50
+#define MATCHMAKER_WINDOW_PER_SECOND 25
+#define MATCHMAKER_MAX_WINDOW 800
+
+// Default time between pairing passes (nanoseconds)
+#define MATCHMAKER_PASS_NS 100000000ull
+
+typedef enum {
+    MATCHMAKER_TICKET_IDLE,
+    MATCHMAKER_TICKET_QUEUED,   // Join submitted; waiting for a match
+    MATCHMAKER_TICKET_MATCHED,
+    MATCHMAKER_TICKET_LEFT
+} MatchmakerTicketState;
+
+typedef enum {
+    MATCHMAKER_EVENT_JOIN,
+    MATCHMAKER_EVENT_LEAVE
+} MatchmakerEventKind;
+
+struct MatchmakerTicket;
+
+// Link in the matchmaker's inbox; a ticket embeds one per kind of event
+typedef struct {
+    MpscNode node;
+    MatchmakerEventKind kind;
+    struct MatchmakerTicket* ticket;
+} MatchmakerEvent;
+
+// A player's place in the queue, owned by the caller (e.g. a connection)
+//
+// The owning thread fills playerId and rating, calls Matchmaker_Join and may
+// later call Matchmaker_Leave. Everything else belongs to the matchmaker
+// until Matchmaker_TicketSettled says the ticket can be reused.
+typedef struct MatchmakerTicket {
+    uint32_t playerId;
+    int32_t rating;
+    uint64_t joinedNs;                  // Set by Matchmaker_Join
+
+    MatchmakerEvent joinEvent;
+    MatchmakerEvent leaveEvent;
+    atomic_int state;                   // MatchmakerTicketState
+    atomic_int pendingEvents;           // Pushed but not yet processed
+
+    // Matchmaker thread only
+    struct MatchmakerTicket* prev;      // Bucket list, oldest first
+    struct MatchmakerTicket* next;
+    int16_t bucket;                     // -1 when not waiting
+} MatchmakerTicket;
+
+// Called on the matchmaker thread for each pair it forms
+typedef void (*MatchmakerPairFn)(void* context, MatchmakerTicket* a, MatchmakerTicket* b, uint64_t nowNs);
+
+typedef struct {
+    uint64_t joins;
+    uint64_t leaves;            // Left while still waiting
+    uint64_t pairs;
+    uint64_t passes;
+    uint64_t sameBucketPairs;   // Paired inside one bucket
+    uint64_t widenedPairs;      // Paired across buckets after the window widened
+    uint64_t passNs;            // Time spent in pairing passes
+    uint64_t drainNs;           // Time spent applying joins and leaves
+} MatchmakerStats;
+
+// Rating-bucketed matchmaking queue
+//
+// Network threads submit joins and leaves through a lock-free MPSC queue;
+// only the thread calling Matchmaker_Poll touches the buckets. Waiting
+// players sit in FIFO lists per rating bucket, with a bitmap of non-empty
+// buckets. Pairing runs as a batch pass on a fixed interval: first each
+// bucket pairs its own players oldest first, which leaves at most one player
+// per bucket; then those leftovers are paired with the nearest leftover whose
+// rating both players' windows accept, oldest first. A window starts at
+// MATCHMAKER_INITIAL_WINDOW and widens the longer a player waits. A pass costs
+// O(new players + buckets), however many players are queued.
+typedef struct {
+    MpscQueue inbox;
+    MatchmakerTicket* head[MATCHMAKER_BUCKETS];
+    MatchmakerTicket* tail[MATCHMAKER_BUCKETS];
+    uint32_t count[MATCHMAKER_BUCKETS];
+    uint64_t occupied[(MATCHMAKER_BUCKETS + 63) / 64];
+    uint32_t waiting;
+
+    uint64_t passIntervalNs;
+    uint64_t nextPassNs;
+
+    MatchmakerPairFn onPair;
+    void* pairContext;
+
+    MatchmakerStats stats;
+} Matchmaker;
+
+void Matchmaker_Init(Matchmaker* matchmaker, uint64_t passIntervalNs, MatchmakerPairFn onPair,
+                     void* pairContext);
+
+// Any thread: queue a player; the ticket must be idle or settled
+void Matchmaker_Join(Matchmaker* matchmaker, MatchmakerTicket* ticket, uint64_t nowNs);
+
+// Any thread: withdraw a queued player (ignored if they were already matched)
+// Call at most once per join, from the thread that joined
+void Matchmaker_Leave(Matchmaker* matchmaker, MatchmakerTicket* ticket);
+
+// True once the matchmaker is done with the ticket (matched, left or never joined)
+bool Matchmaker_TicketSettled(MatchmakerTicket* ticket);
+
+// Matchmaker thread: apply queued joins and leaves, and run a pairing pass
+// when one is due. Returns the number of pairs formed.
+int Matchmaker_Poll(Matchmaker* matchmaker, uint64_t nowNs);
+
+// Rating difference a player accepts after waiting this long
+int Matchmaker_Window(uint64_t waitedNs);
+
+#endif // MATCHMAKER_H
@@ -0,0 +1,188 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Metric definitions: X(id, Prometheus name, help text)
+#define METRICS_COUNTERS(X) \
+    X(PACKETS_IN,  "puzzle_packets_received_total",     "Datagrams accepted by transports") \
+    X(PACKETS_OUT, "puzzle_packets_sent_total",         "Datagrams sent by transports and spectator channels") \
+    X(ROLLBACKS,   "puzzle_rollback_corrections_total", "Mispredictions corrected by re-simulating") \
+    X(OVERRUNS,    "puzzle_tick_overruns_total",        "Room ticks started a full period late")
+
+#define METRICS_GAUGES(X) \
+    X(ACTIVE_ROOMS, "puzzle_active_rooms", "Rooms hosted by the scheduler")
+
+#define METRICS_HISTOGRAMS(X) \
+    X(TICK,          "puzzle_tick_duration_seconds",   "Time to simulate one room tick") \
+    X(DETECT_MATCHES, "puzzle_detect_matches_seconds", "DetectMatches time in ticks that ran it") \
+    X(APPLY_GRAVITY,  "puzzle_apply_gravity_seconds",  "ApplyGravity time in ticks that ran it")
+
+#define METRIC_ENUM(id, name, help) METRIC_##id,
+typedef enum { METRICS_COUNTERS(METRIC_ENUM) METRIC_COUNTER_COUNT } MetricCounter;
+typedef enum { METRICS_GAUGES(METRIC_ENUM) METRIC_GAUGE_COUNT } MetricGauge;
+typedef enum { METRICS_HISTOGRAMS(METRIC_ENUM) METRIC_HISTOGRAM_COUNT } MetricHistogram;
+#undef METRIC_ENUM
+
+// HDR-style log-linear buckets over nanoseconds: every power of two is split
+// into 2^METRICS_SUB_BITS buckets (under 3.2% error), up to 2^METRICS_MAX_BITS ns
+#define METRICS_SUB_BITS 5
+#define METRICS_MAX_BITS 36
+#define METRICS_BUCKETS ((METRICS_MAX_BITS - METRICS_SUB_BITS + 1) << METRICS_SUB_BITS)
+
+typedef struct {
+    _Atomic uint64_t buckets[METRICS_BUCKETS];
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum;               // Nanoseconds
+} MetricsHistogramData;
+
+// One thread's metrics; only that thread writes them, the exporter reads
+typedef struct MetricsThread {
+    _Atomic uint64_t counters[METRIC_COUNTER_COUNT];
+    MetricsHistogramData histograms[METRIC_HISTOGRAM_COUNT];
+    uint64_t spanNs[METRIC_HISTOGRAM_COUNT];   // Time accumulated toward the next sample
+    struct MetricsThread* next;
+} MetricsThread;
+
+// Set by Metrics_RegisterThread; NULL makes every recording call a no-op
+extern _Thread_local MetricsThread* metricsThread;
+
+// Merged view of all threads
+typedef struct {
+    uint64_t counters[METRIC_COUNTER_COUNT];
+    int64_t gauges[METRIC_GAUGE_COUNT];
+    struct {
+        uint64_t buckets[METRICS_BUCKETS];
+        uint64_t count;
+        uint64_t sum;
+    } histograms[METRIC_HISTOGRAM_COUNT];
+} MetricsSnapshot;
+
+// Live server metrics
+//
+// Recording is per thread and lock-free: each thread that registers gets its
+// own block of counters and histograms, and a sample is a few relaxed
+// single-writer increments on it. Nothing is shared, so recording costs a
+// handful of nanoseconds, and threads that never register (or every thread
+// while metrics are disabled) pay one thread-local load. The exporter
+// thread merges the blocks when it is scraped or writes a snapshot.
+
+// Turn recording on for threads registered from now on (before starting them)
+void Metrics_Enable(void);
+
+// Give the calling thread its metrics block (no-op unless enabled)
+void Metrics_RegisterThread(void);
+
+// Monotonic clock in nanoseconds
+uint64_t Metrics_NowNs(void);
+
+// Single-writer increment: a plain load and store, no locked instruction
+static inline void Metrics_Add(_Atomic uint64_t* value, uint64_t amount)
+{
+    atomic_store_explicit(value, atomic_load_explicit(value, memory_order_relaxed) + amount,
+                          memory_order_relaxed);
+}
+
+static inline unsigned Metrics_BucketIndex(uint64_t ns)
+{
+    if (ns < (1u << METRICS_SUB_BITS)) {
+        return (unsigned)ns;
+    }
+    if (ns >= (1ull << METRICS_MAX_BITS)) {
+        ns = (1ull << METRICS_MAX_BITS) - 1;
+    }
+    unsigned exponent = 63u - (unsigned)__builtin_clzll(ns);
+    unsigned shift = exponent - METRICS_SUB_BITS;
+    return ((shift + 1) << METRICS_SUB_BITS) + (unsigned)(ns >> shift) - (1u << METRICS_SUB_BITS);
+}
+
+// Smallest value that lands in a bucket
+uint64_t Metrics_BucketLowerBound(unsigned index);
+
+static inline void Metrics_Count(MetricCounter counter, uint64_t amount)
+{
+    MetricsThread* thread = metricsThread;
+    if (thread) {
+        Metrics_Add(&thread->counters[counter], amount);
+    }
+}
+
+static inline void Metrics_Record(MetricHistogram histogram, uint64_t ns)
+{
+    MetricsThread* thread = metricsThread;
+    if (thread) {
+        MetricsHistogramData* data = &thread->histograms[histogram];
+        Metrics_Add(&data->buckets[Metrics_BucketIndex(ns)], 1);
+        Metrics_Add(&data->count, 1);
+        Metrics_Add(&data->sum, ns);
+    }
+}
+
+// Timing helpers: Begin returns 0 when the thread does not record, so
+// unregistered threads do not even read the clock
+static inline uint64_t Metrics_Begin(void)
+{
+    return metricsThread ? Metrics_NowNs() : 0;
+}
+
+static inline void Metrics_RecordSince(MetricHistogram histogram, uint64_t begin)
+{
+    if (begin) {
+        Metrics_Record(histogram, Metrics_NowNs() - begin);
+    }
+}
+
+// Accumulate time toward a histogram sample taken later by Metrics_RecordSpan
+// (e.g. every kernel call inside one tick)
+static inline void Metrics_AddSpan(MetricHistogram histogram, uint64_t begin)
+{
+    if (begin) {
+        metricsThread->spanNs[histogram] += Metrics_NowNs() - begin;
+    }
+}
+
+// Record the accumulated span, if any, and restart it
+static inline void Metrics_RecordSpan(MetricHistogram histogram)
+{
+    MetricsThread* thread = metricsThread;
+    if (thread && thread->spanNs[histogram]) {
+        Metrics_Record(histogram, thread->spanNs[histogram]);
+        thread->spanNs[histogram] = 0;
+    }
+}
+
+// Gauges are process-wide values set by whichever thread owns them
+void Metrics_SetGauge(MetricGauge gauge, int64_t value);
+
+// Merge every registered thread's metrics
+void Metrics_Collect(MetricsSnapshot* snapshot);
+
+// Value at a quantile (0-1) of a merged histogram, in nanoseconds
+uint64_t Metrics_Quantile(const MetricsSnapshot* snapshot, MetricHistogram histogram, double quantile);
+
+// Prometheus text exposition format (version 0.0.4)
+void Metrics_WritePrometheus(FILE* out, const MetricsSnapshot* snapshot);
+
+// Low-priority thread serving /metrics on 127.0.0.1 and writing snapshots
+typedef struct {
+    int port;                   // 0 = no HTTP endpoint
+    const char* snapshotPath;   // NULL = no file snapshots
+    double snapshotInterval;    // Seconds
+
+    int listenSocket;
+    pthread_t thread;
+    atomic_bool running;
+    atomic_ulong scrapes;
+} MetricsExporter;
+
+// Enable metrics and start exporting; false if the port cannot be bound
+bool MetricsExporter_Start(MetricsExporter* exporter, int port, const char* snapshotPath, double snapshotInterval);
+
+// Stop the thread (writing a final snapshot)
+void MetricsExporter_Stop(MetricsExporter* exporter);
+
+#endif // METRICS_H
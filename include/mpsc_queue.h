@@ -0,0 +1,73 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Intrusive lock-free multi-producer/single-consumer queue (Vyukov)
+// Any thread may push; only the owning thread pops. Push is one atomic
+// exchange; nodes are embedded in the queued objects, so nothing allocates.
+typedef struct MpscNode {
+    _Atomic(struct MpscNode*) next;
+} MpscNode;
+
+typedef struct {
+    _Alignas(64) _Atomic(MpscNode*) head;   // Producers append here
+    _Alignas(64) MpscNode* tail;            // Consumer pops here
+    MpscNode stub;
+} MpscQueue;
+
+static inline void MpscQueue_Init(MpscQueue* queue)
+{
+    atomic_init(&queue->stub.next, NULL);
+    atomic_init(&queue->head, &queue->stub);
+    queue->tail = &queue->stub;
+}
+
+static inline void MpscQueue_Push(MpscQueue* queue, MpscNode* node)
+{
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+    MpscNode* prev = atomic_exchange_explicit(&queue->head, node, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, node, memory_order_release);
+}
+
+// Returns NULL when empty, or when a producer is midway through a push
+// (the node becomes visible on a later call)
+static inline MpscNode* MpscQueue_Pop(MpscQueue* queue)
+{
+    MpscNode* tail = queue->tail;
+    MpscNode* next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+    if (tail == &queue->stub) {
+        if (!next) {
+            return NULL;
+        }
+        queue->tail = next;
+        tail = next;
+        next = atomic_load_explicit(&next->next, memory_order_acquire);
+    }
+
+    if (next) {
+        queue->tail = next;
+        return tail;
+    }
+
+    if (tail != atomic_load_explicit(&queue->head, memory_order_acquire)) {
+        return NULL;
+    }
+
+    // tail is the last node: re-insert the stub behind it so it can be popped
+    MpscQueue_Push(queue, &queue->stub);
+    next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (next) {
+        queue->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+// Recover the containing object from an embedded node
+#define MPSC_CONTAINER(node, type, member) \
+    ((type*)((char*)(node) - offsetof(type, member)))
+
+#endif // MPSC_QUEUE_H
@@ -4,22 +4,24 @@
 #include "game_board.h"
 #include <stdbool.h>
 
-// Maximum blocks that can fall simultaneously
-#define MAX_FALLING_BLOCKS BOARD_SIZE
+// Maximum blocks that can fall simultaneously on any board: a column needs
+// at least one empty cell below a block for it to fall
+#define MAX_FALLING_BLOCKS (BOARD_MAX_WIDTH * (BOARD_MAX_HEIGHT - 1))
 
-// Track a single falling block
+// Track a single falling block (coordinates fit in a byte on any board size)
 typedef struct {
-    int x, y;           // Current grid position (destination)
-    int fallDistance;   // How many cells this block fell
+    uint8_t x, y;           // Current grid position (destination)
+    uint8_t fallDistance;   // How many cells this block fell
 } FallingBlock;
 
 // Gravity animation state
 typedef struct {
     bool active;
+    uint8_t count;      // Number of falling blocks
     float progress;     // 0.0 to 1.0
     float duration;     // Animation duration in seconds
-    int count;          // Number of falling blocks
     FallingBlock blocks[MAX_FALLING_BLOCKS];
+    uint8_t slabFall[GARBAGE_MAX_SLABS];    // Rows each garbage slab fell (board->slabs order)
 } GravityAnimation;
 
 // Initialize gravity animation state
@@ -29,8 +31,32 @@ void GravityAnimation_Init(GravityAnimation* anim);
 // Moves blocks down to fill empty spaces
 // Populates the animation with falling block info
 // Returns true if any blocks moved
+// Dispatches on the board's mode; hot paths call the mode's kernel directly
 bool ApplyGravity(GameBoard* board, GravityAnimation* anim);
 
+// ApplyGravity specialized for each board geometry
+// Columns are compacted from an occupancy bitmask: BMI2 pext/pdep when the
+// build targets it, a 4096-entry table otherwise
+#define DECLARE_APPLY_GRAVITY(tag, width, height) \
+    bool ApplyGravity_##tag(GameBoard* board, GravityAnimation* anim);
+BOARD_GEOMETRIES(DECLARE_APPLY_GRAVITY)
+#undef DECLARE_APPLY_GRAVITY
+
+// Boards holding garbage slabs take a separate path in every variant: each
+// slab drops as one unit, lowest first, onto the blocks settled under it,
+// and the blocks above it land on it (the slab table is reordered by
+// bottom row)
+
+// Cell-by-cell column scan with the same results as ApplyGravity
+// Reference for benchmarks and cross-checks; not used by the game
+bool ApplyGravity_Scan(GameBoard* board, GravityAnimation* anim);
+
+// Raise the stack by one row, inserting newRow at the bottom
+// Cells of the new row that would complete a match with the blocks now
+// above or beside them are recolored deterministically (next color)
+// Returns false (board unchanged) if a block or slab is in the top row
+bool RaiseBoard(GameBoard* board, const uint16_t* newRow);
+
 // Update gravity animation (call each frame with delta time)
 // Returns true when animation completes
 bool GravityAnimation_Update(GravityAnimation* anim, float deltaTime);
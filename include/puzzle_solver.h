@@ -0,0 +1,83 @@
+#ifndef PUZZLE_SOLVER_H
+#define PUZZLE_SOLVER_H
+
+#include "game_board.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Longest solution searched for
+#define PUZZLE_MAX_MOVES 16
+
+// Moves available on any board: every horizontal pair
+#define PUZZLE_MAX_BRANCHING ((BOARD_MAX_WIDTH - 1) * BOARD_MAX_HEIGHT)
+
+// Default transposition table size (log2 of entries, 16 bytes each)
+#define PUZZLE_TABLE_BITS 20
+
+// Most worker threads one solve uses
+#define PUZZLE_MAX_THREADS 64
+
+// A swap of the blocks at (x, y) and (x+1, y)
+typedef struct {
+    uint8_t x, y;
+} PuzzleMove;
+
+// Outcome of one solve
+typedef struct {
+    bool solved;
+    int moveCount;                      // Fewest moves that clear the board
+    PuzzleMove moves[PUZZLE_MAX_MOVES];
+    uint64_t nodes;                     // Boards produced by a move and resolved
+    uint64_t tableProbes;
+    uint64_t tableHits;                 // Probes that pruned a subtree
+    double seconds;
+} PuzzleSolution;
+
+// Transposition table slot, written without locks
+// check holds key ^ data so a torn write from two racing threads fails the
+// key test and reads as a miss
+typedef struct {
+    _Atomic uint64_t check;
+    _Atomic uint64_t data;
+} PuzzleTableEntry;
+
+// Exhaustive solver for "clear the board in N moves" puzzles
+//
+// A move is SwapBlocks followed by gravity and ResolveCascade, exactly as
+// the game plays it out once everything settles. The search is IDA*: depth
+// first with an iteratively raised move bound, so the first solution is a
+// shortest one. Boards are keyed by a 64-bit hash of the grid; the shared
+// table records boards proven unsolvable within some number of moves, which
+// prunes every other move order that reaches them. Boards with a color that
+// has only one or two blocks left can never be cleared and are cut at once.
+//
+// Each bound is searched in parallel by splitting the root moves between
+// threads; the lowest-ordered root move that leads to a solution wins, so the
+// answer does not depend on thread timing. Moves are tried fewest blocks
+// left first, then most same-colored neighbors.
+typedef struct {
+    PuzzleTableEntry* table;
+    uint64_t tableMask;
+    int threads;
+} PuzzleSolver;
+
+// Allocate the table (2^tableBits entries) for up to threads workers
+// Returns false if allocation fails
+bool PuzzleSolver_Init(PuzzleSolver* solver, int tableBits, int threads);
+void PuzzleSolver_Free(PuzzleSolver* solver);
+
+// Find the shortest solution of at most maxMoves moves for a settled board
+// (no pending matches). The board is not modified.
+bool PuzzleSolver_Solve(PuzzleSolver* solver, const GameBoard* board, int maxMoves,
+                        PuzzleSolution* solution);
+
+// Build a settled board that the given number of moves clears, by stacking a
+// three-block match per move and breaking it up with a swap
+// Smaller solutions may exist; the solver finds the shortest
+void Puzzle_Generate(GameBoard* board, BoardModeId mode, int moves, uint64_t seed);
+
+// Apply one move and let the board settle; returns false if the swap is not allowed
+bool Puzzle_ApplyMove(GameBoard* board, PuzzleMove move);
+
+#endif // PUZZLE_SOLVER_H
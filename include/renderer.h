@@ -4,40 +4,40 @@
 #include "game_board.h"
 #include "game_logic.h"
 #include "physics.h"
+#include "raylib.h"
 
 // Rendering constants
 #define BLOCK_SIZE 48
 #define GRID_LINE_WIDTH 2
 
-// Board dimensions in pixels
-#define BOARD_PIXEL_WIDTH  (BOARD_WIDTH * BLOCK_SIZE)
-#define BOARD_PIXEL_HEIGHT (BOARD_HEIGHT * BLOCK_SIZE)
-
 // Window dimensions
 #define WINDOW_WIDTH  800
 #define WINDOW_HEIGHT 650
 
-// Render the game board at the specified offset
-void Renderer_DrawBoard(const GameBoard* board, int offsetX, int offsetY);
-
-// Render the game board with swap animation
-void Renderer_DrawBoardWithSwap(const GameBoard* board, int offsetX, int offsetY,
-                                 const SwapAnimation* swapAnim);
-
 // Render the game board with all animations (swap and gravity)
+// Works for any mode; dispatches to the drawer for the board's geometry
 void Renderer_DrawBoardWithAnimations(const GameBoard* board, int offsetX, int offsetY,
                                        const SwapAnimation* swapAnim,
                                        const GravityAnimation* gravityAnim);
 
+// Board drawer specialized for a mode's geometry (gravityAnim may be NULL)
+// Look it up once per match to skip the per-frame dispatch
+typedef void (*BoardDrawFn)(const GameBoard* board, int offsetX, int offsetY,
+                            const SwapAnimation* swapAnim, const GravityAnimation* gravityAnim);
+BoardDrawFn Renderer_GetBoardDrawer(BoardModeId mode);
+
+// Draw blocks with tiles from this texture (one per color, see ASSET_BLOCK_ATLAS)
+// instead of plain rectangles; pass a zeroed texture to go back
+void Renderer_SetBlockAtlas(Texture2D atlas);
+
 // Render a single block at grid position
 void Renderer_DrawBlock(BlockType type, int gridX, int gridY, int offsetX, int offsetY);
 
 // Render a single block at pixel position (for animation)
 void Renderer_DrawBlockAtPixel(BlockType type, int pixelX, int pixelY);
 
-// Calculate offset to center board in window
-int Renderer_GetCenteredOffsetX(void);
-int Renderer_GetCenteredOffsetY(void);
+// Offset that centers a mode's board in the window
+void Renderer_GetBoardOffset(BoardModeId mode, int* offsetX, int* offsetY);
 
 // Draw cursor highlight at grid position
 void Renderer_DrawCursor(int gridX, int gridY, int offsetX, int offsetY);
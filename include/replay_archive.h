@@ -0,0 +1,156 @@
+#ifndef REPLAY_ARCHIVE_H
+#define REPLAY_ARCHIVE_H
+
+#include "game_state.h"
+#include "row_queue.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Players per recorded match
+#define REPLAY_PLAYERS 2
+
+// Default ticks between keyframes; a seek simulates at most this many ticks
+#define REPLAY_KEYFRAME_INTERVAL 300
+
+// Replay archive file format (all integers little-endian)
+//
+//   File header   "PAREPLAY" magic, format version, count of match blocks
+//                 written (updated after each block is flushed)
+//   Match block   repeated; appended whole when a match ends
+//
+// A match block is self-describing so an archive can be opened by walking
+// block headers only, without reading any inputs or keyframes:
+//
+//   Block header  (REPLAY_BLOCK_HEADER_SIZE bytes) ids, seed, tick and
+//                 keyframe counts, final scores, section offsets
+//   Keyframe table  u32 offset (from block start) per keyframe
+//   Inputs        tickCount x REPLAY_PLAYERS x (x, y, flags)
+//   Checksums     u32 per tick, of both boards after the tick
+//   Final boards  BOARD_KEYFRAME_SIZE per player
+//   Keyframes     full simulation state every keyframeInterval ticks
+//
+// Keyframe k holds the state after k * keyframeInterval ticks: the packed
+// boards with their garbage slabs, animations, pending matches, queued
+// attacks and the rising-row generator, so a reader can resume simulating
+// from it exactly.
+#define REPLAY_FILE_HEADER_SIZE 16
+#define REPLAY_BLOCK_HEADER_SIZE 64
+#define REPLAY_INPUT_SIZE 3
+
+// One match as it appears in a mapped archive (points into the mapping)
+typedef struct {
+    uint32_t matchId;
+    uint64_t seed;
+    uint32_t tickCount;
+    uint32_t keyframeInterval;
+    uint32_t keyframeCount;
+    int32_t finalScores[REPLAY_PLAYERS];
+
+    const uint8_t* block;
+    const uint8_t* keyframeTable;
+    const uint8_t* inputs;
+    const uint8_t* checksums;
+    const uint8_t* finalBoards;
+    size_t blockSize;
+} ReplayView;
+
+// Read-only, memory-mapped archive
+// Opening maps the file and walks block headers to index matches; inputs and
+// keyframes are only paged in when a replay touches them.
+typedef struct {
+    int fd;
+    const uint8_t* base;
+    size_t size;
+    size_t* blockOffsets;       // Offset of each match block
+    int matchCount;             // Whole blocks found
+    int indexedCount;           // Blocks the header says were written
+    size_t tailBytes;           // Bytes after the last whole block (a torn or cut block)
+} ReplayArchive;
+
+// Whether blocks are missing or cut off: the header counts more matches
+// than were read, or a partial block trails the last whole one
+bool ReplayArchive_IsTruncated(const ReplayArchive* archive);
+
+bool ReplayArchive_Open(ReplayArchive* archive, const char* path);
+void ReplayArchive_Close(ReplayArchive* archive);
+
+// Index of the match with this id, or -1
+int ReplayArchive_Find(const ReplayArchive* archive, uint32_t matchId);
+
+// Describe match i; false if its block is malformed
+bool ReplayArchive_GetMatch(const ReplayArchive* archive, int index, ReplayView* view);
+
+// Inputs of both players for one tick
+void ReplayView_GetInputs(const ReplayView* view, uint32_t tick, GameInput inputs[REPLAY_PLAYERS]);
+
+// Checksum recorded after the given tick (tick is 0-based)
+uint32_t ReplayView_GetChecksum(const ReplayView* view, uint32_t tick);
+
+// Headless playback of both players of a match
+typedef struct {
+    GameState players[REPLAY_PLAYERS];
+    RowQueue rows[REPLAY_PLAYERS];
+    uint64_t seed;
+    uint32_t tick;              // Ticks simulated so far
+} ReplaySim;
+
+// Start from the initial state for a seed
+void ReplaySim_Init(ReplaySim* sim, uint64_t seed);
+
+// Simulate one tick with both players' inputs
+void ReplaySim_Step(ReplaySim* sim, const GameInput inputs[REPLAY_PLAYERS]);
+
+// Checksum of both boards (cells, score, combo)
+uint32_t ReplaySim_Checksum(const ReplaySim* sim);
+
+// Move to any tick of a replay: restores the nearest keyframe at or before it
+// (unless the sim is already closer) and simulates forward
+// Returns false if the tick is past the end or a keyframe is malformed
+bool ReplaySim_Seek(ReplaySim* sim, const ReplayView* view, uint32_t tick);
+
+// Appends finished matches to an archive
+//
+// The recorder is fed the inputs and resulting states of each tick by
+// whatever is simulating the match (server, tools), so recording adds no
+// simulation work. Row queues passed in must not have a worker running.
+typedef struct {
+    FILE* file;
+    uint32_t matchesWritten;    // Kept in the file header
+    uint32_t matchId;
+    uint64_t seed;
+    uint32_t keyframeInterval;
+    uint32_t tickCount;
+    bool inMatch;
+
+    // Growable staging buffers for the current match
+    uint8_t* inputs;
+    uint8_t* checksums;
+    uint8_t* keyframes;
+    uint32_t* keyframeOffsets;  // Into the keyframes buffer
+    size_t inputsCapacity, checksumsCapacity;
+    size_t keyframesSize, keyframesCapacity;
+    uint32_t keyframeCount, keyframeOffsetsCapacity;
+} ReplayWriter;
+
+// Open (or create) an archive for appending
+// A torn block at the end of an existing archive is cut off first, and the
+// header count reset to the whole blocks left; returns false for a file
+// that is not an archive
+bool ReplayWriter_Open(ReplayWriter* writer, const char* path);
+void ReplayWriter_Close(ReplayWriter* writer);
+
+// Start recording; players are the states before the first tick
+// keyframeInterval 0 selects REPLAY_KEYFRAME_INTERVAL
+void ReplayWriter_BeginMatch(ReplayWriter* writer, uint32_t matchId, uint64_t seed,
+                             uint32_t keyframeInterval, const GameState* const players[REPLAY_PLAYERS]);
+
+// Record one tick: the inputs applied and the states after applying them
+bool ReplayWriter_AddTick(ReplayWriter* writer, const GameInput inputs[REPLAY_PLAYERS],
+                          const GameState* const players[REPLAY_PLAYERS]);
+
+// Append the match block to the file
+bool ReplayWriter_EndMatch(ReplayWriter* writer, const GameState* const players[REPLAY_PLAYERS]);
+
+#endif // REPLAY_ARCHIVE_H
@@ -0,0 +1,46 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Small deterministic PRNG (xorshift64*) for anything that must be
+// reproducible from a match seed across machines (rows, garbage, replays).
+// rand() is not: its sequence differs between C libraries.
+typedef struct {
+    uint64_t state;
+} Rng;
+
+// Stream ids for the independent sequences drawn from one match seed
+#define RNG_STREAM_BOARD   0
+#define RNG_STREAM_ROWS    1
+#define RNG_STREAM_GARBAGE 2
+#define RNG_STREAM_PUZZLE  3
+
+// Seed a stream; different stream ids give independent sequences from one seed
+static inline void Rng_Seed(Rng* rng, uint64_t seed, uint64_t stream)
+{
+    // splitmix64 scramble so that nearby seeds give unrelated states
+    uint64_t z = seed + (stream + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    rng->state = z ? z : 0x9E3779B97F4A7C15ull;  // xorshift state must be non-zero
+}
+
+static inline uint32_t Rng_Next(Rng* rng)
+{
+    uint64_t x = rng->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    rng->state = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+// Uniform value in [0, bound)
+static inline uint32_t Rng_Range(Rng* rng, uint32_t bound)
+{
+    return (uint32_t)(((uint64_t)Rng_Next(rng) * bound) >> 32);
+}
+
+#endif // RNG_H
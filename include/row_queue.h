@@ -0,0 +1,106 @@
+#ifndef ROW_QUEUE_H
+#define ROW_QUEUE_H
+
+#include "game_board.h"
+#include "rng.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Ring capacities (must be powers of two)
+#define ROW_QUEUE_CAPACITY     64
+#define GARBAGE_QUEUE_CAPACITY 16
+
+// A pre-generated row waiting to rise in from the bottom of the board
+typedef struct {
+    uint16_t cells[BOARD_MAX_WIDTH];    // MAKE_BLOCK values, STATE_NORMAL (mode's width used)
+} QueuedRow;
+
+// Pre-generated placement for an incoming garbage block
+typedef struct {
+    uint8_t column;                     // Leftmost column for a partial-width block
+    uint8_t reserved;
+    uint16_t reveal[BOARD_MAX_WIDTH];   // Blocks a garbage line turns into when cleared
+} GarbageTemplate;
+
+// Seeded look-ahead queue of upcoming rows and garbage templates
+//
+// The queue is a single-producer/single-consumer lock-free ring: the
+// producer (a background worker, or the consumer itself when no worker is
+// running) generates entries in order from the seed, so the contents are
+// identical on every machine that uses the same seed. The consumer peeks
+// at the next entry and pops it with a single index bump.
+//
+// Each row is generated so it has no horizontal match and no vertical match
+// with the two rows queued before it, which sit directly above it once it
+// has risen in.
+typedef struct {
+    // Producer-owned generation state
+    uint64_t seed;
+    uint8_t width;                      // Row width and colors of the board's mode
+    uint8_t colorCount;
+    Rng rowRng;
+    Rng garbageRng;
+    uint64_t rowsGenerated;
+    uint64_t garbageGenerated;
+    uint16_t above[2][BOARD_MAX_WIDTH]; // Last two generated rows (above[1] is newest)
+
+    // Row ring (head written by producer, tail written by consumer)
+    _Alignas(64) atomic_uint rowHead;
+    _Alignas(64) atomic_uint rowTail;
+    QueuedRow rows[ROW_QUEUE_CAPACITY];
+
+    // Garbage template ring
+    _Alignas(64) atomic_uint garbageHead;
+    _Alignas(64) atomic_uint garbageTail;
+    GarbageTemplate garbage[GARBAGE_QUEUE_CAPACITY];
+
+    // Optional background refill worker
+    pthread_t worker;
+    atomic_bool workerRunning;
+    bool hasWorker;
+} RowQueue;
+
+// Initialize the queue for a match seed (no worker; refills inline)
+void RowQueue_Init(RowQueue* queue, uint64_t seed);
+
+// Same, generating rows for a mode's width and colors
+void RowQueue_InitMode(RowQueue* queue, uint64_t seed, BoardModeId mode);
+
+// Generate entries until both rings are full
+// Must only be called by one producer at a time (the worker if started)
+void RowQueue_Refill(RowQueue* queue);
+
+// Start/stop a background thread that keeps the rings topped up
+bool RowQueue_StartWorker(RowQueue* queue);
+void RowQueue_StopWorker(RowQueue* queue);
+
+// Next row to spawn; NULL only if a worker is running and has fallen behind
+const QueuedRow* RowQueue_PeekRow(RowQueue* queue);
+
+// Consume the row returned by RowQueue_PeekRow
+static inline void RowQueue_PopRow(RowQueue* queue)
+{
+    unsigned tail = atomic_load_explicit(&queue->rowTail, memory_order_relaxed);
+    atomic_store_explicit(&queue->rowTail, tail + 1, memory_order_release);
+}
+
+// Next garbage template; NULL only if a worker has fallen behind
+const GarbageTemplate* RowQueue_PeekGarbage(RowQueue* queue);
+
+// Consume the template returned by RowQueue_PeekGarbage
+static inline void RowQueue_PopGarbage(RowQueue* queue)
+{
+    unsigned tail = atomic_load_explicit(&queue->garbageTail, memory_order_relaxed);
+    atomic_store_explicit(&queue->garbageTail, tail + 1, memory_order_release);
+}
+
+// Entries consumed so far; with the seed these fully describe the queue
+unsigned RowQueue_RowsConsumed(RowQueue* queue);
+unsigned RowQueue_GarbageConsumed(RowQueue* queue);
+
+// Discard entries so a freshly initialized queue continues from a saved position
+// Call before RowQueue_StartWorker
+void RowQueue_Skip(RowQueue* queue, unsigned rows, unsigned garbage);
+
+#endif // ROW_QUEUE_H
@@ -0,0 +1,125 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "match.h"
+#include "match_arena.h"
+#include "mpsc_queue.h"
+#include "timer_wheel.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Upper bound on worker shards
+#define SCHEDULER_MAX_SHARDS 64
+
+// A room with no input for this many ticks counts as idle (cheap to migrate)
+#define ROOM_IDLE_TICKS (GAME_TICK_RATE * 2)
+
+// Ticks a late room may run back-to-back before it is resynced to the clock
+#define SCHEDULER_MAX_CATCHUP 4
+
+// How often the control thread checks shard balance (nanoseconds)
+#define SCHEDULER_REBALANCE_NS 1000000000ull
+
+// A match hosted by the scheduler
+// Owned by exactly one shard at a time; only that shard's thread touches it
+typedef struct Room {
+    Match* match;
+    TimerNode timer;            // Next simulation tick on the shard's wheel
+    MpscNode queueNode;         // Link in a shard inbox or the finished queue
+    uint64_t baseNs;            // Clock time of tick 0 (ticks are due at fixed offsets)
+    uint32_t lastInputTick;
+    uint32_t maxTicks;          // Match ends after this many ticks (0 = never)
+    int shard;
+    struct SpectatorChannel* spectators;    // Optional broadcast after each tick (NULL = none)
+} Room;
+
+// Called on the owning shard before each tick; feeds inputs into the match
+typedef void (*RoomInputHook)(Room* room, void* context);
+
+// Per-shard counters, written by the shard and readable from any thread
+typedef struct {
+    atomic_ulong ticks;         // Room ticks simulated
+    atomic_ulong overruns;      // Ticks started a full period or more late
+    atomic_ulong droppedTicks;  // Ticks skipped when a room was resynced
+    atomic_ulong busyNs;        // Time spent simulating
+    atomic_ulong migratedOut;   // Rooms handed to other shards
+    atomic_int rooms;           // Rooms currently owned (or in flight to it)
+} ShardCounters;
+
+typedef struct Scheduler Scheduler;
+
+// One worker thread and the rooms it owns
+typedef struct {
+    Scheduler* scheduler;
+    int index;
+    pthread_t thread;
+    TimerWheel wheel;           // Shard thread only
+    MpscQueue inbox;            // New and migrated rooms
+    ShardCounters counters;
+    atomic_int migrateCount;    // Idle rooms the control thread asked it to give up
+    atomic_int migrateTarget;
+} Shard;
+
+// Plain copy of a shard's counters
+typedef struct {
+    unsigned long ticks;
+    unsigned long overruns;
+    unsigned long droppedTicks;
+    unsigned long busyNs;
+    unsigned long migratedOut;
+    int rooms;
+} ShardStats;
+
+// Sharded match tick scheduler
+//
+// Rooms are spread across worker threads (optionally pinned to cores). Each
+// shard drives its rooms' fixed-rate ticks from its own timer wheel and is the
+// only thread that touches them, so the tick path takes no locks. Rooms move
+// between threads only through lock-free MPSC queues: the control thread
+// places new rooms on the least-loaded shard, takes finished rooms back to
+// release their slabs, and asks overloaded shards to hand idle rooms over.
+struct Scheduler {
+    int shardCount;
+    bool pinThreads;
+    Shard shards[SCHEDULER_MAX_SHARDS];
+
+    // Control thread state
+    MatchPool pool;
+    Room* rooms;                // Parallel to the pool's slabs
+    MpscQueue finished;         // Rooms whose match ended
+    uint32_t nextMatchId;
+    uint64_t lastRebalanceNs;
+
+    RoomInputHook inputHook;
+    void* hookContext;
+    struct StatePublisher* publisher;   // Live boards for the inspect tool (NULL = off)
+    atomic_bool running;
+};
+
+// Monotonic clock in nanoseconds
+uint64_t Scheduler_NowNs(void);
+
+bool Scheduler_Init(Scheduler* scheduler, int shardCount, int roomCapacity, bool pinThreads);
+void Scheduler_Destroy(Scheduler* scheduler);
+
+// Install the input hook; call before Scheduler_Start
+void Scheduler_SetInputHook(Scheduler* scheduler, RoomInputHook hook, void* context);
+
+// Publish every room's boards after each tick, two slots per room in pool
+// order (rooms past the segment's slots are skipped); call before Scheduler_Start
+void Scheduler_SetStatePublisher(Scheduler* scheduler, struct StatePublisher* publisher);
+
+bool Scheduler_Start(Scheduler* scheduler);
+void Scheduler_Stop(Scheduler* scheduler);
+
+// Control thread: create a room on the least-loaded shard (NULL if full)
+Room* Scheduler_CreateRoom(Scheduler* scheduler, uint64_t seed, uint32_t maxTicks);
+
+// Control thread: release finished rooms and rebalance shards periodically
+// Returns the number of rooms released
+int Scheduler_Poll(Scheduler* scheduler);
+
+void Scheduler_GetShardStats(Scheduler* scheduler, int shard, ShardStats* out);
+
+#endif // SCHEDULER_H
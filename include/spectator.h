@@ -0,0 +1,101 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include "board_codec.h"
+#include "match.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+// Ticks between keyframes; late joiners replay at most this many deltas
+#define SPECTATOR_KEYFRAME_INTERVAL 60
+
+// Largest spectator datagram
+#define SPECTATOR_PACKET_SIZE 1200
+
+// Packet buffers per channel: a keyframe, its deltas and one in flight
+#define SPECTATOR_POOL_SIZE (SPECTATOR_KEYFRAME_INTERVAL + 2)
+
+// Datagrams handed to the kernel per sendmmsg call
+#define SPECTATOR_SEND_BATCH 256
+
+// Spectator packet kinds (first byte of every datagram)
+typedef enum {
+    SPECTATOR_PACKET_KEYFRAME = 1,  // Full boards (keyframe, then slab section) of every player
+    SPECTATOR_PACKET_DELTA    = 2   // Changes since the previous tick
+} SpectatorPacketKind;
+
+// Size of the header in front of the per-player board data:
+// kind (1), match id (4), tick (4), player count (1)
+// Multi-byte fields here and in the board data are little-endian; each
+// player's delta is prefixed with its 16-bit length
+#define SPECTATOR_HEADER_SIZE 10
+
+// Pooled datagram
+// A tick's update is encoded once and the same bytes are sent to every
+// subscriber. The keyframe history owns every buffer taken from the pool;
+// sends finish before the publish that made them returns, so a buffer goes
+// back only when the history is reset for the next keyframe.
+typedef struct PacketBuffer {
+    uint16_t length;
+    struct PacketBuffer* nextFree;
+    uint8_t data[SPECTATOR_PACKET_SIZE];
+} PacketBuffer;
+
+typedef struct {
+    struct sockaddr_storage address;
+    socklen_t addressLength;
+    bool needsCatchUp;              // Joined since the last publish
+} Subscriber;
+
+// Per-channel traffic counters
+typedef struct {
+    uint64_t ticksPublished;
+    uint64_t datagramsSent;
+    uint64_t bytesSent;
+    uint64_t sendErrors;
+    uint64_t encodeBytes;           // Bytes serialized (once per tick, not per viewer)
+} SpectatorStats;
+
+// Broadcast channel for one match
+// Owned by the shard that ticks the match; not thread-safe.
+typedef struct SpectatorChannel {
+    int socket;
+    uint32_t matchId;
+
+    GameBoard lastBoards[MATCH_PLAYERS];    // Base for the next delta
+
+    PacketBuffer pool[SPECTATOR_POOL_SIZE];
+    PacketBuffer* freeList;
+    PacketBuffer* keyframe;                 // Latest keyframe (NULL before the first)
+    PacketBuffer* deltas[SPECTATOR_KEYFRAME_INTERVAL];
+    int deltaCount;                         // Deltas since the keyframe
+
+    Subscriber* subscribers;
+    int subscriberCount;
+    int subscriberCapacity;
+    int pendingCatchUp;
+
+    // sendmmsg scratch, sized to one batch
+    void* messages;
+    void* iovecs;
+
+    SpectatorStats stats;
+} SpectatorChannel;
+
+// Allocates the subscriber table and send scratch once
+bool SpectatorChannel_Init(SpectatorChannel* channel, int socket, uint32_t matchId, int capacity);
+void SpectatorChannel_Destroy(SpectatorChannel* channel);
+
+// Add or remove a viewer; new viewers get the keyframe and buffered deltas
+// at the next publish
+bool SpectatorChannel_Subscribe(SpectatorChannel* channel, const struct sockaddr* address,
+                                socklen_t addressLength);
+void SpectatorChannel_Unsubscribe(SpectatorChannel* channel, const struct sockaddr* address,
+                                  socklen_t addressLength);
+
+// Encode this tick's update once and send it to every subscriber
+void SpectatorChannel_Publish(SpectatorChannel* channel, const Match* match);
+
+#endif // SPECTATOR_H
@@ -0,0 +1,109 @@
+#ifndef STATE_PUBLISHER_H
+#define STATE_PUBLISHER_H
+
+#include "game_state.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Default POSIX shared-memory object name
+#define STATE_SHM_DEFAULT_NAME "/puzzle-attack-state"
+
+#define STATE_SHM_MAGIC 0x4d485350u    // "PSHM"
+#define STATE_SHM_VERSION 1
+
+// Boards a segment holds (the server publishes two per room, in pool order)
+#define STATE_SHM_SLOTS 64
+
+// One published board, guarded by a seqlock
+// The sequence is odd while the writer is inside; readers copy the slot and
+// retry if the sequence was odd or changed. The GameState is a raw copy:
+// its pointer members belong to the writer and must not be followed.
+typedef struct {
+    _Alignas(64) _Atomic uint32_t sequence;
+    uint32_t matchId;
+    uint32_t tick;
+    uint8_t player;
+    GameState state;
+} StateSlot;
+
+// Segment layout
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotSize;              // sizeof(StateSlot): readers built from other sources refuse
+    uint32_t slotCount;
+    int32_t writerPid;
+    char source[12];                // "client" or "server"
+    _Alignas(64) StateSlot slots[STATE_SHM_SLOTS];
+} StateSegment;
+
+// Writer side of a live state segment
+//
+// Publishing is for debugging without disturbing timing: the writer pays one
+// memcpy of the GameState and two atomic stores per board per tick, never
+// waits for readers, and callers skip it entirely (a NULL check) when the
+// option is off.
+typedef struct StatePublisher {
+    StateSegment* segment;
+    char name[64];
+} StatePublisher;
+
+// Create (or replace) the segment; false if shared memory is unavailable
+bool StatePublisher_Open(StatePublisher* publisher, const char* name, const char* source);
+
+// Unmap and remove the segment
+void StatePublisher_Close(StatePublisher* publisher);
+
+// Publish one board; each slot must have a single writer at a time
+static inline void StatePublisher_Publish(StatePublisher* publisher, int slot, uint32_t matchId,
+                                          int player, uint32_t tick, const GameState* state)
+{
+    if (slot < 0 || slot >= STATE_SHM_SLOTS) {
+        return;
+    }
+    StateSlot* target = &publisher->segment->slots[slot];
+    uint32_t sequence = atomic_load_explicit(&target->sequence, memory_order_relaxed);
+    atomic_store_explicit(&target->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    target->matchId = matchId;
+    target->tick = tick;
+    target->player = (uint8_t)player;
+    memcpy(&target->state, state, sizeof(GameState));
+
+    atomic_store_explicit(&target->sequence, sequence + 2, memory_order_release);
+}
+
+// Reader side: a read-only mapping of another process's segment
+typedef struct {
+    const StateSegment* segment;
+    size_t size;
+} StateReader;
+
+// Attach read-only; false if the segment is missing or from a different build
+bool StateReader_Open(StateReader* reader, const char* name);
+void StateReader_Close(StateReader* reader);
+
+// Outcome of reading a slot
+typedef enum {
+    STATE_READ_OK,
+    STATE_READ_EMPTY,           // Never published (or out of range)
+    STATE_READ_TORN             // Stuck mid-update: the writer died or stalled inside a publish
+} StateReadResult;
+
+// Yields a reader waits through an update before giving up on the slot;
+// the writer's pid is checked every STATE_READ_PID_CHECK of them
+#define STATE_READ_MAX_SPINS (1 << 16)
+#define STATE_READ_PID_CHECK 1024
+
+// Consistent copy of a slot
+// Spins while the writer is mid-update, which lasts one memcpy. A sequence
+// that stays odd means the writer crashed (or was stopped) inside a publish,
+// which is when someone is most likely inspecting it: that reports
+// STATE_READ_TORN rather than waiting forever.
+StateReadResult StateReader_Read(const StateReader* reader, int slot, StateSlot* out);
+
+#endif // STATE_PUBLISHER_H
@@ -0,0 +1,51 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Hierarchical timer wheel with 1 ms resolution
+// Level 0 has 256 one-millisecond slots; each higher level has 64 slots
+// covering 64 times the range of the level below (~18.6 hours in total).
+// Timers far in the future sit in coarse slots and cascade down as the
+// wheel turns, so insert, cancel and per-tick expiry are O(1).
+#define TIMER_WHEEL_L0_BITS  8
+#define TIMER_WHEEL_LN_BITS  6
+#define TIMER_WHEEL_L0_SLOTS (1 << TIMER_WHEEL_L0_BITS)
+#define TIMER_WHEEL_LN_SLOTS (1 << TIMER_WHEEL_LN_BITS)
+#define TIMER_WHEEL_UPPER_LEVELS 3
+
+// Intrusive timer node; embed it in the object being scheduled
+typedef struct TimerNode {
+    struct TimerNode* next;
+    struct TimerNode** pprev;   // NULL when not scheduled
+    uint64_t expires;           // Absolute time in ms
+} TimerNode;
+
+typedef struct {
+    uint64_t now;               // Next millisecond to be processed
+    int count;                  // Scheduled timers
+    TimerNode* level0[TIMER_WHEEL_L0_SLOTS];
+    TimerNode* levels[TIMER_WHEEL_UPPER_LEVELS][TIMER_WHEEL_LN_SLOTS];
+} TimerWheel;
+
+// Callback for an expired timer; it may reschedule the node
+typedef void (*TimerCallback)(TimerNode* node, void* context);
+
+void TimerWheel_Init(TimerWheel* wheel, uint64_t nowMs);
+
+// Schedule a node at an absolute time; times in the past fire on the next advance
+void TimerWheel_Schedule(TimerWheel* wheel, TimerNode* node, uint64_t expiresMs);
+
+// Unschedule a node (no-op if it is not scheduled)
+void TimerWheel_Cancel(TimerWheel* wheel, TimerNode* node);
+
+static inline bool TimerNode_IsScheduled(const TimerNode* node)
+{
+    return node->pprev != 0;
+}
+
+// Fire every timer due at or before nowMs; returns the number fired
+int TimerWheel_Advance(TimerWheel* wheel, uint64_t nowMs, TimerCallback callback, void* context);
+
+#endif // TIMER_WHEEL_H
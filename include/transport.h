@@ -0,0 +1,190 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+// Largest datagram the transport emits
+#define TRANSPORT_MTU 1200
+
+// Reliable messages are split into fragments of at most this many bytes;
+// each fragment occupies one window slot
+#define TRANSPORT_FRAGMENT_SIZE 1024
+#define TRANSPORT_MAX_FRAGMENTS 32
+#define TRANSPORT_MAX_MESSAGE (TRANSPORT_FRAGMENT_SIZE * TRANSPORT_MAX_FRAGMENTS)
+
+// Reliable send/receive window in fragments (power of two)
+// At most TRANSPORT_WINDOW - TRANSPORT_MAX_FRAGMENTS are in flight
+#define TRANSPORT_WINDOW 128
+
+// Sent-packet history used to resolve acks (power of two, >= 33)
+#define TRANSPORT_PACKET_HISTORY 256
+
+// Reliable fragments tracked per datagram
+#define TRANSPORT_MAX_PACKET_FRAGMENTS 64
+
+// Latest-wins unreliable channels (e.g. state deltas per player)
+#define TRANSPORT_UNRELIABLE_CHANNELS 4
+#define TRANSPORT_MAX_UNRELIABLE 1000
+
+// Datagrams sent per Transport_Update at most
+#define TRANSPORT_MAX_DATAGRAMS_PER_UPDATE 32
+
+// Datagram header: magic (1), flags (1), sequence (2), ack (2), ack bits (4)
+#define TRANSPORT_HEADER_SIZE 10
+
+typedef enum {
+    TRANSPORT_MESSAGE_RELIABLE,     // Delivered once, in send order
+    TRANSPORT_MESSAGE_UNRELIABLE    // May be lost; stale ones are dropped
+} TransportMessageKind;
+
+// Hands a finished datagram to the link below (socket, emulator, ...)
+typedef void (*TransportSendFn)(void* context, const uint8_t* data, size_t length);
+
+// Receives messages as they are delivered; data is only valid during the call
+// channel is 0 for reliable messages
+typedef void (*TransportMessageFn)(void* context, TransportMessageKind kind, int channel,
+                                   const uint8_t* data, size_t length);
+
+// One fragment of a reliable message (a window slot)
+typedef struct {
+    uint16_t sequence;
+    uint8_t fragmentIndex;
+    uint8_t fragmentCount;
+    uint16_t length;
+    bool used;                      // Send: queued, not yet acked; receive: arrived
+    double lastSent;                // Send only (negative = never sent)
+    uint8_t data[TRANSPORT_FRAGMENT_SIZE];
+} TransportSlot;
+
+// What one sent datagram carried, so its ack can release the fragments
+typedef struct {
+    uint16_t sequence;
+    bool valid;
+    bool acked;
+    double sentTime;
+    uint8_t fragmentCount;
+    uint16_t fragments[TRANSPORT_MAX_PACKET_FRAGMENTS];
+} TransportPacketRecord;
+
+typedef struct {
+    uint64_t packetsSent;
+    uint64_t packetsReceived;
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    uint64_t packetsAcked;
+    uint64_t packetsLost;           // Dropped from history without an ack
+    uint64_t duplicates;            // Datagrams received twice
+    uint64_t resends;               // Reliable fragments sent again
+    uint64_t reliableDelivered;
+    uint64_t unreliableDelivered;
+    uint64_t staleDropped;          // Unreliable messages older than the last delivered
+} TransportStats;
+
+// One end of a connection
+//
+// Every datagram carries a sequence number plus the latest sequence received
+// from the peer and a 32-bit bitfield acking the 32 before it, so each packet
+// acknowledges up to 33 of the peer's packets. Reliable messages are split into
+// fragments held in a fixed window until a packet carrying them is acked, and
+// are resent after a timeout derived from the RTT estimate. Unreliable messages
+// are latest-wins per channel: queuing a new one replaces an unsent older one,
+// and the receiver discards any older than what it already delivered.
+//
+// Queued messages are coalesced into as few MTU-sized datagrams as possible on
+// Transport_Update. The send and receive windows and the reassembly buffer are
+// one allocation made by Transport_Init, about 292 KB per connection
+// (2 * TRANSPORT_WINDOW slots of ~1 KB plus TRANSPORT_MAX_MESSAGE); the struct
+// itself is about 42 KB, mostly the sent-packet history. Nothing is allocated
+// per packet. The transport never touches a socket: datagrams leave through
+// the send callback and arrive through Transport_Receive.
+typedef struct {
+    TransportSendFn send;
+    void* sendContext;
+    TransportMessageFn deliver;
+    void* deliverContext;
+
+    // Datagram sequencing and acks
+    uint16_t localSequence;         // Next datagram to send
+    uint16_t remoteSequence;        // Newest datagram received
+    uint32_t remoteAckBits;         // Which of the 32 before remoteSequence arrived
+    bool receivedAny;
+    bool ackPending;                // Received something not yet acked back
+    TransportPacketRecord sentPackets[TRANSPORT_PACKET_HISTORY];
+
+    // Reliable send window
+    uint16_t sendOldest;            // Oldest unacked fragment
+    uint16_t sendNext;              // Next fragment sequence to assign
+    TransportSlot* sendSlots;       // TRANSPORT_WINDOW slots
+
+    // Reliable receive window
+    uint16_t receiveNext;           // Next fragment sequence to deliver
+    TransportSlot* receiveSlots;    // TRANSPORT_WINDOW slots
+    uint8_t* reassembly;            // TRANSPORT_MAX_MESSAGE bytes
+
+    // Latest-wins unreliable channels
+    uint16_t unreliableStamp[TRANSPORT_UNRELIABLE_CHANNELS];
+    bool unreliablePending[TRANSPORT_UNRELIABLE_CHANNELS];
+    uint16_t unreliableLength[TRANSPORT_UNRELIABLE_CHANNELS];
+    uint8_t unreliableData[TRANSPORT_UNRELIABLE_CHANNELS][TRANSPORT_MAX_UNRELIABLE];
+    uint16_t receivedStamp[TRANSPORT_UNRELIABLE_CHANNELS];
+    bool receivedOnChannel[TRANSPORT_UNRELIABLE_CHANNELS];
+
+    // Round-trip estimate from acks (seconds)
+    double rtt;                     // Smoothed
+    double jitter;                  // Smoothed mean deviation
+    bool rttValid;
+
+    TransportStats stats;
+} Transport;
+
+// Allocates the windows; returns false if out of memory
+bool Transport_Init(Transport* transport, TransportSendFn send, void* sendContext,
+                    TransportMessageFn deliver, void* deliverContext);
+
+// Frees the windows; the transport must be initialized again before reuse
+void Transport_Destroy(Transport* transport);
+
+// Queue a reliable, ordered message (fragmented if larger than a fragment)
+// Returns false if it is too large or the window has no room; try again later
+bool Transport_SendReliable(Transport* transport, const void* data, size_t length);
+
+// Queue a latest-wins message, replacing any unsent one on the channel
+bool Transport_SendUnreliable(Transport* transport, int channel, const void* data, size_t length);
+
+// Reliable fragments that can still be queued
+int Transport_ReliableCapacity(const Transport* transport);
+
+// Process one incoming datagram; delivers any messages it completes
+void Transport_Receive(Transport* transport, const uint8_t* data, size_t length, double now);
+
+// Coalesce due messages (new, resends, latest unreliable) and acks into
+// datagrams and pass them to the send callback
+void Transport_Update(Transport* transport, double now);
+
+// Time after which an unacked fragment is resent
+double Transport_ResendTimeout(const Transport* transport);
+
+// Connected UDP peer usable as the transport's send callback
+typedef struct {
+    int socket;
+    struct sockaddr_storage peer;
+    socklen_t peerLength;
+} UdpLink;
+
+// Open a non-blocking UDP socket bound to the address (port 0 = any)
+// Returns the socket, or -1
+int UdpLink_OpenSocket(const struct sockaddr* address, socklen_t addressLength);
+
+void UdpLink_Init(UdpLink* link, int socket, const struct sockaddr* peer, socklen_t peerLength);
+
+// TransportSendFn for a UdpLink context
+void UdpLink_Send(void* link, const uint8_t* data, size_t length);
+
+// Feed every datagram waiting on the link's socket into the transport
+// Returns the number of datagrams read
+int UdpLink_Poll(UdpLink* link, Transport* transport, double now);
+
+#endif // TRANSPORT_H
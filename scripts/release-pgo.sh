@@ -0,0 +1,104 @@
+#!/bin/sh
+# Helpers for `make release-pgo`
+#
+#   release-pgo.sh train DIR             Run the training workload on DIR's instrumented binaries
+#   release-pgo.sh compare BASE PGO      Run the benchmark suite on both builds and report speedups
+#
+# Training exercises the shared simulation the way a server does: bot
+# matches with cascades recorded and re-simulated, dense post-clear boards,
+# rollback netcode, the sharded scheduler, spectators, the matchmaker, the
+# puzzle solver and the mixer.
+# The benchmarks use different inputs so the profile is not scored on the
+# exact runs it was trained on.
+
+set -e
+
+WORK="${TMPDIR:-/tmp}/puzzle-attack-pgo.$$"
+trap 'rm -rf "$WORK"' EXIT
+mkdir -p "$WORK"
+
+train() {
+    dir="$1"
+    echo "== training $dir"
+    "$dir/tools/replay" record "$WORK/train.par" --matches 8 --minutes 5 > /dev/null
+    "$dir/tools/verify" --quiet --threads 2 "$WORK/train.par" > /dev/null
+    "$dir/tools/replay" seek "$WORK/train.par" --seeks 2000 > /dev/null
+    "$dir/tools/boardbench" --rounds 100 --seed 7 > /dev/null
+    "$dir/tools/puzzle" bench --moves 4 --count 40 --seed 11 > /dev/null
+    "$dir/tools/netbench" scenarios --seconds 20 --seed 3 > /dev/null
+    "$dir/puzzle-attack-server" --bench-scheduler --rooms 2000 --seconds 2 --no-pin > /dev/null
+    "$dir/puzzle-attack-server" --bench-spectators 200 --seconds 2 > /dev/null
+    "$dir/puzzle-attack-server" --bench-matchmaker 10000 --seconds 1 > /dev/null
+    "$dir/tools/audiobench" bench --seconds 20 --seed 5 > /dev/null
+    echo "== profile written"
+}
+
+# Best of five runs of a command, reduced to one number by an awk program
+# (the highest, or the lowest when sense is "lower")
+best() {
+    program="$1"
+    shift
+    sense="$1"
+    shift
+    result=""
+    for run in 1 2 3 4 5; do
+        value=$("$@" 2>/dev/null | awk "$program")
+        if [ -z "$result" ]; then
+            result="$value"
+        else
+            result=$(awk -v a="$result" -v b="$value" -v s="$sense" \
+                'BEGIN { if ((s == "lower") == (b < a)) print b; else print a }')
+        fi
+    done
+    echo "$result"
+}
+
+# name, sense, awk program, command (run with BIN set to each build)
+row() {
+    name="$1"
+    sense="$2"
+    program="$3"
+    shift 3
+    base=$(BIN="$BASE" best "$program" "$sense" sh -c "$*")
+    pgo=$(BIN="$PGO" best "$program" "$sense" sh -c "$*")
+    awk -v n="$name" -v a="$base" -v b="$pgo" -v s="$sense" 'BEGIN {
+        speedup = (s == "lower") ? a / b : b / a
+        printf "%-34s %12.2f %12.2f %8.2fx\n", n, a, b, speedup
+        print speedup >> "'"$WORK"'/speedups"
+    }'
+}
+
+compare() {
+    BASE="$1"
+    PGO="$2"
+    export BASE PGO WORK
+    "$BASE/tools/replay" record "$WORK/bench.par" --matches 16 --minutes 10 > /dev/null
+
+    printf "%-34s %12s %12s %9s\n" "benchmark" "-O2" "PGO+LTO" "speedup"
+    row "verify replays (M ticks/s)" higher '/M ticks\/s/ { print $(NF-2) }' \
+        '"$BIN/tools/verify" --quiet --threads 1 "$WORK/bench.par"'
+    row "gravity via GameBoard_GetCell (ns)" lower '$1 == "classic" { print $3 }' \
+        '"$BIN/tools/boardbench" --rounds 300 --seed 1 classic'
+    row "gravity kernel, classic (ns)" lower '$1 == "classic" { print $4 }' \
+        '"$BIN/tools/boardbench" --rounds 300 --seed 1 classic'
+    row "detect matches, classic (ns)" lower '$1 == "classic" { print $7 }' \
+        '"$BIN/tools/boardbench" --rounds 300 --seed 1 classic'
+    row "detect matches, wide (ns)" lower '$1 == "wide" { print $7 }' \
+        '"$BIN/tools/boardbench" --rounds 300 --seed 1 wide'
+    row "puzzle solver (M nodes/s)" higher '/nodes\/s/ { print $(NF-6) }' \
+        '"$BIN/tools/puzzle" bench --moves 5 --count 30 --threads 1'
+    row "mixer callback, average (us)" lower '/mix cost/ { print $6 }' \
+        '"$BIN/tools/audiobench" bench --seconds 60'
+    row "scheduler, 5000 rooms (busy %)" lower '$1 == "0" { print $7 }' \
+        '"$BIN/puzzle-attack-server" --bench-scheduler --rooms 5000 --seconds 2 --no-pin --shards 1'
+
+    awk '{ log_sum += log($1); n++ } END {
+        if (n) printf "%-34s %34.2fx\n", "geometric mean", exp(log_sum / n)
+    }' "$WORK/speedups"
+}
+
+case "$1" in
+    train) train "$2" ;;
+    compare) compare "$2" "$3" ;;
+    *) echo "usage: $0 train DIR | compare BASE_DIR PGO_DIR" >&2; exit 1 ;;
+esac
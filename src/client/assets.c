@@ -0,0 +1,185 @@
+#define _POSIX_C_SOURCE 200809L
+#include "assets.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+_Static_assert(ASSET_PIXEL_FORMAT_RGBA8 == PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, "bundle pixel format");
+
+// How often the loader checks the playhead
+#define LOADER_INTERVAL_NS 50000000L
+
+bool Assets_Load(Assets* assets, const char* path)
+{
+    memset(assets, 0, sizeof(*assets));
+    if (!AssetBundle_Open(&assets->bundle, path)) {
+        return false;
+    }
+    assets->loaded = true;
+
+    Image atlas;
+    if (Assets_GetImage(assets, ASSET_BLOCK_ATLAS, &atlas)) {
+        assets->blockAtlas = LoadTextureFromImage(atlas);
+    }
+    return true;
+}
+
+void Assets_Unload(Assets* assets)
+{
+    if (assets->blockAtlas.id != 0) {
+        UnloadTexture(assets->blockAtlas);
+    }
+    if (assets->loaded) {
+        AssetBundle_Close(&assets->bundle);
+    }
+    memset(assets, 0, sizeof(*assets));
+}
+
+bool Assets_GetWave(const Assets* assets, const char* name, Wave* wave)
+{
+    const AssetEntry* entry = assets->loaded ? AssetBundle_Find(&assets->bundle, name) : NULL;
+    if (!entry || (entry->kind != ASSET_KIND_WAVE && entry->kind != ASSET_KIND_MUSIC)) {
+        return false;
+    }
+
+    unsigned frameBytes = entry->audio.sampleSize / 8 * entry->audio.channels;
+    wave->frameCount = frameBytes ? (unsigned)(entry->size / frameBytes) : 0;
+    wave->sampleRate = entry->audio.sampleRate;
+    wave->sampleSize = entry->audio.sampleSize;
+    wave->channels = entry->audio.channels;
+    wave->data = (void*)AssetBundle_Data(&assets->bundle, entry);
+    return true;
+}
+
+bool Assets_GetImage(const Assets* assets, const char* name, Image* image)
+{
+    const AssetEntry* entry = assets->loaded ? AssetBundle_Find(&assets->bundle, name) : NULL;
+    if (!entry || entry->kind != ASSET_KIND_IMAGE) {
+        return false;
+    }
+
+    image->data = (void*)AssetBundle_Data(&assets->bundle, entry);
+    image->width = (int)entry->image.width;
+    image->height = (int)entry->image.height;
+    image->mipmaps = 1;
+    image->format = (int)entry->image.pixelFormat;
+    return true;
+}
+
+const AssetEntry* Assets_FindMusic(const Assets* assets)
+{
+    for (uint32_t i = 0; assets->loaded && i < assets->bundle.entryCount; i++) {
+        if (assets->bundle.entries[i].kind == ASSET_KIND_MUSIC) {
+            return &assets->bundle.entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Touch every page in [offset, offset + length) of the track, wrapping at its end
+static void PageIn(const MusicStreamer* music, size_t offset, size_t length)
+{
+    const volatile uint8_t* data = AssetBundle_Data(music->bundle, music->entry);
+    size_t size = music->entry->size;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+    while (length > 0) {
+        size_t span = size - offset < length ? size - offset : length;
+        AssetBundle_Prefetch(music->bundle, music->entry, offset, span);
+        for (size_t at = offset; at < offset + span; at += page) {
+            (void)data[at];
+        }
+        length -= span;
+        offset = 0;
+    }
+}
+
+static void* MusicLoader(void* arg)
+{
+    MusicStreamer* music = (MusicStreamer*)arg;
+    size_t lookahead = (size_t)MUSIC_LOOKAHEAD_SECONDS * music->entry->audio.sampleRate * music->frameBytes;
+    if (lookahead > music->entry->size) {
+        lookahead = music->entry->size;
+    }
+
+    struct timespec interval = { 0, LOADER_INTERVAL_NS };
+    while (atomic_load_explicit(&music->running, memory_order_acquire)) {
+        PageIn(music, atomic_load_explicit(&music->playhead, memory_order_relaxed), lookahead);
+        nanosleep(&interval, NULL);
+    }
+    return NULL;
+}
+
+bool MusicStreamer_Start(MusicStreamer* music, const Assets* assets, const AssetEntry* entry)
+{
+    memset(music, 0, sizeof(*music));
+    music->frameBytes = entry->audio.sampleSize / 8 * entry->audio.channels;
+    if (!IsAudioDeviceReady() || entry->kind != ASSET_KIND_MUSIC || music->frameBytes == 0 ||
+        entry->size < MUSIC_CHUNK_FRAMES * music->frameBytes) {
+        return false;
+    }
+    music->bundle = &assets->bundle;
+    music->entry = entry;
+    music->wrapChunk = malloc(MUSIC_CHUNK_FRAMES * music->frameBytes);
+    if (!music->wrapChunk) {
+        return false;
+    }
+
+    // The first chunks are fed right away; page them in before starting
+    PageIn(music, 0, 2 * MUSIC_CHUNK_FRAMES * music->frameBytes);
+    atomic_init(&music->playhead, 0);
+    atomic_init(&music->running, true);
+    if (pthread_create(&music->loader, NULL, MusicLoader, music) != 0) {
+        free(music->wrapChunk);
+        return false;
+    }
+
+    SetAudioStreamBufferSizeDefault(MUSIC_CHUNK_FRAMES);
+    music->stream = LoadAudioStream(entry->audio.sampleRate, entry->audio.sampleSize, entry->audio.channels);
+    music->active = true;
+    MusicStreamer_Update(music);
+    PlayAudioStream(music->stream);
+    return true;
+}
+
+void MusicStreamer_Update(MusicStreamer* music)
+{
+    if (!music->active) {
+        return;
+    }
+
+    const uint8_t* data = AssetBundle_Data(music->bundle, music->entry);
+    size_t size = music->entry->size - music->entry->size % music->frameBytes;
+    size_t chunk = MUSIC_CHUNK_FRAMES * music->frameBytes;
+
+    while (IsAudioStreamProcessed(music->stream)) {
+        if (size - music->cursor >= chunk) {
+            UpdateAudioStream(music->stream, data + music->cursor, MUSIC_CHUNK_FRAMES);
+            music->cursor += chunk;
+        } else {
+            // Only the chunk spanning the loop point is copied
+            size_t tail = size - music->cursor;
+            memcpy(music->wrapChunk, data + music->cursor, tail);
+            memcpy(music->wrapChunk + tail, data, chunk - tail);
+            UpdateAudioStream(music->stream, music->wrapChunk, MUSIC_CHUNK_FRAMES);
+            music->cursor = chunk - tail;
+        }
+        if (music->cursor == size) {
+            music->cursor = 0;
+        }
+    }
+    atomic_store_explicit(&music->playhead, music->cursor, memory_order_relaxed);
+}
+
+void MusicStreamer_Stop(MusicStreamer* music)
+{
+    if (!music->active) {
+        return;
+    }
+    atomic_store_explicit(&music->running, false, memory_order_release);
+    pthread_join(music->loader, NULL);
+    UnloadAudioStream(music->stream);
+    free(music->wrapChunk);
+    memset(music, 0, sizeof(*music));
+}
@@ -0,0 +1,172 @@
+#define _POSIX_C_SOURCE 200809L
+#include "audio.h"
+#include "game_state.h"
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+static const struct {
+    const char* asset;
+    uint8_t maxVoices;
+} SOUNDS[AUDIO_SOUND_COUNT] = {
+#define AUDIO_SOUND_ENTRY(name, asset, voices) { asset, voices },
+    AUDIO_SOUNDS(AUDIO_SOUND_ENTRY)
+#undef AUDIO_SOUND_ENTRY
+};
+
+#define BLOCK_NANOS ((uint64_t)AUDIO_MIX_BLOCK_FRAMES * 1000000000ull / AUDIO_MIX_RATE)
+
+static uint64_t NowNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void SleepNanos(uint64_t nanos)
+{
+    struct timespec ts = { (time_t)(nanos / 1000000000ull), (long)(nanos % 1000000000ull) };
+    nanosleep(&ts, NULL);
+}
+
+static void* MixerThread(void* arg)
+{
+    Audio* audio = (Audio*)arg;
+    static float block[AUDIO_MIX_BLOCK_FRAMES * AUDIO_MIX_CHANNELS];
+
+    uint64_t next = NowNanos();
+    while (atomic_load_explicit(&audio->running, memory_order_acquire)) {
+        if (audio->streaming) {
+            // Refill whichever stream buffers the device has finished with
+            while (IsAudioStreamProcessed(audio->stream)) {
+                AudioMixer_Mix(&audio->mixer, block, AUDIO_MIX_BLOCK_FRAMES, NowNanos());
+                UpdateAudioStream(audio->stream, block, AUDIO_MIX_BLOCK_FRAMES);
+            }
+            SleepNanos(BLOCK_NANOS / 4);
+        } else {
+            // No device: consume blocks in real time and drop them
+            AudioMixer_Mix(&audio->mixer, block, AUDIO_MIX_BLOCK_FRAMES, NowNanos());
+            next += BLOCK_NANOS;
+            uint64_t now = NowNanos();
+            if (next > now) {
+                SleepNanos(next - now);
+            } else {
+                next = now;
+            }
+        }
+    }
+    return NULL;
+}
+
+bool Audio_Start(Audio* audio, const Assets* assets)
+{
+    memset(audio, 0, sizeof(*audio));
+    AudioMixer_Init(&audio->mixer);
+
+    // Samples play straight from the bundle mapping; missing ones stay silent
+    for (int i = 0; i < AUDIO_SOUND_COUNT; i++) {
+        AudioSample sample = { 0 };
+        Wave wave;
+        if (Assets_GetWave(assets, SOUNDS[i].asset, &wave) && wave.channels >= 1 && wave.channels <= 2) {
+            sample.data = wave.data;
+            sample.frameCount = wave.frameCount;
+            sample.sampleRate = wave.sampleRate;
+            sample.sampleSize = (uint8_t)wave.sampleSize;
+            sample.channels = (uint8_t)wave.channels;
+            sample.maxVoices = SOUNDS[i].maxVoices;
+        }
+        AudioMixer_AddSample(&audio->mixer, &sample);
+    }
+
+    audio->streaming = IsAudioDeviceReady();
+    if (audio->streaming) {
+        SetAudioStreamBufferSizeDefault(AUDIO_MIX_BLOCK_FRAMES);
+        audio->stream = LoadAudioStream(AUDIO_MIX_RATE, 32, AUDIO_MIX_CHANNELS);
+        audio->streaming = IsAudioStreamReady(audio->stream);
+    }
+    if (!audio->streaming) {
+        TraceLog(LOG_WARNING, "No audio device, mixing sound effects without output");
+    }
+
+    atomic_init(&audio->running, true);
+    if (pthread_create(&audio->thread, NULL, MixerThread, audio) != 0) {
+        if (audio->streaming) {
+            UnloadAudioStream(audio->stream);
+        }
+        return false;
+    }
+    if (audio->streaming) {
+        PlayAudioStream(audio->stream);
+    }
+    audio->active = true;
+    return true;
+}
+
+void Audio_Play(Audio* audio, AudioSoundId sound, double time, float volume, float pan, float rate)
+{
+    if (!audio->active) {
+        return;
+    }
+    AudioEvent event = {
+        .time = (uint64_t)(time * 1e9),
+        .sample = (uint8_t)sound,
+        .volume = (uint8_t)(volume * 255.0f),
+        .pan = (int8_t)(pan * 127.0f),
+        .rate = (uint32_t)(rate * AUDIO_RATE_ONE),
+    };
+    AudioMixer_Play(&audio->mixer, &event);
+}
+
+void Audio_PlayGameEvents(Audio* audio, int events, double time)
+{
+    if (events & GAME_EVENT_SWAP) {
+        Audio_Play(audio, AUDIO_SOUND_SWAP, time, 0.6f, 0.0f, 1.0f);
+    }
+    if (events & GAME_EVENT_LAND) {
+        Audio_Play(audio, AUDIO_SOUND_LAND, time, 0.5f, 0.0f, 1.0f);
+    }
+    if (events & GAME_EVENT_MATCH) {
+        // A match right after a landing continues a cascade; each link is a semitone higher
+        if (events & GAME_EVENT_LAND) {
+            audio->chain++;
+            Audio_Play(audio, AUDIO_SOUND_CHAIN, time, 0.8f, 0.0f, powf(2.0f, (audio->chain - 1) / 12.0f));
+        } else {
+            audio->chain = 0;
+        }
+    }
+    if (events & GAME_EVENT_CLEAR) {
+        Audio_Play(audio, AUDIO_SOUND_CLEAR, time, 0.8f, 0.0f, 1.0f);
+    }
+}
+
+void Audio_LogStats(const Audio* audio)
+{
+    const AudioMixerStats* stats = &audio->mixer.stats;
+    uint64_t callbacks = atomic_load_explicit(&stats->callbacks, memory_order_relaxed);
+    if (callbacks == 0) {
+        return;
+    }
+    TraceLog(LOG_INFO, "Audio mixer: %llu callbacks, %.2f us avg, %.2f us max (block %.2f ms); "
+             "%llu sounds, %llu late, %llu voices stolen, %u queue drops",
+             (unsigned long long)callbacks,
+             atomic_load_explicit(&stats->mixNanos, memory_order_relaxed) / 1000.0 / callbacks,
+             atomic_load_explicit(&stats->mixNanosMax, memory_order_relaxed) / 1000.0,
+             BLOCK_NANOS / 1e6,
+             (unsigned long long)atomic_load_explicit(&stats->eventsStarted, memory_order_relaxed),
+             (unsigned long long)atomic_load_explicit(&stats->eventsLate, memory_order_relaxed),
+             (unsigned long long)atomic_load_explicit(&stats->voicesStolen, memory_order_relaxed),
+             audio->mixer.events.dropped);
+}
+
+void Audio_Stop(Audio* audio)
+{
+    if (!audio->active) {
+        return;
+    }
+    atomic_store_explicit(&audio->running, false, memory_order_release);
+    pthread_join(audio->thread, NULL);
+    if (audio->streaming) {
+        UnloadAudioStream(audio->stream);
+    }
+    audio->active = false;
+}
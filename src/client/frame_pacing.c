@@ -0,0 +1,138 @@
+#include "frame_pacing.h"
+#include "raylib.h"
+
+// Smoothing factors for the running estimates
+static const double WORK_AVG_WEIGHT = 0.1;
+static const double LATENCY_AVG_WEIGHT = 0.05;
+static const double WORK_PEAK_DECAY = 0.98;
+static const double MARGIN_DECAY = 0.01;
+
+// A present this many periods after the previous one missed its vblank
+static const double MISSED_FRAME_RATIO = 1.5;
+
+void FramePacing_Init(FramePacing* pacing, FramePacingMode mode, int targetFPS,
+                      bool vsync, const char* csvPath)
+{
+    pacing->mode = mode;
+    // Low-latency pacing targets the vertical blank, so it needs the swap to block on it
+    pacing->vsync = vsync || mode == FRAME_PACING_LOW_LATENCY;
+    pacing->period = 1.0 / (double)targetFPS;
+
+    pacing->lastPresent = 0.0;
+    pacing->sampleTime = 0.0;
+    pacing->drawStart = 0.0;
+    pacing->sleepTime = 0.0;
+
+    pacing->work = 0.0;
+    pacing->workAvg = 0.0;
+    pacing->workPeak = 0.0;
+    pacing->margin = FRAME_PACING_MAX_MARGIN / 2.0;
+
+    pacing->latency = 0.0;
+    pacing->latencyAvg = 0.0;
+    pacing->frame = 0;
+    pacing->missedFrames = 0;
+
+    pacing->log = NULL;
+    if (csvPath) {
+        pacing->log = fopen(csvPath, "w");
+        if (pacing->log) {
+            fprintf(pacing->log, "frame,mode,sleep_ms,work_ms,margin_ms,interval_ms,latency_ms\n");
+        }
+    }
+
+    if (pacing->vsync) {
+        SetConfigFlags(FLAG_VSYNC_HINT);
+    }
+}
+
+void FramePacing_Start(FramePacing* pacing)
+{
+    // In low-latency mode we do our own sleeping before the input sample
+    SetTargetFPS(pacing->mode == FRAME_PACING_DEFAULT ? (int)(1.0 / pacing->period + 0.5) : 0);
+    pacing->lastPresent = GetTime();
+}
+
+void FramePacing_BeginFrame(FramePacing* pacing)
+{
+    if (pacing->mode == FRAME_PACING_LOW_LATENCY) {
+        // Wake up just early enough for the update, draw and swap to make the next vblank
+        double deadline = pacing->lastPresent + pacing->period;
+        double wake = deadline - pacing->workPeak - pacing->margin;
+        double now = GetTime();
+
+        pacing->sleepTime = wake - now;
+        if (pacing->sleepTime > 0.0) {
+            WaitTime(pacing->sleepTime);
+        } else {
+            pacing->sleepTime = 0.0;
+        }
+
+        PollInputEvents();
+        pacing->sampleTime = GetTime();
+    } else {
+        // raylib polled input at the end of the previous EndDrawing
+        pacing->sleepTime = 0.0;
+        pacing->sampleTime = pacing->lastPresent;
+    }
+
+    pacing->drawStart = GetTime();
+}
+
+void FramePacing_BeforePresent(FramePacing* pacing)
+{
+    double work = GetTime() - pacing->drawStart;
+
+    pacing->work = work;
+    pacing->workAvg += (work - pacing->workAvg) * WORK_AVG_WEIGHT;
+    pacing->workPeak *= WORK_PEAK_DECAY;
+    if (work > pacing->workPeak) {
+        pacing->workPeak = work;
+    }
+}
+
+void FramePacing_EndFrame(FramePacing* pacing)
+{
+    double present = GetTime();
+    double interval = present - pacing->lastPresent;
+
+    pacing->latency = present - pacing->sampleTime;
+    if (pacing->frame == 0) {
+        pacing->latencyAvg = pacing->latency;
+    } else {
+        pacing->latencyAvg += (pacing->latency - pacing->latencyAvg) * LATENCY_AVG_WEIGHT;
+    }
+
+    // Adapt the safety margin: back off sharply on a missed vblank, creep back otherwise
+    if (pacing->frame > 0 && interval > pacing->period * MISSED_FRAME_RATIO) {
+        pacing->missedFrames++;
+        pacing->margin *= 2.0;
+        if (pacing->margin > FRAME_PACING_MAX_MARGIN) {
+            pacing->margin = FRAME_PACING_MAX_MARGIN;
+        }
+    } else {
+        pacing->margin -= (pacing->margin - FRAME_PACING_MIN_MARGIN) * MARGIN_DECAY;
+    }
+
+    if (pacing->log) {
+        fprintf(pacing->log, "%lu,%s,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                pacing->frame,
+                pacing->mode == FRAME_PACING_LOW_LATENCY ? "low-latency" : "default",
+                pacing->sleepTime * 1000.0,
+                pacing->work * 1000.0,
+                pacing->margin * 1000.0,
+                interval * 1000.0,
+                pacing->latency * 1000.0);
+    }
+
+    pacing->lastPresent = present;
+    pacing->frame++;
+}
+
+void FramePacing_Shutdown(FramePacing* pacing)
+{
+    if (pacing->log) {
+        fclose(pacing->log);
+        pacing->log = NULL;
+    }
+}
@@ -1,38 +1,54 @@
 #include "input.h"
 #include "raylib.h"
 
+// Key presses latched across input polls, cleared once per frame
+static bool latchedLeft;
+static bool latchedRight;
+static bool latchedUp;
+static bool latchedDown;
+static bool latchedSwap;
+static bool latchedRaise;
+
 void Cursor_Init(Cursor* cursor)
 {
+    Cursor_InitSized(cursor, BOARD_WIDTH, BOARD_HEIGHT);
+}
+
+void Cursor_InitSized(Cursor* cursor, int boardWidth, int boardHeight)
+{
+    cursor->boardWidth = boardWidth;
+    cursor->boardHeight = boardHeight;
+
     // Start at bottom-left of board
     cursor->x = 0;
-    cursor->y = BOARD_HEIGHT - 1;
+    cursor->y = boardHeight - 1;
 }
 
 void Cursor_Clamp(Cursor* cursor)
 {
     if (cursor->x < 0) cursor->x = 0;
-    if (cursor->x >= BOARD_WIDTH - 1) cursor->x = BOARD_WIDTH - 2;  // Cursor is 2 blocks wide
+    if (cursor->x >= cursor->boardWidth - 1) cursor->x = cursor->boardWidth - 2;  // Cursor is 2 blocks wide
     if (cursor->y < 0) cursor->y = 0;
-    if (cursor->y >= BOARD_HEIGHT) cursor->y = BOARD_HEIGHT - 1;
+    if (cursor->y >= cursor->boardHeight) cursor->y = cursor->boardHeight - 1;
 }
 
 bool Cursor_HandleInput(Cursor* cursor)
 {
     bool moved = false;
 
-    if (IsKeyPressed(KEY_LEFT)) {
+    if (latchedLeft || IsKeyPressed(KEY_LEFT)) {
         cursor->x--;
         moved = true;
     }
-    if (IsKeyPressed(KEY_RIGHT)) {
+    if (latchedRight || IsKeyPressed(KEY_RIGHT)) {
         cursor->x++;
         moved = true;
     }
-    if (IsKeyPressed(KEY_UP)) {
+    if (latchedUp || IsKeyPressed(KEY_UP)) {
         cursor->y--;
         moved = true;
     }
-    if (IsKeyPressed(KEY_DOWN)) {
+    if (latchedDown || IsKeyPressed(KEY_DOWN)) {
         cursor->y++;
         moved = true;
     }
@@ -46,5 +62,30 @@ bool Cursor_HandleInput(Cursor* cursor)
 
 bool Input_SwapPressed(void)
 {
-    return IsKeyPressed(KEY_SPACE);
+    return latchedSwap || IsKeyPressed(KEY_SPACE);
+}
+
+bool Input_RaisePressed(void)
+{
+    return latchedRaise || IsKeyPressed(KEY_LEFT_SHIFT) || IsKeyPressed(KEY_RIGHT_SHIFT);
+}
+
+void Input_Latch(void)
+{
+    latchedLeft  |= IsKeyPressed(KEY_LEFT);
+    latchedRight |= IsKeyPressed(KEY_RIGHT);
+    latchedUp    |= IsKeyPressed(KEY_UP);
+    latchedDown  |= IsKeyPressed(KEY_DOWN);
+    latchedSwap  |= IsKeyPressed(KEY_SPACE);
+    latchedRaise |= IsKeyPressed(KEY_LEFT_SHIFT) || IsKeyPressed(KEY_RIGHT_SHIFT);
+}
+
+void Input_ClearLatch(void)
+{
+    latchedLeft = false;
+    latchedRight = false;
+    latchedUp = false;
+    latchedDown = false;
+    latchedSwap = false;
+    latchedRaise = false;
 }
@@ -1,4 +1,7 @@
 #include "renderer.h"
+#include "asset_bundle.h"
+#include "board_mode.h"
+#include "garbage.h"
 #include "raylib.h"
 
 // Map BlockType to raylib Color
@@ -10,6 +13,7 @@ static Color GetBlockColor(BlockType type)
         case BLOCK_GREEN:  return GREEN;
         case BLOCK_YELLOW: return YELLOW;
         case BLOCK_PURPLE: return PURPLE;
+        case BLOCK_CYAN:   return SKYBLUE;
         case BLOCK_EMPTY:
         default:           return BLANK;
     }
@@ -17,23 +21,48 @@ static Color GetBlockColor(BlockType type)
 
 static const int BLOCK_PADDING = 2;
 
-void Renderer_DrawBlockAtPixel(BlockType type, int pixelX, int pixelY)
+// Baked block tiles from the asset bundle (id 0 = draw plain rectangles)
+static Texture2D blockAtlas;
+
+// Tiles fill a block inside BLOCK_PADDING on each side
+_Static_assert(ASSET_BLOCK_TILE_SIZE == BLOCK_SIZE - 4, "atlas tile size");
+
+void Renderer_SetBlockAtlas(Texture2D atlas)
 {
-    if (type == BLOCK_EMPTY) {
+    blockAtlas = atlas;
+}
+
+// Fill a block's cell (inside the padding) with its color or atlas tile
+static void FillBlock(BlockType type, int pixelX, int pixelY)
+{
+    if (blockAtlas.id != 0) {
+        Rectangle tile = {
+            (float)(__builtin_ctz(type) * ASSET_BLOCK_TILE_SIZE), 0.0f,
+            (float)ASSET_BLOCK_TILE_SIZE, (float)ASSET_BLOCK_TILE_SIZE
+        };
+        DrawTextureRec(blockAtlas, tile,
+                       (Vector2){ (float)(pixelX + BLOCK_PADDING), (float)(pixelY + BLOCK_PADDING) }, WHITE);
         return;
     }
 
-    Color color = GetBlockColor(type);
-
     DrawRectangle(
         pixelX + BLOCK_PADDING,
         pixelY + BLOCK_PADDING,
         BLOCK_SIZE - (BLOCK_PADDING * 2),
         BLOCK_SIZE - (BLOCK_PADDING * 2),
-        color
+        GetBlockColor(type)
     );
 }
 
+void Renderer_DrawBlockAtPixel(BlockType type, int pixelX, int pixelY)
+{
+    if (type == BLOCK_EMPTY) {
+        return;
+    }
+
+    FillBlock(type, pixelX, pixelY);
+}
+
 // Draw a block with state-based rendering (e.g., matched blocks flash white)
 static void DrawBlockWithState(BlockType type, BlockState state, int pixelX, int pixelY)
 {
@@ -41,18 +70,10 @@ static void DrawBlockWithState(BlockType type, BlockState state, int pixelX, int
         return;
     }
 
-    Color color = GetBlockColor(type);
+    FillBlock(type, pixelX, pixelY);
 
     // Matched blocks get a white overlay
     if (state == STATE_MATCHED) {
-        // Draw base color
-        DrawRectangle(
-            pixelX + BLOCK_PADDING,
-            pixelY + BLOCK_PADDING,
-            BLOCK_SIZE - (BLOCK_PADDING * 2),
-            BLOCK_SIZE - (BLOCK_PADDING * 2),
-            color
-        );
         // Draw white overlay with transparency
         DrawRectangle(
             pixelX + BLOCK_PADDING,
@@ -69,14 +90,6 @@ static void DrawBlockWithState(BlockType type, BlockState state, int pixelX, int
             BLOCK_SIZE - (BLOCK_PADDING * 2),
             WHITE
         );
-    } else {
-        DrawRectangle(
-            pixelX + BLOCK_PADDING,
-            pixelY + BLOCK_PADDING,
-            BLOCK_SIZE - (BLOCK_PADDING * 2),
-            BLOCK_SIZE - (BLOCK_PADDING * 2),
-            color
-        );
     }
 }
 
@@ -87,178 +100,77 @@ void Renderer_DrawBlock(BlockType type, int gridX, int gridY, int offsetX, int o
     Renderer_DrawBlockAtPixel(type, pixelX, pixelY);
 }
 
-void Renderer_DrawBoard(const GameBoard* board, int offsetX, int offsetY)
+// Draw each garbage slab as one panel, mid-fall if gravity is animating it
+static void DrawSlabs(const GameBoard* board, int offsetX, int offsetY, const GravityAnimation* gravityAnim)
 {
-    // Draw background
-    DrawRectangle(
-        offsetX,
-        offsetY,
-        BOARD_PIXEL_WIDTH,
-        BOARD_PIXEL_HEIGHT,
-        DARKGRAY
-    );
+    for (int s = 0; s < board->slabCount; s++) {
+        const GarbageSlab* slab = &board->slabs[s];
+        int pixelX = offsetX + (slab->x * BLOCK_SIZE) + BLOCK_PADDING;
+        int pixelY = offsetY + (slab->y * BLOCK_SIZE) + BLOCK_PADDING;
+        if (gravityAnim && gravityAnim->active) {
+            pixelY -= (int)((1.0f - gravityAnim->progress) * gravityAnim->slabFall[s] * BLOCK_SIZE);
+        }
+        int pixelWidth = slab->width * BLOCK_SIZE - (BLOCK_PADDING * 2);
+        int pixelHeight = slab->height * BLOCK_SIZE - (BLOCK_PADDING * 2);
 
-    // Draw grid lines
-    for (int x = 0; x <= BOARD_WIDTH; x++) {
-        int lineX = offsetX + (x * BLOCK_SIZE);
-        DrawLine(lineX, offsetY, lineX, offsetY + BOARD_PIXEL_HEIGHT, GRAY);
-    }
-    for (int y = 0; y <= BOARD_HEIGHT; y++) {
-        int lineY = offsetY + (y * BLOCK_SIZE);
-        DrawLine(offsetX, lineY, offsetX + BOARD_PIXEL_WIDTH, lineY, GRAY);
-    }
+        DrawRectangle(pixelX, pixelY, pixelWidth, pixelHeight, (Color){ 90, 90, 110, 255 });
+        DrawRectangleLines(pixelX, pixelY, pixelWidth, pixelHeight, LIGHTGRAY);
 
-    // Draw blocks
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
-        for (int x = 0; x < BOARD_WIDTH; x++) {
-            uint16_t cell = board->grid[GRID_INDEX(x, y)];
-            BlockType type = BLOCK_TYPE(cell);
-            Renderer_DrawBlock(type, x, y, offsetX, offsetY);
+        // A strip of the colors the bottom row turns into
+        for (int i = 0; i < slab->width; i++) {
+            BlockType type = GarbageSlab_Reveal(slab, (i + slab->height - 1) % slab->width);
+            DrawRectangle(pixelX + (i * BLOCK_SIZE) + BLOCK_SIZE / 4, pixelY + pixelHeight - 8,
+                          BLOCK_SIZE / 2 - BLOCK_PADDING, 4, GetBlockColor(type));
         }
     }
-
-    // Draw grid coordinates (for debugging)
-    for (int x = 0; x < BOARD_WIDTH; x++) {
-        int pixelX = offsetX + (x * BLOCK_SIZE) + (BLOCK_SIZE / 2) - 4;
-        int pixelY = offsetY + BOARD_PIXEL_HEIGHT + 5;
-        DrawText(TextFormat("%d", x), pixelX, pixelY, 10, LIGHTGRAY);
-    }
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
-        int pixelX = offsetX - 15;
-        int pixelY = offsetY + (y * BLOCK_SIZE) + (BLOCK_SIZE / 2) - 5;
-        DrawText(TextFormat("%d", y), pixelX, pixelY, 10, LIGHTGRAY);
-    }
-
-    // Draw board outline
-    DrawRectangleLines(offsetX, offsetY, BOARD_PIXEL_WIDTH, BOARD_PIXEL_HEIGHT, WHITE);
 }
 
-void Renderer_DrawBoardWithSwap(const GameBoard* board, int offsetX, int offsetY,
-                                 const SwapAnimation* swapAnim)
+// Board drawing specialized per geometry, so the per-cell loops run over
+// constant dimensions and animated cells are skipped with one mask test
+BOARD_KERNEL void DrawBoardSized(const GameBoard* board, int offsetX, int offsetY,
+                                 const SwapAnimation* swapAnim,
+                                 const GravityAnimation* gravityAnim,
+                                 const int width, const int height)
 {
+    const int pixelWidth = width * BLOCK_SIZE;
+    const int pixelHeight = height * BLOCK_SIZE;
+
     // Draw background
-    DrawRectangle(offsetX, offsetY, BOARD_PIXEL_WIDTH, BOARD_PIXEL_HEIGHT, DARKGRAY);
+    DrawRectangle(offsetX, offsetY, pixelWidth, pixelHeight, DARKGRAY);
 
     // Draw grid lines
-    for (int x = 0; x <= BOARD_WIDTH; x++) {
+    BOARD_UNROLL
+    for (int x = 0; x <= width; x++) {
         int lineX = offsetX + (x * BLOCK_SIZE);
-        DrawLine(lineX, offsetY, lineX, offsetY + BOARD_PIXEL_HEIGHT, GRAY);
+        DrawLine(lineX, offsetY, lineX, offsetY + pixelHeight, GRAY);
     }
-    for (int y = 0; y <= BOARD_HEIGHT; y++) {
+    for (int y = 0; y <= height; y++) {
         int lineY = offsetY + (y * BLOCK_SIZE);
-        DrawLine(offsetX, lineY, offsetX + BOARD_PIXEL_WIDTH, lineY, GRAY);
-    }
-
-    // Draw blocks (skip animated blocks if swap is active)
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
-        for (int x = 0; x < BOARD_WIDTH; x++) {
-            // Skip blocks being animated
-            if (swapAnim->active && y == swapAnim->y &&
-                (x == swapAnim->x || x == swapAnim->x + 1)) {
-                continue;
-            }
-
-            uint16_t cell = board->grid[GRID_INDEX(x, y)];
-            BlockType type = BLOCK_TYPE(cell);
-            BlockState state = BLOCK_STATE(cell);
-            int pixelX = offsetX + (x * BLOCK_SIZE);
-            int pixelY = offsetY + (y * BLOCK_SIZE);
-            DrawBlockWithState(type, state, pixelX, pixelY);
-        }
+        DrawLine(offsetX, lineY, offsetX + pixelWidth, lineY, GRAY);
     }
 
-    // Draw animated blocks
+    // Cells an animation draws instead: bit y of column x
+    uint16_t animated[BOARD_MAX_WIDTH] = { 0 };
     if (swapAnim->active) {
-        int leftGridX = swapAnim->x;
-        int rightGridX = swapAnim->x + 1;
-        int gridY = swapAnim->y;
-
-        // Get block types (they've already been swapped in the board data)
-        // So the "left" position now contains what was on the right, and vice versa
-        BlockType leftType = BLOCK_TYPE(board->grid[GRID_INDEX(leftGridX, gridY)]);
-        BlockType rightType = BLOCK_TYPE(board->grid[GRID_INDEX(rightGridX, gridY)]);
-
-        // Calculate animation offset
-        float animOffset = (1.0f - swapAnim->progress) * BLOCK_SIZE;
-
-        // Left block (was right, moving left): starts from right, ends at left
-        int leftPixelX = offsetX + (leftGridX * BLOCK_SIZE) + (int)animOffset;
-        int leftPixelY = offsetY + (gridY * BLOCK_SIZE);
-        Renderer_DrawBlockAtPixel(leftType, leftPixelX, leftPixelY);
-
-        // Right block (was left, moving right): starts from left, ends at right
-        int rightPixelX = offsetX + (rightGridX * BLOCK_SIZE) - (int)animOffset;
-        int rightPixelY = offsetY + (gridY * BLOCK_SIZE);
-        Renderer_DrawBlockAtPixel(rightType, rightPixelX, rightPixelY);
+        animated[swapAnim->x] |= (uint16_t)(1u << swapAnim->y);
+        animated[swapAnim->x + 1] |= (uint16_t)(1u << swapAnim->y);
     }
-
-    // Draw grid coordinates (for debugging)
-    for (int x = 0; x < BOARD_WIDTH; x++) {
-        int pixelX = offsetX + (x * BLOCK_SIZE) + (BLOCK_SIZE / 2) - 4;
-        int pixelY = offsetY + BOARD_PIXEL_HEIGHT + 5;
-        DrawText(TextFormat("%d", x), pixelX, pixelY, 10, LIGHTGRAY);
-    }
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
-        int pixelX = offsetX - 15;
-        int pixelY = offsetY + (y * BLOCK_SIZE) + (BLOCK_SIZE / 2) - 5;
-        DrawText(TextFormat("%d", y), pixelX, pixelY, 10, LIGHTGRAY);
-    }
-
-    // Draw board outline
-    DrawRectangleLines(offsetX, offsetY, BOARD_PIXEL_WIDTH, BOARD_PIXEL_HEIGHT, WHITE);
-}
-
-// Helper to check if a block is being animated by gravity
-static bool IsBlockFalling(const GravityAnimation* gravityAnim, int x, int y)
-{
-    if (!gravityAnim || !gravityAnim->active) {
-        return false;
-    }
-    for (int i = 0; i < gravityAnim->count; i++) {
-        if (gravityAnim->blocks[i].x == x && gravityAnim->blocks[i].y == y) {
-            return true;
+    if (gravityAnim && gravityAnim->active) {
+        for (int i = 0; i < gravityAnim->count; i++) {
+            animated[gravityAnim->blocks[i].x] |= (uint16_t)(1u << gravityAnim->blocks[i].y);
         }
     }
-    return false;
-}
-
-void Renderer_DrawBoardWithAnimations(const GameBoard* board, int offsetX, int offsetY,
-                                       const SwapAnimation* swapAnim,
-                                       const GravityAnimation* gravityAnim)
-{
-    // Draw background
-    DrawRectangle(offsetX, offsetY, BOARD_PIXEL_WIDTH, BOARD_PIXEL_HEIGHT, DARKGRAY);
-
-    // Draw grid lines
-    for (int x = 0; x <= BOARD_WIDTH; x++) {
-        int lineX = offsetX + (x * BLOCK_SIZE);
-        DrawLine(lineX, offsetY, lineX, offsetY + BOARD_PIXEL_HEIGHT, GRAY);
-    }
-    for (int y = 0; y <= BOARD_HEIGHT; y++) {
-        int lineY = offsetY + (y * BLOCK_SIZE);
-        DrawLine(offsetX, lineY, offsetX + BOARD_PIXEL_WIDTH, lineY, GRAY);
-    }
 
     // Draw blocks (skip animated blocks)
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
-        for (int x = 0; x < BOARD_WIDTH; x++) {
-            // Skip blocks being swap-animated
-            if (swapAnim->active && y == swapAnim->y &&
-                (x == swapAnim->x || x == swapAnim->x + 1)) {
-                continue;
-            }
-
-            // Skip blocks being gravity-animated
-            if (IsBlockFalling(gravityAnim, x, y)) {
+    for (int y = 0; y < height; y++) {
+        const uint16_t* row = &board->grid[y * width];
+        BOARD_UNROLL
+        for (int x = 0; x < width; x++) {
+            if (animated[x] & (1u << y)) {
                 continue;
             }
-
-            uint16_t cell = board->grid[GRID_INDEX(x, y)];
-            BlockType type = BLOCK_TYPE(cell);
-            BlockState state = BLOCK_STATE(cell);
-            int pixelX = offsetX + (x * BLOCK_SIZE);
-            int pixelY = offsetY + (y * BLOCK_SIZE);
-            DrawBlockWithState(type, state, pixelX, pixelY);
+            DrawBlockWithState(BLOCK_TYPE(row[x]), BLOCK_STATE(row[x]),
+                               offsetX + (x * BLOCK_SIZE), offsetY + (y * BLOCK_SIZE));
         }
     }
 
@@ -268,8 +180,8 @@ void Renderer_DrawBoardWithAnimations(const GameBoard* board, int offsetX, int o
         int rightGridX = swapAnim->x + 1;
         int gridY = swapAnim->y;
 
-        BlockType leftType = BLOCK_TYPE(board->grid[GRID_INDEX(leftGridX, gridY)]);
-        BlockType rightType = BLOCK_TYPE(board->grid[GRID_INDEX(rightGridX, gridY)]);
+        BlockType leftType = BLOCK_TYPE(board->grid[gridY * width + leftGridX]);
+        BlockType rightType = BLOCK_TYPE(board->grid[gridY * width + rightGridX]);
 
         float animOffset = (1.0f - swapAnim->progress) * BLOCK_SIZE;
 
@@ -289,8 +201,7 @@ void Renderer_DrawBoardWithAnimations(const GameBoard* board, int offsetX, int o
             int y = gravityAnim->blocks[i].y;
             int fallDist = gravityAnim->blocks[i].fallDistance;
 
-            uint16_t cell = board->grid[GRID_INDEX(x, y)];
-            BlockType type = BLOCK_TYPE(cell);
+            BlockType type = BLOCK_TYPE(board->grid[y * width + x]);
 
             // Calculate animated position (falling from above)
             float remainingFall = (1.0f - gravityAnim->progress) * fallDist * BLOCK_SIZE;
@@ -301,30 +212,57 @@ void Renderer_DrawBoardWithAnimations(const GameBoard* board, int offsetX, int o
         }
     }
 
+    DrawSlabs(board, offsetX, offsetY, gravityAnim);
+
     // Draw grid coordinates (for debugging)
-    for (int x = 0; x < BOARD_WIDTH; x++) {
+    for (int x = 0; x < width; x++) {
         int pixelX = offsetX + (x * BLOCK_SIZE) + (BLOCK_SIZE / 2) - 4;
-        int pixelY = offsetY + BOARD_PIXEL_HEIGHT + 5;
+        int pixelY = offsetY + pixelHeight + 5;
         DrawText(TextFormat("%d", x), pixelX, pixelY, 10, LIGHTGRAY);
     }
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
+    for (int y = 0; y < height; y++) {
         int pixelX = offsetX - 15;
         int pixelY = offsetY + (y * BLOCK_SIZE) + (BLOCK_SIZE / 2) - 5;
         DrawText(TextFormat("%d", y), pixelX, pixelY, 10, LIGHTGRAY);
     }
 
     // Draw board outline
-    DrawRectangleLines(offsetX, offsetY, BOARD_PIXEL_WIDTH, BOARD_PIXEL_HEIGHT, WHITE);
+    DrawRectangleLines(offsetX, offsetY, pixelWidth, pixelHeight, WHITE);
+}
+
+#define DEFINE_DRAW_BOARD(tag, width, height)                                                   \
+    static void DrawBoard_##tag(const GameBoard* board, int offsetX, int offsetY,               \
+                                const SwapAnimation* swapAnim,                                  \
+                                const GravityAnimation* gravityAnim)                            \
+    {                                                                                           \
+        DrawBoardSized(board, offsetX, offsetY, swapAnim, gravityAnim, (width), (height));      \
+    }
+BOARD_GEOMETRIES(DEFINE_DRAW_BOARD)
+#undef DEFINE_DRAW_BOARD
+
+#define DRAW_BOARD_ENTRY(tag, width, height) [BOARD_GEOMETRY_##tag] = DrawBoard_##tag,
+static const BoardDrawFn BOARD_DRAWERS[BOARD_GEOMETRY_COUNT] = {
+    BOARD_GEOMETRIES(DRAW_BOARD_ENTRY)
+};
+#undef DRAW_BOARD_ENTRY
+
+BoardDrawFn Renderer_GetBoardDrawer(BoardModeId mode)
+{
+    return BOARD_DRAWERS[BoardMode_Get(mode)->geometry];
 }
 
-int Renderer_GetCenteredOffsetX(void)
+void Renderer_DrawBoardWithAnimations(const GameBoard* board, int offsetX, int offsetY,
+                                       const SwapAnimation* swapAnim,
+                                       const GravityAnimation* gravityAnim)
 {
-    return (WINDOW_WIDTH - BOARD_PIXEL_WIDTH) / 2;
+    BOARD_DRAWERS[BoardMode_Of(board)->geometry](board, offsetX, offsetY, swapAnim, gravityAnim);
 }
 
-int Renderer_GetCenteredOffsetY(void)
+void Renderer_GetBoardOffset(BoardModeId mode, int* offsetX, int* offsetY)
 {
-    return (WINDOW_HEIGHT - BOARD_PIXEL_HEIGHT) / 2;
+    const BoardMode* boardMode = BoardMode_Get(mode);
+    *offsetX = (WINDOW_WIDTH - boardMode->width * BLOCK_SIZE) / 2;
+    *offsetY = (WINDOW_HEIGHT - boardMode->height * BLOCK_SIZE) / 2;
 }
 
 // Cursor styling constants
@@ -1,99 +1,238 @@
+#define _POSIX_C_SOURCE 200809L
 #include "raylib.h"
-#include "game_board.h"
-#include "game_logic.h"
-#include "match_detection.h"
-#include "physics.h"
+#include "game_state.h"
 #include "renderer.h"
 #include "input.h"
+#include "frame_pacing.h"
+#include "replay_archive.h"
+#include "assets.h"
+#include "audio.h"
+#include "logger.h"
+#include "state_publisher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
-// Clear animation timing
-static const float CLEAR_DELAY = 0.3f;  // Time to show matched blocks before clearing
+// Replay playback controls: LEFT/RIGHT seek, SPACE pauses
+#define REPLAY_SEEK_TICKS (10 * GAME_TICK_RATE)
 
-int main(void)
+// Time-to-first-frame budget, from process start to the first present
+#define TTFF_BUDGET_MS 200.0
+
+// Frames longer than three 60 Hz periods are logged
+#define SLOW_FRAME_SECONDS (3.0f / 60.0f)
+
+static double NowSeconds(void)
 {
-    // Initialize game board with random blocks
-    GameBoard board;
-    GameBoard_Init(&board);
-    GameBoard_FillRandom(&board);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
 
-    // Initialize cursor
-    Cursor cursor;
-    Cursor_Init(&cursor);
+static void UpdateReplay(ReplaySim* sim, const ReplayView* view, bool* paused)
+{
+    if (IsKeyPressed(KEY_SPACE)) {
+        *paused = !*paused;
+    }
+
+    uint32_t target = sim->tick;
+    if (IsKeyPressed(KEY_RIGHT)) {
+        target = (target + REPLAY_SEEK_TICKS < view->tickCount) ? target + REPLAY_SEEK_TICKS : view->tickCount;
+    } else if (IsKeyPressed(KEY_LEFT)) {
+        target = (target > REPLAY_SEEK_TICKS) ? target - REPLAY_SEEK_TICKS : 0;
+    } else if (!*paused && target < view->tickCount) {
+        target++;
+    }
+    ReplaySim_Seek(sim, view, target);
+}
+
+int main(int argc, char** argv)
+{
+    double startTime = NowSeconds();
 
-    // Initialize swap animation
-    SwapAnimation swapAnim;
-    SwapAnimation_Init(&swapAnim);
+    // Parse command line options
+    FramePacingMode pacingMode = FRAME_PACING_DEFAULT;
+    bool vsync = false;
+    const char* latencyLogPath = NULL;
+    const char* replayPath = NULL;
+    uint32_t replayMatch = 0;
+    const char* modeName = NULL;
+    const char* assetsPath = NULL;
+    bool ttffOnly = false;
+    const char* publishName = NULL;
+    const char* logFile = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--low-latency") == 0) {
+            pacingMode = FRAME_PACING_LOW_LATENCY;
+        } else if (strcmp(argv[i], "--vsync") == 0) {
+            vsync = true;
+        } else if (strcmp(argv[i], "--latency-log") == 0 && i + 1 < argc) {
+            latencyLogPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay-match") == 0 && i + 1 < argc) {
+            replayMatch = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+            modeName = argv[++i];
+        } else if (strcmp(argv[i], "--assets") == 0 && i + 1 < argc) {
+            assetsPath = argv[++i];
+        } else if (strcmp(argv[i], "--ttff") == 0) {
+            ttffOnly = true;
+        } else if (strcmp(argv[i], "--log-file") == 0 && i + 1 < argc) {
+            logFile = argv[++i];
+        } else if (strcmp(argv[i], "--publish-state") == 0) {
+            publishName = STATE_SHM_DEFAULT_NAME;
+            if (i + 1 < argc && argv[i + 1][0] == '/') {
+                publishName = argv[++i];
+            }
+        }
+    }
 
-    // Initialize gravity animation
-    GravityAnimation gravityAnim;
-    GravityAnimation_Init(&gravityAnim);
+    uint64_t seed = (uint64_t)time(NULL);
 
-    // Track match/clear state
-    int lastMatchCount = 0;
-    int lastClearCount = 0;
-    float clearTimer = 0.0f;
-    bool waitingToClear = false;
+    // Binary log drained off the game thread (decode with tools/logs)
+    if (logFile && !Logger_Start(logFile)) {
+        TraceLog(LOG_WARNING, "Could not create log file %s", logFile);
+    }
+
+    // Board size and colors for this session
+    const BoardMode* mode = BoardMode_Get(BOARD_MODE_CLASSIC);
+    if (modeName) {
+        mode = BoardMode_Find(modeName);
+        if (!mode) {
+            TraceLog(LOG_WARNING, "Unknown mode %s, playing classic", modeName);
+            mode = BoardMode_Get(BOARD_MODE_CLASSIC);
+        }
+    }
+
+    LOG_EVENT(SESSION_STARTED, mode->id, seed);
+
+    // Upcoming rows for the rising stack, generated ahead on a worker thread
+    static RowQueue rowQueue;
+    RowQueue_InitMode(&rowQueue, seed, (BoardModeId)mode->id);
+    RowQueue_StartWorker(&rowQueue);
+
+    // Initialize game state (board, animations, match/clear state)
+    static GameState game;
+    GameState_InitMode(&game, (BoardModeId)mode->id, seed, &rowQueue);
+
+    // Optional replay playback from a mapped archive (player 1's board is shown)
+    static ReplaySim replay;
+    ReplayArchive archive;
+    ReplayView replayView;
+    bool replaying = false;
+    bool replayPaused = false;
+    if (replayPath) {
+        if (ReplayArchive_Open(&archive, replayPath)) {
+            int index = ReplayArchive_Find(&archive, replayMatch);
+            if (ReplayArchive_GetMatch(&archive, index, &replayView)) {
+                ReplaySim_Init(&replay, replayView.seed);
+                replaying = true;
+            } else {
+                ReplayArchive_Close(&archive);
+            }
+        }
+        if (!replaying) {
+            TraceLog(LOG_WARNING, "Could not open match %u in replay archive %s", replayMatch, replayPath);
+        }
+    }
+
+    // Replays are recorded on classic boards
+    if (replaying) {
+        mode = BoardMode_Get(BOARD_MODE_CLASSIC);
+    }
+
+    // Initialize cursor
+    Cursor cursor;
+    Cursor_InitSized(&cursor, mode->width, mode->height);
+
+    // Initialize frame pacing (must precede InitWindow for the vsync flag)
+    FramePacing pacing;
+    FramePacing_Init(&pacing, pacingMode, 60, vsync, latencyLogPath);
 
     // Initialize window
     InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Puzzle Attack");
-    SetTargetFPS(60);
+    FramePacing_Start(&pacing);
+
+    // Map the asset bundle; only the block atlas is uploaded before the first frame
+    static Assets assets;
+    char defaultAssetsPath[4096];
+    if (!assetsPath) {
+        snprintf(defaultAssetsPath, sizeof(defaultAssetsPath), "%sassets.pab", GetApplicationDirectory());
+        assetsPath = defaultAssetsPath;
+    }
+    if (Assets_Load(&assets, assetsPath)) {
+        Renderer_SetBlockAtlas(assets.blockAtlas);
+    } else {
+        TraceLog(LOG_WARNING, "Could not open asset bundle %s, drawing plain blocks", assetsPath);
+    }
 
-    // Calculate centered board position
-    int boardX = Renderer_GetCenteredOffsetX();
-    int boardY = Renderer_GetCenteredOffsetY();
+    // Optional live view of the shown board for the inspect tool (slot 0)
+    static StatePublisher statePublisher;
+    StatePublisher* publisher = NULL;
+    if (publishName) {
+        if (StatePublisher_Open(&statePublisher, publishName, "client")) {
+            publisher = &statePublisher;
+        } else {
+            TraceLog(LOG_WARNING, "Could not create shared memory segment %s", publishName);
+        }
+    }
+
+    // Frames counted for the state publisher and the log
+    uint32_t frameCount = 0;
+
+    // Audio starts after the first frame so it never delays it
+    static Audio audio;
+    static MusicStreamer music;
+    bool firstFrame = true;
+
+    // Calculate centered board position and pick the mode's board drawer
+    int boardX, boardY;
+    Renderer_GetBoardOffset((BoardModeId)mode->id, &boardX, &boardY);
+    BoardDrawFn drawBoard = Renderer_GetBoardDrawer((BoardModeId)mode->id);
 
     // Main game loop
     while (!WindowShouldClose())
     {
-        float deltaTime = GetFrameTime();
+        // Keep presses from the poll inside EndDrawing, then (in low-latency
+        // mode) sleep and re-sample input as late as possible
+        Input_Latch();
+        FramePacing_BeginFrame(&pacing);
 
-        // Handle cursor movement (always allowed)
-        Cursor_HandleInput(&cursor);
-
-        // Handle swap input (only when not animating)
-        if (!swapAnim.active && !gravityAnim.active && Input_SwapPressed()) {
-            if (SwapBlocks(&board, cursor.x, cursor.y)) {
-                SwapAnimation_Start(&swapAnim, cursor.x, cursor.y);
-            }
+        float deltaTime = GetFrameTime();
+        frameCount++;
+        if (deltaTime > SLOW_FRAME_SECONDS) {
+            LOG_EVENT(FRAME_SLOW, frameCount, deltaTime * 1000.0f);
         }
 
-        // Update swap animation
-        bool swapCompleted = SwapAnimation_Update(&swapAnim, deltaTime);
+        const GameState* shown = &game;
+        if (replaying) {
+            // Replays advance on the fixed tick, one per frame
+            UpdateReplay(&replay, &replayView, &replayPaused);
+            shown = &replay.players[0];
+        } else {
+            // Handle cursor movement (always allowed)
+            Cursor_HandleInput(&cursor);
 
-        // Update gravity animation
-        bool gravityCompleted = GravityAnimation_Update(&gravityAnim, deltaTime);
+            // Gather this frame's input and step the simulation
+            GameInput input = { (uint8_t)cursor.x, (uint8_t)cursor.y, 0 };
+            if (Input_SwapPressed()) input.flags |= GAME_INPUT_SWAP;
+            if (Input_RaisePressed()) input.flags |= GAME_INPUT_RAISE;
 
-        // Check for matches after swap completes
-        if (swapCompleted) {
-            lastMatchCount = DetectMatches(&board);
-            if (lastMatchCount > 0) {
-                waitingToClear = true;
-                clearTimer = CLEAR_DELAY;
-            } else {
-                // No matches - apply gravity (handles swapping into empty space)
-                ApplyGravity(&board, &gravityAnim);
-            }
-        }
-
-        // Check for matches after gravity completes (cascade)
-        if (gravityCompleted) {
-            lastMatchCount = DetectMatches(&board);
-            if (lastMatchCount > 0) {
-                waitingToClear = true;
-                clearTimer = CLEAR_DELAY;
+            int events = GameState_Update(&game, &input, deltaTime);
+            Audio_PlayGameEvents(&audio, events, NowSeconds());
+            if (events & GAME_EVENT_RAISE) {
+                // Keep the cursor on the same blocks
+                cursor.y--;
+                Cursor_Clamp(&cursor);
             }
         }
 
-        // Update clear timer and clear matches when ready
-        if (waitingToClear) {
-            clearTimer -= deltaTime;
-            if (clearTimer <= 0.0f) {
-                lastClearCount = ClearMatches(&board);
-                waitingToClear = false;
+        Input_ClearLatch();
 
-                // Apply gravity after clearing
-                ApplyGravity(&board, &gravityAnim);
-            }
+        if (publisher) {
+            StatePublisher_Publish(publisher, 0, replaying ? replayMatch : 0, 0, frameCount, shown);
         }
 
         // Rendering
@@ -101,27 +240,83 @@ int main(void)
         ClearBackground(BLACK);
 
         // Draw the game board with all animations
-        Renderer_DrawBoardWithAnimations(&board, boardX, boardY, &swapAnim, &gravityAnim);
+        drawBoard(&shown->board, boardX, boardY, &shown->swapAnim, &shown->gravityAnim);
 
         // Draw cursor
-        Renderer_DrawCursor(cursor.x, cursor.y, boardX, boardY);
+        if (!replaying) {
+            Renderer_DrawCursor(cursor.x, cursor.y, boardX, boardY);
+        }
 
         // Draw UI text
         DrawText("Puzzle Attack", 10, 10, 20, WHITE);
-        DrawText("Arrow keys: move | SPACE: swap", 10, 35, 16, GRAY);
-        DrawText(TextFormat("Score: %d", board.score), 10, 60, 20, YELLOW);
+        if (replaying) {
+            DrawText(TextFormat("Replay %u: %02u:%02u / %02u:%02u | LEFT/RIGHT: seek | SPACE: pause",
+                                replayView.matchId,
+                                replay.tick / GAME_TICK_RATE / 60, replay.tick / GAME_TICK_RATE % 60,
+                                replayView.tickCount / GAME_TICK_RATE / 60, replayView.tickCount / GAME_TICK_RATE % 60),
+                     10, 35, 16, GRAY);
+        } else {
+            DrawText("Arrow keys: move | SPACE: swap | SHIFT: raise", 10, 35, 16, GRAY);
+        }
+        DrawText(TextFormat("Score: %d", shown->board.score), 10, 60, 20, YELLOW);
 
-        if (waitingToClear && lastMatchCount > 0) {
-            DrawText(TextFormat("Matched: %d blocks!", lastMatchCount), 10, 85, 16, GREEN);
-        } else if (lastClearCount > 0) {
-            DrawText(TextFormat("Cleared: %d blocks", lastClearCount), 10, 85, 16, LIME);
+        if (shown->waitingToClear && shown->lastMatchCount > 0) {
+            DrawText(TextFormat("Matched: %d blocks!", shown->lastMatchCount), 10, 85, 16, GREEN);
+        } else if (shown->lastClearCount > 0) {
+            DrawText(TextFormat("Cleared: %d blocks", shown->lastClearCount), 10, 85, 16, LIME);
         }
 
         DrawFPS(WINDOW_WIDTH - 80, 10);
+        DrawText(TextFormat("Latency: %.1f ms", pacing.latencyAvg * 1000.0),
+                 WINDOW_WIDTH - 140, 35, 16, GRAY);
+        DrawText(pacingMode == FRAME_PACING_LOW_LATENCY ? "Pacing: low-latency" : "Pacing: default",
+                 WINDOW_WIDTH - 170, 55, 16, GRAY);
+        DrawText(TextFormat("Mixer: %.1f us", audio.mixer.stats.lastMixNanos / 1000.0),
+                 WINDOW_WIDTH - 140, 75, 16, GRAY);
 
+        FramePacing_BeforePresent(&pacing);
         EndDrawing();
+        FramePacing_EndFrame(&pacing);
+
+        if (firstFrame) {
+            firstFrame = false;
+            double ttff = (NowSeconds() - startTime) * 1000.0;
+            TraceLog(ttff > TTFF_BUDGET_MS ? LOG_WARNING : LOG_INFO,
+                     "Time to first frame: %.1f ms (budget %.0f ms)", ttff, TTFF_BUDGET_MS);
+            if (ttffOnly) {
+                printf("ttff_ms %.3f\n", ttff);
+                break;
+            }
+
+            InitAudioDevice();
+            Audio_Start(&audio, &assets);
+            const AssetEntry* track = Assets_FindMusic(&assets);
+            if (track) {
+                if (!MusicStreamer_Start(&music, &assets, track)) {
+                    TraceLog(LOG_WARNING, "Could not stream music track %s", track->name);
+                }
+            }
+        }
+        MusicStreamer_Update(&music);
     }
 
+    if (replaying) {
+        ReplayArchive_Close(&archive);
+    }
+    RowQueue_StopWorker(&rowQueue);
+    FramePacing_Shutdown(&pacing);
+    MusicStreamer_Stop(&music);
+    Audio_Stop(&audio);
+    Audio_LogStats(&audio);
+    if (IsAudioDeviceReady()) {
+        CloseAudioDevice();
+    }
+    Renderer_SetBlockAtlas((Texture2D){ 0 });
+    Assets_Unload(&assets);
+    if (publisher) {
+        StatePublisher_Close(publisher);
+    }
+    Logger_Stop();
     CloseWindow();
     return 0;
 }
@@ -0,0 +1,104 @@
+#include "match.h"
+#include <string.h>
+
+// Smallest clear that sends garbage, and the tallest slab one clear sends
+#define MATCH_ATTACK_MIN_CLEAR 4
+#define MATCH_ATTACK_MAX_HEIGHT 3
+
+// Garbage a clear sends to the opponent: nothing for a plain run of three,
+// otherwise a slab one block narrower than the clear (the board's width at
+// most), a row taller for each further board width of blocks cleared
+static bool AttackFor(const GameState* state, int* width, int* height)
+{
+    int cleared = state->lastClearCount;
+    if (cleared < MATCH_ATTACK_MIN_CLEAR) {
+        return false;
+    }
+    int boardWidth = state->mode->width;
+    *width = cleared - 1 < boardWidth ? cleared - 1 : boardWidth;
+    *height = 1 + (cleared - 1) / (boardWidth + 1);
+    if (*height > MATCH_ATTACK_MAX_HEIGHT) {
+        *height = MATCH_ATTACK_MAX_HEIGHT;
+    }
+    return true;
+}
+
+void Match_Init(Match* match, uint32_t id, uint64_t seed, void* arenaMemory, size_t arenaSize)
+{
+    match->id = id;
+    match->tick = 0;
+    match->seed = seed;
+    match->poolNext = -1;
+
+    // Both players get the same rows, consumed at their own pace
+    for (int p = 0; p < MATCH_PLAYERS; p++) {
+        RowQueue_Init(&match->rows[p], seed);
+        GameState_Init(&match->players[p], seed, &match->rows[p]);
+    }
+
+    memset(match->inputs, 0, sizeof(match->inputs));
+    memset(match->snapshots, 0, sizeof(match->snapshots));
+
+    MatchArena_Init(&match->arena, arenaMemory, arenaSize);
+    for (int p = 0; p < MATCH_PLAYERS; p++) {
+        match->sendBuffers[p] = MatchArena_Alloc(&match->arena, MATCH_PACKET_SIZE);
+        match->recvBuffers[p] = MatchArena_Alloc(&match->arena, MATCH_PACKET_SIZE);
+    }
+}
+
+void Match_SubmitInput(Match* match, int player, uint32_t tick, const GameInput* input)
+{
+    // Only ticks that have not been simulated yet and fit in the window
+    if (player < 0 || player >= MATCH_PLAYERS ||
+        tick < match->tick || tick - match->tick >= MATCH_INPUT_HISTORY) {
+        return;
+    }
+    GameInput* slot = &match->inputs[player][tick & (MATCH_INPUT_HISTORY - 1)];
+    *slot = *input;
+
+    // Attacks come from the opponent's clears in Match_Tick, never from the
+    // attacked player's own client
+    if (slot->flags & GAME_INPUT_GARBAGE) {
+        slot->flags &= (uint8_t)~GAME_INPUT_GARBAGE;
+        if (slot->flags == 0) {
+            slot->x = 0;
+            slot->y = 0;
+        }
+    }
+}
+
+void Match_Tick(Match* match)
+{
+    int slot = (int)(match->tick & (MATCH_INPUT_HISTORY - 1));
+    int events[MATCH_PLAYERS];
+
+    for (int p = 0; p < MATCH_PLAYERS; p++) {
+        GameInput* input = &match->inputs[p][slot];
+        events[p] = GameState_Update(&match->players[p], input, GAME_TICK_SECONDS);
+
+        // Clear the slot so it reads as "no input" when the ring wraps
+        input->flags = 0;
+    }
+
+    // Attacks are sent once both players have stepped, so neither side's
+    // garbage depends on the order they are updated in
+    for (int p = 0; p < MATCH_PLAYERS; p++) {
+        int width, height;
+        if ((events[p] & GAME_EVENT_CLEAR) && AttackFor(&match->players[p], &width, &height)) {
+            GameState_QueueGarbage(&match->players[MATCH_PLAYERS - 1 - p], width, height);
+        }
+    }
+
+    match->tick++;
+}
+
+void Match_Snapshot(Match* match)
+{
+    MatchSnapshot* snapshot = &match->snapshots[match->tick & (MATCH_SNAPSHOT_COUNT - 1)];
+
+    snapshot->tick = match->tick;
+    for (int p = 0; p < MATCH_PLAYERS; p++) {
+        snapshot->rowsConsumed[p] = RowQueue_RowsConsumed(&match->rows[p]);
+        snapshot->players[p] = match->players[p];
+    }
+}
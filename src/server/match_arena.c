@@ -0,0 +1,106 @@
+#include "match_arena.h"
+#include "match.h"
+#include <stdlib.h>
+
+// Round size up to a power-of-two alignment
+#define ALIGN_UP(size, align) (((size) + (align) - 1) & ~((size_t)(align) - 1))
+
+void MatchArena_Init(MatchArena* arena, void* memory, size_t size)
+{
+    arena->base = (uint8_t*)memory;
+    arena->size = size;
+    arena->used = 0;
+}
+
+void* MatchArena_Alloc(MatchArena* arena, size_t size)
+{
+    size_t offset = ALIGN_UP(arena->used, MATCH_ARENA_ALIGN);
+    if (offset + size > arena->size) {
+        return NULL;
+    }
+    arena->used = offset + size;
+    return arena->base + offset;
+}
+
+void MatchArena_Reset(MatchArena* arena)
+{
+    arena->used = 0;
+}
+
+// Offset of the arena region inside a slab
+static size_t ArenaOffset(void)
+{
+    return ALIGN_UP(sizeof(Match), MATCH_SLAB_ALIGN);
+}
+
+size_t MatchPool_SlabSize(void)
+{
+    return ALIGN_UP(ArenaOffset() + MATCH_ARENA_SIZE, MATCH_SLAB_ALIGN);
+}
+
+static Match* SlabAt(const MatchPool* pool, int index)
+{
+    return (Match*)(pool->memory + (size_t)index * pool->slabSize);
+}
+
+bool MatchPool_Init(MatchPool* pool, int capacity)
+{
+    pool->slabSize = MatchPool_SlabSize();
+    pool->capacity = capacity;
+    pool->active = 0;
+    pool->freeHead = -1;
+
+    pool->memory = aligned_alloc(MATCH_SLAB_ALIGN, pool->slabSize * (size_t)capacity);
+    if (!pool->memory) {
+        pool->capacity = 0;
+        return false;
+    }
+
+    // Chain every slab onto the free list, lowest index first
+    for (int i = capacity - 1; i >= 0; i--) {
+        SlabAt(pool, i)->poolNext = pool->freeHead;
+        pool->freeHead = i;
+    }
+    return true;
+}
+
+void MatchPool_Destroy(MatchPool* pool)
+{
+    free(pool->memory);
+    pool->memory = NULL;
+    pool->capacity = 0;
+    pool->active = 0;
+    pool->freeHead = -1;
+}
+
+Match* MatchPool_Acquire(MatchPool* pool, uint32_t matchId, uint64_t seed)
+{
+    if (pool->freeHead < 0) {
+        return NULL;
+    }
+
+    Match* match = SlabAt(pool, pool->freeHead);
+    pool->freeHead = match->poolNext;
+    pool->active++;
+
+    Match_Init(match, matchId, seed, (uint8_t*)match + ArenaOffset(), MATCH_ARENA_SIZE);
+    return match;
+}
+
+int MatchPool_IndexOf(const MatchPool* pool, const Match* match)
+{
+    return (int)(((const uint8_t*)match - pool->memory) / pool->slabSize);
+}
+
+void MatchPool_Release(MatchPool* pool, Match* match)
+{
+    int index = MatchPool_IndexOf(pool, match);
+
+    RowQueue_StopWorker(&match->rows[0]);
+    RowQueue_StopWorker(&match->rows[1]);
+    MatchArena_Reset(&match->arena);
+
+    match->poolNext = pool->freeHead;
+    pool->freeHead = index;
+    pool->active--;
+}
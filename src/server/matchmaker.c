@@ -0,0 +1,232 @@
+#include "matchmaker.h"
+#include "metrics.h"
+#include <string.h>
+
+#define NS_PER_SECOND 1000000000ull
+
+int Matchmaker_Window(uint64_t waitedNs)
+{
+    uint64_t window = MATCHMAKER_INITIAL_WINDOW +
+                      waitedNs * MATCHMAKER_WINDOW_PER_SECOND / NS_PER_SECOND;
+    return window < MATCHMAKER_MAX_WINDOW ? (int)window : MATCHMAKER_MAX_WINDOW;
+}
+
+void Matchmaker_Init(Matchmaker* matchmaker, uint64_t passIntervalNs, MatchmakerPairFn onPair,
+                     void* pairContext)
+{
+    memset(matchmaker, 0, sizeof(*matchmaker));
+    MpscQueue_Init(&matchmaker->inbox);
+    matchmaker->passIntervalNs = passIntervalNs ? passIntervalNs : MATCHMAKER_PASS_NS;
+    matchmaker->onPair = onPair;
+    matchmaker->pairContext = pairContext;
+}
+
+void Matchmaker_Join(Matchmaker* matchmaker, MatchmakerTicket* ticket, uint64_t nowNs)
+{
+    ticket->joinedNs = nowNs;
+    ticket->joinEvent.kind = MATCHMAKER_EVENT_JOIN;
+    ticket->joinEvent.ticket = ticket;
+    ticket->leaveEvent.kind = MATCHMAKER_EVENT_LEAVE;
+    ticket->leaveEvent.ticket = ticket;
+    atomic_store_explicit(&ticket->state, MATCHMAKER_TICKET_QUEUED, memory_order_relaxed);
+    atomic_fetch_add_explicit(&ticket->pendingEvents, 1, memory_order_relaxed);
+    MpscQueue_Push(&matchmaker->inbox, &ticket->joinEvent.node);
+}
+
+void Matchmaker_Leave(Matchmaker* matchmaker, MatchmakerTicket* ticket)
+{
+    atomic_fetch_add_explicit(&ticket->pendingEvents, 1, memory_order_relaxed);
+    MpscQueue_Push(&matchmaker->inbox, &ticket->leaveEvent.node);
+}
+
+bool Matchmaker_TicketSettled(MatchmakerTicket* ticket)
+{
+    return atomic_load_explicit(&ticket->pendingEvents, memory_order_acquire) == 0 &&
+           atomic_load_explicit(&ticket->state, memory_order_acquire) != MATCHMAKER_TICKET_QUEUED;
+}
+
+static int BucketOf(int32_t rating)
+{
+    if (rating < 0) {
+        rating = 0;
+    } else if (rating >= MATCHMAKER_RATING_MAX) {
+        rating = MATCHMAKER_RATING_MAX - 1;
+    }
+    return rating / MATCHMAKER_BUCKET_WIDTH;
+}
+
+static void Enqueue(Matchmaker* matchmaker, MatchmakerTicket* ticket)
+{
+    int bucket = BucketOf(ticket->rating);
+    ticket->bucket = (int16_t)bucket;
+    ticket->next = NULL;
+    ticket->prev = matchmaker->tail[bucket];
+    if (ticket->prev) {
+        ticket->prev->next = ticket;
+    } else {
+        matchmaker->head[bucket] = ticket;
+    }
+    matchmaker->tail[bucket] = ticket;
+    matchmaker->count[bucket]++;
+    matchmaker->occupied[bucket / 64] |= 1ull << (bucket % 64);
+    matchmaker->waiting++;
+}
+
+static void Unlink(Matchmaker* matchmaker, MatchmakerTicket* ticket)
+{
+    int bucket = ticket->bucket;
+    if (ticket->prev) {
+        ticket->prev->next = ticket->next;
+    } else {
+        matchmaker->head[bucket] = ticket->next;
+    }
+    if (ticket->next) {
+        ticket->next->prev = ticket->prev;
+    } else {
+        matchmaker->tail[bucket] = ticket->prev;
+    }
+    if (--matchmaker->count[bucket] == 0) {
+        matchmaker->occupied[bucket / 64] &= ~(1ull << (bucket % 64));
+    }
+    ticket->bucket = -1;
+    matchmaker->waiting--;
+}
+
+// Finish a ticket's event; after this its owner may reuse it
+static void SettleEvent(MatchmakerTicket* ticket)
+{
+    atomic_fetch_sub_explicit(&ticket->pendingEvents, 1, memory_order_release);
+}
+
+static void Pair(Matchmaker* matchmaker, MatchmakerTicket* a, MatchmakerTicket* b, uint64_t nowNs)
+{
+    Unlink(matchmaker, a);
+    Unlink(matchmaker, b);
+    matchmaker->stats.pairs++;
+    if (matchmaker->onPair) {
+        matchmaker->onPair(matchmaker->pairContext, a, b, nowNs);
+    }
+    atomic_store_explicit(&a->state, MATCHMAKER_TICKET_MATCHED, memory_order_release);
+    atomic_store_explicit(&b->state, MATCHMAKER_TICKET_MATCHED, memory_order_release);
+}
+
+static void DrainInbox(Matchmaker* matchmaker)
+{
+    MpscNode* node;
+    while ((node = MpscQueue_Pop(&matchmaker->inbox)) != NULL) {
+        MatchmakerEvent* event = MPSC_CONTAINER(node, MatchmakerEvent, node);
+        MatchmakerTicket* ticket = event->ticket;
+
+        if (event->kind == MATCHMAKER_EVENT_JOIN) {
+            Enqueue(matchmaker, ticket);
+            matchmaker->stats.joins++;
+        } else if (ticket->bucket >= 0) {
+            Unlink(matchmaker, ticket);
+            atomic_store_explicit(&ticket->state, MATCHMAKER_TICKET_LEFT, memory_order_release);
+            matchmaker->stats.leaves++;
+        }
+        SettleEvent(ticket);
+    }
+}
+
+static int AbsInt(int value)
+{
+    return value < 0 ? -value : value;
+}
+
+// Order leftovers oldest first (insertion sort; there is at most one per bucket)
+static void SortByAge(MatchmakerTicket** tickets, int count)
+{
+    for (int i = 1; i < count; i++) {
+        MatchmakerTicket* ticket = tickets[i];
+        int j = i - 1;
+        while (j >= 0 && tickets[j]->joinedNs > ticket->joinedNs) {
+            tickets[j + 1] = tickets[j];
+            j--;
+        }
+        tickets[j + 1] = ticket;
+    }
+}
+
+static int RunPass(Matchmaker* matchmaker, uint64_t nowNs)
+{
+    int pairs = 0;
+
+    // Pair within each bucket, oldest first, leaving at most one behind
+    MatchmakerTicket* leftovers[MATCHMAKER_BUCKETS];
+    int leftoverCount = 0;
+    for (int word = 0; word < (MATCHMAKER_BUCKETS + 63) / 64; word++) {
+        uint64_t bits = matchmaker->occupied[word];
+        while (bits) {
+            int bucket = word * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            while (matchmaker->count[bucket] >= 2) {
+                MatchmakerTicket* a = matchmaker->head[bucket];
+                Pair(matchmaker, a, a->next, nowNs);
+                matchmaker->stats.sameBucketPairs++;
+                pairs++;
+            }
+            if (matchmaker->count[bucket] == 1) {
+                leftovers[leftoverCount++] = matchmaker->head[bucket];
+            }
+        }
+    }
+
+    // Pair leftovers across buckets: oldest first, with the nearest rating
+    // that both windows accept
+    SortByAge(leftovers, leftoverCount);
+    for (int i = 0; i < leftoverCount; i++) {
+        MatchmakerTicket* ticket = leftovers[i];
+        if (ticket->bucket < 0) {
+            continue;
+        }
+        int window = Matchmaker_Window(nowNs - ticket->joinedNs);
+        int reach = window / MATCHMAKER_BUCKET_WIDTH + 1;
+        MatchmakerTicket* best = NULL;
+        int bestDistance = window + 1;
+
+        for (int d = 1; d <= reach; d++) {
+            // Nothing nearer can be found once whole buckets are out of range
+            if ((d - 1) * MATCHMAKER_BUCKET_WIDTH > bestDistance) {
+                break;
+            }
+            for (int side = -1; side <= 1; side += 2) {
+                int bucket = ticket->bucket + side * d;
+                if (bucket < 0 || bucket >= MATCHMAKER_BUCKETS || matchmaker->count[bucket] == 0) {
+                    continue;
+                }
+                MatchmakerTicket* other = matchmaker->head[bucket];
+                int distance = AbsInt(other->rating - ticket->rating);
+                if (distance < bestDistance && distance <= Matchmaker_Window(nowNs - other->joinedNs)) {
+                    best = other;
+                    bestDistance = distance;
+                }
+            }
+        }
+
+        if (best) {
+            Pair(matchmaker, ticket, best, nowNs);
+            matchmaker->stats.widenedPairs++;
+            pairs++;
+        }
+    }
+    return pairs;
+}
+
+int Matchmaker_Poll(Matchmaker* matchmaker, uint64_t nowNs)
+{
+    uint64_t start = Metrics_NowNs();
+    DrainInbox(matchmaker);
+    uint64_t drained = Metrics_NowNs();
+    matchmaker->stats.drainNs += drained - start;
+
+    if (nowNs < matchmaker->nextPassNs) {
+        return 0;
+    }
+    matchmaker->nextPassNs = nowNs + matchmaker->passIntervalNs;
+
+    int pairs = RunPass(matchmaker, nowNs);
+    matchmaker->stats.passes++;
+    matchmaker->stats.passNs += Metrics_NowNs() - drained;
+    return pairs;
+}
@@ -0,0 +1,344 @@
+#define _GNU_SOURCE
+#include "scheduler.h"
+#include "logger.h"
+#include "metrics.h"
+#include "spectator.h"
+#include "state_publisher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#define NS_PER_SEC 1000000000ull
+#define NS_PER_MS  1000000ull
+
+// Clock time at which a room's given tick is due
+static uint64_t TickDueNs(const Room* room, uint32_t tick)
+{
+    return room->baseNs + (uint64_t)tick * NS_PER_SEC / GAME_TICK_RATE;
+}
+
+uint64_t Scheduler_NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+static bool IsRoomIdle(const Room* room)
+{
+    return room->match->tick - room->lastInputTick > ROOM_IDLE_TICKS;
+}
+
+// Hand an idle room to another shard if the control thread asked for it
+static bool TryMigrate(Shard* shard, Room* room)
+{
+    if (atomic_load_explicit(&shard->migrateCount, memory_order_relaxed) <= 0 || !IsRoomIdle(room)) {
+        return false;
+    }
+    if (atomic_fetch_sub_explicit(&shard->migrateCount, 1, memory_order_relaxed) <= 0) {
+        atomic_fetch_add_explicit(&shard->migrateCount, 1, memory_order_relaxed);
+        return false;
+    }
+
+    int target = atomic_load_explicit(&shard->migrateTarget, memory_order_acquire);
+    Shard* dest = &shard->scheduler->shards[target];
+
+    atomic_fetch_sub_explicit(&shard->counters.rooms, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&shard->counters.migratedOut, 1, memory_order_relaxed);
+    LOG_EVENT(ROOM_MIGRATED, room->match->id, shard->index, target);
+    atomic_fetch_add_explicit(&dest->counters.rooms, 1, memory_order_relaxed);
+    MpscQueue_Push(&dest->inbox, &room->queueNode);
+    return true;
+}
+
+// Timer callback: run the room's due tick(s) and schedule the next one
+static void OnRoomDue(TimerNode* node, void* context)
+{
+    Room* room = (Room*)((char*)node - offsetof(Room, timer));
+    Shard* shard = (Shard*)context;
+    Scheduler* scheduler = shard->scheduler;
+    Match* match = room->match;
+
+    uint64_t start = Scheduler_NowNs();
+    uint64_t due = TickDueNs(room, match->tick);
+    uint64_t periodNs = NS_PER_SEC / GAME_TICK_RATE;
+
+    // Late rooms catch up a few ticks back-to-back, then resync to the clock
+    uint64_t behind = (start > due) ? (start - due) / periodNs : 0;
+    if (behind > 0) {
+        atomic_fetch_add_explicit(&shard->counters.overruns, 1, memory_order_relaxed);
+        Metrics_Count(METRIC_OVERRUNS, 1);
+        LOG_EVENT(TICK_OVERRUN, match->id, match->tick, (unsigned)behind);
+    }
+    int ticksToRun = 1 + (int)(behind < SCHEDULER_MAX_CATCHUP - 1 ? behind : SCHEDULER_MAX_CATCHUP - 1);
+
+    for (int i = 0; i < ticksToRun; i++) {
+        if (scheduler->inputHook) {
+            scheduler->inputHook(room, scheduler->hookContext);
+        }
+        int slot = (int)(match->tick & (MATCH_INPUT_HISTORY - 1));
+        if (match->inputs[0][slot].flags || match->inputs[1][slot].flags) {
+            room->lastInputTick = match->tick;
+        }
+        uint64_t tickStart = Metrics_Begin();
+        Match_Tick(match);
+        Metrics_RecordSince(METRIC_TICK, tickStart);
+        Metrics_RecordSpan(METRIC_DETECT_MATCHES);
+        Metrics_RecordSpan(METRIC_APPLY_GRAVITY);
+        if (scheduler->publisher) {
+            int first = MatchPool_IndexOf(&scheduler->pool, match) * MATCH_PLAYERS;
+            for (int p = 0; p < MATCH_PLAYERS; p++) {
+                StatePublisher_Publish(scheduler->publisher, first + p, match->id, p,
+                                       match->tick, &match->players[p]);
+            }
+        }
+    }
+    if (room->spectators) {
+        // Catch-up ticks collapse into a single update for viewers
+        SpectatorChannel_Publish(room->spectators, match);
+    }
+    atomic_fetch_add_explicit(&shard->counters.ticks, (unsigned long)ticksToRun, memory_order_relaxed);
+
+    if (behind >= SCHEDULER_MAX_CATCHUP) {
+        // Shift the timeline instead of running an unbounded burst
+        uint64_t dropped = behind + 1 - (uint64_t)ticksToRun;
+        room->baseNs += dropped * periodNs;
+        atomic_fetch_add_explicit(&shard->counters.droppedTicks, (unsigned long)dropped, memory_order_relaxed);
+        LOG_EVENT(TICKS_DROPPED, match->id, (unsigned)dropped);
+    }
+
+    atomic_fetch_add_explicit(&shard->counters.busyNs,
+                              (unsigned long)(Scheduler_NowNs() - start), memory_order_relaxed);
+
+    if (room->maxTicks && match->tick >= room->maxTicks) {
+        atomic_fetch_sub_explicit(&shard->counters.rooms, 1, memory_order_relaxed);
+        MpscQueue_Push(&scheduler->finished, &room->queueNode);
+        return;
+    }
+    if (TryMigrate(shard, room)) {
+        return;
+    }
+
+    TimerWheel_Schedule(&shard->wheel, &room->timer, TickDueNs(room, match->tick) / NS_PER_MS);
+}
+
+static void PinToCore(int index)
+{
+#ifdef __linux__
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores > 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(index % cores, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#else
+    (void)index;
+#endif
+}
+
+static void* ShardMain(void* arg)
+{
+    Shard* shard = (Shard*)arg;
+    Scheduler* scheduler = shard->scheduler;
+
+    if (scheduler->pinThreads) {
+        PinToCore(shard->index);
+    }
+    Metrics_RegisterThread();
+    char name[16];
+    snprintf(name, sizeof(name), "shard-%d", shard->index);
+    Logger_RegisterThread(name);
+    TimerWheel_Init(&shard->wheel, Scheduler_NowNs() / NS_PER_MS);
+
+    while (atomic_load_explicit(&scheduler->running, memory_order_acquire)) {
+        // Adopt new and migrated rooms
+        MpscNode* node;
+        while ((node = MpscQueue_Pop(&shard->inbox)) != NULL) {
+            Room* room = MPSC_CONTAINER(node, Room, queueNode);
+            room->shard = shard->index;
+            TimerWheel_Schedule(&shard->wheel, &room->timer,
+                                TickDueNs(room, room->match->tick) / NS_PER_MS);
+        }
+
+        uint64_t now = Scheduler_NowNs();
+        TimerWheel_Advance(&shard->wheel, now / NS_PER_MS, OnRoomDue, shard);
+
+        // Sleep to the next millisecond boundary
+        uint64_t wake = (now / NS_PER_MS + 1) * NS_PER_MS;
+        now = Scheduler_NowNs();
+        if (wake > now) {
+            struct timespec ts = { 0, (long)(wake - now) };
+            nanosleep(&ts, NULL);
+        }
+    }
+    return NULL;
+}
+
+bool Scheduler_Init(Scheduler* scheduler, int shardCount, int roomCapacity, bool pinThreads)
+{
+    if (shardCount < 1) shardCount = 1;
+    if (shardCount > SCHEDULER_MAX_SHARDS) shardCount = SCHEDULER_MAX_SHARDS;
+
+    memset(scheduler, 0, sizeof(*scheduler));
+    scheduler->shardCount = shardCount;
+    scheduler->pinThreads = pinThreads;
+
+    if (!MatchPool_Init(&scheduler->pool, roomCapacity)) {
+        return false;
+    }
+    scheduler->rooms = calloc((size_t)roomCapacity, sizeof(Room));
+    if (!scheduler->rooms) {
+        MatchPool_Destroy(&scheduler->pool);
+        return false;
+    }
+
+    MpscQueue_Init(&scheduler->finished);
+    atomic_init(&scheduler->running, false);
+
+    for (int i = 0; i < shardCount; i++) {
+        Shard* shard = &scheduler->shards[i];
+        shard->scheduler = scheduler;
+        shard->index = i;
+        MpscQueue_Init(&shard->inbox);
+        atomic_init(&shard->migrateCount, 0);
+        atomic_init(&shard->migrateTarget, 0);
+    }
+    return true;
+}
+
+void Scheduler_Destroy(Scheduler* scheduler)
+{
+    free(scheduler->rooms);
+    scheduler->rooms = NULL;
+    MatchPool_Destroy(&scheduler->pool);
+}
+
+void Scheduler_SetInputHook(Scheduler* scheduler, RoomInputHook hook, void* context)
+{
+    scheduler->inputHook = hook;
+    scheduler->hookContext = context;
+}
+
+void Scheduler_SetStatePublisher(Scheduler* scheduler, struct StatePublisher* publisher)
+{
+    scheduler->publisher = publisher;
+}
+
+bool Scheduler_Start(Scheduler* scheduler)
+{
+    atomic_store(&scheduler->running, true);
+    scheduler->lastRebalanceNs = Scheduler_NowNs();
+
+    for (int i = 0; i < scheduler->shardCount; i++) {
+        if (pthread_create(&scheduler->shards[i].thread, NULL, ShardMain, &scheduler->shards[i]) != 0) {
+            scheduler->shardCount = i;
+            Scheduler_Stop(scheduler);
+            return false;
+        }
+    }
+    return true;
+}
+
+void Scheduler_Stop(Scheduler* scheduler)
+{
+    atomic_store(&scheduler->running, false);
+    for (int i = 0; i < scheduler->shardCount; i++) {
+        pthread_join(scheduler->shards[i].thread, NULL);
+    }
+}
+
+Room* Scheduler_CreateRoom(Scheduler* scheduler, uint64_t seed, uint32_t maxTicks)
+{
+    Match* match = MatchPool_Acquire(&scheduler->pool, scheduler->nextMatchId, seed);
+    if (!match) {
+        return NULL;
+    }
+    scheduler->nextMatchId++;
+
+    Room* room = &scheduler->rooms[MatchPool_IndexOf(&scheduler->pool, match)];
+    memset(room, 0, sizeof(*room));
+    room->match = match;
+    room->baseNs = Scheduler_NowNs();
+    room->maxTicks = maxTicks;
+
+    // Least-loaded shard by room count
+    int best = 0;
+    int bestRooms = atomic_load(&scheduler->shards[0].counters.rooms);
+    for (int i = 1; i < scheduler->shardCount; i++) {
+        int rooms = atomic_load(&scheduler->shards[i].counters.rooms);
+        if (rooms < bestRooms) {
+            best = i;
+            bestRooms = rooms;
+        }
+    }
+
+    room->shard = best;
+    atomic_fetch_add(&scheduler->shards[best].counters.rooms, 1);
+    MpscQueue_Push(&scheduler->shards[best].inbox, &room->queueNode);
+    LOG_EVENT(ROOM_CREATED, match->id, best);
+    return room;
+}
+
+// Ask the busiest shard to move idle rooms to the quietest one
+static void Rebalance(Scheduler* scheduler)
+{
+    int busiest = 0, quietest = 0;
+    int most = atomic_load(&scheduler->shards[0].counters.rooms);
+    int least = most;
+
+    for (int i = 1; i < scheduler->shardCount; i++) {
+        int rooms = atomic_load(&scheduler->shards[i].counters.rooms);
+        if (rooms > most) { most = rooms; busiest = i; }
+        if (rooms < least) { least = rooms; quietest = i; }
+    }
+
+    if (most - least > 1) {
+        Shard* shard = &scheduler->shards[busiest];
+        atomic_store_explicit(&shard->migrateTarget, quietest, memory_order_release);
+        atomic_store_explicit(&shard->migrateCount, (most - least) / 2, memory_order_release);
+    }
+}
+
+int Scheduler_Poll(Scheduler* scheduler)
+{
+    int released = 0;
+    MpscNode* node;
+
+    while ((node = MpscQueue_Pop(&scheduler->finished)) != NULL) {
+        Room* room = MPSC_CONTAINER(node, Room, queueNode);
+        LOG_EVENT(ROOM_FINISHED, room->match->id, room->match->tick);
+        MatchPool_Release(&scheduler->pool, room->match);
+        room->match = NULL;
+        released++;
+    }
+
+    int rooms = 0;
+    for (int i = 0; i < scheduler->shardCount; i++) {
+        rooms += atomic_load_explicit(&scheduler->shards[i].counters.rooms, memory_order_relaxed);
+    }
+    Metrics_SetGauge(METRIC_ACTIVE_ROOMS, rooms);
+
+    uint64_t now = Scheduler_NowNs();
+    if (now - scheduler->lastRebalanceNs >= SCHEDULER_REBALANCE_NS) {
+        scheduler->lastRebalanceNs = now;
+        Rebalance(scheduler);
+    }
+    return released;
+}
+
+void Scheduler_GetShardStats(Scheduler* scheduler, int shard, ShardStats* out)
+{
+    ShardCounters* counters = &scheduler->shards[shard].counters;
+    out->ticks = atomic_load_explicit(&counters->ticks, memory_order_relaxed);
+    out->overruns = atomic_load_explicit(&counters->overruns, memory_order_relaxed);
+    out->droppedTicks = atomic_load_explicit(&counters->droppedTicks, memory_order_relaxed);
+    out->busyNs = atomic_load_explicit(&counters->busyNs, memory_order_relaxed);
+    out->migratedOut = atomic_load_explicit(&counters->migratedOut, memory_order_relaxed);
+    out->rooms = atomic_load_explicit(&counters->rooms, memory_order_relaxed);
+}
@@ -0,0 +1,772 @@
+#define _POSIX_C_SOURCE 200809L
+#include "logger.h"
+#include "match.h"
+#include "match_arena.h"
+#include "matchmaker.h"
+#include "metrics.h"
+#include "rng.h"
+#include "scheduler.h"
+#include "spectator.h"
+#include "state_publisher.h"
+#include <arpa/inet.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// Default number of matches for --arena-report
+static const int ARENA_REPORT_MATCHES = 1000;
+
+// Default number of viewers for --bench-spectators
+#define SPECTATOR_BENCH_VIEWERS 1000
+
+// Resident set size in bytes (0 where /proc is unavailable)
+static size_t GetResidentBytes(void)
+{
+    long pages = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        long size;
+        if (fscanf(statm, "%ld %ld", &size, &pages) != 2) {
+            pages = 0;
+        }
+        fclose(statm);
+    }
+    return (size_t)pages * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+// Fill a pool with matches, tick them, and report the memory they cost
+static int RunArenaReport(int count)
+{
+    size_t rssBefore = GetResidentBytes();
+
+    MatchPool pool;
+    if (!MatchPool_Init(&pool, count)) {
+        fprintf(stderr, "Failed to reserve %d match slabs\n", count);
+        return 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        Match* match = MatchPool_Acquire(&pool, (uint32_t)i, (uint64_t)i * 7919u + 1u);
+        for (int t = 0; t < GAME_TICK_RATE; t++) {
+            Match_Tick(match);
+        }
+        Match_Snapshot(match);
+    }
+
+    size_t rssAfter = GetResidentBytes();
+
+    printf("Match struct:      %zu bytes\n", sizeof(Match));
+    printf("  GameState:       %zu bytes x %d\n", sizeof(GameState), MATCH_PLAYERS);
+    printf("  GravityAnim:     %zu bytes (of GameState)\n", sizeof(GravityAnimation));
+    printf("  RowQueue:        %zu bytes x %d\n", sizeof(RowQueue), MATCH_PLAYERS);
+    printf("  Input history:   %zu bytes\n", sizeof(((Match*)0)->inputs));
+    printf("  Snapshots:       %zu bytes\n", sizeof(((Match*)0)->snapshots));
+    printf("Match arena:       %d bytes\n", MATCH_ARENA_SIZE);
+    printf("Slab (per match):  %zu bytes\n", pool.slabSize);
+    printf("Matches:           %d\n", count);
+    if (rssAfter > 0) {
+        double perThousand = (double)(rssAfter - rssBefore) * 1000.0 / count;
+        printf("RSS growth:        %.1f KiB total, %.1f KiB per 1000 matches\n",
+               (double)(rssAfter - rssBefore) / 1024.0, perThousand / 1024.0);
+        printf("RSS total:         %.1f KiB\n", (double)rssAfter / 1024.0);
+    }
+
+    MatchPool_Destroy(&pool);
+    return 0;
+}
+
+// Scheduler benchmark settings
+typedef struct {
+    int shards;
+    int rooms;
+    int seconds;
+    bool pin;
+    const char* publishName;    // Shared-memory segment for live boards (NULL = off)
+} SchedulerBenchConfig;
+
+// Stand-in for network input: each player swaps somewhere every few ticks
+// and occasionally raises the stack
+static void BotInputHook(Room* room, void* context)
+{
+    (void)context;
+    Match* match = room->match;
+
+    for (int p = 0; p < MATCH_PLAYERS; p++) {
+        Rng rng;
+        Rng_Seed(&rng, match->seed ^ ((uint64_t)match->tick << 1), (uint64_t)p);
+        if (Rng_Range(&rng, 8) != 0) {
+            continue;
+        }
+
+        GameInput input;
+        input.x = (uint8_t)Rng_Range(&rng, BOARD_WIDTH - 1);
+        input.y = (uint8_t)Rng_Range(&rng, BOARD_HEIGHT);
+        input.flags = (Rng_Range(&rng, 50) == 0) ? GAME_INPUT_RAISE : GAME_INPUT_SWAP;
+        Match_SubmitInput(match, p, match->tick, &input);
+    }
+}
+
+// Run rooms on the sharded scheduler and report per-shard tick overruns
+static int RunSchedulerBench(const SchedulerBenchConfig* config)
+{
+    static Scheduler scheduler;
+    if (!Scheduler_Init(&scheduler, config->shards, config->rooms, config->pin)) {
+        fprintf(stderr, "Failed to reserve %d rooms\n", config->rooms);
+        return 1;
+    }
+    Scheduler_SetInputHook(&scheduler, BotInputHook, NULL);
+    static StatePublisher publisher;
+    if (config->publishName) {
+        if (!StatePublisher_Open(&publisher, config->publishName, "server")) {
+            fprintf(stderr, "Cannot create shared memory segment %s\n", config->publishName);
+            Scheduler_Destroy(&scheduler);
+            return 1;
+        }
+        Scheduler_SetStatePublisher(&scheduler, &publisher);
+    }
+    if (!Scheduler_Start(&scheduler)) {
+        fprintf(stderr, "Failed to start shard threads\n");
+        StatePublisher_Close(&publisher);
+        Scheduler_Destroy(&scheduler);
+        return 1;
+    }
+
+    uint64_t start = Scheduler_NowNs();
+    for (int i = 0; i < config->rooms; i++) {
+        Scheduler_CreateRoom(&scheduler, (uint64_t)i * 7919u + 1u, 0);
+    }
+
+    struct timespec pollInterval = { 0, 10 * 1000 * 1000 };
+    while (Scheduler_NowNs() - start < (uint64_t)config->seconds * 1000000000ull) {
+        Scheduler_Poll(&scheduler);
+        nanosleep(&pollInterval, NULL);
+    }
+    double elapsed = (double)(Scheduler_NowNs() - start) / 1e9;
+
+    Scheduler_Stop(&scheduler);
+
+    unsigned long totalTicks = 0, totalOverruns = 0;
+    printf("shard  rooms  ticks/s   overruns  dropped  migrated  busy%%\n");
+    for (int i = 0; i < scheduler.shardCount; i++) {
+        ShardStats stats;
+        Scheduler_GetShardStats(&scheduler, i, &stats);
+        totalTicks += stats.ticks;
+        totalOverruns += stats.overruns;
+        printf("%5d  %5d  %8.0f  %8lu  %7lu  %8lu  %5.1f\n",
+               i, stats.rooms, (double)stats.ticks / elapsed, stats.overruns,
+               stats.droppedTicks, stats.migratedOut,
+               100.0 * (double)stats.busyNs / 1e9 / elapsed);
+    }
+
+    double required = (double)config->rooms * GAME_TICK_RATE;
+    double achieved = (double)totalTicks / elapsed;
+    printf("rooms %d on %d shards: %.0f room-ticks/s (%.1f%% of %.0f needed), %lu overruns\n",
+           config->rooms, scheduler.shardCount, achieved, 100.0 * achieved / required,
+           required, totalOverruns);
+
+    StatePublisher_Close(&publisher);
+    Scheduler_Destroy(&scheduler);
+    return 0;
+}
+
+// Loopback sockets standing in for spectator clients (viewers share them round-robin)
+#define BENCH_RECEIVERS 16
+
+typedef struct {
+    int sockets[BENCH_RECEIVERS];
+    atomic_bool running;
+    atomic_ulong datagrams;
+    atomic_ulong bytes;
+} SpectatorSink;
+
+static void* SpectatorSinkMain(void* arg)
+{
+    SpectatorSink* sink = (SpectatorSink*)arg;
+    struct pollfd fds[BENCH_RECEIVERS];
+    uint8_t buffer[SPECTATOR_PACKET_SIZE];
+
+    for (int i = 0; i < BENCH_RECEIVERS; i++) {
+        fds[i].fd = sink->sockets[i];
+        fds[i].events = POLLIN;
+    }
+    while (atomic_load(&sink->running)) {
+        if (poll(fds, BENCH_RECEIVERS, 50) <= 0) {
+            continue;
+        }
+        for (int i = 0; i < BENCH_RECEIVERS; i++) {
+            if (!(fds[i].revents & POLLIN)) {
+                continue;
+            }
+            ssize_t length;
+            while ((length = recv(fds[i].fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+                atomic_fetch_add_explicit(&sink->datagrams, 1, memory_order_relaxed);
+                atomic_fetch_add_explicit(&sink->bytes, (unsigned long)length, memory_order_relaxed);
+            }
+        }
+    }
+    return NULL;
+}
+
+static double ThreadCpuSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Broadcast one bot-driven match to many loopback viewers at the tick rate
+// and report fan-out throughput and publisher CPU per viewer
+static int RunSpectatorBench(int viewers, int seconds)
+{
+    SpectatorSink sink;
+    struct sockaddr_in addresses[BENCH_RECEIVERS];
+    int sendSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sendSocket < 0) {
+        perror("socket");
+        return 1;
+    }
+    int bufferSize = 8 * 1024 * 1024;
+    setsockopt(sendSocket, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+
+    for (int i = 0; i < BENCH_RECEIVERS; i++) {
+        sink.sockets[i] = socket(AF_INET, SOCK_DGRAM, 0);
+        setsockopt(sink.sockets[i], SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+        memset(&addresses[i], 0, sizeof(addresses[i]));
+        addresses[i].sin_family = AF_INET;
+        addresses[i].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(addresses[i]);
+        if (sink.sockets[i] < 0 ||
+            bind(sink.sockets[i], (struct sockaddr*)&addresses[i], sizeof(addresses[i])) != 0 ||
+            getsockname(sink.sockets[i], (struct sockaddr*)&addresses[i], &length) != 0) {
+            perror("receiver socket");
+            return 1;
+        }
+    }
+
+    static MatchPool pool;
+    static SpectatorChannel channel;
+    if (!MatchPool_Init(&pool, 1) ||
+        !SpectatorChannel_Init(&channel, sendSocket, 1, viewers)) {
+        fprintf(stderr, "Failed to allocate the match or %d viewers\n", viewers);
+        return 1;
+    }
+    Match* match = MatchPool_Acquire(&pool, 1, 12345);
+    Room room = { .match = match };
+    for (int i = 0; i < viewers; i++) {
+        SpectatorChannel_Subscribe(&channel, (struct sockaddr*)&addresses[i % BENCH_RECEIVERS],
+                                   sizeof(addresses[i % BENCH_RECEIVERS]));
+    }
+
+    atomic_init(&sink.running, true);
+    atomic_init(&sink.datagrams, 0);
+    atomic_init(&sink.bytes, 0);
+    pthread_t sinkThread;
+    pthread_create(&sinkThread, NULL, SpectatorSinkMain, &sink);
+
+    uint64_t periodNs = 1000000000ull / GAME_TICK_RATE;
+    uint64_t start = Scheduler_NowNs();
+    uint64_t ticks = (uint64_t)seconds * GAME_TICK_RATE;
+    double publishCpu = 0.0;
+
+    for (uint64_t t = 0; t < ticks; t++) {
+        BotInputHook(&room, NULL);
+        Match_Tick(match);
+
+        double cpuBefore = ThreadCpuSeconds();
+        SpectatorChannel_Publish(&channel, match);
+        publishCpu += ThreadCpuSeconds() - cpuBefore;
+
+        uint64_t due = start + (t + 1) * periodNs;
+        uint64_t now = Scheduler_NowNs();
+        if (due > now) {
+            struct timespec ts = { (time_t)((due - now) / 1000000000ull), (long)((due - now) % 1000000000ull) };
+            nanosleep(&ts, NULL);
+        }
+    }
+    double elapsed = (double)(Scheduler_NowNs() - start) / 1e9;
+
+    // Give the receiver a moment to drain what is still queued
+    struct timespec drain = { 0, 100 * 1000 * 1000 };
+    nanosleep(&drain, NULL);
+    atomic_store(&sink.running, false);
+    pthread_join(sinkThread, NULL);
+
+    const SpectatorStats* stats = &channel.stats;
+    unsigned long received = atomic_load(&sink.datagrams);
+    printf("viewers %d, %lu ticks in %.2f s\n", viewers, (unsigned long)stats->ticksPublished, elapsed);
+    printf("encoded:     %.1f bytes/tick (once per tick)\n",
+           (double)stats->encodeBytes / (double)stats->ticksPublished);
+    printf("sent:        %.0f datagrams/s, %.2f MB/s, %lu send errors\n",
+           (double)stats->datagramsSent / elapsed, (double)stats->bytesSent / elapsed / 1e6,
+           (unsigned long)stats->sendErrors);
+    printf("received:    %.0f datagrams/s, %.2f MB/s (%.1f%% of sent)\n",
+           (double)received / elapsed, (double)atomic_load(&sink.bytes) / elapsed / 1e6,
+           stats->datagramsSent ? 100.0 * (double)received / (double)stats->datagramsSent : 0.0);
+    printf("publish CPU: %.1f us/tick, %.0f ns per viewer per tick, %.1f%% of one core\n",
+           publishCpu * 1e6 / (double)stats->ticksPublished,
+           publishCpu * 1e9 / (double)stats->ticksPublished / viewers,
+           100.0 * publishCpu / elapsed);
+
+    SpectatorChannel_Destroy(&channel);
+    MatchPool_Destroy(&pool);
+    close(sendSocket);
+    for (int i = 0; i < BENCH_RECEIVERS; i++) {
+        close(sink.sockets[i]);
+    }
+    return 0;
+}
+
+// Threads standing in for network threads in --bench-matchmaker
+#define MATCHMAKER_BENCH_PRODUCERS 2
+
+// Pairing latency histogram: 1 ms buckets
+#define MATCHMAKER_LATENCY_BUCKETS 30000
+
+// One in this many queued players gives up before being matched
+#define MATCHMAKER_LEAVE_ODDS 50
+
+typedef struct {
+    Matchmaker* matchmaker;
+    MatchmakerTicket* tickets;
+    int ticketCount;
+    double rate;                // Arrivals per second from this thread
+    uint64_t seed;
+    atomic_bool* running;
+    uint64_t arrivals;
+    uint64_t leaveRequests;
+    uint64_t poolExhausted;     // Arrivals skipped for lack of a settled ticket
+} MatchmakerProducer;
+
+typedef struct {
+    uint32_t latency[MATCHMAKER_LATENCY_BUCKETS];
+    uint64_t players;
+    uint64_t ratingDifference;
+    uint32_t maxDifference;
+} MatchmakerBenchResults;
+
+// Ratings roughly normal around 1500 (Irwin-Hall sum of uniforms)
+static int32_t SyntheticRating(Rng* rng)
+{
+    int32_t sum = 0;
+    for (int i = 0; i < 4; i++) {
+        sum += (int32_t)Rng_Range(rng, 701);
+    }
+    return 1500 + sum - 1400;
+}
+
+static void* MatchmakerProducerMain(void* arg)
+{
+    MatchmakerProducer* producer = (MatchmakerProducer*)arg;
+    Rng rng;
+    Rng_Seed(&rng, producer->seed, 0);
+    int cursor = 0;
+    uint64_t start = Scheduler_NowNs();
+    struct timespec pause = { 0, 200 * 1000 };
+
+    while (atomic_load_explicit(producer->running, memory_order_relaxed)) {
+        uint64_t now = Scheduler_NowNs();
+        uint64_t due = (uint64_t)((double)(now - start) * producer->rate / 1e9);
+
+        while (producer->arrivals < due) {
+            // Next ticket the matchmaker has finished with
+            MatchmakerTicket* ticket = NULL;
+            for (int tries = 0; tries < 64 && !ticket; tries++) {
+                MatchmakerTicket* candidate = &producer->tickets[cursor];
+                cursor = (cursor + 1) % producer->ticketCount;
+                if (Matchmaker_TicketSettled(candidate)) {
+                    ticket = candidate;
+                }
+            }
+            producer->arrivals++;
+            if (!ticket) {
+                producer->poolExhausted++;
+                continue;
+            }
+
+            ticket->rating = SyntheticRating(&rng);
+            Matchmaker_Join(producer->matchmaker, ticket, now);
+
+            // Some players give up: withdraw one that joined a while ago
+            if (Rng_Range(&rng, MATCHMAKER_LEAVE_ODDS) == 0) {
+                int back = (int)Rng_Range(&rng, 256) + 1;
+                MatchmakerTicket* quitter =
+                    &producer->tickets[(cursor - back + producer->ticketCount) % producer->ticketCount];
+                // Queued, join applied and no leave sent yet
+                if (atomic_load_explicit(&quitter->pendingEvents, memory_order_acquire) == 0 &&
+                    atomic_load_explicit(&quitter->state, memory_order_acquire) == MATCHMAKER_TICKET_QUEUED) {
+                    Matchmaker_Leave(producer->matchmaker, quitter);
+                    producer->leaveRequests++;
+                }
+            }
+        }
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+static void OnBenchPair(void* context, MatchmakerTicket* a, MatchmakerTicket* b, uint64_t nowNs)
+{
+    MatchmakerBenchResults* results = (MatchmakerBenchResults*)context;
+    MatchmakerTicket* players[2] = { a, b };
+    for (int i = 0; i < 2; i++) {
+        uint64_t ms = (nowNs - players[i]->joinedNs) / 1000000ull;
+        results->latency[ms < MATCHMAKER_LATENCY_BUCKETS ? ms : MATCHMAKER_LATENCY_BUCKETS - 1]++;
+    }
+    results->players += 2;
+    uint32_t difference = (uint32_t)abs(a->rating - b->rating);
+    results->ratingDifference += difference;
+    if (difference > results->maxDifference) {
+        results->maxDifference = difference;
+    }
+}
+
+static uint32_t LatencyPercentileMs(const MatchmakerBenchResults* results, double fraction)
+{
+    uint64_t target = (uint64_t)(fraction * (double)results->players);
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < MATCHMAKER_LATENCY_BUCKETS; i++) {
+        seen += results->latency[i];
+        if (seen > target) {
+            return i;
+        }
+    }
+    return MATCHMAKER_LATENCY_BUCKETS - 1;
+}
+
+// Keep about N players arriving per pairing pass, so each pass sees N
+// waiting, and report pairing latency and matchmaker thread cost
+static int RunMatchmakerBench(int waiting, int seconds)
+{
+    static Matchmaker matchmaker;
+    static MatchmakerBenchResults results;
+    memset(&results, 0, sizeof(results));
+    Matchmaker_Init(&matchmaker, MATCHMAKER_PASS_NS, OnBenchPair, &results);
+
+    double rate = (double)waiting * 1e9 / (double)MATCHMAKER_PASS_NS;
+    atomic_bool running;
+    atomic_init(&running, true);
+
+    // Each ticket is busy from its join until the pass that settles it; the
+    // pool covers several passes of arrivals plus the slow tail
+    int poolSize = waiting * 8 / MATCHMAKER_BENCH_PRODUCERS + 4096;
+    MatchmakerProducer producers[MATCHMAKER_BENCH_PRODUCERS];
+    pthread_t threads[MATCHMAKER_BENCH_PRODUCERS];
+    for (int p = 0; p < MATCHMAKER_BENCH_PRODUCERS; p++) {
+        MatchmakerProducer* producer = &producers[p];
+        memset(producer, 0, sizeof(*producer));
+        producer->matchmaker = &matchmaker;
+        producer->tickets = calloc((size_t)poolSize, sizeof(MatchmakerTicket));
+        if (!producer->tickets) {
+            fprintf(stderr, "Failed to allocate %d tickets\n", poolSize);
+            return 1;
+        }
+        for (int i = 0; i < poolSize; i++) {
+            producer->tickets[i].playerId = (uint32_t)(p * poolSize + i);
+            producer->tickets[i].bucket = -1;
+        }
+        producer->ticketCount = poolSize;
+        producer->rate = rate / MATCHMAKER_BENCH_PRODUCERS;
+        producer->seed = 1000 + (uint64_t)p;
+        producer->running = &running;
+    }
+    for (int p = 0; p < MATCHMAKER_BENCH_PRODUCERS; p++) {
+        pthread_create(&threads[p], NULL, MatchmakerProducerMain, &producers[p]);
+    }
+
+    // The matchmaker thread: poll every millisecond
+    uint64_t start = Scheduler_NowNs();
+    uint64_t end = start + (uint64_t)seconds * 1000000000ull;
+    double cpuStart = ThreadCpuSeconds();
+    uint64_t waitingAtPass = 0, maxPassNs = 0;
+    struct timespec pause = { 0, 1000 * 1000 };
+    for (;;) {
+        uint64_t now = Scheduler_NowNs();
+        if (now >= end) {
+            break;
+        }
+        uint64_t passes = matchmaker.stats.passes;
+        uint64_t passNs = matchmaker.stats.passNs;
+        int pairs = Matchmaker_Poll(&matchmaker, now);
+        if (matchmaker.stats.passes != passes) {
+            waitingAtPass += matchmaker.waiting + 2u * (uint64_t)pairs;
+            uint64_t thisPass = matchmaker.stats.passNs - passNs;
+            if (thisPass > maxPassNs) {
+                maxPassNs = thisPass;
+            }
+        }
+        nanosleep(&pause, NULL);
+    }
+    double cpu = ThreadCpuSeconds() - cpuStart;
+    double elapsed = (double)(Scheduler_NowNs() - start) / 1e9;
+
+    atomic_store(&running, false);
+    uint64_t arrivals = 0, leaveRequests = 0, exhausted = 0;
+    for (int p = 0; p < MATCHMAKER_BENCH_PRODUCERS; p++) {
+        pthread_join(threads[p], NULL);
+        arrivals += producers[p].arrivals;
+        leaveRequests += producers[p].leaveRequests;
+        exhausted += producers[p].poolExhausted;
+    }
+
+    const MatchmakerStats* stats = &matchmaker.stats;
+    printf("target %d waiting per %.0f ms pass, %d producers, %.1f s\n", waiting,
+           (double)MATCHMAKER_PASS_NS / 1e6, MATCHMAKER_BENCH_PRODUCERS, elapsed);
+    printf("arrivals:    %.0f/s (%lu skipped: ticket pool empty), %lu leaves applied of %lu requested\n",
+           (double)arrivals / elapsed, (unsigned long)exhausted, (unsigned long)stats->leaves,
+           (unsigned long)leaveRequests);
+    printf("waiting:     %.0f at each pass on average, %u left at the end\n",
+           stats->passes ? (double)waitingAtPass / (double)stats->passes : 0.0, matchmaker.waiting);
+    printf("pairs:       %.0f/s, %.1f%% within a bucket, avg rating gap %.1f, max %u\n",
+           (double)stats->pairs / elapsed,
+           stats->pairs ? 100.0 * (double)stats->sameBucketPairs / (double)stats->pairs : 0.0,
+           results.players ? 2.0 * (double)results.ratingDifference / (double)results.players : 0.0,
+           results.maxDifference);
+    printf("latency:     p50 %u ms, p99 %u ms, p99.9 %u ms (join to pair)\n",
+           LatencyPercentileMs(&results, 0.5), LatencyPercentileMs(&results, 0.99),
+           LatencyPercentileMs(&results, 0.999));
+    printf("pass:        %.1f us average, %.1f us max, %.1f ns per player paired\n",
+           stats->passes ? (double)stats->passNs / (double)stats->passes / 1e3 : 0.0,
+           (double)maxPassNs / 1e3,
+           results.players ? (double)stats->passNs / (double)results.players : 0.0);
+    printf("drain:       %.1f ns per join/leave applied\n",
+           (double)stats->drainNs / (double)(stats->joins + stats->leaves + 1));
+    printf("thread CPU:  %.1f%% of one core\n\n", 100.0 * cpu / elapsed);
+
+    for (int p = 0; p < MATCHMAKER_BENCH_PRODUCERS; p++) {
+        free(producers[p].tickets);
+    }
+    return 0;
+}
+
+// Samples per thread in --bench-metrics (cycled through a table of values)
+#define METRICS_BENCH_SAMPLES 20000000
+#define METRICS_BENCH_VALUES 4096
+
+typedef struct {
+    const uint64_t* values;
+    double recordNs;
+    double countNs;
+} MetricsBenchThread;
+
+static void* MetricsBenchMain(void* arg)
+{
+    MetricsBenchThread* bench = (MetricsBenchThread*)arg;
+    Metrics_RegisterThread();
+
+    uint64_t start = Scheduler_NowNs();
+    for (int i = 0; i < METRICS_BENCH_SAMPLES; i++) {
+        Metrics_Record(METRIC_TICK, bench->values[i & (METRICS_BENCH_VALUES - 1)]);
+    }
+    uint64_t middle = Scheduler_NowNs();
+    for (int i = 0; i < METRICS_BENCH_SAMPLES; i++) {
+        Metrics_Count(METRIC_PACKETS_OUT, 1);
+    }
+    uint64_t end = Scheduler_NowNs();
+
+    bench->recordNs = (double)(middle - start) / METRICS_BENCH_SAMPLES;
+    bench->countNs = (double)(end - middle) / METRICS_BENCH_SAMPLES;
+    return NULL;
+}
+
+// Cost of recording a histogram sample and a counter increment, alone and
+// with every core recording at once, and the accuracy of merged quantiles
+static int RunMetricsBench(int threads)
+{
+    static uint64_t values[METRICS_BENCH_VALUES];
+    static uint64_t sorted[METRICS_BENCH_VALUES];
+    Rng rng;
+    Rng_Seed(&rng, 1, 0);
+    for (int i = 0; i < METRICS_BENCH_VALUES; i++) {
+        // Tick-like durations: log-uniform from 1 us to 1 ms
+        values[i] = (uint64_t)(1000.0 * pow(1000.0, (double)Rng_Next(&rng) / 4294967296.0));
+        sorted[i] = values[i];
+    }
+    Metrics_Enable();
+
+    MetricsBenchThread bench[SCHEDULER_MAX_SHARDS];
+    pthread_t handles[SCHEDULER_MAX_SHARDS];
+    threads = threads < 1 ? 1 : (threads > SCHEDULER_MAX_SHARDS ? SCHEDULER_MAX_SHARDS : threads);
+    int counts[2] = { 1, threads };
+    for (int run = 0; run < (threads > 1 ? 2 : 1); run++) {
+        double recordNs = 0.0, countNs = 0.0;
+        for (int t = 0; t < counts[run]; t++) {
+            bench[t].values = values;
+            pthread_create(&handles[t], NULL, MetricsBenchMain, &bench[t]);
+        }
+        for (int t = 0; t < counts[run]; t++) {
+            pthread_join(handles[t], NULL);
+            recordNs += bench[t].recordNs / counts[run];
+            countNs += bench[t].countNs / counts[run];
+        }
+        printf("%2d thread(s): histogram sample %.2f ns, counter increment %.2f ns\n",
+               counts[run], recordNs, countNs);
+    }
+
+    uint64_t start = Scheduler_NowNs();
+    uint64_t timedSamples = 0;
+    Metrics_RegisterThread();
+    while (Scheduler_NowNs() - start < 200000000ull) {
+        uint64_t begin = Metrics_Begin();
+        Metrics_RecordSince(METRIC_DETECT_MATCHES, begin);
+        timedSamples++;
+    }
+    printf("timed sample (two clock reads + record): %.2f ns\n",
+           (double)(Scheduler_NowNs() - start) / (double)timedSamples);
+
+    // Every value went in the same number of times per thread, so the merged
+    // quantiles can be checked against the sorted table
+    static MetricsSnapshot snapshot;
+    Metrics_Collect(&snapshot);
+    for (int i = 1; i < METRICS_BENCH_VALUES; i++) {
+        uint64_t value = sorted[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j] > value) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = value;
+    }
+    const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    for (int q = 0; q < 4; q++) {
+        uint64_t exact = sorted[(int)(quantiles[q] * METRICS_BENCH_VALUES)];
+        uint64_t merged = Metrics_Quantile(&snapshot, METRIC_TICK, quantiles[q]);
+        printf("p%-5g exact %8.2f us, histogram %8.2f us (%+.1f%%)\n", quantiles[q] * 100.0,
+               exact / 1e3, merged / 1e3, 100.0 * ((double)merged - (double)exact) / (double)exact);
+    }
+    return 0;
+}
+
+static void PrintUsage(const char* program)
+{
+    printf("Usage: %s [options]\n", program);
+    printf("  --arena-report [N]  Report memory per match for N matches (default %d)\n",
+           ARENA_REPORT_MATCHES);
+    printf("  --bench-scheduler   Tick bot-driven rooms on the sharded scheduler\n");
+    printf("    --shards N        Worker shards (default: online cores)\n");
+    printf("    --rooms N         Rooms to host (default 1000)\n");
+    printf("    --seconds N       Duration (default 5)\n");
+    printf("    --no-pin          Do not pin shard threads to cores\n");
+    printf("    --publish-state [NAME]  Publish live boards to shared memory (default %s)\n",
+           STATE_SHM_DEFAULT_NAME);
+    printf("  --bench-spectators [N]  Broadcast one match to N loopback viewers (default %d)\n",
+           SPECTATOR_BENCH_VIEWERS);
+    printf("    --seconds N       Duration (default 5)\n");
+    printf("  --bench-matchmaker [N]  Pair synthetic arrivals with N waiting per pass (default 10k and 100k)\n");
+    printf("    --seconds N       Duration per size (default 5)\n");
+    printf("  --bench-metrics     Cost of recording metrics samples, alone and on every core\n");
+    printf("Metrics (with --bench-scheduler or --bench-spectators):\n");
+    printf("  --metrics-port N    Serve Prometheus metrics on 127.0.0.1:N/metrics\n");
+    printf("  --metrics-file F    Write a metrics snapshot to F periodically\n");
+    printf("  --metrics-interval S  Seconds between snapshots (default 10)\n");
+    printf("Logging:\n");
+    printf("  --log-file F        Write a binary log to F (decode with tools/logs)\n");
+}
+
+int main(int argc, char** argv)
+{
+    bool benchScheduler = false;
+    int spectatorViewers = 0;
+    int matchmakerWaiting = -1;
+    bool benchMetrics = false;
+    int metricsPort = 0;
+    const char* metricsFile = NULL;
+    double metricsInterval = 10.0;
+    const char* logFile = NULL;
+    SchedulerBenchConfig bench = { (int)sysconf(_SC_NPROCESSORS_ONLN), 1000, 5, true, NULL };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--arena-report") == 0) {
+            int count = ARENA_REPORT_MATCHES;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                count = atoi(argv[++i]);
+            }
+            return RunArenaReport(count > 0 ? count : ARENA_REPORT_MATCHES);
+        } else if (strcmp(argv[i], "--bench-scheduler") == 0) {
+            benchScheduler = true;
+        } else if (strcmp(argv[i], "--bench-spectators") == 0) {
+            spectatorViewers = SPECTATOR_BENCH_VIEWERS;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                spectatorViewers = atoi(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--bench-matchmaker") == 0) {
+            matchmakerWaiting = 0;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                matchmakerWaiting = atoi(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            bench.shards = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rooms") == 0 && i + 1 < argc) {
+            bench.rooms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            bench.seconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-pin") == 0) {
+            bench.pin = false;
+        } else if (strcmp(argv[i], "--publish-state") == 0) {
+            bench.publishName = STATE_SHM_DEFAULT_NAME;
+            if (i + 1 < argc && argv[i + 1][0] == '/') {
+                bench.publishName = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--bench-metrics") == 0) {
+            benchMetrics = true;
+        } else if (strcmp(argv[i], "--metrics-port") == 0 && i + 1 < argc) {
+            metricsPort = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--metrics-file") == 0 && i + 1 < argc) {
+            metricsFile = argv[++i];
+        } else if (strcmp(argv[i], "--metrics-interval") == 0 && i + 1 < argc) {
+            metricsInterval = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--log-file") == 0 && i + 1 < argc) {
+            logFile = argv[++i];
+        }
+    }
+
+    if (benchMetrics) {
+        return RunMetricsBench(bench.shards);
+    }
+
+    // Export before any worker starts, so every thread registers its block
+    static MetricsExporter exporter;
+    bool exporting = metricsPort > 0 || metricsFile;
+    if (exporting) {
+        if (!MetricsExporter_Start(&exporter, metricsPort, metricsFile, metricsInterval)) {
+            fprintf(stderr, "Cannot serve metrics on port %d\n", metricsPort);
+            return 1;
+        }
+        Metrics_RegisterThread();
+    }
+    if (logFile && !Logger_Start(logFile)) {
+        fprintf(stderr, "Cannot write log file %s\n", logFile);
+        if (exporting) {
+            MetricsExporter_Stop(&exporter);
+        }
+        return 1;
+    }
+    int result = -1;
+
+    if (spectatorViewers > 0) {
+        result = RunSpectatorBench(spectatorViewers, bench.seconds);
+    } else if (matchmakerWaiting > 0) {
+        result = RunMatchmakerBench(matchmakerWaiting, bench.seconds);
+    } else if (matchmakerWaiting == 0) {
+        result = RunMatchmakerBench(10000, bench.seconds) || RunMatchmakerBench(100000, bench.seconds);
+    } else if (benchScheduler) {
+        result = RunSchedulerBench(&bench);
+    }
+
+    Logger_Stop();
+    if (exporting) {
+        MetricsExporter_Stop(&exporter);
+    }
+    if (result < 0) {
+        PrintUsage(argv[0]);
+        return 0;
+    }
+    return result;
+}
@@ -0,0 +1,256 @@
+#define _GNU_SOURCE
+#include "spectator.h"
+#include "metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+static PacketBuffer* AcquireBuffer(SpectatorChannel* channel)
+{
+    PacketBuffer* buffer = channel->freeList;
+    if (buffer) {
+        channel->freeList = buffer->nextFree;
+        buffer->length = 0;
+    }
+    return buffer;
+}
+
+static void ReleaseBuffer(SpectatorChannel* channel, PacketBuffer* buffer)
+{
+    if (buffer) {
+        buffer->nextFree = channel->freeList;
+        channel->freeList = buffer;
+    }
+}
+
+// Little-endian helpers, as in the board codec, so the wire format does not
+// depend on the host
+static void WriteU16(uint8_t* out, uint16_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void WriteU32(uint8_t* out, uint32_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static void WriteHeader(uint8_t* out, SpectatorPacketKind kind, uint32_t matchId, uint32_t tick)
+{
+    out[0] = (uint8_t)kind;
+    WriteU32(out + 1, matchId);
+    WriteU32(out + 5, tick);
+    out[9] = MATCH_PLAYERS;
+}
+
+// Send one shared buffer to a range of subscribers, a batch at a time
+static void SendToSubscribers(SpectatorChannel* channel, const PacketBuffer* buffer,
+                              int first, int count)
+{
+#ifdef __linux__
+    struct mmsghdr* messages = (struct mmsghdr*)channel->messages;
+    struct iovec* iov = (struct iovec*)channel->iovecs;
+
+    // Every message points at the same bytes; nothing is copied per viewer
+    iov->iov_base = (void*)buffer->data;
+    iov->iov_len = buffer->length;
+
+    for (int start = first; start < first + count; start += SPECTATOR_SEND_BATCH) {
+        int batch = first + count - start;
+        if (batch > SPECTATOR_SEND_BATCH) {
+            batch = SPECTATOR_SEND_BATCH;
+        }
+        for (int i = 0; i < batch; i++) {
+            Subscriber* subscriber = &channel->subscribers[start + i];
+            memset(&messages[i], 0, sizeof(messages[i]));
+            messages[i].msg_hdr.msg_name = &subscriber->address;
+            messages[i].msg_hdr.msg_namelen = subscriber->addressLength;
+            messages[i].msg_hdr.msg_iov = iov;
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int sent = 0;
+        while (sent < batch) {
+            int result = sendmmsg(channel->socket, messages + sent, (unsigned)(batch - sent), 0);
+            if (result <= 0) {
+                // Drop the rest of the batch; viewers resync at the next keyframe
+                channel->stats.sendErrors += (uint64_t)(batch - sent);
+                break;
+            }
+            sent += result;
+        }
+        channel->stats.datagramsSent += (uint64_t)sent;
+        Metrics_Count(METRIC_PACKETS_OUT, (uint64_t)sent);
+        channel->stats.bytesSent += (uint64_t)sent * buffer->length;
+    }
+#else
+    for (int i = first; i < first + count; i++) {
+        Subscriber* subscriber = &channel->subscribers[i];
+        if (sendto(channel->socket, (const void*)buffer->data, buffer->length, 0,
+                   (const struct sockaddr*)&subscriber->address, subscriber->addressLength) < 0) {
+            channel->stats.sendErrors++;
+        } else {
+            channel->stats.datagramsSent++;
+            Metrics_Count(METRIC_PACKETS_OUT, 1);
+            channel->stats.bytesSent += buffer->length;
+        }
+    }
+#endif
+}
+
+bool SpectatorChannel_Init(SpectatorChannel* channel, int socket, uint32_t matchId, int capacity)
+{
+    memset(channel, 0, sizeof(*channel));
+    channel->socket = socket;
+    channel->matchId = matchId;
+    channel->subscriberCapacity = capacity;
+
+    channel->subscribers = calloc((size_t)capacity, sizeof(Subscriber));
+#ifdef __linux__
+    channel->messages = calloc(SPECTATOR_SEND_BATCH, sizeof(struct mmsghdr));
+    channel->iovecs = calloc(1, sizeof(struct iovec));
+    if (!channel->messages || !channel->iovecs) {
+        SpectatorChannel_Destroy(channel);
+        return false;
+    }
+#endif
+    if (!channel->subscribers) {
+        SpectatorChannel_Destroy(channel);
+        return false;
+    }
+
+    for (int i = SPECTATOR_POOL_SIZE - 1; i >= 0; i--) {
+        channel->pool[i].nextFree = channel->freeList;
+        channel->freeList = &channel->pool[i];
+    }
+    return true;
+}
+
+void SpectatorChannel_Destroy(SpectatorChannel* channel)
+{
+    free(channel->subscribers);
+    free(channel->messages);
+    free(channel->iovecs);
+    channel->subscribers = NULL;
+    channel->messages = NULL;
+    channel->iovecs = NULL;
+    channel->subscriberCount = 0;
+}
+
+bool SpectatorChannel_Subscribe(SpectatorChannel* channel, const struct sockaddr* address,
+                                socklen_t addressLength)
+{
+    if (channel->subscriberCount >= channel->subscriberCapacity ||
+        addressLength > (socklen_t)sizeof(struct sockaddr_storage)) {
+        return false;
+    }
+
+    Subscriber* subscriber = &channel->subscribers[channel->subscriberCount++];
+    memcpy(&subscriber->address, address, addressLength);
+    subscriber->addressLength = addressLength;
+    subscriber->needsCatchUp = true;
+    channel->pendingCatchUp++;
+    return true;
+}
+
+void SpectatorChannel_Unsubscribe(SpectatorChannel* channel, const struct sockaddr* address,
+                                  socklen_t addressLength)
+{
+    for (int i = 0; i < channel->subscriberCount; i++) {
+        Subscriber* subscriber = &channel->subscribers[i];
+        if (subscriber->addressLength == addressLength &&
+            memcmp(&subscriber->address, address, addressLength) == 0) {
+            if (subscriber->needsCatchUp) {
+                channel->pendingCatchUp--;
+            }
+            // Swap-remove; order does not matter for a broadcast
+            *subscriber = channel->subscribers[--channel->subscriberCount];
+            return;
+        }
+    }
+}
+
+// Drop the keyframe history so a new keyframe can start it
+static void ResetHistory(SpectatorChannel* channel)
+{
+    ReleaseBuffer(channel, channel->keyframe);
+    channel->keyframe = NULL;
+    for (int i = 0; i < channel->deltaCount; i++) {
+        ReleaseBuffer(channel, channel->deltas[i]);
+    }
+    channel->deltaCount = 0;
+}
+
+// Bring new viewers up to date: the keyframe, then every delta since
+static void SendCatchUp(SpectatorChannel* channel)
+{
+    for (int i = 0; i < channel->subscriberCount && channel->pendingCatchUp > 0; i++) {
+        Subscriber* subscriber = &channel->subscribers[i];
+        if (!subscriber->needsCatchUp) {
+            continue;
+        }
+        subscriber->needsCatchUp = false;
+        channel->pendingCatchUp--;
+
+        SendToSubscribers(channel, channel->keyframe, i, 1);
+        for (int d = 0; d < channel->deltaCount; d++) {
+            SendToSubscribers(channel, channel->deltas[d], i, 1);
+        }
+    }
+}
+
+void SpectatorChannel_Publish(SpectatorChannel* channel, const Match* match)
+{
+    PacketBuffer* packet;
+
+    if (!channel->keyframe || channel->deltaCount >= SPECTATOR_KEYFRAME_INTERVAL) {
+        ResetHistory(channel);
+
+        packet = AcquireBuffer(channel);
+        WriteHeader(packet->data, SPECTATOR_PACKET_KEYFRAME, channel->matchId, match->tick);
+        size_t length = SPECTATOR_HEADER_SIZE;
+        for (int p = 0; p < MATCH_PLAYERS; p++) {
+            length += BoardCodec_WriteKeyframe(&match->players[p].board, packet->data + length);
+            length += BoardCodec_WriteSlabs(&match->players[p].board, packet->data + length);
+        }
+        packet->length = (uint16_t)length;
+        channel->keyframe = packet;
+
+        // Everyone gets the keyframe, so nobody needs a separate catch-up
+        for (int i = 0; i < channel->subscriberCount; i++) {
+            channel->subscribers[i].needsCatchUp = false;
+        }
+        channel->pendingCatchUp = 0;
+    } else {
+        if (channel->pendingCatchUp > 0) {
+            SendCatchUp(channel);
+        }
+
+        packet = AcquireBuffer(channel);
+        WriteHeader(packet->data, SPECTATOR_PACKET_DELTA, channel->matchId, match->tick);
+        size_t length = SPECTATOR_HEADER_SIZE;
+        for (int p = 0; p < MATCH_PLAYERS; p++) {
+            // Each player's delta is prefixed with its 16-bit length
+            uint8_t* prefix = packet->data + length;
+            uint16_t deltaLength = (uint16_t)BoardCodec_WriteDelta(&channel->lastBoards[p],
+                                                                   &match->players[p].board,
+                                                                   prefix + 2);
+            WriteU16(prefix, deltaLength);
+            length += 2 + deltaLength;
+        }
+        packet->length = (uint16_t)length;
+        channel->deltas[channel->deltaCount++] = packet;
+    }
+
+    for (int p = 0; p < MATCH_PLAYERS; p++) {
+        channel->lastBoards[p] = match->players[p].board;
+    }
+
+    channel->stats.ticksPublished++;
+    channel->stats.encodeBytes += packet->length;
+    SendToSubscribers(channel, packet, 0, channel->subscriberCount);
+}
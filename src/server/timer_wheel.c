@@ -0,0 +1,127 @@
+#include "timer_wheel.h"
+#include <string.h>
+
+// Bit offset of each upper level's slot index
+static int LevelShift(int level)
+{
+    return TIMER_WHEEL_L0_BITS + level * TIMER_WHEEL_LN_BITS;
+}
+
+static void LinkNode(TimerNode** slot, TimerNode* node)
+{
+    node->next = *slot;
+    if (node->next) {
+        node->next->pprev = &node->next;
+    }
+    node->pprev = slot;
+    *slot = node;
+}
+
+// Pick the slot for a node relative to the wheel's current time
+static TimerNode** SlotFor(TimerWheel* wheel, uint64_t expires)
+{
+    uint64_t delta = expires - wheel->now;
+
+    if (delta < TIMER_WHEEL_L0_SLOTS) {
+        return &wheel->level0[expires & (TIMER_WHEEL_L0_SLOTS - 1)];
+    }
+    for (int level = 0; level < TIMER_WHEEL_UPPER_LEVELS; level++) {
+        int shift = LevelShift(level);
+        if (delta < ((uint64_t)1 << (shift + TIMER_WHEEL_LN_BITS)) ||
+            level == TIMER_WHEEL_UPPER_LEVELS - 1) {
+            if (level == TIMER_WHEEL_UPPER_LEVELS - 1 &&
+                delta >= ((uint64_t)1 << (shift + TIMER_WHEEL_LN_BITS))) {
+                // Beyond the wheel's range: park in the furthest slot, it re-cascades
+                expires = wheel->now + ((uint64_t)1 << (shift + TIMER_WHEEL_LN_BITS)) - 1;
+            }
+            return &wheel->levels[level][(expires >> shift) & (TIMER_WHEEL_LN_SLOTS - 1)];
+        }
+    }
+    return NULL;  // Unreachable
+}
+
+void TimerWheel_Init(TimerWheel* wheel, uint64_t nowMs)
+{
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->now = nowMs;
+}
+
+void TimerWheel_Schedule(TimerWheel* wheel, TimerNode* node, uint64_t expiresMs)
+{
+    if (TimerNode_IsScheduled(node)) {
+        TimerWheel_Cancel(wheel, node);
+    }
+    if (expiresMs < wheel->now) {
+        expiresMs = wheel->now;
+    }
+
+    node->expires = expiresMs;
+    LinkNode(SlotFor(wheel, expiresMs), node);
+    wheel->count++;
+}
+
+void TimerWheel_Cancel(TimerWheel* wheel, TimerNode* node)
+{
+    if (!TimerNode_IsScheduled(node)) {
+        return;
+    }
+
+    *node->pprev = node->next;
+    if (node->next) {
+        node->next->pprev = node->pprev;
+    }
+    node->next = NULL;
+    node->pprev = NULL;
+    wheel->count--;
+}
+
+// Move every node of an upper-level slot into finer slots
+static void Cascade(TimerWheel* wheel, int level)
+{
+    int index = (int)((wheel->now >> LevelShift(level)) & (TIMER_WHEEL_LN_SLOTS - 1));
+    TimerNode* node = wheel->levels[level][index];
+    wheel->levels[level][index] = NULL;
+
+    while (node) {
+        TimerNode* next = node->next;
+        LinkNode(SlotFor(wheel, node->expires), node);
+        node = next;
+    }
+}
+
+int TimerWheel_Advance(TimerWheel* wheel, uint64_t nowMs, TimerCallback callback, void* context)
+{
+    int fired = 0;
+
+    while (wheel->now <= nowMs) {
+        int index = (int)(wheel->now & (TIMER_WHEEL_L0_SLOTS - 1));
+
+        // Refill level 0 from the coarser levels each time it wraps
+        if (index == 0) {
+            for (int level = 0; level < TIMER_WHEEL_UPPER_LEVELS; level++) {
+                Cascade(wheel, level);
+                if (((wheel->now >> LevelShift(level)) & (TIMER_WHEEL_LN_SLOTS - 1)) != 0) {
+                    break;
+                }
+            }
+        }
+
+        // Detach the slot first so callbacks can reschedule without the
+        // node landing back in the slot being drained
+        TimerNode* pending = wheel->level0[index];
+        wheel->level0[index] = NULL;
+        if (pending) {
+            pending->pprev = &pending;
+        }
+        wheel->now++;
+
+        while (pending) {
+            TimerNode* node = pending;
+            TimerWheel_Cancel(wheel, node);
+            fired++;
+            callback(node, context);
+        }
+    }
+
+    return fired;
+}
@@ -0,0 +1,99 @@
+#define _POSIX_C_SOURCE 200809L
+#include "asset_bundle.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool AssetBundle_Open(AssetBundle* bundle, const char* path)
+{
+    memset(bundle, 0, sizeof(*bundle));
+    bundle->fd = open(path, O_RDONLY);
+    if (bundle->fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(bundle->fd, &info) != 0 || (size_t)info.st_size < ASSET_BUNDLE_HEADER_SIZE) {
+        AssetBundle_Close(bundle);
+        return false;
+    }
+    bundle->size = (size_t)info.st_size;
+
+    void* base = mmap(NULL, bundle->size, PROT_READ, MAP_SHARED, bundle->fd, 0);
+    if (base == MAP_FAILED) {
+        AssetBundle_Close(bundle);
+        return false;
+    }
+    bundle->base = base;
+
+    const AssetBundleHeader* header = (const AssetBundleHeader*)bundle->base;
+    size_t tableEnd = ASSET_BUNDLE_HEADER_SIZE + (size_t)header->entryCount * sizeof(AssetEntry);
+    if (header->magic != ASSET_BUNDLE_MAGIC || header->version != ASSET_BUNDLE_VERSION ||
+        header->fileSize != bundle->size || tableEnd > bundle->size) {
+        AssetBundle_Close(bundle);
+        return false;
+    }
+    bundle->entries = (const AssetEntry*)(bundle->base + ASSET_BUNDLE_HEADER_SIZE);
+    bundle->entryCount = header->entryCount;
+
+    // Only the table is read now; data pages fault in when an asset is used
+    for (uint32_t i = 0; i < bundle->entryCount; i++) {
+        const AssetEntry* entry = &bundle->entries[i];
+        if (entry->name[ASSET_NAME_SIZE - 1] != '\0' || entry->offset % ASSET_BUNDLE_ALIGN != 0 ||
+            entry->offset < tableEnd || entry->size > bundle->size - entry->offset) {
+            AssetBundle_Close(bundle);
+            return false;
+        }
+    }
+    return true;
+}
+
+void AssetBundle_Close(AssetBundle* bundle)
+{
+    if (bundle->base) {
+        munmap((void*)bundle->base, bundle->size);
+    }
+    if (bundle->fd >= 0) {
+        close(bundle->fd);
+    }
+    memset(bundle, 0, sizeof(*bundle));
+    bundle->fd = -1;
+}
+
+const AssetEntry* AssetBundle_Find(const AssetBundle* bundle, const char* name)
+{
+    // Entries are sorted by name
+    uint32_t low = 0, high = bundle->entryCount;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        int order = strncmp(name, bundle->entries[mid].name, ASSET_NAME_SIZE);
+        if (order == 0) {
+            return &bundle->entries[mid];
+        }
+        if (order < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+void AssetBundle_Prefetch(const AssetBundle* bundle, const AssetEntry* entry, size_t offset, size_t length)
+{
+    if (offset >= entry->size) {
+        return;
+    }
+    if (length > entry->size - offset) {
+        length = entry->size - offset;
+    }
+
+    // madvise wants a page-aligned start
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = (size_t)entry->offset + offset;
+    size_t aligned = start & ~(page - 1);
+    posix_madvise((void*)(bundle->base + aligned), length + (start - aligned), POSIX_MADV_WILLNEED);
+}
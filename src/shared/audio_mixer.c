@@ -0,0 +1,202 @@
+#define _POSIX_C_SOURCE 200809L
+#include "audio_mixer.h"
+#include <string.h>
+#include <time.h>
+
+// Events further ahead than this are pulled in (their clock is off)
+#define MAX_SCHEDULE_FRAMES AUDIO_MIX_RATE
+
+static uint64_t NowNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void AudioMixer_Init(AudioMixer* mixer)
+{
+    memset(mixer, 0, sizeof(*mixer));
+    AudioEventQueue_Init(&mixer->events);
+}
+
+int AudioMixer_AddSample(AudioMixer* mixer, const AudioSample* sample)
+{
+    if (mixer->sampleCount == AUDIO_MAX_SAMPLES) {
+        return -1;
+    }
+    mixer->samples[mixer->sampleCount] = *sample;
+    return mixer->sampleCount++;
+}
+
+// Output frame an event's timestamp maps to
+static int64_t FrameAt(const AudioMixer* mixer, uint64_t time)
+{
+    // Whole seconds first, so far-off timestamps cannot overflow
+    int64_t elapsed = (int64_t)(time - mixer->anchorTime);
+    int64_t frames = elapsed / 1000000000 * AUDIO_MIX_RATE + elapsed % 1000000000 * AUDIO_MIX_RATE / 1000000000;
+    return (int64_t)mixer->anchorFrame + frames + AUDIO_MIX_LATENCY_FRAMES;
+}
+
+static void ReleaseVoice(AudioMixer* mixer, AudioVoice* voice)
+{
+    voice->active = false;
+    mixer->voicesPerSample[voice->sample]--;
+}
+
+// Voice for a new sound: a free one, else the oldest playing the same sample
+// once the sample is at its limit, else the oldest overall
+static AudioVoice* AllocateVoice(AudioMixer* mixer, uint8_t sample)
+{
+    bool limited = mixer->voicesPerSample[sample] >= mixer->samples[sample].maxVoices;
+    AudioVoice* chosen = NULL;
+    for (int i = 0; i < AUDIO_MAX_VOICES; i++) {
+        AudioVoice* voice = &mixer->voices[i];
+        if (!voice->active) {
+            if (!limited) {
+                return voice;
+            }
+            continue;
+        }
+        if ((!limited || voice->sample == sample) && (!chosen || voice->serial < chosen->serial)) {
+            chosen = voice;
+        }
+    }
+    if (chosen) {
+        ReleaseVoice(mixer, chosen);
+        atomic_fetch_add_explicit(&mixer->stats.voicesStolen, 1, memory_order_relaxed);
+    }
+    return chosen;
+}
+
+static void StartVoice(AudioMixer* mixer, const AudioEvent* event, uint64_t blockStart)
+{
+    if (event->sample >= mixer->sampleCount || mixer->samples[event->sample].frameCount == 0 ||
+        mixer->samples[event->sample].maxVoices == 0) {
+        return;
+    }
+    const AudioSample* sample = &mixer->samples[event->sample];
+
+    int64_t target = FrameAt(mixer, event->time);
+    if (target < (int64_t)blockStart) {
+        target = (int64_t)blockStart;
+        atomic_fetch_add_explicit(&mixer->stats.eventsLate, 1, memory_order_relaxed);
+    } else if (target > (int64_t)(blockStart + MAX_SCHEDULE_FRAMES)) {
+        target = (int64_t)(blockStart + MAX_SCHEDULE_FRAMES);
+    }
+
+    AudioVoice* voice = AllocateVoice(mixer, event->sample);
+    if (!voice) {
+        return;
+    }
+
+    // Linear pan with a constant gain at the center
+    float volume = event->volume / 255.0f;
+    float pan = event->pan / 127.0f;
+    voice->gainLeft = volume * (pan > 0.0f ? 1.0f - pan : 1.0f);
+    voice->gainRight = volume * (pan < 0.0f ? 1.0f + pan : 1.0f);
+
+    voice->active = true;
+    voice->sample = event->sample;
+    voice->startFrame = (uint64_t)target;
+    voice->position = 0;
+    voice->step = (((uint64_t)sample->sampleRate * (event->rate ? event->rate : AUDIO_RATE_ONE)) << 24) / AUDIO_MIX_RATE;
+    voice->serial = mixer->nextSerial++;
+    mixer->voicesPerSample[event->sample]++;
+    atomic_fetch_add_explicit(&mixer->stats.eventsStarted, 1, memory_order_relaxed);
+}
+
+// One source frame as left/right floats
+static inline void ReadFrame(const AudioSample* sample, uint32_t index, float* left, float* right)
+{
+    uint32_t at = index * sample->channels;
+    switch (sample->sampleSize) {
+    case 8:
+        *left = (((const uint8_t*)sample->data)[at] - 128) / 128.0f;
+        *right = (((const uint8_t*)sample->data)[at + sample->channels - 1] - 128) / 128.0f;
+        break;
+    case 16:
+        *left = ((const int16_t*)sample->data)[at] / 32768.0f;
+        *right = ((const int16_t*)sample->data)[at + sample->channels - 1] / 32768.0f;
+        break;
+    default:
+        *left = ((const float*)sample->data)[at];
+        *right = ((const float*)sample->data)[at + sample->channels - 1];
+        break;
+    }
+}
+
+// Add one voice's contribution to the block; false once the sample has ended
+static bool MixVoice(const AudioMixer* mixer, AudioVoice* voice, float* out, uint32_t frames, uint64_t blockStart)
+{
+    if (voice->startFrame >= blockStart + frames) {
+        return true;
+    }
+    const AudioSample* sample = &mixer->samples[voice->sample];
+    uint32_t last = sample->frameCount - 1;
+
+    uint32_t i = voice->startFrame > blockStart ? (uint32_t)(voice->startFrame - blockStart) : 0;
+    for (; i < frames; i++) {
+        uint32_t index = (uint32_t)(voice->position >> 32);
+        if (index > last) {
+            return false;
+        }
+
+        // Linear interpolation toward the next source frame
+        float t = (float)(uint32_t)voice->position * (1.0f / 4294967296.0f);
+        float left0, right0, left1, right1;
+        ReadFrame(sample, index, &left0, &right0);
+        ReadFrame(sample, index < last ? index + 1 : last, &left1, &right1);
+        out[2 * i] += (left0 + (left1 - left0) * t) * voice->gainLeft;
+        out[2 * i + 1] += (right0 + (right1 - right0) * t) * voice->gainRight;
+
+        voice->position += voice->step;
+    }
+    return (voice->position >> 32) <= last;
+}
+
+void AudioMixer_Mix(AudioMixer* mixer, float* out, uint32_t frames, uint64_t now)
+{
+    uint64_t begin = NowNanos();
+    uint64_t blockStart = mixer->streamFrame;
+
+    // Tie the frame clock to the event clock; re-anchor if the device has
+    // drifted from it (or stalled) by more than the scheduling latency
+    int64_t drift = FrameAt(mixer, now) - AUDIO_MIX_LATENCY_FRAMES - (int64_t)blockStart;
+    if (mixer->anchorTime == 0 || drift > AUDIO_MIX_LATENCY_FRAMES || drift < -AUDIO_MIX_LATENCY_FRAMES) {
+        mixer->anchorTime = now;
+        mixer->anchorFrame = blockStart;
+    }
+
+    AudioEvent event;
+    while (AudioEventQueue_Pop(&mixer->events, &event)) {
+        StartVoice(mixer, &event, blockStart);
+    }
+
+    memset(out, 0, (size_t)frames * AUDIO_MIX_CHANNELS * sizeof(float));
+    uint32_t active = 0;
+    for (int i = 0; i < AUDIO_MAX_VOICES; i++) {
+        AudioVoice* voice = &mixer->voices[i];
+        if (!voice->active) {
+            continue;
+        }
+        if (MixVoice(mixer, voice, out, frames, blockStart)) {
+            active++;
+        } else {
+            ReleaseVoice(mixer, voice);
+        }
+    }
+
+    for (uint32_t i = 0; i < frames * AUDIO_MIX_CHANNELS; i++) {
+        out[i] = out[i] > 1.0f ? 1.0f : (out[i] < -1.0f ? -1.0f : out[i]);
+    }
+    mixer->streamFrame += frames;
+
+    uint64_t cost = NowNanos() - begin;
+    atomic_fetch_add_explicit(&mixer->stats.callbacks, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&mixer->stats.mixNanos, cost, memory_order_relaxed);
+    atomic_store_explicit(&mixer->stats.lastMixNanos, cost, memory_order_relaxed);
+    if (cost > atomic_load_explicit(&mixer->stats.mixNanosMax, memory_order_relaxed)) {
+        atomic_store_explicit(&mixer->stats.mixNanosMax, cost, memory_order_relaxed);
+    }
+    atomic_store_explicit(&mixer->stats.voicesActive, active, memory_order_relaxed);
+}
@@ -0,0 +1,193 @@
+#include "board_codec.h"
+#include <string.h>
+
+// Color index <-> BlockType (index 0 is empty)
+static const BlockType COLOR_TYPES[BLOCK_MAX_TYPE_COUNT + 1] = {
+    BLOCK_EMPTY,
+    BLOCK_RED,
+    BLOCK_BLUE,
+    BLOCK_GREEN,
+    BLOCK_YELLOW,
+    BLOCK_PURPLE,
+    BLOCK_CYAN
+};
+
+static int ColorIndex(BlockType type)
+{
+    switch (type) {
+        case BLOCK_RED:    return 1;
+        case BLOCK_BLUE:   return 2;
+        case BLOCK_GREEN:  return 3;
+        case BLOCK_YELLOW: return 4;
+        case BLOCK_PURPLE: return 5;
+        case BLOCK_CYAN:   return 6;
+        case BLOCK_EMPTY:
+        default:           return 0;
+    }
+}
+
+uint8_t BoardCodec_PackCell(uint16_t cell)
+{
+    return (uint8_t)(ColorIndex(BLOCK_TYPE(cell)) | ((BLOCK_STATE(cell) & 0x07) << 3));
+}
+
+uint16_t BoardCodec_UnpackCell(uint8_t packed)
+{
+    int color = packed & 0x07;
+    if (color > BLOCK_MAX_TYPE_COUNT) {
+        color = 0;
+    }
+    return MAKE_BLOCK(COLOR_TYPES[color], (packed >> 3) & 0x07);
+}
+
+// Little-endian helpers for the header fields
+static void WriteU32(uint8_t* out, uint32_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t ReadU32(const uint8_t* in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+size_t BoardCodec_WriteKeyframe(const GameBoard* board, uint8_t* out)
+{
+    WriteU32(out, (uint32_t)board->score);
+    WriteU32(out + 4, (uint32_t)board->combo);
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        out[8 + i] = BoardCodec_PackCell(board->grid[i]);
+    }
+    return BOARD_KEYFRAME_SIZE;
+}
+
+size_t BoardCodec_ReadKeyframe(GameBoard* board, const uint8_t* in, size_t length)
+{
+    if (length < BOARD_KEYFRAME_SIZE) {
+        return 0;
+    }
+    board->score = (int)ReadU32(in);
+    board->combo = (int)ReadU32(in + 4);
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        board->grid[i] = BoardCodec_UnpackCell(in[8 + i]);
+    }
+    board->slabCount = 0;
+    return BOARD_KEYFRAME_SIZE;
+}
+
+size_t BoardCodec_WriteSlabs(const GameBoard* board, uint8_t* out)
+{
+    *out++ = board->slabCount;
+    for (int s = 0; s < board->slabCount; s++) {
+        const GarbageSlab* slab = &board->slabs[s];
+        *out++ = (uint8_t)(slab->x | ((slab->width - 1) << 3));
+        *out++ = (uint8_t)(slab->y | ((slab->height - 1) << 4));
+        *out++ = slab->state;
+    }
+    return 1 + (size_t)board->slabCount * BOARD_SLAB_SIZE;
+}
+
+size_t BoardCodec_ReadSlabs(GameBoard* board, const uint8_t* in, size_t length)
+{
+    if (length < 1 || in[0] > GARBAGE_MAX_SLABS || length < 1 + (size_t)in[0] * BOARD_SLAB_SIZE) {
+        return 0;
+    }
+    GarbageSlab slabs[GARBAGE_MAX_SLABS];
+    const uint8_t* p = in + 1;
+    for (int s = 0; s < in[0]; s++, p += BOARD_SLAB_SIZE) {
+        GarbageSlab slab = {
+            .x = p[0] & 0x07, .width = (uint8_t)((p[0] >> 3) + 1),
+            .y = p[1] & 0x0F, .height = (uint8_t)((p[1] >> 4) + 1),
+            .state = p[2]
+        };
+        if (slab.x + slab.width > BOARD_WIDTH || slab.y + slab.height > BOARD_HEIGHT) {
+            return 0;
+        }
+        slabs[s] = slab;
+    }
+    memcpy(board->slabs, slabs, (size_t)in[0] * sizeof(slabs[0]));
+    board->slabCount = in[0];
+    return 1 + (size_t)in[0] * BOARD_SLAB_SIZE;
+}
+
+// Slabs compare by what the wire carries
+static bool SlabsEqual(const GameBoard* a, const GameBoard* b)
+{
+    if (a->slabCount != b->slabCount) {
+        return false;
+    }
+    for (int s = 0; s < a->slabCount; s++) {
+        const GarbageSlab* x = &a->slabs[s];
+        const GarbageSlab* y = &b->slabs[s];
+        if (x->x != y->x || x->y != y->y || x->width != y->width ||
+            x->height != y->height || x->state != y->state) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t BoardCodec_WriteDelta(const GameBoard* prev, const GameBoard* cur, uint8_t* out)
+{
+    uint8_t* mask = out + 8;
+    uint8_t* cells = mask + BOARD_CHANGED_MASK_SIZE;
+    size_t changed = 0;
+
+    WriteU32(out, (uint32_t)cur->score);
+    WriteU32(out + 4, (uint32_t)cur->combo);
+    memset(mask, 0, BOARD_CHANGED_MASK_SIZE);
+
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        if (prev->grid[i] != cur->grid[i]) {
+            mask[i / 8] |= (uint8_t)(1u << (i % 8));
+            cells[changed++] = BoardCodec_PackCell(cur->grid[i]);
+        }
+    }
+
+    uint8_t* slabs = cells + changed;
+    if (SlabsEqual(prev, cur)) {
+        *slabs = BOARD_SLABS_UNCHANGED;
+        return 8 + BOARD_CHANGED_MASK_SIZE + changed + 1;
+    }
+    return 8 + BOARD_CHANGED_MASK_SIZE + changed + BoardCodec_WriteSlabs(cur, slabs);
+}
+
+size_t BoardCodec_ApplyDelta(GameBoard* board, const uint8_t* in, size_t length)
+{
+    if (length < 8 + BOARD_CHANGED_MASK_SIZE) {
+        return 0;
+    }
+
+    // Validate the length before touching the board
+    const uint8_t* mask = in + 8;
+    size_t changed = 0;
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        changed += (mask[i / 8] >> (i % 8)) & 1u;
+    }
+    size_t offset = 8 + BOARD_CHANGED_MASK_SIZE;
+    if (length < offset + changed + 1) {
+        return 0;
+    }
+
+    // The slab section comes last; it leaves the board alone if malformed
+    size_t slabsLength = 1;
+    if (in[offset + changed] != BOARD_SLABS_UNCHANGED) {
+        slabsLength = BoardCodec_ReadSlabs(board, in + offset + changed, length - offset - changed);
+        if (slabsLength == 0) {
+            return 0;
+        }
+    }
+
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        if (mask[i / 8] & (1u << (i % 8))) {
+            board->grid[i] = BoardCodec_UnpackCell(in[offset++]);
+        }
+    }
+
+    board->score = (int)ReadU32(in);
+    board->combo = (int)ReadU32(in + 4);
+    return offset + slabsLength;
+}
@@ -1,20 +1,23 @@
 #include "game_board.h"
+#include "board_mode.h"
+#include "rng.h"
 #include <stdlib.h>
 #include <time.h>
 
-// Lookup table to convert index (0-4) to BlockType
-static const BlockType BLOCK_TYPES[BLOCK_TYPE_COUNT] = {
+// Lookup table to convert index (0-5) to BlockType; a mode uses the first colorCount
+static const BlockType BLOCK_TYPES[BLOCK_MAX_TYPE_COUNT] = {
     BLOCK_RED,
     BLOCK_BLUE,
     BLOCK_GREEN,
     BLOCK_YELLOW,
-    BLOCK_PURPLE
+    BLOCK_PURPLE,
+    BLOCK_CYAN
 };
 
-// Get a random block type
-static BlockType GetRandomBlockType(void)
+// Get a random block type (from rng if given, rand() otherwise)
+static BlockType GetRandomBlockType(Rng* rng, int colorCount)
 {
-    int index = rand() % BLOCK_TYPE_COUNT;
+    int index = rng ? (int)Rng_Range(rng, (uint32_t)colorCount) : rand() % colorCount;
     return BLOCK_TYPES[index];
 }
 
@@ -47,24 +50,19 @@ static bool WouldCreateMatch(const GameBoard* board, int x, int y, BlockType typ
            WouldMatchVertical(board, x, y, type);
 }
 
-void GameBoard_FillRandom(GameBoard* board)
+static void FillBoard(GameBoard* board, Rng* rng)
 {
-    static bool seeded = false;
-    if (!seeded) {
-        srand((unsigned int)time(NULL));
-        seeded = true;
-    }
-
+    const BoardMode* mode = BoardMode_Of(board);
     GameBoard_Clear(board);
 
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
-        for (int x = 0; x < BOARD_WIDTH; x++) {
+    for (int y = 0; y < mode->height; y++) {
+        for (int x = 0; x < mode->width; x++) {
             BlockType type;
             int retries = 0;
             const int maxRetries = 10;
 
             do {
-                type = GetRandomBlockType();
+                type = GetRandomBlockType(rng, mode->colorCount);
                 retries++;
             } while (WouldCreateMatch(board, x, y, type) && retries < maxRetries);
 
@@ -72,3 +70,21 @@ void GameBoard_FillRandom(GameBoard* board)
         }
     }
 }
+
+void GameBoard_FillRandom(GameBoard* board)
+{
+    static bool seeded = false;
+    if (!seeded) {
+        srand((unsigned int)time(NULL));
+        seeded = true;
+    }
+
+    FillBoard(board, NULL);
+}
+
+void GameBoard_FillSeeded(GameBoard* board, uint64_t seed)
+{
+    Rng rng;
+    Rng_Seed(&rng, seed, RNG_STREAM_BOARD);
+    FillBoard(board, &rng);
+}
@@ -0,0 +1,51 @@
+#include "board_mode.h"
+#include <string.h>
+
+#define CHECK_GEOMETRY(tag, width, height)                                          \
+    _Static_assert((width) <= BOARD_MAX_WIDTH && (height) <= BOARD_MAX_HEIGHT,      \
+                   "board geometry " #tag " exceeds BOARD_MAX_WIDTH/HEIGHT");        \
+    _Static_assert((height) <= 16, "column masks hold at most 16 rows");
+BOARD_GEOMETRIES(CHECK_GEOMETRY)
+#undef CHECK_GEOMETRY
+
+// Geometry tag -> dimensions, for building the mode table
+#define GEOMETRY_WIDTH(tag) GEOMETRY_WIDTH_##tag
+#define GEOMETRY_HEIGHT(tag) GEOMETRY_HEIGHT_##tag
+#define DEFINE_DIMENSIONS(tag, width, height) \
+    enum { GEOMETRY_WIDTH_##tag = (width), GEOMETRY_HEIGHT_##tag = (height) };
+BOARD_GEOMETRIES(DEFINE_DIMENSIONS)
+#undef DEFINE_DIMENSIONS
+
+#define MODE_ENTRY(modeId, modeName, tag, colors)   \
+    [BOARD_MODE_##modeId] = {                       \
+        .name = modeName,                           \
+        .id = BOARD_MODE_##modeId,                  \
+        .width = GEOMETRY_WIDTH(tag),               \
+        .height = GEOMETRY_HEIGHT(tag),             \
+        .colorCount = (colors),                     \
+        .geometry = BOARD_GEOMETRY_##tag,           \
+        .detectMatches = DetectMatches_##tag,       \
+        .applyGravity = ApplyGravity_##tag,         \
+    },
+static const BoardMode BOARD_MODE_TABLE[BOARD_MODE_COUNT] = {
+    BOARD_MODES(MODE_ENTRY)
+};
+#undef MODE_ENTRY
+
+const BoardMode* BoardMode_Get(BoardModeId id)
+{
+    if ((unsigned)id >= BOARD_MODE_COUNT) {
+        id = BOARD_MODE_CLASSIC;
+    }
+    return &BOARD_MODE_TABLE[id];
+}
+
+const BoardMode* BoardMode_Find(const char* name)
+{
+    for (int i = 0; i < BOARD_MODE_COUNT; i++) {
+        if (strcmp(BOARD_MODE_TABLE[i].name, name) == 0) {
+            return &BOARD_MODE_TABLE[i];
+        }
+    }
+    return NULL;
+}
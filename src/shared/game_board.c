@@ -1,37 +1,61 @@
 #include "game_board.h"
+#include "board_mode.h"
 #include <string.h>
 
 void GameBoard_Init(GameBoard* board)
+{
+    GameBoard_InitMode(board, BOARD_MODE_CLASSIC);
+}
+
+void GameBoard_InitMode(GameBoard* board, BoardModeId mode)
 {
     GameBoard_Clear(board);
     board->score = 0;
     board->combo = 0;
+    board->mode = (uint8_t)BoardMode_Get(mode)->id;
 }
 
 void GameBoard_Clear(GameBoard* board)
 {
     memset(board->grid, 0, sizeof(board->grid));
+    board->slabCount = 0;
+}
+
+int GameBoard_Width(const GameBoard* board)
+{
+    return BoardMode_Of(board)->width;
+}
+
+int GameBoard_Height(const GameBoard* board)
+{
+    return BoardMode_Of(board)->height;
+}
+
+bool GameBoard_Contains(const GameBoard* board, int x, int y)
+{
+    const BoardMode* mode = BoardMode_Of(board);
+    return x >= 0 && x < mode->width && y >= 0 && y < mode->height;
 }
 
 uint16_t GameBoard_GetCell(const GameBoard* board, int x, int y)
 {
-    if (!GameBoard_IsValidPosition(x, y)) {
+    if (!GameBoard_Contains(board, x, y)) {
         return MAKE_BLOCK(BLOCK_EMPTY, STATE_NORMAL);
     }
-    return board->grid[GRID_INDEX(x, y)];
+    return board->grid[y * GameBoard_Width(board) + x];
 }
 
 void GameBoard_SetCell(GameBoard* board, int x, int y, uint16_t value)
 {
-    if (GameBoard_IsValidPosition(x, y)) {
-        board->grid[GRID_INDEX(x, y)] = value;
+    if (GameBoard_Contains(board, x, y)) {
+        board->grid[y * GameBoard_Width(board) + x] = value;
     }
 }
 
 void GameBoard_SetBlockType(GameBoard* board, int x, int y, BlockType type)
 {
-    if (GameBoard_IsValidPosition(x, y)) {
-        int idx = GRID_INDEX(x, y);
+    if (GameBoard_Contains(board, x, y)) {
+        int idx = y * GameBoard_Width(board) + x;
         BlockState state = BLOCK_STATE(board->grid[idx]);
         board->grid[idx] = MAKE_BLOCK(type, state);
     }
@@ -39,8 +63,8 @@ void GameBoard_SetBlockType(GameBoard* board, int x, int y, BlockType type)
 
 void GameBoard_SetBlockState(GameBoard* board, int x, int y, BlockState state)
 {
-    if (GameBoard_IsValidPosition(x, y)) {
-        int idx = GRID_INDEX(x, y);
+    if (GameBoard_Contains(board, x, y)) {
+        int idx = y * GameBoard_Width(board) + x;
         BlockType type = BLOCK_TYPE(board->grid[idx]);
         board->grid[idx] = MAKE_BLOCK(type, state);
     }
@@ -1,4 +1,8 @@
 #include "game_logic.h"
+#include "board_mode.h"
+#include "garbage.h"
+#include "physics.h"
+#include <string.h>
 
 static const float SWAP_DURATION = 0.15f;  // seconds
 
@@ -38,7 +42,7 @@ bool SwapAnimation_Update(SwapAnimation* anim, float deltaTime)
 
 bool SwapBlocks(GameBoard* board, int x, int y)
 {
-    if (!GameBoard_IsValidPosition(x, y) || !GameBoard_IsValidPosition(x + 1, y)) {
+    if (!GameBoard_Contains(board, x, y) || !GameBoard_Contains(board, x + 1, y)) {
         return false;
     }
 
@@ -55,33 +59,110 @@ bool SwapBlocks(GameBoard* board, int x, int y)
         return false;
     }
 
+    // Cells under garbage are empty in the grid but not free
+    if (board->slabCount > 0 &&
+        (Garbage_SlabAt(board, x, y) >= 0 || Garbage_SlabAt(board, x + 1, y) >= 0)) {
+        return false;
+    }
+
     GameBoard_SetCell(board, x, y, right);
     GameBoard_SetCell(board, x + 1, y, left);
     return true;
 }
 
-int ClearMatches(GameBoard* board)
+int ClearMatches(GameBoard* board, const MatchList* matches)
 {
+    const int width = GameBoard_Width(board);
     int clearedCount = 0;
+    int bonus = 0;
+
+    for (int r = 0; r < matches->runCount; r++) {
+        const MatchRun* run = &matches->runs[r];
+        int step = (run->orientation == MATCH_HORIZONTAL) ? 1 : width;
+        int index = run->y * width + run->x;
+
+        // Cells shared by crossing runs are only cleared (and counted) once
+        for (int i = 0; i < run->length; i++, index += step) {
+            if (BLOCK_STATE(board->grid[index]) == STATE_MATCHED) {
+                board->grid[index] = MAKE_BLOCK(BLOCK_EMPTY, STATE_NORMAL);
+                clearedCount++;
+            }
+        }
 
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        if (BLOCK_STATE(board->grid[i]) == STATE_MATCHED) {
-            board->grid[i] = MAKE_BLOCK(BLOCK_EMPTY, STATE_NORMAL);
-            clearedCount++;
+        // Apply bonus for longer runs
+        if (run->length >= 5) {
+            bonus += SCORE_BONUS_5_PLUS_MATCH;
+        } else if (run->length >= 4) {
+            bonus += SCORE_BONUS_4_MATCH;
         }
     }
 
     // Add score for cleared blocks
     if (clearedCount > 0) {
-        board->score += clearedCount * SCORE_PER_BLOCK;
+        board->score += clearedCount * SCORE_PER_BLOCK + bonus;
+    }
 
-        // Apply bonus for larger clears
-        if (clearedCount >= 5) {
-            board->score += SCORE_BONUS_5_PLUS_MATCH;
-        } else if (clearedCount >= 4) {
-            board->score += SCORE_BONUS_4_MATCH;
+    return clearedCount;
+}
+
+// Compact every column downwards, through the mode's gravity kernel (which
+// also settles garbage slabs); the animation it records is discarded
+static void CompactColumns(GameBoard* board, const BoardMode* mode)
+{
+    GravityAnimation anim;
+    mode->applyGravity(board, &anim);
+}
+
+int ResolveCascade(GameBoard* board, CascadeEvents* out_events)
+{
+    int steps = 0;
+    int totalCleared = 0;
+    int startScore = board->score;
+
+    const BoardMode* mode = BoardMode_Of(board);
+    MatchList matches;
+
+    // Blocks left over gaps (e.g. by a swap) fall before anything is
+    // matched, as GameState_Update applies gravity before detecting
+    CompactColumns(board, mode);
+
+    while (steps < MAX_CASCADE_STEPS && mode->detectMatches(board, &matches) > 0) {
+        if (out_events) {
+            CascadeStep* step = &out_events->steps[steps];
+            memset(step->clearedMask, 0, sizeof(step->clearedMask));
+            for (int r = 0; r < matches.runCount; r++) {
+                const MatchRun* run = &matches.runs[r];
+                if (run->orientation == MATCH_HORIZONTAL) {
+                    for (int x = run->x; x < run->x + run->length; x++) {
+                        step->clearedMask[x] |= (uint16_t)(1u << run->y);
+                    }
+                } else {
+                    step->clearedMask[run->x] |=
+                        (uint16_t)(((1u << run->length) - 1u) << run->y);
+                }
+            }
+            step->chain = (uint8_t)(steps + 1);
+        }
+
+        int scoreBefore = board->score;
+        Garbage_React(board, &matches);
+        int cleared = ClearMatches(board, &matches);
+        totalCleared += cleared;
+
+        if (out_events) {
+            out_events->steps[steps].cleared = (uint8_t)cleared;
+            out_events->steps[steps].scoreDelta = (int16_t)(board->score - scoreBefore);
         }
+
+        CompactColumns(board, mode);
+        steps++;
     }
 
-    return clearedCount;
+    if (out_events) {
+        out_events->stepCount = steps;
+        out_events->totalCleared = totalCleared;
+        out_events->totalScore = board->score - startScore;
+    }
+
+    return steps;
 }
@@ -0,0 +1,168 @@
+#include "game_state.h"
+#include "garbage.h"
+#include "logger.h"
+#include "metrics.h"
+#include <string.h>
+
+// Clear animation timing
+static const float CLEAR_DELAY = 0.3f;  // Time to show matched blocks before clearing
+
+void GameState_Init(GameState* state, uint64_t seed, RowQueue* rows)
+{
+    GameState_InitMode(state, BOARD_MODE_CLASSIC, seed, rows);
+}
+
+void GameState_InitMode(GameState* state, BoardModeId mode, uint64_t seed, RowQueue* rows)
+{
+    GameBoard_InitMode(&state->board, mode);
+    GameBoard_FillSeeded(&state->board, seed);
+    state->mode = BoardMode_Of(&state->board);
+
+    SwapAnimation_Init(&state->swapAnim);
+    GravityAnimation_Init(&state->gravityAnim);
+
+    state->matches.runCount = 0;
+    state->matches.groupCount = 0;
+    state->matches.matchedCount = 0;
+    state->clearTimer = 0.0f;
+    state->waitingToClear = false;
+    state->lastMatchCount = 0;
+    state->lastClearCount = 0;
+    state->pendingGarbageCount = 0;
+    state->rows = rows;
+}
+
+bool GameState_QueueGarbage(GameState* state, int width, int height)
+{
+    if (state->pendingGarbageCount >= GAME_PENDING_GARBAGE_MAX ||
+        width < 1 || width > state->mode->width || height < 1 || height > state->mode->height) {
+        return false;
+    }
+    PendingGarbage* pending = &state->pendingGarbage[state->pendingGarbageCount++];
+    pending->width = (uint8_t)width;
+    pending->height = (uint8_t)height;
+    return true;
+}
+
+// Drop the oldest queued slab if the board is settled and has room for it
+static bool DropPendingGarbage(GameState* state)
+{
+    if (state->pendingGarbageCount == 0 || !state->rows ||
+        state->swapAnim.active || state->gravityAnim.active || state->waitingToClear) {
+        return false;
+    }
+    const PendingGarbage* next = &state->pendingGarbage[0];
+    const GarbageTemplate* garbage = RowQueue_PeekGarbage(state->rows);
+    if (!garbage || !Garbage_Spawn(&state->board, garbage, next->width, next->height)) {
+        return false;
+    }
+    RowQueue_PopGarbage(state->rows);
+    state->pendingGarbageCount--;
+    memmove(&state->pendingGarbage[0], &state->pendingGarbage[1],
+            (size_t)state->pendingGarbageCount * sizeof(state->pendingGarbage[0]));
+    state->mode->applyGravity(&state->board, &state->gravityAnim);
+    return true;
+}
+
+int GameState_Update(GameState* state, const GameInput* input, float deltaTime)
+{
+    int events = 0;
+
+    // Incoming garbage joins the queue; the oldest lands first once the
+    // board settles, and the fall it starts holds off swaps
+    if (input->flags & GAME_INPUT_GARBAGE) {
+        GameState_QueueGarbage(state, input->x + 1, input->y + 1);
+    }
+    if (DropPendingGarbage(state)) {
+        events |= GAME_EVENT_GARBAGE;
+    }
+
+    // Handle swap input (only when not animating)
+    if ((input->flags & GAME_INPUT_SWAP) &&
+        !state->swapAnim.active && !state->gravityAnim.active) {
+        if (SwapBlocks(&state->board, input->x, input->y)) {
+            SwapAnimation_Start(&state->swapAnim, input->x, input->y);
+            events |= GAME_EVENT_SWAP;
+        }
+    }
+
+    // Handle raise input (only when the board is settled)
+    if ((input->flags & GAME_INPUT_RAISE) && state->rows &&
+        !state->swapAnim.active && !state->gravityAnim.active && !state->waitingToClear) {
+        const QueuedRow* row = RowQueue_PeekRow(state->rows);
+        if (row && RaiseBoard(&state->board, row->cells)) {
+            RowQueue_PopRow(state->rows);
+            events |= GAME_EVENT_RAISE;
+        }
+    }
+
+    // Update animations
+    bool swapCompleted = SwapAnimation_Update(&state->swapAnim, deltaTime);
+    bool gravityCompleted = GravityAnimation_Update(&state->gravityAnim, deltaTime);
+
+    // Check for matches after swap completes
+    if (swapCompleted) {
+        uint64_t detectStart = Metrics_Begin();
+        state->lastMatchCount = state->mode->detectMatches(&state->board, &state->matches);
+        Metrics_AddSpan(METRIC_DETECT_MATCHES, detectStart);
+        if (state->lastMatchCount > 0) {
+            state->waitingToClear = true;
+            state->clearTimer = CLEAR_DELAY;
+            events |= GAME_EVENT_MATCH;
+        } else {
+            // No matches - apply gravity (handles swapping into empty space)
+            uint64_t gravityStart = Metrics_Begin();
+            state->mode->applyGravity(&state->board, &state->gravityAnim);
+            Metrics_AddSpan(METRIC_APPLY_GRAVITY, gravityStart);
+        }
+    }
+
+    // Check for matches after gravity completes (cascade)
+    if (gravityCompleted) {
+        events |= GAME_EVENT_LAND;
+        Garbage_Land(&state->board);
+        uint64_t detectStart = Metrics_Begin();
+        state->lastMatchCount = state->mode->detectMatches(&state->board, &state->matches);
+        Metrics_AddSpan(METRIC_DETECT_MATCHES, detectStart);
+        if (state->lastMatchCount > 0) {
+            state->waitingToClear = true;
+            state->clearTimer = CLEAR_DELAY;
+            events |= GAME_EVENT_MATCH;
+        }
+    }
+
+    // Update clear timer and clear matches when ready
+    if (state->waitingToClear) {
+        state->clearTimer -= deltaTime;
+        if (state->clearTimer <= 0.0f) {
+            int revealed = Garbage_React(&state->board, &state->matches);
+            state->lastClearCount = ClearMatches(&state->board, &state->matches);
+            state->waitingToClear = false;
+            events |= GAME_EVENT_CLEAR;
+            LOG_EVENT(BLOCKS_CLEARED, state->lastClearCount, state->board.combo, state->board.score);
+
+            // Apply gravity after clearing
+            uint64_t gravityStart = Metrics_Begin();
+            bool falling = state->mode->applyGravity(&state->board, &state->gravityAnim);
+            Metrics_AddSpan(METRIC_APPLY_GRAVITY, gravityStart);
+
+            // Revealed blocks that did not need to fall are checked now, as
+            // a landing would have
+            if (revealed > 0) {
+                events |= GAME_EVENT_REVEAL;
+                if (!falling) {
+                    uint64_t detectStart = Metrics_Begin();
+                    state->lastMatchCount = state->mode->detectMatches(&state->board, &state->matches);
+                    Metrics_AddSpan(METRIC_DETECT_MATCHES, detectStart);
+                    if (state->lastMatchCount > 0) {
+                        state->waitingToClear = true;
+                        state->clearTimer = CLEAR_DELAY;
+                        events |= GAME_EVENT_MATCH;
+                    }
+                }
+            }
+        }
+    }
+
+    return events;
+}
@@ -0,0 +1,157 @@
+#include "garbage.h"
+#include "board_mode.h"
+
+// Reveal colors are packed 3 bits per column: index 1-6 is BlockType 1 << (index - 1)
+static uint32_t PackedReveal(const GarbageSlab* slab)
+{
+    return (uint32_t)slab->reveal[0] | ((uint32_t)slab->reveal[1] << 8) | ((uint32_t)slab->reveal[2] << 16);
+}
+
+BlockType GarbageSlab_Reveal(const GarbageSlab* slab, int i)
+{
+    uint32_t index = (PackedReveal(slab) >> (3 * i)) & 0x7;
+    return index ? (BlockType)(1u << (index - 1)) : BLOCK_RED;
+}
+
+// Whether two cell rectangles share an edge (inclusive bounds, not overlapping)
+static bool RectsTouch(int ax0, int ay0, int ax1, int ay1, int bx0, int by0, int bx1, int by1)
+{
+    bool columnsOverlap = ax0 <= bx1 && bx0 <= ax1;
+    bool rowsOverlap = ay0 <= by1 && by0 <= ay1;
+    return (columnsOverlap && (ay1 + 1 == by0 || by1 + 1 == ay0)) ||
+           (rowsOverlap && (ax1 + 1 == bx0 || bx1 + 1 == ax0));
+}
+
+static bool SlabsTouch(const GarbageSlab* a, const GarbageSlab* b)
+{
+    return RectsTouch(a->x, a->y, a->x + a->width - 1, a->y + a->height - 1,
+                      b->x, b->y, b->x + b->width - 1, b->y + b->height - 1);
+}
+
+static bool RunTouches(const MatchRun* run, const GarbageSlab* slab)
+{
+    int x1 = run->x + (run->orientation == MATCH_HORIZONTAL ? run->length - 1 : 0);
+    int y1 = run->y + (run->orientation == MATCH_VERTICAL ? run->length - 1 : 0);
+    return RectsTouch(run->x, run->y, x1, y1,
+                      slab->x, slab->y, slab->x + slab->width - 1, slab->y + slab->height - 1);
+}
+
+bool Garbage_Spawn(GameBoard* board, const GarbageTemplate* garbage, int width, int height)
+{
+    const BoardMode* mode = BoardMode_Of(board);
+    if (board->slabCount >= GARBAGE_MAX_SLABS ||
+        width < 1 || width > mode->width || height < 1 || height > mode->height) {
+        return false;
+    }
+
+    int x0 = garbage->column;
+    if (x0 + width > mode->width) {
+        x0 = mode->width - width;
+    }
+
+    GarbageSlab slab = {
+        .x = (uint8_t)x0, .y = 0,
+        .width = (uint8_t)width, .height = (uint8_t)height,
+        .state = STATE_FALLING
+    };
+    for (int s = 0; s < board->slabCount; s++) {
+        const GarbageSlab* other = &board->slabs[s];
+        if (other->y < height && other->x < x0 + width && x0 < other->x + other->width) {
+            return false;
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = x0; x < x0 + width; x++) {
+            if (BLOCK_TYPE(board->grid[y * mode->width + x]) != BLOCK_EMPTY) {
+                return false;
+            }
+        }
+    }
+
+    uint32_t reveal = 0;
+    for (int i = 0; i < width; i++) {
+        BlockType type = BLOCK_TYPE(garbage->reveal[x0 + i]);
+        uint32_t index = type != BLOCK_EMPTY ? (uint32_t)__builtin_ctz(type) + 1 : 1;
+        reveal |= index << (3 * i);
+    }
+    slab.reveal[0] = (uint8_t)reveal;
+    slab.reveal[1] = (uint8_t)(reveal >> 8);
+    slab.reveal[2] = (uint8_t)(reveal >> 16);
+
+    board->slabs[board->slabCount++] = slab;
+    return true;
+}
+
+int Garbage_SlabAt(const GameBoard* board, int x, int y)
+{
+    for (int s = 0; s < board->slabCount; s++) {
+        const GarbageSlab* slab = &board->slabs[s];
+        if (x >= slab->x && x < slab->x + slab->width && y >= slab->y && y < slab->y + slab->height) {
+            return s;
+        }
+    }
+    return -1;
+}
+
+int Garbage_React(GameBoard* board, const MatchList* matches)
+{
+    uint32_t triggered = 0;
+    for (int s = 0; s < board->slabCount; s++) {
+        for (int r = 0; r < matches->runCount; r++) {
+            if (RunTouches(&matches->runs[r], &board->slabs[s])) {
+                triggered |= 1u << s;
+                break;
+            }
+        }
+    }
+    if (!triggered) {
+        return 0;
+    }
+
+    // Slabs touching a converting slab convert with it
+    for (bool spread = true; spread;) {
+        spread = false;
+        for (int s = 0; s < board->slabCount; s++) {
+            if (triggered & (1u << s)) {
+                continue;
+            }
+            for (uint32_t bits = triggered; bits; bits &= bits - 1) {
+                if (SlabsTouch(&board->slabs[s], &board->slabs[__builtin_ctz(bits)])) {
+                    triggered |= 1u << s;
+                    spread = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Highest index first, so swap-removing a used-up slab only moves one
+    // that has already been handled
+    const int boardWidth = BoardMode_Of(board)->width;
+    int revealed = 0;
+    for (int s = board->slabCount - 1; s >= 0; s--) {
+        if (!(triggered & (1u << s))) {
+            continue;
+        }
+        GarbageSlab* slab = &board->slabs[s];
+        uint16_t* row = &board->grid[(slab->y + slab->height - 1) * boardWidth + slab->x];
+
+        // Each row reveals the colors shifted by one, so stacked rows differ
+        for (int i = 0; i < slab->width; i++) {
+            row[i] = MAKE_BLOCK(GarbageSlab_Reveal(slab, (i + slab->height - 1) % slab->width), STATE_NORMAL);
+        }
+        revealed += slab->width;
+
+        if (--slab->height == 0) {
+            *slab = board->slabs[--board->slabCount];
+        }
+    }
+    return revealed;
+}
+
+void Garbage_Land(GameBoard* board)
+{
+    for (int s = 0; s < board->slabCount; s++) {
+        board->slabs[s].state = STATE_NORMAL;
+    }
+}
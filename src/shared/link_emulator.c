@@ -0,0 +1,166 @@
+#include "link_emulator.h"
+#include <string.h>
+
+// Uniform double in [0, 1)
+static double RandomUnit(Rng* rng)
+{
+    return (double)Rng_Next(rng) * (1.0 / 4294967296.0);
+}
+
+static bool Earlier(const LinkEmulator* link, uint16_t a, uint16_t b)
+{
+    const LinkPacket* x = &link->packets[a];
+    const LinkPacket* y = &link->packets[b];
+    return x->deliverAt < y->deliverAt || (x->deliverAt == y->deliverAt && x->order < y->order);
+}
+
+static void HeapPush(LinkEmulator* link, uint16_t index)
+{
+    int i = link->heapCount++;
+    link->heap[i] = index;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!Earlier(link, link->heap[i], link->heap[parent])) {
+            break;
+        }
+        uint16_t swap = link->heap[i];
+        link->heap[i] = link->heap[parent];
+        link->heap[parent] = swap;
+        i = parent;
+    }
+}
+
+static uint16_t HeapPop(LinkEmulator* link)
+{
+    uint16_t top = link->heap[0];
+    link->heap[0] = link->heap[--link->heapCount];
+
+    int i = 0;
+    for (;;) {
+        int left = 2 * i + 1, right = left + 1, smallest = i;
+        if (left < link->heapCount && Earlier(link, link->heap[left], link->heap[smallest])) {
+            smallest = left;
+        }
+        if (right < link->heapCount && Earlier(link, link->heap[right], link->heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        uint16_t swap = link->heap[i];
+        link->heap[i] = link->heap[smallest];
+        link->heap[smallest] = swap;
+        i = smallest;
+    }
+    return top;
+}
+
+void LinkEmulator_Init(LinkEmulator* link, const LinkConditions* conditions, uint64_t seed,
+                       LinkDeliverFn deliver, void* deliverContext)
+{
+    link->conditions = *conditions;
+    Rng_Seed(&link->rng, seed, 0);
+    link->deliver = deliver;
+    link->deliverContext = deliverContext;
+    link->now = 0.0;
+    link->linkFreeAt = 0.0;
+    link->nextOrder = 0;
+
+    link->freeCount = LINK_EMULATOR_CAPACITY;
+    for (int i = 0; i < LINK_EMULATOR_CAPACITY; i++) {
+        link->freeList[i] = (uint16_t)(LINK_EMULATOR_CAPACITY - 1 - i);
+    }
+    link->heapCount = 0;
+    memset(&link->stats, 0, sizeof(link->stats));
+}
+
+void LinkEmulator_SetConditions(LinkEmulator* link, const LinkConditions* conditions)
+{
+    link->conditions = *conditions;
+}
+
+// Queue one copy of a datagram for delivery after the given departure time
+static void Schedule(LinkEmulator* link, const uint8_t* data, size_t length, double departure)
+{
+    const LinkConditions* conditions = &link->conditions;
+    if (link->freeCount == 0) {
+        link->stats.queueDrops++;
+        return;
+    }
+
+    double delay = conditions->latency;
+    if (conditions->jitter > 0.0) {
+        delay += (RandomUnit(&link->rng) * 2.0 - 1.0) * conditions->jitter;
+    }
+    if (conditions->reorder > 0.0 && RandomUnit(&link->rng) < conditions->reorder) {
+        delay += conditions->reorderDelay;
+        link->stats.reordered++;
+    }
+    if (delay < 0.0) {
+        delay = 0.0;
+    }
+
+    uint16_t index = link->freeList[--link->freeCount];
+    LinkPacket* packet = &link->packets[index];
+    packet->deliverAt = departure + delay;
+    packet->order = link->nextOrder++;
+    packet->length = (uint16_t)length;
+    memcpy(packet->data, data, length);
+    HeapPush(link, index);
+}
+
+void LinkEmulator_Send(void* context, const uint8_t* data, size_t length)
+{
+    LinkEmulator* link = (LinkEmulator*)context;
+    const LinkConditions* conditions = &link->conditions;
+
+    link->stats.sent++;
+    link->stats.bytesSent += length;
+    if (length > TRANSPORT_MTU) {
+        link->stats.oversized++;
+        return;
+    }
+
+    if (conditions->loss > 0.0 && RandomUnit(&link->rng) < conditions->loss) {
+        link->stats.lost++;
+        return;
+    }
+
+    // Serialize onto a bandwidth-limited link; drop from the tail when the queue is too long
+    double departure = link->now;
+    if (conditions->bandwidth > 0.0) {
+        double start = link->linkFreeAt > link->now ? link->linkFreeAt : link->now;
+        if (start - link->now > conditions->queueLimit) {
+            link->stats.queueDrops++;
+            return;
+        }
+        departure = start + (double)length / conditions->bandwidth;
+        link->linkFreeAt = departure;
+    }
+
+    Schedule(link, data, length, departure);
+    if (conditions->duplicate > 0.0 && RandomUnit(&link->rng) < conditions->duplicate) {
+        link->stats.duplicated++;
+        Schedule(link, data, length, departure);
+    }
+}
+
+void LinkEmulator_Advance(LinkEmulator* link, double now)
+{
+    link->now = now;
+    while (link->heapCount > 0 && link->packets[link->heap[0]].deliverAt <= now) {
+        uint16_t index = HeapPop(link);
+        LinkPacket* packet = &link->packets[index];
+        link->stats.delivered++;
+        link->stats.bytesDelivered += packet->length;
+
+        // The slot is still taken during the callback, so sends it makes cannot reuse it
+        link->deliver(link->deliverContext, packet->data, packet->length, packet->deliverAt);
+        link->freeList[link->freeCount++] = index;
+    }
+}
+
+int LinkEmulator_Pending(const LinkEmulator* link)
+{
+    return link->heapCount;
+}
@@ -0,0 +1,249 @@
+#define _POSIX_C_SOURCE 200809L
+#include "logger.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Drain interval; a ring absorbs this long of logging at 800k records/s
+#define LOGGER_DRAIN_MS 5
+
+// Clock records map ticks to time; one a second keeps TSC drift negligible
+#define LOGGER_CLOCK_INTERVAL_NS 1000000000ull
+
+_Thread_local LogRing* loggerRing;
+
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+static LogRing* registry;
+static int ringCount;
+
+static FILE* logFile;
+static pthread_t drainThread;
+static atomic_bool running;
+
+static const int MESSAGE_LEVELS[] = {
+#define LOGGER_MESSAGE_LEVEL(id, level, format) level,
+    LOGGER_MESSAGES(LOGGER_MESSAGE_LEVEL)
+#undef LOGGER_MESSAGE_LEVEL
+};
+
+static const char* const MESSAGE_FORMATS[] = {
+#define LOGGER_MESSAGE_FORMAT(id, level, format) format,
+    LOGGER_MESSAGES(LOGGER_MESSAGE_FORMAT)
+#undef LOGGER_MESSAGE_FORMAT
+};
+
+static const char* const MESSAGE_NAMES[] = {
+#define LOGGER_MESSAGE_NAME(id, level, format) #id,
+    LOGGER_MESSAGES(LOGGER_MESSAGE_NAME)
+#undef LOGGER_MESSAGE_NAME
+};
+
+static const char* const LEVEL_NAMES[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+static uint64_t ClockNs(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+#if !defined(__x86_64__) && !defined(__i386__)
+uint64_t Logger_Ticks(void)
+{
+    return ClockNs(CLOCK_MONOTONIC);
+}
+#endif
+
+int Logger_MessageLevel(int message)
+{
+    return message >= 0 && message < LOG_MSG_COUNT ? MESSAGE_LEVELS[message] : LOGGER_ERROR;
+}
+
+const char* Logger_MessageFormat(int message)
+{
+    return message >= 0 && message < LOG_MSG_COUNT ? MESSAGE_FORMATS[message] : NULL;
+}
+
+const char* Logger_MessageName(int message)
+{
+    return message >= 0 && message < LOG_MSG_COUNT ? MESSAGE_NAMES[message] : NULL;
+}
+
+const char* Logger_LevelName(int level)
+{
+    return level >= LOGGER_DEBUG && level <= LOGGER_ERROR ? LEVEL_NAMES[level] : "?";
+}
+
+uint64_t Logger_TableHash(void)
+{
+    uint64_t hash = 1469598103934665603ull;
+    for (int m = 0; m < LOG_MSG_COUNT; m++) {
+        hash = (hash ^ (uint64_t)MESSAGE_LEVELS[m]) * 1099511628211ull;
+        for (const char* c = MESSAGE_FORMATS[m]; *c; c++) {
+            hash = (hash ^ (uint8_t)*c) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+static void WriteMarker(uint16_t marker, uint8_t thread, const void* args, size_t size)
+{
+    LogRecord record;
+    memset(&record, 0, sizeof(record));
+    record.message = marker;
+    record.thread = thread;
+    memcpy(record.args, args, size);
+    record.argCount = (uint8_t)((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    record.ticks = Logger_Ticks();
+    fwrite(&record, sizeof(record), 1, logFile);
+}
+
+// Pair the tick counter with both clocks (ticks read on either side of them)
+static void WriteClock(void)
+{
+    LogRecord record;
+    memset(&record, 0, sizeof(record));
+    record.message = LOGGER_RECORD_CLOCK;
+    record.argCount = 2;
+    uint64_t before = Logger_Ticks();
+    record.args[0] = ClockNs(CLOCK_MONOTONIC);
+    record.args[1] = ClockNs(CLOCK_REALTIME);
+    record.ticks = before + (Logger_Ticks() - before) / 2;
+    fwrite(&record, sizeof(record), 1, logFile);
+}
+
+// Copy everything published so far from every ring to the file
+static void DrainRings(void)
+{
+    pthread_mutex_lock(&registryLock);
+    for (LogRing* ring = registry; ring; ring = ring->next) {
+        if (!ring->announced) {
+            WriteMarker(LOGGER_RECORD_THREAD, ring->index, ring->name, sizeof(ring->name));
+            ring->announced = true;
+        }
+
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        while (tail != head) {
+            // Up to the end of the buffer, then wrap
+            uint32_t start = tail & (LOGGER_RING_RECORDS - 1);
+            uint32_t count = head - tail;
+            if (count > LOGGER_RING_RECORDS - start) {
+                count = LOGGER_RING_RECORDS - start;
+            }
+            fwrite(&ring->records[start], sizeof(LogRecord), count, logFile);
+            tail += count;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+        uint64_t dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+        if (dropped != ring->reportedDropped) {
+            uint64_t count = dropped - ring->reportedDropped;
+            WriteMarker(LOGGER_RECORD_DROPPED, ring->index, &count, sizeof(count));
+            ring->reportedDropped = dropped;
+        }
+    }
+    pthread_mutex_unlock(&registryLock);
+}
+
+static void* DrainMain(void* arg)
+{
+    (void)arg;
+    // The first pass writes a second clock record, so even a short or
+    // crashed run has a tick rate to decode with
+    uint64_t lastClock = 0;
+    struct timespec interval = { 0, LOGGER_DRAIN_MS * 1000000L };
+    while (atomic_load_explicit(&running, memory_order_acquire)) {
+        nanosleep(&interval, NULL);
+        DrainRings();
+        uint64_t now = ClockNs(CLOCK_MONOTONIC);
+        if (now - lastClock >= LOGGER_CLOCK_INTERVAL_NS) {
+            WriteClock();
+            lastClock = now;
+        }
+        fflush(logFile);
+    }
+    DrainRings();
+    WriteClock();
+    return NULL;
+}
+
+bool Logger_Start(const char* path)
+{
+    if (atomic_load(&running)) {
+        return false;
+    }
+    logFile = fopen(path, "wb");
+    if (!logFile) {
+        return false;
+    }
+    LogFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LOGGER_FILE_MAGIC, sizeof(header.magic));
+    header.recordSize = sizeof(LogRecord);
+    header.messageCount = LOG_MSG_COUNT;
+    header.tableHash = Logger_TableHash();
+    fwrite(&header, sizeof(header), 1, logFile);
+    WriteClock();
+
+    // Rings from an earlier run are reused; forget what they still hold
+    pthread_mutex_lock(&registryLock);
+    for (LogRing* ring = registry; ring; ring = ring->next) {
+        atomic_store(&ring->tail, atomic_load(&ring->head));
+        ring->reportedDropped = atomic_load(&ring->dropped);
+        ring->announced = false;
+    }
+    pthread_mutex_unlock(&registryLock);
+
+    atomic_store(&running, true);
+    if (pthread_create(&drainThread, NULL, DrainMain, NULL) != 0) {
+        atomic_store(&running, false);
+        fclose(logFile);
+        logFile = NULL;
+        return false;
+    }
+    Logger_RegisterThread("main");
+    LOG_EVENT(LOGGER_STARTED, (int)getpid());
+    return true;
+}
+
+void Logger_Stop(void)
+{
+    if (!atomic_load(&running)) {
+        return;
+    }
+    atomic_store_explicit(&running, false, memory_order_release);
+    pthread_join(drainThread, NULL);
+    fclose(logFile);
+    logFile = NULL;
+}
+
+void Logger_RegisterThread(const char* name)
+{
+    if (loggerRing || !atomic_load(&running)) {
+        return;
+    }
+    LogRing* ring = aligned_alloc(64, sizeof(LogRing));
+    if (!ring) {
+        return;
+    }
+    memset(ring, 0, offsetof(LogRing, records));
+    snprintf(ring->name, sizeof(ring->name), "%s", name);
+
+    // Rings outlive their threads so late records still reach the file
+    pthread_mutex_lock(&registryLock);
+    if (ringCount > UINT8_MAX) {
+        pthread_mutex_unlock(&registryLock);
+        free(ring);
+        return;
+    }
+    ring->index = (uint8_t)ringCount++;
+    ring->next = registry;
+    registry = ring;
+    pthread_mutex_unlock(&registryLock);
+    loggerRing = ring;
+}
@@ -1,59 +1,94 @@
 #include "match_detection.h"
+#include "board_mode.h"
 #include <string.h>
 
-// Ceiling division: rounds up a/b
-#define CEIL_DIV(a, b) (((a) + (b) - 1) / (b))
+// No run owns this cell
+#define NO_OWNER -1
 
-// Bitmask array size: ceiling of BOARD_SIZE / 8 (bits packed into bytes)
-#define MARKED_ARRAY_SIZE CEIL_DIV(BOARD_SIZE, 8)
+// Helper to mark a block as matched (preserves type, sets state to MATCHED)
+static inline void MarkAsMatched(GameBoard* board, int index)
+{
+    board->grid[index] = MAKE_BLOCK(BLOCK_TYPE(board->grid[index]), STATE_MATCHED);
+}
 
-// Bitmask helpers
-static inline void SetMarked(uint8_t* marked, int index)
+// Union-find over run indices, used to group runs that share a cell
+static int FindGroupRoot(int8_t* parent, int run)
 {
-    marked[index / 8] |= (1 << (index % 8));
+    while (parent[run] != run) {
+        parent[run] = parent[parent[run]];
+        run = parent[run];
+    }
+    return run;
 }
 
-static inline bool IsMarked(const uint8_t* marked, int index)
+static void UnionGroups(int8_t* parent, int a, int b)
 {
-    return (marked[index / 8] & (1 << (index % 8))) != 0;
+    int rootA = FindGroupRoot(parent, a);
+    int rootB = FindGroupRoot(parent, b);
+    if (rootA != rootB) {
+        parent[rootB] = (int8_t)rootA;
+    }
 }
 
-// Helper to mark a block as matched (preserves type, sets state to MATCHED)
-static void MarkAsMatched(GameBoard* board, int x, int y)
+// Append a run to the list and return its index
+static int AddRun(MatchList* matches, BlockType type, int x, int y, int length,
+                  MatchOrientation orientation)
 {
-    uint16_t cell = GameBoard_GetCell(board, x, y);
-    BlockType type = BLOCK_TYPE(cell);
-    GameBoard_SetCell(board, x, y, MAKE_BLOCK(type, STATE_MATCHED));
+    int index = matches->runCount++;
+    MatchRun* run = &matches->runs[index];
+    run->type = (uint8_t)type;
+    run->x = (uint8_t)x;
+    run->y = (uint8_t)y;
+    run->length = (uint8_t)length;
+    run->orientation = (uint8_t)orientation;
+    run->group = 0;
+    return index;
 }
 
-// Check horizontal matches starting from each position
-static int DetectHorizontalMatches(GameBoard* board, uint8_t* marked)
+// Bit i set when cell i continues the color of cell i - 1 (cells stride apart)
+// A run of MIN_MATCH_LENGTH needs two consecutive continuations
+BOARD_KERNEL uint32_t ContinuationMask(const uint16_t* cells, const int count, const int stride)
 {
-    int matchCount = 0;
+    uint32_t same = 0;
+    BOARD_UNROLL
+    for (int i = 1; i < count; i++) {
+        BlockType type = BLOCK_TYPE(cells[i * stride]);
+        same |= (uint32_t)(type != BLOCK_EMPTY && type == BLOCK_TYPE(cells[(i - 1) * stride])) << i;
+    }
+    return same;
+}
+
+// Find horizontal runs, recording which run owns each cell
+BOARD_KERNEL void DetectHorizontalMatches(GameBoard* board, MatchList* matches, int8_t* owner,
+                                          const int width, const int height)
+{
+    for (int y = 0; y < height; y++) {
+        const uint16_t* row = &board->grid[y * width];
+        uint32_t same = ContinuationMask(row, width, 1);
+        if ((same & (same >> 1)) == 0) {
+            continue;
+        }
 
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
         int runStart = 0;
-        BlockType runType = BLOCK_TYPE(GameBoard_GetCell(board, 0, y));
+        BlockType runType = BLOCK_TYPE(row[0]);
         int runLength = 1;
 
-        for (int x = 1; x <= BOARD_WIDTH; x++) {
-            BlockType currentType = (x < BOARD_WIDTH)
-                ? BLOCK_TYPE(GameBoard_GetCell(board, x, y))
-                : BLOCK_EMPTY;
+        BOARD_UNROLL
+        for (int x = 1; x <= width; x++) {
+            BlockType currentType = (x < width) ? BLOCK_TYPE(row[x]) : BLOCK_EMPTY;
 
             if (currentType == runType && runType != BLOCK_EMPTY) {
                 runLength++;
             } else {
                 // End of run - check if it's a match
                 if (runLength >= MIN_MATCH_LENGTH && runType != BLOCK_EMPTY) {
+                    int run = AddRun(matches, runType, runStart, y, runLength, MATCH_HORIZONTAL);
                     for (int i = runStart; i < runStart + runLength; i++) {
-                        int index = GRID_INDEX(i, y);
-                        if (!IsMarked(marked, index)) {
-                            SetMarked(marked, index);
-                            matchCount++;
-                        }
-                        MarkAsMatched(board, i, y);
+                        int index = y * width + i;
+                        owner[index] = (int8_t)run;
+                        MarkAsMatched(board, index);
                     }
+                    matches->matchedCount += runLength;
                 }
 
                 // Start new run
@@ -63,37 +98,44 @@ static int DetectHorizontalMatches(GameBoard* board, uint8_t* marked)
             }
         }
     }
-
-    return matchCount;
 }
 
-// Check vertical matches starting from each position
-static int DetectVerticalMatches(GameBoard* board, uint8_t* marked)
+// Find vertical runs, joining groups with any horizontal run they cross
+BOARD_KERNEL void DetectVerticalMatches(GameBoard* board, MatchList* matches,
+                                        const int8_t* owner, int8_t* parent,
+                                        const int width, const int height)
 {
-    int matchCount = 0;
+    BOARD_UNROLL
+    for (int x = 0; x < width; x++) {
+        const uint16_t* column = &board->grid[x];
+        uint32_t same = ContinuationMask(column, height, width);
+        if ((same & (same >> 1)) == 0) {
+            continue;
+        }
 
-    for (int x = 0; x < BOARD_WIDTH; x++) {
         int runStart = 0;
-        BlockType runType = BLOCK_TYPE(GameBoard_GetCell(board, x, 0));
+        BlockType runType = BLOCK_TYPE(column[0]);
         int runLength = 1;
 
-        for (int y = 1; y <= BOARD_HEIGHT; y++) {
-            BlockType currentType = (y < BOARD_HEIGHT)
-                ? BLOCK_TYPE(GameBoard_GetCell(board, x, y))
-                : BLOCK_EMPTY;
+        for (int y = 1; y <= height; y++) {
+            BlockType currentType = (y < height) ? BLOCK_TYPE(column[y * width]) : BLOCK_EMPTY;
 
             if (currentType == runType && runType != BLOCK_EMPTY) {
                 runLength++;
             } else {
                 // End of run - check if it's a match
                 if (runLength >= MIN_MATCH_LENGTH && runType != BLOCK_EMPTY) {
+                    int run = AddRun(matches, runType, x, runStart, runLength, MATCH_VERTICAL);
+                    parent[run] = (int8_t)run;
                     for (int i = runStart; i < runStart + runLength; i++) {
-                        int index = GRID_INDEX(x, i);
-                        if (!IsMarked(marked, index)) {
-                            SetMarked(marked, index);
-                            matchCount++;
+                        int index = i * width + x;
+                        if (owner[index] == NO_OWNER) {
+                            matches->matchedCount++;
+                        } else {
+                            // Shared with a horizontal run: L, T or + shape
+                            UnionGroups(parent, owner[index], run);
                         }
-                        MarkAsMatched(board, x, i);
+                        MarkAsMatched(board, index);
                     }
                 }
 
@@ -104,34 +146,58 @@ static int DetectVerticalMatches(GameBoard* board, uint8_t* marked)
             }
         }
     }
-
-    return matchCount;
 }
 
-int DetectMatches(GameBoard* board)
+BOARD_KERNEL int DetectMatchesSized(GameBoard* board, MatchList* matches,
+                                    const int width, const int height)
 {
-    // Track which blocks have been counted to avoid double-counting
-    // L-shaped and T-shaped matches. Uses bitmask: 72 cells / 8 = 9 bytes
-    uint8_t marked[MARKED_ARRAY_SIZE];
-    memset(marked, 0, sizeof(marked));
+    // Which horizontal run covers each cell, so crossing vertical runs are
+    // grouped with it and shared cells are only counted once
+    int8_t owner[BOARD_MAX_SIZE];
+    int8_t parent[MAX_MATCH_RUNS];
+    memset(owner, NO_OWNER, (size_t)(width * height));
 
-    int totalMatched = 0;
+    matches->runCount = 0;
+    matches->groupCount = 0;
+    matches->matchedCount = 0;
 
     // Detect horizontal matches first
-    totalMatched += DetectHorizontalMatches(board, marked);
+    DetectHorizontalMatches(board, matches, owner, width, height);
+    for (int i = 0; i < matches->runCount; i++) {
+        parent[i] = (int8_t)i;
+    }
 
-    // Detect vertical matches (uses same marked array to avoid double-counting)
-    totalMatched += DetectVerticalMatches(board, marked);
+    // Detect vertical matches (joins groups through the shared cells)
+    DetectVerticalMatches(board, matches, owner, parent, width, height);
 
-    return totalMatched;
+    // Number the groups in order of their first run
+    int8_t groupOfRoot[MAX_MATCH_RUNS];
+    memset(groupOfRoot, NO_OWNER, sizeof(groupOfRoot));
+    for (int i = 0; i < matches->runCount; i++) {
+        int root = FindGroupRoot(parent, i);
+        if (groupOfRoot[root] == NO_OWNER) {
+            groupOfRoot[root] = (int8_t)matches->groupCount++;
+        }
+        matches->runs[i].group = (uint8_t)groupOfRoot[root];
+    }
+
+    return matches->matchedCount;
 }
 
-bool HasMatchedBlocks(const GameBoard* board)
-{
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        if (BLOCK_STATE(board->grid[i]) == STATE_MATCHED) {
-            return true;
-        }
+#define DEFINE_DETECT_MATCHES(tag, width, height)                       \
+    int DetectMatches_##tag(GameBoard* board, MatchList* matches)       \
+    {                                                                   \
+        return DetectMatchesSized(board, matches, (width), (height));  \
     }
-    return false;
+BOARD_GEOMETRIES(DEFINE_DETECT_MATCHES)
+#undef DEFINE_DETECT_MATCHES
+
+int DetectMatches(GameBoard* board, MatchList* matches)
+{
+    return BoardMode_Of(board)->detectMatches(board, matches);
+}
+
+bool HasMatchedBlocks(const MatchList* matches)
+{
+    return matches->runCount > 0;
 }
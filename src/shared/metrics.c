@@ -0,0 +1,345 @@
+#define _GNU_SOURCE
+#include "metrics.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+// Histogram buckets exported: one le boundary per power of two in this range
+// (powers of two are bucket edges, so the cumulative counts are exact)
+#define EXPORT_MIN_BITS 8       // 256 ns
+#define EXPORT_MAX_BITS 34      // 17 s
+
+// Longest request header read from a scraper
+#define REQUEST_SIZE 2048
+
+_Thread_local MetricsThread* metricsThread;
+
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+static MetricsThread* registry;
+static atomic_bool enabled;
+static _Atomic int64_t gauges[METRIC_GAUGE_COUNT];
+
+static const char* const COUNTER_NAMES[] = {
+#define METRIC_NAME(id, name, help) name,
+    METRICS_COUNTERS(METRIC_NAME)
+};
+static const char* const GAUGE_NAMES[] = { METRICS_GAUGES(METRIC_NAME) };
+static const char* const HISTOGRAM_NAMES[] = { METRICS_HISTOGRAMS(METRIC_NAME) };
+#undef METRIC_NAME
+
+static const char* const COUNTER_HELP[] = {
+#define METRIC_HELP(id, name, help) help,
+    METRICS_COUNTERS(METRIC_HELP)
+};
+static const char* const GAUGE_HELP[] = { METRICS_GAUGES(METRIC_HELP) };
+static const char* const HISTOGRAM_HELP[] = { METRICS_HISTOGRAMS(METRIC_HELP) };
+#undef METRIC_HELP
+
+uint64_t Metrics_NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void Metrics_Enable(void)
+{
+    atomic_store(&enabled, true);
+}
+
+void Metrics_RegisterThread(void)
+{
+    if (metricsThread || !atomic_load(&enabled)) {
+        return;
+    }
+    MetricsThread* thread = aligned_alloc(64, (sizeof(MetricsThread) + 63) & ~(size_t)63);
+    if (!thread) {
+        return;
+    }
+    memset(thread, 0, sizeof(*thread));
+
+    // Blocks outlive their threads so counters never go backwards
+    pthread_mutex_lock(&registryLock);
+    thread->next = registry;
+    registry = thread;
+    pthread_mutex_unlock(&registryLock);
+    metricsThread = thread;
+}
+
+uint64_t Metrics_BucketLowerBound(unsigned index)
+{
+    if (index < (1u << METRICS_SUB_BITS)) {
+        return index;
+    }
+    unsigned shift = (index >> METRICS_SUB_BITS) - 1;
+    uint64_t mantissa = (index & ((1u << METRICS_SUB_BITS) - 1)) + (1u << METRICS_SUB_BITS);
+    return mantissa << shift;
+}
+
+void Metrics_SetGauge(MetricGauge gauge, int64_t value)
+{
+    atomic_store_explicit(&gauges[gauge], value, memory_order_relaxed);
+}
+
+void Metrics_Collect(MetricsSnapshot* snapshot)
+{
+    memset(snapshot, 0, sizeof(*snapshot));
+    for (int g = 0; g < METRIC_GAUGE_COUNT; g++) {
+        snapshot->gauges[g] = atomic_load_explicit(&gauges[g], memory_order_relaxed);
+    }
+
+    pthread_mutex_lock(&registryLock);
+    for (MetricsThread* thread = registry; thread; thread = thread->next) {
+        for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+            snapshot->counters[c] += atomic_load_explicit(&thread->counters[c], memory_order_relaxed);
+        }
+        for (int h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+            MetricsHistogramData* data = &thread->histograms[h];
+            // A sample racing the merge may be in its bucket but not yet in
+            // count; exported cumulative counts are clamped to count
+            snapshot->histograms[h].count += atomic_load_explicit(&data->count, memory_order_relaxed);
+            snapshot->histograms[h].sum += atomic_load_explicit(&data->sum, memory_order_relaxed);
+            for (int b = 0; b < METRICS_BUCKETS; b++) {
+                snapshot->histograms[h].buckets[b] += atomic_load_explicit(&data->buckets[b], memory_order_relaxed);
+            }
+        }
+    }
+    pthread_mutex_unlock(&registryLock);
+}
+
+uint64_t Metrics_Quantile(const MetricsSnapshot* snapshot, MetricHistogram histogram, double quantile)
+{
+    uint64_t total = 0;
+    for (int b = 0; b < METRICS_BUCKETS; b++) {
+        total += snapshot->histograms[histogram].buckets[b];
+    }
+    uint64_t rank = (uint64_t)(quantile * (double)total);
+    uint64_t seen = 0;
+    for (int b = 0; b < METRICS_BUCKETS; b++) {
+        seen += snapshot->histograms[histogram].buckets[b];
+        if (seen > rank) {
+            return Metrics_BucketLowerBound((unsigned)b);
+        }
+    }
+    return 0;
+}
+
+void Metrics_WritePrometheus(FILE* out, const MetricsSnapshot* snapshot)
+{
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+        fprintf(out, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n", COUNTER_NAMES[c], COUNTER_HELP[c],
+                COUNTER_NAMES[c], COUNTER_NAMES[c], (unsigned long long)snapshot->counters[c]);
+    }
+    for (int g = 0; g < METRIC_GAUGE_COUNT; g++) {
+        fprintf(out, "# HELP %s %s\n# TYPE %s gauge\n%s %lld\n", GAUGE_NAMES[g], GAUGE_HELP[g],
+                GAUGE_NAMES[g], GAUGE_NAMES[g], (long long)snapshot->gauges[g]);
+    }
+    for (int h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+        const char* name = HISTOGRAM_NAMES[h];
+        uint64_t count = snapshot->histograms[h].count;
+        fprintf(out, "# HELP %s %s\n# TYPE %s histogram\n", name, HISTOGRAM_HELP[h], name);
+
+        uint64_t cumulative = 0;
+        int bucket = 0;
+        for (int bits = EXPORT_MIN_BITS; bits <= EXPORT_MAX_BITS; bits++) {
+            uint64_t bound = 1ull << bits;
+            while (bucket < METRICS_BUCKETS && Metrics_BucketLowerBound((unsigned)bucket) < bound) {
+                cumulative += snapshot->histograms[h].buckets[bucket++];
+            }
+            fprintf(out, "%s_bucket{le=\"%.9g\"} %llu\n", name, (double)bound / 1e9,
+                    (unsigned long long)(cumulative < count ? cumulative : count));
+        }
+        fprintf(out, "%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)count);
+        fprintf(out, "%s_sum %.9f\n", name, (double)snapshot->histograms[h].sum / 1e9);
+        fprintf(out, "%s_count %llu\n", name, (unsigned long long)count);
+    }
+}
+
+// Write the snapshot beside the target and rename it over, so readers never
+// see a partial file
+static void WriteSnapshotFile(const char* path, const MetricsSnapshot* snapshot)
+{
+    char temp[4096];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE* out = fopen(temp, "w");
+    if (!out) {
+        return;
+    }
+    Metrics_WritePrometheus(out, snapshot);
+    if (fclose(out) == 0) {
+        rename(temp, path);
+    } else {
+        remove(temp);
+    }
+}
+
+static void SendAll(int fd, const char* data, size_t length)
+{
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+}
+
+// Answer one HTTP request: GET /metrics (or /) gets the merged metrics
+static void ServeScrape(MetricsExporter* exporter, int fd)
+{
+    struct timeval timeout = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char request[REQUEST_SIZE];
+    size_t length = 0;
+    while (length < sizeof(request) - 1) {
+        ssize_t got = recv(fd, request + length, sizeof(request) - 1 - length, 0);
+        if (got <= 0) {
+            break;
+        }
+        length += (size_t)got;
+        request[length] = '\0';
+        if (strstr(request, "\r\n\r\n")) {
+            break;
+        }
+    }
+    request[length] = '\0';
+
+    if (strncmp(request, "GET /metrics ", 13) != 0 && strncmp(request, "GET / ", 6) != 0) {
+        static const char notFound[] = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        SendAll(fd, notFound, sizeof(notFound) - 1);
+        return;
+    }
+
+    static MetricsSnapshot snapshot;
+    Metrics_Collect(&snapshot);
+    char* body = NULL;
+    size_t bodyLength = 0;
+    FILE* out = open_memstream(&body, &bodyLength);
+    if (!out) {
+        return;
+    }
+    Metrics_WritePrometheus(out, &snapshot);
+    fclose(out);
+
+    char header[256];
+    int headerLength = snprintf(header, sizeof(header),
+                                "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                "Content-Length: %zu\r\nConnection: close\r\n\r\n", bodyLength);
+    SendAll(fd, header, (size_t)headerLength);
+    SendAll(fd, body, bodyLength);
+    free(body);
+    atomic_fetch_add_explicit(&exporter->scrapes, 1, memory_order_relaxed);
+}
+
+static void* ExporterMain(void* arg)
+{
+    MetricsExporter* exporter = (MetricsExporter*)arg;
+#ifdef __linux__
+    // Only run when the shards leave a core idle
+    struct sched_param param = { 0 };
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+
+    static MetricsSnapshot snapshot;
+    uint64_t intervalNs = (uint64_t)(exporter->snapshotInterval * 1e9);
+    uint64_t nextSnapshot = Metrics_NowNs() + intervalNs;
+
+    while (atomic_load_explicit(&exporter->running, memory_order_acquire)) {
+        // Wake at least every 100 ms to notice Stop
+        int timeoutMs = 100;
+        if (exporter->snapshotPath) {
+            uint64_t now = Metrics_NowNs();
+            if (now >= nextSnapshot) {
+                Metrics_Collect(&snapshot);
+                WriteSnapshotFile(exporter->snapshotPath, &snapshot);
+                nextSnapshot = now + intervalNs;
+            }
+            uint64_t waitMs = (nextSnapshot - now) / 1000000;
+            timeoutMs = waitMs < (uint64_t)timeoutMs ? (int)waitMs : timeoutMs;
+        }
+
+        if (exporter->listenSocket < 0) {
+            struct timespec ts = { 0, (long)timeoutMs * 1000000 };
+            nanosleep(&ts, NULL);
+            continue;
+        }
+        struct pollfd pfd = { exporter->listenSocket, POLLIN, 0 };
+        if (poll(&pfd, 1, timeoutMs) > 0) {
+            int fd = accept(exporter->listenSocket, NULL, NULL);
+            if (fd >= 0) {
+                ServeScrape(exporter, fd);
+                close(fd);
+            }
+        }
+    }
+
+    if (exporter->snapshotPath) {
+        Metrics_Collect(&snapshot);
+        WriteSnapshotFile(exporter->snapshotPath, &snapshot);
+    }
+    return NULL;
+}
+
+bool MetricsExporter_Start(MetricsExporter* exporter, int port, const char* snapshotPath, double snapshotInterval)
+{
+    memset(exporter, 0, sizeof(*exporter));
+    exporter->port = port;
+    exporter->snapshotPath = snapshotPath;
+    exporter->snapshotInterval = snapshotInterval > 0.0 ? snapshotInterval : 1.0;
+    exporter->listenSocket = -1;
+
+    if (port > 0) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons((uint16_t)port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 16) != 0) {
+            close(fd);
+            return false;
+        }
+        exporter->listenSocket = fd;
+    }
+
+    Metrics_Enable();
+    atomic_init(&exporter->running, true);
+    atomic_init(&exporter->scrapes, 0);
+    if (pthread_create(&exporter->thread, NULL, ExporterMain, exporter) != 0) {
+        if (exporter->listenSocket >= 0) {
+            close(exporter->listenSocket);
+        }
+        return false;
+    }
+    return true;
+}
+
+void MetricsExporter_Stop(MetricsExporter* exporter)
+{
+    atomic_store_explicit(&exporter->running, false, memory_order_release);
+    pthread_join(exporter->thread, NULL);
+    if (exporter->listenSocket >= 0) {
+        close(exporter->listenSocket);
+        exporter->listenSocket = -1;
+    }
+}
@@ -1,4 +1,12 @@
 #include "physics.h"
+#include "board_mode.h"
+#include <string.h>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#else
+#include <pthread.h>
+#endif
 
 static const float GRAVITY_DURATION = 0.15f;  // seconds per cell fallen
 
@@ -8,59 +16,321 @@ void GravityAnimation_Init(GravityAnimation* anim)
     anim->progress = 0.0f;
     anim->duration = GRAVITY_DURATION;
     anim->count = 0;
+    memset(anim->slabFall, 0, sizeof(anim->slabFall));
 }
 
-bool ApplyGravity(GameBoard* board, GravityAnimation* anim)
+// Rows are numbered from the bottom in the column kernels below: bit b of a
+// column's occupancy mask is cell (x, height - 1 - b), and nibble k of a
+// packed row list holds one such row number
+#define ROW_NUMBERS 0xFEDCBA9876543210ull
+_Static_assert(BOARD_MAX_HEIGHT <= 12, "gravity lookup table is indexed by a 12-bit column mask");
+
+#if defined(__BMI2__)
+// Rows of the occupied cells, lowest first, packed into nibbles
+static inline uint64_t CompactRows(uint32_t occupied)
+{
+    uint64_t nibbles = _pdep_u64(occupied, 0x1111111111111111ull) * 0xF;
+    return _pext_u64(ROW_NUMBERS, nibbles);
+}
+#else
+// CompactRows for every column mask, built on first use (32 KiB)
+static uint64_t compactRowsTable[1 << BOARD_MAX_HEIGHT];
+static pthread_once_t compactRowsOnce = PTHREAD_ONCE_INIT;
+
+static void BuildCompactRowsTable(void)
+{
+    for (uint32_t mask = 0; mask < (1u << BOARD_MAX_HEIGHT); mask++) {
+        uint64_t rows = 0;
+        int count = 0;
+        for (uint32_t bits = mask; bits; bits &= bits - 1) {
+            rows |= (uint64_t)__builtin_ctz(bits) << (4 * count++);
+        }
+        compactRowsTable[mask] = rows;
+    }
+}
+
+static inline uint64_t CompactRows(uint32_t occupied)
+{
+    return compactRowsTable[occupied];
+}
+#endif
+
+// Start the animation for whatever moved, timed by the longest fall
+static bool StartGravityAnimation(GravityAnimation* anim, bool moved, int maxFallDistance)
+{
+    if (!moved) {
+        return false;
+    }
+    anim->active = true;
+    anim->progress = 0.0f;
+    // Scale duration based on max fall distance for consistent speed
+    anim->duration = GRAVITY_DURATION * maxFallDistance;
+    return true;
+}
+
+// Drop the blocks of column x in rows [top, end) onto *floorY, lowest first
+static void SettleColumn(GameBoard* board, GravityAnimation* anim, const int width, int x, int top, int end,
+                         uint32_t occupied, int* floorY, int* maxFallDistance)
+{
+    uint32_t rows = occupied & ((1u << end) - 1u) & ~((1u << top) - 1u);
+    int floor = *floorY;
+    while (rows) {
+        int y = 31 - __builtin_clz(rows);
+        rows &= ~(1u << y);
+        int toY = --floor;
+        if (toY == y) {
+            continue;
+        }
+        board->grid[toY * width + x] = board->grid[y * width + x];
+        board->grid[y * width + x] = MAKE_BLOCK(BLOCK_EMPTY, STATE_NORMAL);
+
+        anim->blocks[anim->count].x = (uint8_t)x;
+        anim->blocks[anim->count].y = (uint8_t)toY;
+        anim->blocks[anim->count].fallDistance = (uint8_t)(toY - y);
+        anim->count++;
+        if (toY - y > *maxFallDistance) {
+            *maxFallDistance = toY - y;
+        }
+    }
+    *floorY = floor;
+}
+
+// Gravity for a board with garbage slabs
+// Slabs are settled lowest first. The blocks under a slab drop onto what
+// is already settled in each of its columns, then the slab drops as a unit
+// onto the highest of those stacks and becomes the floor for the blocks
+// above it. Only blocks and slabs are visited, never the covered cells.
+BOARD_KERNEL bool ApplyGravityWithSlabs(GameBoard* board, GravityAnimation* anim,
+                                        const int width, const int height)
+{
+    anim->count = 0;
+    memset(anim->slabFall, 0, sizeof(anim->slabFall));
+    int maxFallDistance = 0;
+    bool slabMoved = false;
+
+    // Insertion sort by bottom row, lowest on the board first
+    for (int s = 1; s < board->slabCount; s++) {
+        GarbageSlab slab = board->slabs[s];
+        int i = s;
+        while (i > 0 && board->slabs[i - 1].y + board->slabs[i - 1].height < slab.y + slab.height) {
+            board->slabs[i] = board->slabs[i - 1];
+            i--;
+        }
+        board->slabs[i] = slab;
+    }
+
+    uint32_t occupied[BOARD_MAX_WIDTH];     // Bit y: row y holds a block
+    int floorY[BOARD_MAX_WIDTH];            // Top of the settled part of the column
+    int pending[BOARD_MAX_WIDTH];           // Rows from here down are settled
+    BOARD_UNROLL
+    for (int x = 0; x < width; x++) {
+        occupied[x] = 0;
+        floorY[x] = height;
+        pending[x] = height;
+    }
+    for (int y = 0; y < height; y++) {
+        BOARD_UNROLL
+        for (int x = 0; x < width; x++) {
+            occupied[x] |= (uint32_t)(BLOCK_TYPE(board->grid[y * width + x]) != BLOCK_EMPTY) << y;
+        }
+    }
+
+    for (int s = 0; s < board->slabCount; s++) {
+        GarbageSlab* slab = &board->slabs[s];
+        int bottom = slab->y + slab->height - 1;
+        int landing = height;
+        for (int x = slab->x; x < slab->x + slab->width; x++) {
+            SettleColumn(board, anim, width, x, bottom + 1, pending[x], occupied[x], &floorY[x], &maxFallDistance);
+            pending[x] = slab->y;
+            if (floorY[x] < landing) {
+                landing = floorY[x];
+            }
+        }
+
+        int fallDistance = landing - 1 - bottom;
+        slab->y = (uint8_t)(slab->y + fallDistance);
+        slab->state = fallDistance > 0 ? STATE_FALLING : STATE_NORMAL;
+        anim->slabFall[s] = (uint8_t)fallDistance;
+        if (fallDistance > 0) {
+            slabMoved = true;
+            if (fallDistance > maxFallDistance) {
+                maxFallDistance = fallDistance;
+            }
+        }
+        for (int x = slab->x; x < slab->x + slab->width; x++) {
+            floorY[x] = slab->y;
+        }
+    }
+
+    for (int x = 0; x < width; x++) {
+        SettleColumn(board, anim, width, x, 0, pending[x], occupied[x], &floorY[x], &maxFallDistance);
+    }
+
+    return StartGravityAnimation(anim, anim->count > 0 || slabMoved, maxFallDistance);
+}
+
+BOARD_KERNEL bool ApplyGravitySized(GameBoard* board, GravityAnimation* anim,
+                                    const int width, const int height)
 {
+    if (board->slabCount > 0) {
+        return ApplyGravityWithSlabs(board, anim, width, height);
+    }
+#if !defined(__BMI2__)
+    pthread_once(&compactRowsOnce, BuildCompactRowsTable);
+#endif
     anim->count = 0;
     int maxFallDistance = 0;
 
     // Process each column independently
-    for (int x = 0; x < BOARD_WIDTH; x++) {
-        // Track where the next block should land
-        int writeY = BOARD_HEIGHT - 1;
+    BOARD_UNROLL
+    for (int x = 0; x < width; x++) {
+        uint16_t* column = &board->grid[x];
+        uint32_t occupied = 0;
+        BOARD_UNROLL
+        for (int y = 0; y < height; y++) {
+            occupied |= (uint32_t)(BLOCK_TYPE(column[y * width]) != BLOCK_EMPTY) << (height - 1 - y);
+        }
+
+        // Blocks below the lowest gap stay put; nothing above it means the
+        // column is already settled
+        int firstGap = __builtin_ctz(~occupied);
+        if ((occupied >> firstGap) == 0) {
+            continue;
+        }
+
+        // Compacting the column puts the k-th block from the bottom in row k,
+        // so each block falls by its row minus the popcount of the blocks
+        // below it. Rows only ever move down, so copying lowest first is safe.
+        int filled = __builtin_popcount(occupied);
+        uint64_t rows = CompactRows(occupied);
+        for (int k = firstGap; k < filled; k++) {
+            int from = (int)(rows >> (4 * k)) & 0xF;
+            int toY = height - 1 - k;
+            column[toY * width] = column[(height - 1 - from) * width];
+
+            // Record for animation
+            anim->blocks[anim->count].x = (uint8_t)x;
+            anim->blocks[anim->count].y = (uint8_t)toY;
+            anim->blocks[anim->count].fallDistance = (uint8_t)(from - k);
+            anim->count++;
+        }
+
+        // Cells above the compacted stack that held a block are now empty
+        for (uint32_t vacated = occupied >> filled << filled; vacated; vacated &= vacated - 1) {
+            column[(height - 1 - __builtin_ctz(vacated)) * width] = MAKE_BLOCK(BLOCK_EMPTY, STATE_NORMAL);
+        }
+
+        // The top block falls furthest: past every gap in the column
+        int fallDistance = (31 - __builtin_clz(occupied)) - (filled - 1);
+        if (fallDistance > maxFallDistance) {
+            maxFallDistance = fallDistance;
+        }
+    }
+
+    // Start animation if any blocks moved
+    return StartGravityAnimation(anim, anim->count > 0, maxFallDistance);
+}
+
+#define DEFINE_APPLY_GRAVITY(tag, width, height)                            \
+    bool ApplyGravity_##tag(GameBoard* board, GravityAnimation* anim)       \
+    {                                                                       \
+        return ApplyGravitySized(board, anim, (width), (height));           \
+    }
+BOARD_GEOMETRIES(DEFINE_APPLY_GRAVITY)
+#undef DEFINE_APPLY_GRAVITY
+
+bool ApplyGravity(GameBoard* board, GravityAnimation* anim)
+{
+    return BoardMode_Of(board)->applyGravity(board, anim);
+}
+
+bool ApplyGravity_Scan(GameBoard* board, GravityAnimation* anim)
+{
+    const BoardMode* mode = BoardMode_Of(board);
+    if (board->slabCount > 0) {
+        return ApplyGravityWithSlabs(board, anim, mode->width, mode->height);
+    }
+
+    anim->count = 0;
+    int maxFallDistance = 0;
 
-        // Scan from bottom to top
-        for (int readY = BOARD_HEIGHT - 1; readY >= 0; readY--) {
+    for (int x = 0; x < mode->width; x++) {
+        // Track where the next block should land, scanning from bottom to top
+        int writeY = mode->height - 1;
+        for (int readY = mode->height - 1; readY >= 0; readY--) {
             uint16_t cell = GameBoard_GetCell(board, x, readY);
-            BlockType type = BLOCK_TYPE(cell);
-
-            if (type != BLOCK_EMPTY) {
-                int fallDistance = writeY - readY;
-
-                if (fallDistance > 0) {
-                    // Move block down
-                    GameBoard_SetCell(board, x, writeY, cell);
-                    GameBoard_SetCell(board, x, readY, MAKE_BLOCK(BLOCK_EMPTY, STATE_NORMAL));
-
-                    // Record for animation
-                    if (anim->count < MAX_FALLING_BLOCKS) {
-                        anim->blocks[anim->count].x = x;
-                        anim->blocks[anim->count].y = writeY;
-                        anim->blocks[anim->count].fallDistance = fallDistance;
-                        anim->count++;
-                    }
-
-                    if (fallDistance > maxFallDistance) {
-                        maxFallDistance = fallDistance;
-                    }
-                }
+            if (BLOCK_TYPE(cell) == BLOCK_EMPTY) {
+                continue;
+            }
 
-                writeY--;
+            int fallDistance = writeY - readY;
+            if (fallDistance > 0) {
+                GameBoard_SetCell(board, x, writeY, cell);
+                GameBoard_SetCell(board, x, readY, MAKE_BLOCK(BLOCK_EMPTY, STATE_NORMAL));
+
+                anim->blocks[anim->count].x = (uint8_t)x;
+                anim->blocks[anim->count].y = (uint8_t)writeY;
+                anim->blocks[anim->count].fallDistance = (uint8_t)fallDistance;
+                anim->count++;
+
+                if (fallDistance > maxFallDistance) {
+                    maxFallDistance = fallDistance;
+                }
             }
+            writeY--;
         }
     }
 
-    // Start animation if any blocks moved
-    if (anim->count > 0) {
-        anim->active = true;
-        anim->progress = 0.0f;
-        // Scale duration based on max fall distance for consistent speed
-        anim->duration = GRAVITY_DURATION * maxFallDistance;
-        return true;
+    return StartGravityAnimation(anim, anim->count > 0, maxFallDistance);
+}
+
+// Cycle to the next of the mode's colors (BlockType values are single bits)
+static BlockType NextColor(BlockType type, int colorCount)
+{
+    return (type == (BlockType)(1 << (colorCount - 1))) ? BLOCK_RED : (BlockType)(type << 1);
+}
+
+bool RaiseBoard(GameBoard* board, const uint16_t* newRow)
+{
+    const BoardMode* mode = BoardMode_Of(board);
+    const int width = mode->width;
+    const int height = mode->height;
+
+    // A block or slab in the top row would be pushed off the board
+    for (int x = 0; x < width; x++) {
+        if (BLOCK_TYPE(board->grid[x]) != BLOCK_EMPTY) {
+            return false;
+        }
+    }
+    for (int s = 0; s < board->slabCount; s++) {
+        if (board->slabs[s].y == 0) {
+            return false;
+        }
     }
 
-    return false;
+    memmove(&board->grid[0], &board->grid[width],
+            (size_t)(width * (height - 1)) * sizeof(board->grid[0]));
+    for (int s = 0; s < board->slabCount; s++) {
+        board->slabs[s].y--;
+    }
+
+    uint16_t* bottom = &board->grid[(height - 1) * width];
+    for (int x = 0; x < width; x++) {
+        BlockType type = BLOCK_TYPE(newRow[x]);
+        BlockType up1 = BLOCK_TYPE(bottom[x - width]);
+        BlockType up2 = BLOCK_TYPE(bottom[x - 2 * width]);
+        BlockType left1 = (x >= 1) ? BLOCK_TYPE(bottom[x - 1]) : BLOCK_EMPTY;
+        BlockType left2 = (x >= 2) ? BLOCK_TYPE(bottom[x - 2]) : BLOCK_EMPTY;
+
+        // The queue already avoids this against the rows it generated; the
+        // player may have rearranged them since
+        while ((type == up1 && type == up2) || (type == left1 && type == left2)) {
+            type = NextColor(type, mode->colorCount);
+        }
+        bottom[x] = MAKE_BLOCK(type, STATE_NORMAL);
+    }
+
+    return true;
 }
 
 bool GravityAnimation_Update(GravityAnimation* anim, float deltaTime)
@@ -0,0 +1,486 @@
+#define _POSIX_C_SOURCE 200809L
+#include "puzzle_solver.h"
+#include "board_mode.h"
+#include "game_logic.h"
+#include "rng.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Table data: the low byte is the number of moves the board is proven not to
+// be solvable in
+#define TABLE_DEPTH_MASK 0xFFull
+
+// Attempts at placing and breaking up one match before giving up on a move
+#define GENERATE_ATTEMPTS 64
+
+// A board one move away from its parent
+typedef struct {
+    GameBoard board;
+    uint64_t key;
+    int order;                  // Lower is tried first
+    PuzzleMove move;
+} SearchChild;
+
+// State shared by the workers searching one bound
+typedef struct {
+    PuzzleSolver* solver;
+    const SearchChild* roots;
+    int rootCount;
+    int bound;
+    atomic_int nextRoot;
+    atomic_int bestRoot;        // Lowest root index with a solution (INT_MAX = none)
+    int pathLength[PUZZLE_MAX_BRANCHING];
+    PuzzleMove paths[PUZZLE_MAX_BRANCHING][PUZZLE_MAX_MOVES];
+} SearchShared;
+
+typedef struct {
+    SearchShared* shared;
+    int rootIndex;              // Root move being searched
+    uint64_t nodes;
+    uint64_t probes;
+    uint64_t hits;
+    PuzzleMove path[PUZZLE_MAX_MOVES];
+    SearchChild children[PUZZLE_MAX_MOVES][PUZZLE_MAX_BRANCHING];
+    int order[PUZZLE_MAX_MOVES][PUZZLE_MAX_BRANCHING];
+} SearchWorker;
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Settled boards only hold normal blocks, so the raw grid identifies them
+static uint64_t HashBoard(const GameBoard* board)
+{
+    uint64_t words[sizeof(board->grid) / sizeof(uint64_t)];
+    memcpy(words, board->grid, sizeof(words));
+
+    uint64_t hash = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        hash = (hash ^ words[i]) * 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 31;
+    }
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+    return hash ^ (hash >> 31);
+}
+
+// Count blocks; a color with one or two blocks can never be matched again
+// Returns the block count, or -1 for such a dead board
+static int CountBlocks(const GameBoard* board, const BoardMode* mode)
+{
+    int perColor[BLOCK_MAX_TYPE_COUNT] = { 0 };
+    int total = 0;
+    for (int i = 0; i < mode->width * mode->height; i++) {
+        BlockType type = BLOCK_TYPE(board->grid[i]);
+        if (type != BLOCK_EMPTY) {
+            perColor[__builtin_ctz(type)]++;
+            total++;
+        }
+    }
+    for (int c = 0; c < mode->colorCount; c++) {
+        if (perColor[c] == 1 || perColor[c] == 2) {
+            return -1;
+        }
+    }
+    return total;
+}
+
+// Same-colored horizontal and vertical neighbors: boards with more are
+// usually fewer moves from a match
+static int CountNeighbors(const GameBoard* board, const BoardMode* mode)
+{
+    const int width = mode->width;
+    int neighbors = 0;
+    for (int y = 0; y < mode->height; y++) {
+        for (int x = 0; x < width; x++) {
+            BlockType type = BLOCK_TYPE(board->grid[y * width + x]);
+            if (type == BLOCK_EMPTY) {
+                continue;
+            }
+            neighbors += x + 1 < width && BLOCK_TYPE(board->grid[y * width + x + 1]) == type;
+            neighbors += y + 1 < mode->height && BLOCK_TYPE(board->grid[(y + 1) * width + x]) == type;
+        }
+    }
+    return neighbors;
+}
+
+// ResolveCascade settles the swap before looking for matches
+static bool ApplyMove(GameBoard* board, PuzzleMove move)
+{
+    if (!SwapBlocks(board, move.x, move.y)) {
+        return false;
+    }
+    ResolveCascade(board, NULL);
+    return true;
+}
+
+bool Puzzle_ApplyMove(GameBoard* board, PuzzleMove move)
+{
+    return ApplyMove(board, move);
+}
+
+// Play every move from the board into children, ordered best first
+// Returns the number of live children; *clearing is set to the index of a
+// child with an empty board, or -1
+static int Expand(SearchWorker* worker, const GameBoard* board, SearchChild* children, int* order,
+                  int* clearing)
+{
+    const BoardMode* mode = BoardMode_Of(board);
+    const int width = mode->width;
+    int count = 0;
+    *clearing = -1;
+
+    for (int y = 0; y < mode->height; y++) {
+        for (int x = 0; x + 1 < width; x++) {
+            // Swapping two blocks of the same color (or two gaps) changes nothing
+            if (BLOCK_TYPE(board->grid[y * width + x]) == BLOCK_TYPE(board->grid[y * width + x + 1])) {
+                continue;
+            }
+
+            SearchChild* child = &children[count];
+            child->board = *board;
+            child->move.x = (uint8_t)x;
+            child->move.y = (uint8_t)y;
+            if (!ApplyMove(&child->board, child->move)) {
+                continue;
+            }
+            worker->nodes++;
+
+            int blocks = CountBlocks(&child->board, mode);
+            if (blocks == 0) {
+                *clearing = count;
+                return count + 1;
+            }
+            if (blocks < 0) {
+                continue;
+            }
+            child->key = HashBoard(&child->board);
+            child->order = blocks * 4 * BOARD_MAX_SIZE - CountNeighbors(&child->board, mode);
+
+            // Insertion sort by order; ties keep move order
+            int i = count++;
+            while (i > 0 && children[order[i - 1]].order > child->order) {
+                order[i] = order[i - 1];
+                i--;
+            }
+            order[i] = (int)(child - children);
+        }
+    }
+    return count;
+}
+
+static bool TableProbe(SearchWorker* worker, uint64_t key, int remaining)
+{
+    PuzzleTableEntry* entry = &worker->shared->solver->table[key & worker->shared->solver->tableMask];
+    uint64_t data = atomic_load_explicit(&entry->data, memory_order_relaxed);
+    uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+    worker->probes++;
+    if ((check ^ data) == key && (int)(data & TABLE_DEPTH_MASK) >= remaining) {
+        worker->hits++;
+        return true;
+    }
+    return false;
+}
+
+// Record that the board has no solution within remaining moves
+static void TableStore(SearchWorker* worker, uint64_t key, int remaining)
+{
+    PuzzleTableEntry* entry = &worker->shared->solver->table[key & worker->shared->solver->tableMask];
+    uint64_t data = atomic_load_explicit(&entry->data, memory_order_relaxed);
+    uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+
+    // Keep a deeper result for the same board; otherwise the newest wins
+    if ((check ^ data) == key && (int)(data & TABLE_DEPTH_MASK) >= remaining) {
+        return;
+    }
+    data = (uint64_t)remaining;
+    atomic_store_explicit(&entry->check, key ^ data, memory_order_relaxed);
+    atomic_store_explicit(&entry->data, data, memory_order_relaxed);
+}
+
+// A lower root move already has a solution; this one cannot win
+static bool Aborted(const SearchWorker* worker)
+{
+    return atomic_load_explicit(&worker->shared->bestRoot, memory_order_relaxed) < worker->rootIndex;
+}
+
+// Depth-first search for a solution within remaining moves of a live board
+static bool Search(SearchWorker* worker, const GameBoard* board, uint64_t key, int remaining, int ply)
+{
+    if (Aborted(worker) || TableProbe(worker, key, remaining)) {
+        return false;
+    }
+
+    SearchChild* children = worker->children[ply];
+    int* order = worker->order[ply];
+    int clearing;
+    int count = Expand(worker, board, children, order, &clearing);
+    if (clearing >= 0) {
+        worker->path[ply] = children[clearing].move;
+        worker->shared->pathLength[worker->rootIndex] = ply + 1;
+        return true;
+    }
+
+    if (remaining > 1) {
+        for (int i = 0; i < count; i++) {
+            const SearchChild* child = &children[order[i]];
+            worker->path[ply] = child->move;
+            if (Search(worker, &child->board, child->key, remaining - 1, ply + 1)) {
+                return true;
+            }
+        }
+        // An abandoned search proves nothing
+        if (Aborted(worker)) {
+            return false;
+        }
+    }
+
+    TableStore(worker, key, remaining);
+    return false;
+}
+
+static void* SearchThread(void* arg)
+{
+    SearchWorker* worker = (SearchWorker*)arg;
+    SearchShared* shared = worker->shared;
+
+    for (;;) {
+        int index = atomic_fetch_add_explicit(&shared->nextRoot, 1, memory_order_relaxed);
+        if (index >= shared->rootCount ||
+            index > atomic_load_explicit(&shared->bestRoot, memory_order_relaxed)) {
+            break;
+        }
+
+        const SearchChild* root = &shared->roots[index];
+        worker->rootIndex = index;
+        worker->path[0] = root->move;
+        if (!Search(worker, &root->board, root->key, shared->bound - 1, 1)) {
+            continue;
+        }
+
+        memcpy(shared->paths[index], worker->path, sizeof(worker->path));
+        int best = atomic_load_explicit(&shared->bestRoot, memory_order_relaxed);
+        while (index < best &&
+               !atomic_compare_exchange_weak_explicit(&shared->bestRoot, &best, index,
+                                                      memory_order_acq_rel, memory_order_relaxed)) {
+        }
+    }
+    return NULL;
+}
+
+bool PuzzleSolver_Init(PuzzleSolver* solver, int tableBits, int threads)
+{
+    if (tableBits < 10) {
+        tableBits = 10;
+    }
+    solver->tableMask = (1ull << tableBits) - 1;
+    solver->table = calloc((size_t)solver->tableMask + 1, sizeof(PuzzleTableEntry));
+    solver->threads = threads < 1 ? 1 : threads > PUZZLE_MAX_THREADS ? PUZZLE_MAX_THREADS : threads;
+    return solver->table != NULL;
+}
+
+void PuzzleSolver_Free(PuzzleSolver* solver)
+{
+    free(solver->table);
+    solver->table = NULL;
+}
+
+bool PuzzleSolver_Solve(PuzzleSolver* solver, const GameBoard* board, int maxMoves,
+                        PuzzleSolution* solution)
+{
+    memset(solution, 0, sizeof(*solution));
+    if (maxMoves > PUZZLE_MAX_MOVES) {
+        maxMoves = PUZZLE_MAX_MOVES;
+    }
+    double start = NowSeconds();
+
+    int blocks = CountBlocks(board, BoardMode_Of(board));
+    if (blocks <= 0 || maxMoves < 1) {
+        solution->solved = blocks == 0;
+        return solution->solved;
+    }
+
+    // Entries from another board's search are still true, but only waste slots
+    memset(solver->table, 0, ((size_t)solver->tableMask + 1) * sizeof(PuzzleTableEntry));
+
+    SearchWorker* workers = malloc((size_t)solver->threads * sizeof(SearchWorker));
+    SearchShared* shared = malloc(sizeof(SearchShared));
+    SearchChild* roots = malloc(PUZZLE_MAX_BRANCHING * sizeof(SearchChild));
+    int* rootOrder = malloc(PUZZLE_MAX_BRANCHING * sizeof(int));
+    if (!workers || !shared || !roots || !rootOrder) {
+        free(workers);
+        free(shared);
+        free(roots);
+        free(rootOrder);
+        return false;
+    }
+    for (int t = 0; t < solver->threads; t++) {
+        memset(&workers[t], 0, offsetof(SearchWorker, path));
+        workers[t].shared = shared;
+    }
+    shared->solver = solver;
+
+    // The root moves are expanded once; each bound hands them out to the threads
+    int clearing;
+    SearchChild* unordered = workers[0].children[0];
+    int rootCount = Expand(&workers[0], board, unordered, rootOrder, &clearing);
+    if (clearing >= 0) {
+        solution->solved = true;
+        solution->moveCount = 1;
+        solution->moves[0] = unordered[clearing].move;
+    } else {
+        for (int i = 0; i < rootCount; i++) {
+            roots[i] = unordered[rootOrder[i]];
+        }
+    }
+    shared->roots = roots;
+    shared->rootCount = rootCount;
+
+    pthread_t threads[PUZZLE_MAX_THREADS];
+    for (int bound = 2; !solution->solved && bound <= maxMoves && rootCount > 0; bound++) {
+        shared->bound = bound;
+        atomic_init(&shared->nextRoot, 0);
+        atomic_init(&shared->bestRoot, INT_MAX);
+
+        int threadCount = solver->threads < rootCount ? solver->threads : rootCount;
+        for (int t = 1; t < threadCount; t++) {
+            pthread_create(&threads[t], NULL, SearchThread, &workers[t]);
+        }
+        SearchThread(&workers[0]);
+        for (int t = 1; t < threadCount; t++) {
+            pthread_join(threads[t], NULL);
+        }
+
+        int best = atomic_load(&shared->bestRoot);
+        if (best != INT_MAX) {
+            solution->solved = true;
+            solution->moveCount = shared->pathLength[best];
+            memcpy(solution->moves, shared->paths[best], sizeof(solution->moves));
+        }
+    }
+
+    for (int t = 0; t < solver->threads; t++) {
+        solution->nodes += workers[t].nodes;
+        solution->tableProbes += workers[t].probes;
+        solution->tableHits += workers[t].hits;
+    }
+    solution->seconds = NowSeconds() - start;
+
+    free(workers);
+    free(shared);
+    free(roots);
+    free(rootOrder);
+    return solution->solved;
+}
+
+// Height of the stack in each column
+static void ColumnHeights(const GameBoard* board, const BoardMode* mode, int* heights)
+{
+    for (int x = 0; x < mode->width; x++) {
+        int y = 0;
+        while (y < mode->height && BLOCK_TYPE(board->grid[y * mode->width + x]) == BLOCK_EMPTY) {
+            y++;
+        }
+        heights[x] = mode->height - y;
+    }
+}
+
+// Put three blocks of one color on top of the stack, in a column or across
+// three columns of equal height; they must form the board's only match
+static bool PlaceMatch(GameBoard* board, const BoardMode* mode, Rng* rng, uint16_t* placed)
+{
+    int heights[BOARD_MAX_WIDTH];
+    ColumnHeights(board, mode, heights);
+    const int width = mode->width;
+    BlockType type = (BlockType)(1 << Rng_Range(rng, mode->colorCount));
+
+    int x = (int)Rng_Range(rng, (uint32_t)width);
+    bool horizontal = Rng_Range(rng, 2) == 0 && x + 2 < width &&
+                      heights[x] == heights[x + 1] && heights[x] == heights[x + 2] &&
+                      heights[x] < mode->height;
+    if (horizontal) {
+        int y = mode->height - 1 - heights[x];
+        for (int i = 0; i < 3; i++) {
+            placed[i] = (uint16_t)(y * width + x + i);
+        }
+    } else {
+        if (heights[x] + 3 > mode->height) {
+            return false;
+        }
+        int y = mode->height - 1 - heights[x];
+        for (int i = 0; i < 3; i++) {
+            placed[i] = (uint16_t)((y - i) * width + x);
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        board->grid[placed[i]] = MAKE_BLOCK(type, STATE_NORMAL);
+    }
+
+    GameBoard check = *board;
+    MatchList matches;
+    return mode->detectMatches(&check, &matches) == 3;
+}
+
+// Break the placed match with one swap that leaves the board settled and
+// without matches, so swapping back is exactly the move that clears it
+static bool BreakMatch(GameBoard* board, const BoardMode* mode, Rng* rng, const uint16_t* placed)
+{
+    const int width = mode->width;
+    GameBoard candidates[6];
+    int count = 0;
+
+    for (int i = 0; i < 3; i++) {
+        for (int side = 0; side < 2; side++) {
+            int x = placed[i] % width - side;
+            int y = placed[i] / width;
+            if (x < 0 || x + 1 >= width) {
+                continue;
+            }
+            GameBoard trial = *board;
+            if (BLOCK_TYPE(trial.grid[y * width + x]) == BLOCK_TYPE(trial.grid[y * width + x + 1]) ||
+                !SwapBlocks(&trial, x, y)) {
+                continue;
+            }
+
+            GameBoard check = trial;
+            GravityAnimation anim;
+            MatchList matches;
+            if (mode->applyGravity(&check, &anim) || mode->detectMatches(&check, &matches) > 0) {
+                continue;
+            }
+            candidates[count++] = trial;
+        }
+    }
+
+    if (count == 0) {
+        return false;
+    }
+    *board = candidates[Rng_Range(rng, (uint32_t)count)];
+    return true;
+}
+
+void Puzzle_Generate(GameBoard* board, BoardModeId mode, int moves, uint64_t seed)
+{
+    GameBoard_InitMode(board, mode);
+    const BoardMode* boardMode = BoardMode_Of(board);
+    Rng rng;
+    Rng_Seed(&rng, seed, RNG_STREAM_PUZZLE);
+
+    for (int m = 0; m < moves; m++) {
+        for (int attempt = 0; attempt < GENERATE_ATTEMPTS; attempt++) {
+            GameBoard trial = *board;
+            uint16_t placed[3];
+            if (PlaceMatch(&trial, boardMode, &rng, placed) &&
+                BreakMatch(&trial, boardMode, &rng, placed)) {
+                *board = trial;
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,826 @@
+#define _POSIX_C_SOURCE 200809L
+#include "replay_archive.h"
+#include "board_codec.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char FILE_MAGIC[8] = { 'P', 'A', 'R', 'E', 'P', 'L', 'A', 'Y' };
+static const uint32_t FILE_VERSION = 2;
+static const int FILE_MATCH_COUNT_OFFSET = 12;   // u32 in the file header
+static const uint32_t BLOCK_MAGIC = 0x4843544Du;   // "MTCH"
+
+// Upper bound on one player's encoded keyframe state
+#define STATE_MAX_SIZE 2048
+
+// Block header field offsets
+enum {
+    BLOCK_MAGIC_OFFSET       = 0,
+    BLOCK_SIZE_OFFSET        = 4,
+    BLOCK_MATCH_ID_OFFSET    = 8,
+    BLOCK_INTERVAL_OFFSET    = 12,
+    BLOCK_SEED_OFFSET        = 16,
+    BLOCK_TICKS_OFFSET       = 24,
+    BLOCK_KEYFRAMES_OFFSET   = 28,
+    BLOCK_SCORES_OFFSET      = 32,
+    BLOCK_INPUTS_AT          = 40,
+    BLOCK_CHECKSUMS_AT       = 44,
+    BLOCK_FINAL_BOARDS_AT    = 48,
+    BLOCK_KEYFRAME_DATA_AT   = 52
+};
+
+// Little-endian helpers
+static void WriteU32(uint8_t* out, uint32_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t ReadU32(const uint8_t* in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static void WriteU64(uint8_t* out, uint64_t value)
+{
+    WriteU32(out, (uint32_t)value);
+    WriteU32(out + 4, (uint32_t)(value >> 32));
+}
+
+static uint64_t ReadU64(const uint8_t* in)
+{
+    return (uint64_t)ReadU32(in) | ((uint64_t)ReadU32(in + 4) << 32);
+}
+
+// Floats are stored as their exact bits so restored timers match bit for bit
+static void WriteF32(uint8_t* out, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    WriteU32(out, bits);
+}
+
+static float ReadF32(const uint8_t* in)
+{
+    uint32_t bits = ReadU32(in);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// --- Simulation state encoding ---
+
+static size_t WriteRowQueue(const RowQueue* queue, uint8_t* out)
+{
+    uint8_t* p = out;
+    unsigned rowTail = atomic_load_explicit(&queue->rowTail, memory_order_acquire);
+    unsigned rowHead = atomic_load_explicit(&queue->rowHead, memory_order_acquire);
+    unsigned garbageTail = atomic_load_explicit(&queue->garbageTail, memory_order_acquire);
+    unsigned garbageHead = atomic_load_explicit(&queue->garbageHead, memory_order_acquire);
+
+    WriteU64(p, queue->rowRng.state);          p += 8;
+    WriteU64(p, queue->garbageRng.state);      p += 8;
+    WriteU64(p, queue->rowsGenerated);         p += 8;
+    WriteU64(p, queue->garbageGenerated);      p += 8;
+    for (int r = 0; r < 2; r++) {
+        for (int x = 0; x < BOARD_WIDTH; x++) {
+            *p++ = BoardCodec_PackCell(queue->above[r][x]);
+        }
+    }
+
+    // Entries already generated but not yet consumed
+    WriteU32(p, rowTail);                      p += 4;
+    WriteU32(p, rowHead);                      p += 4;
+    for (unsigned i = rowTail; i != rowHead; i++) {
+        const QueuedRow* row = &queue->rows[i & (ROW_QUEUE_CAPACITY - 1)];
+        for (int x = 0; x < BOARD_WIDTH; x++) {
+            *p++ = BoardCodec_PackCell(row->cells[x]);
+        }
+    }
+    WriteU32(p, garbageTail);                  p += 4;
+    WriteU32(p, garbageHead);                  p += 4;
+    for (unsigned i = garbageTail; i != garbageHead; i++) {
+        const GarbageTemplate* garbage = &queue->garbage[i & (GARBAGE_QUEUE_CAPACITY - 1)];
+        *p++ = garbage->column;
+        for (int x = 0; x < BOARD_WIDTH; x++) {
+            *p++ = BoardCodec_PackCell(garbage->reveal[x]);
+        }
+    }
+    return (size_t)(p - out);
+}
+
+static size_t ReadRowQueue(RowQueue* queue, const uint8_t* in, const uint8_t* end)
+{
+    const uint8_t* p = in;
+    if (end - p < 32 + 2 * BOARD_WIDTH + 8) {
+        return 0;
+    }
+
+    queue->rowRng.state = ReadU64(p);          p += 8;
+    queue->garbageRng.state = ReadU64(p);      p += 8;
+    queue->rowsGenerated = ReadU64(p);         p += 8;
+    queue->garbageGenerated = ReadU64(p);      p += 8;
+    for (int r = 0; r < 2; r++) {
+        for (int x = 0; x < BOARD_WIDTH; x++) {
+            queue->above[r][x] = BoardCodec_UnpackCell(*p++);
+        }
+    }
+
+    unsigned rowTail = ReadU32(p);             p += 4;
+    unsigned rowHead = ReadU32(p);             p += 4;
+    if (rowHead - rowTail > ROW_QUEUE_CAPACITY ||
+        end - p < (ptrdiff_t)((rowHead - rowTail) * BOARD_WIDTH + 8)) {
+        return 0;
+    }
+    for (unsigned i = rowTail; i != rowHead; i++) {
+        QueuedRow* row = &queue->rows[i & (ROW_QUEUE_CAPACITY - 1)];
+        for (int x = 0; x < BOARD_WIDTH; x++) {
+            row->cells[x] = BoardCodec_UnpackCell(*p++);
+        }
+    }
+
+    unsigned garbageTail = ReadU32(p);         p += 4;
+    unsigned garbageHead = ReadU32(p);         p += 4;
+    if (garbageHead - garbageTail > GARBAGE_QUEUE_CAPACITY ||
+        end - p < (ptrdiff_t)((garbageHead - garbageTail) * (BOARD_WIDTH + 1))) {
+        return 0;
+    }
+    for (unsigned i = garbageTail; i != garbageHead; i++) {
+        GarbageTemplate* garbage = &queue->garbage[i & (GARBAGE_QUEUE_CAPACITY - 1)];
+        garbage->column = *p++;
+        garbage->reserved = 0;
+        for (int x = 0; x < BOARD_WIDTH; x++) {
+            garbage->reveal[x] = BoardCodec_UnpackCell(*p++);
+        }
+    }
+
+    atomic_store_explicit(&queue->rowTail, rowTail, memory_order_relaxed);
+    atomic_store_explicit(&queue->rowHead, rowHead, memory_order_relaxed);
+    atomic_store_explicit(&queue->garbageTail, garbageTail, memory_order_relaxed);
+    atomic_store_explicit(&queue->garbageHead, garbageHead, memory_order_relaxed);
+    return (size_t)(p - in);
+}
+
+static size_t WriteState(const GameState* state, uint8_t* out)
+{
+    uint8_t* p = out;
+
+    p += BoardCodec_WriteKeyframe(&state->board, p);
+
+    // The slab section as sent, plus the colors each slab will reveal
+    p += BoardCodec_WriteSlabs(&state->board, p);
+    for (int s = 0; s < state->board.slabCount; s++) {
+        memcpy(p, state->board.slabs[s].reveal, 3);
+        p += 3;
+    }
+
+    *p++ = state->swapAnim.active;
+    *p++ = (uint8_t)state->swapAnim.x;
+    *p++ = (uint8_t)state->swapAnim.y;
+    WriteF32(p, state->swapAnim.progress);     p += 4;
+    WriteF32(p, state->swapAnim.duration);     p += 4;
+
+    const GravityAnimation* gravity = &state->gravityAnim;
+    *p++ = gravity->active;
+    *p++ = gravity->count;
+    WriteF32(p, gravity->progress);            p += 4;
+    WriteF32(p, gravity->duration);            p += 4;
+    for (int i = 0; i < gravity->count; i++) {
+        *p++ = gravity->blocks[i].x;
+        *p++ = gravity->blocks[i].y;
+        *p++ = gravity->blocks[i].fallDistance;
+    }
+    memcpy(p, gravity->slabFall, state->board.slabCount);
+    p += state->board.slabCount;
+
+    // Pending matches are cleared later from this list
+    const MatchList* matches = &state->matches;
+    *p++ = (uint8_t)matches->runCount;
+    *p++ = (uint8_t)matches->groupCount;
+    *p++ = (uint8_t)matches->matchedCount;
+    for (int i = 0; i < matches->runCount; i++) {
+        const MatchRun* run = &matches->runs[i];
+        *p++ = run->type;
+        *p++ = run->x;
+        *p++ = run->y;
+        *p++ = run->length;
+        *p++ = run->orientation;
+        *p++ = run->group;
+    }
+
+    WriteF32(p, state->clearTimer);            p += 4;
+    *p++ = state->waitingToClear;
+    *p++ = (uint8_t)state->lastMatchCount;
+    *p++ = (uint8_t)state->lastClearCount;
+
+    // Attacks still waiting for the board to settle
+    *p++ = (uint8_t)state->pendingGarbageCount;
+    for (int i = 0; i < state->pendingGarbageCount; i++) {
+        *p++ = state->pendingGarbage[i].width;
+        *p++ = state->pendingGarbage[i].height;
+    }
+
+    *p++ = state->rows != NULL;
+    if (state->rows) {
+        p += WriteRowQueue(state->rows, p);
+    }
+    return (size_t)(p - out);
+}
+
+// Restore into a state whose rows pointer already refers to its own queue
+static size_t ReadState(GameState* state, const uint8_t* in, const uint8_t* end)
+{
+    const uint8_t* p = in;
+
+    size_t used = BoardCodec_ReadKeyframe(&state->board, p, (size_t)(end - p));
+    if (used == 0) {
+        return 0;
+    }
+    p += used;
+
+    used = BoardCodec_ReadSlabs(&state->board, p, (size_t)(end - p));
+    int slabCount = state->board.slabCount;
+    if (used == 0 || end - p < (ptrdiff_t)(used + slabCount * 3 + 21)) {
+        return 0;
+    }
+    p += used;
+    for (int s = 0; s < slabCount; s++) {
+        memcpy(state->board.slabs[s].reveal, p, 3);
+        p += 3;
+    }
+
+    state->swapAnim.active = *p++ != 0;
+    state->swapAnim.x = *p++;
+    state->swapAnim.y = *p++;
+    state->swapAnim.progress = ReadF32(p);     p += 4;
+    state->swapAnim.duration = ReadF32(p);     p += 4;
+
+    GravityAnimation* gravity = &state->gravityAnim;
+    gravity->active = *p++ != 0;
+    gravity->count = *p++;
+    gravity->progress = ReadF32(p);            p += 4;
+    gravity->duration = ReadF32(p);            p += 4;
+    if (gravity->count > MAX_FALLING_BLOCKS || end - p < gravity->count * 3 + slabCount + 3) {
+        return 0;
+    }
+    for (int i = 0; i < gravity->count; i++) {
+        gravity->blocks[i].x = *p++;
+        gravity->blocks[i].y = *p++;
+        gravity->blocks[i].fallDistance = *p++;
+    }
+    memset(gravity->slabFall, 0, sizeof(gravity->slabFall));
+    memcpy(gravity->slabFall, p, (size_t)slabCount);
+    p += slabCount;
+
+    MatchList* matches = &state->matches;
+    matches->runCount = *p++;
+    matches->groupCount = *p++;
+    matches->matchedCount = *p++;
+    if (matches->runCount > MAX_MATCH_RUNS || end - p < matches->runCount * 6 + 9) {
+        return 0;
+    }
+    for (int i = 0; i < matches->runCount; i++) {
+        MatchRun* run = &matches->runs[i];
+        run->type = *p++;
+        run->x = *p++;
+        run->y = *p++;
+        run->length = *p++;
+        run->orientation = *p++;
+        run->group = *p++;
+    }
+
+    state->clearTimer = ReadF32(p);            p += 4;
+    state->waitingToClear = *p++ != 0;
+    state->lastMatchCount = *p++;
+    state->lastClearCount = *p++;
+
+    state->pendingGarbageCount = *p++;
+    if (state->pendingGarbageCount > GAME_PENDING_GARBAGE_MAX ||
+        end - p < state->pendingGarbageCount * 2 + 1) {
+        return 0;
+    }
+    for (int i = 0; i < state->pendingGarbageCount; i++) {
+        state->pendingGarbage[i].width = *p++;
+        state->pendingGarbage[i].height = *p++;
+    }
+
+    bool hasRows = *p++ != 0;
+    if (hasRows != (state->rows != NULL)) {
+        return 0;
+    }
+    if (hasRows) {
+        size_t queueSize = ReadRowQueue(state->rows, p, end);
+        if (queueSize == 0) {
+            return 0;
+        }
+        p += queueSize;
+    }
+    return (size_t)(p - in);
+}
+
+static uint32_t StateChecksum(const GameState* const players[REPLAY_PLAYERS])
+{
+    // FNV-1a over every cell, score and combo, the garbage slab table and
+    // the attacks waiting to drop
+    uint32_t hash = 2166136261u;
+    for (int p = 0; p < REPLAY_PLAYERS; p++) {
+        const GameBoard* board = &players[p]->board;
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            hash = (hash ^ (board->grid[i] & 0xFF)) * 16777619u;
+            hash = (hash ^ (board->grid[i] >> 8)) * 16777619u;
+        }
+        hash = (hash ^ (uint32_t)board->score) * 16777619u;
+        hash = (hash ^ (uint32_t)board->combo) * 16777619u;
+        hash = (hash ^ board->slabCount) * 16777619u;
+        for (int s = 0; s < board->slabCount; s++) {
+            const GarbageSlab* slab = &board->slabs[s];
+            uint32_t packed = (uint32_t)slab->x | ((uint32_t)slab->y << 8) |
+                              ((uint32_t)slab->width << 16) | ((uint32_t)slab->height << 24);
+            uint32_t colors = (uint32_t)slab->state | ((uint32_t)slab->reveal[0] << 8) |
+                              ((uint32_t)slab->reveal[1] << 16) | ((uint32_t)slab->reveal[2] << 24);
+            hash = (hash ^ packed) * 16777619u;
+            hash = (hash ^ colors) * 16777619u;
+        }
+
+        // Queued attacks decide what drops later, so they are state too
+        const GameState* state = players[p];
+        hash = (hash ^ (uint32_t)state->pendingGarbageCount) * 16777619u;
+        for (int i = 0; i < state->pendingGarbageCount; i++) {
+            uint32_t size = (uint32_t)state->pendingGarbage[i].width | ((uint32_t)state->pendingGarbage[i].height << 8);
+            hash = (hash ^ size) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+// --- Playback ---
+
+void ReplaySim_Init(ReplaySim* sim, uint64_t seed)
+{
+    sim->seed = seed;
+    sim->tick = 0;
+    for (int p = 0; p < REPLAY_PLAYERS; p++) {
+        RowQueue_Init(&sim->rows[p], seed);
+        GameState_Init(&sim->players[p], seed, &sim->rows[p]);
+    }
+}
+
+void ReplaySim_Step(ReplaySim* sim, const GameInput inputs[REPLAY_PLAYERS])
+{
+    for (int p = 0; p < REPLAY_PLAYERS; p++) {
+        GameState_Update(&sim->players[p], &inputs[p], GAME_TICK_SECONDS);
+    }
+    sim->tick++;
+}
+
+uint32_t ReplaySim_Checksum(const ReplaySim* sim)
+{
+    const GameState* players[REPLAY_PLAYERS];
+    for (int p = 0; p < REPLAY_PLAYERS; p++) {
+        players[p] = &sim->players[p];
+    }
+    return StateChecksum(players);
+}
+
+static bool LoadKeyframe(ReplaySim* sim, const ReplayView* view, uint32_t index)
+{
+    uint32_t offset = ReadU32(view->keyframeTable + index * 4);
+    if (offset >= view->blockSize) {
+        return false;
+    }
+
+    const uint8_t* p = view->block + offset;
+    const uint8_t* end = view->block + view->blockSize;
+    sim->seed = view->seed;
+    for (int i = 0; i < REPLAY_PLAYERS; i++) {
+        // Seed fields that are not part of the keyframe, then overwrite the rest
+        sim->rows[i].seed = view->seed;
+        sim->rows[i].hasWorker = false;
+        sim->players[i].rows = &sim->rows[i];
+
+        size_t used = ReadState(&sim->players[i], p, end);
+        if (used == 0) {
+            return false;
+        }
+        p += used;
+    }
+    sim->tick = index * view->keyframeInterval;
+    return true;
+}
+
+bool ReplaySim_Seek(ReplaySim* sim, const ReplayView* view, uint32_t tick)
+{
+    if (tick > view->tickCount || view->keyframeCount == 0) {
+        return false;
+    }
+
+    // Stepping forward is cheaper than a keyframe when the target is close
+    bool canStep = sim->seed == view->seed && sim->tick <= tick &&
+                   tick - sim->tick < view->keyframeInterval;
+    if (!canStep) {
+        uint32_t index = tick / view->keyframeInterval;
+        if (index >= view->keyframeCount) {
+            index = view->keyframeCount - 1;
+        }
+        if (!LoadKeyframe(sim, view, index)) {
+            return false;
+        }
+    }
+
+    GameInput inputs[REPLAY_PLAYERS];
+    while (sim->tick < tick) {
+        ReplayView_GetInputs(view, sim->tick, inputs);
+        ReplaySim_Step(sim, inputs);
+    }
+    return true;
+}
+
+// --- Reading ---
+
+// Size of the block whose header this is, or 0 if it is not a whole block:
+// bad magic, or longer than the bytes left (torn by a crash mid-append)
+static uint32_t WholeBlockSize(const uint8_t* header, size_t remaining)
+{
+    uint32_t blockSize = ReadU32(header + BLOCK_SIZE_OFFSET);
+    if (ReadU32(header + BLOCK_MAGIC_OFFSET) != BLOCK_MAGIC ||
+        blockSize < REPLAY_BLOCK_HEADER_SIZE || blockSize > remaining) {
+        return 0;
+    }
+    return blockSize;
+}
+
+bool ReplayArchive_Open(ReplayArchive* archive, const char* path)
+{
+    memset(archive, 0, sizeof(*archive));
+    archive->fd = open(path, O_RDONLY);
+    if (archive->fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(archive->fd, &info) != 0 || (size_t)info.st_size < REPLAY_FILE_HEADER_SIZE) {
+        ReplayArchive_Close(archive);
+        return false;
+    }
+    archive->size = (size_t)info.st_size;
+
+    void* base = mmap(NULL, archive->size, PROT_READ, MAP_SHARED, archive->fd, 0);
+    if (base == MAP_FAILED) {
+        ReplayArchive_Close(archive);
+        return false;
+    }
+    archive->base = base;
+    posix_madvise(base, archive->size, POSIX_MADV_RANDOM);
+
+    if (memcmp(archive->base, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+        ReadU32(archive->base + 8) != FILE_VERSION) {
+        ReplayArchive_Close(archive);
+        return false;
+    }
+    archive->indexedCount = (int)ReadU32(archive->base + FILE_MATCH_COUNT_OFFSET);
+
+    // Walk the block headers; a torn block at the end (crash mid-append) is ignored
+    size_t capacity = 0;
+    size_t offset = REPLAY_FILE_HEADER_SIZE;
+    while (offset + REPLAY_BLOCK_HEADER_SIZE <= archive->size) {
+        uint32_t blockSize = WholeBlockSize(archive->base + offset, archive->size - offset);
+        if (blockSize == 0) {
+            break;
+        }
+
+        if ((size_t)archive->matchCount == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            size_t* grown = realloc(archive->blockOffsets, capacity * sizeof(size_t));
+            if (!grown) {
+                ReplayArchive_Close(archive);
+                return false;
+            }
+            archive->blockOffsets = grown;
+        }
+        archive->blockOffsets[archive->matchCount++] = offset;
+        offset += blockSize;
+    }
+    archive->tailBytes = archive->size - offset;
+    return true;
+}
+
+bool ReplayArchive_IsTruncated(const ReplayArchive* archive)
+{
+    // More readable blocks than counted is fine: a crash between flushing a
+    // block and updating the count leaves a whole archive
+    return archive->tailBytes > 0 || archive->indexedCount > archive->matchCount;
+}
+
+void ReplayArchive_Close(ReplayArchive* archive)
+{
+    if (archive->base) {
+        munmap((void*)archive->base, archive->size);
+    }
+    if (archive->fd >= 0) {
+        close(archive->fd);
+    }
+    free(archive->blockOffsets);
+    memset(archive, 0, sizeof(*archive));
+    archive->fd = -1;
+}
+
+int ReplayArchive_Find(const ReplayArchive* archive, uint32_t matchId)
+{
+    for (int i = 0; i < archive->matchCount; i++) {
+        const uint8_t* header = archive->base + archive->blockOffsets[i];
+        if (ReadU32(header + BLOCK_MATCH_ID_OFFSET) == matchId) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool ReplayArchive_GetMatch(const ReplayArchive* archive, int index, ReplayView* view)
+{
+    if (index < 0 || index >= archive->matchCount) {
+        return false;
+    }
+
+    const uint8_t* block = archive->base + archive->blockOffsets[index];
+    size_t blockSize = ReadU32(block + BLOCK_SIZE_OFFSET);
+
+    view->block = block;
+    view->blockSize = blockSize;
+    view->matchId = ReadU32(block + BLOCK_MATCH_ID_OFFSET);
+    view->keyframeInterval = ReadU32(block + BLOCK_INTERVAL_OFFSET);
+    view->seed = ReadU64(block + BLOCK_SEED_OFFSET);
+    view->tickCount = ReadU32(block + BLOCK_TICKS_OFFSET);
+    view->keyframeCount = ReadU32(block + BLOCK_KEYFRAMES_OFFSET);
+    for (int p = 0; p < REPLAY_PLAYERS; p++) {
+        view->finalScores[p] = (int32_t)ReadU32(block + BLOCK_SCORES_OFFSET + p * 4);
+    }
+
+    uint32_t inputsAt = ReadU32(block + BLOCK_INPUTS_AT);
+    uint32_t checksumsAt = ReadU32(block + BLOCK_CHECKSUMS_AT);
+    uint32_t finalBoardsAt = ReadU32(block + BLOCK_FINAL_BOARDS_AT);
+    uint32_t keyframesAt = ReadU32(block + BLOCK_KEYFRAME_DATA_AT);
+
+    // Every section must lie inside the block, in order
+    uint64_t tableEnd = REPLAY_BLOCK_HEADER_SIZE + (uint64_t)view->keyframeCount * 4;
+    uint64_t inputsEnd = inputsAt + (uint64_t)view->tickCount * REPLAY_PLAYERS * REPLAY_INPUT_SIZE;
+    uint64_t checksumsEnd = checksumsAt + (uint64_t)view->tickCount * 4;
+    uint64_t finalBoardsEnd = finalBoardsAt + (uint64_t)REPLAY_PLAYERS * BOARD_KEYFRAME_SIZE;
+    if (view->keyframeInterval == 0 || view->keyframeCount == 0 ||
+        inputsAt < tableEnd || checksumsAt < inputsEnd || finalBoardsAt < checksumsEnd ||
+        keyframesAt < finalBoardsEnd || keyframesAt > blockSize) {
+        return false;
+    }
+
+    view->keyframeTable = block + REPLAY_BLOCK_HEADER_SIZE;
+    view->inputs = block + inputsAt;
+    view->checksums = block + checksumsAt;
+    view->finalBoards = block + finalBoardsAt;
+    return true;
+}
+
+void ReplayView_GetInputs(const ReplayView* view, uint32_t tick, GameInput inputs[REPLAY_PLAYERS])
+{
+    const uint8_t* p = view->inputs + (size_t)tick * REPLAY_PLAYERS * REPLAY_INPUT_SIZE;
+    for (int i = 0; i < REPLAY_PLAYERS; i++) {
+        inputs[i].x = p[0];
+        inputs[i].y = p[1];
+        inputs[i].flags = p[2];
+        p += REPLAY_INPUT_SIZE;
+    }
+}
+
+uint32_t ReplayView_GetChecksum(const ReplayView* view, uint32_t tick)
+{
+    return ReadU32(view->checksums + (size_t)tick * 4);
+}
+
+// --- Writing ---
+
+// Make room for at least `needed` bytes in a growable buffer
+static bool Reserve(uint8_t** buffer, size_t* capacity, size_t needed)
+{
+    if (needed <= *capacity) {
+        return true;
+    }
+    size_t grown = *capacity ? *capacity : 4096;
+    while (grown < needed) {
+        grown *= 2;
+    }
+    uint8_t* memory = realloc(*buffer, grown);
+    if (!memory) {
+        return false;
+    }
+    *buffer = memory;
+    *capacity = grown;
+    return true;
+}
+
+static bool AddKeyframe(ReplayWriter* writer, const GameState* const players[REPLAY_PLAYERS])
+{
+    if (writer->keyframeCount == writer->keyframeOffsetsCapacity) {
+        uint32_t capacity = writer->keyframeOffsetsCapacity ? writer->keyframeOffsetsCapacity * 2 : 64;
+        uint32_t* offsets = realloc(writer->keyframeOffsets, capacity * sizeof(uint32_t));
+        if (!offsets) {
+            return false;
+        }
+        writer->keyframeOffsets = offsets;
+        writer->keyframeOffsetsCapacity = capacity;
+    }
+    if (!Reserve(&writer->keyframes, &writer->keyframesCapacity,
+                 writer->keyframesSize + REPLAY_PLAYERS * STATE_MAX_SIZE)) {
+        return false;
+    }
+
+    writer->keyframeOffsets[writer->keyframeCount++] = (uint32_t)writer->keyframesSize;
+    for (int p = 0; p < REPLAY_PLAYERS; p++) {
+        writer->keyframesSize += WriteState(players[p], writer->keyframes + writer->keyframesSize);
+    }
+    return true;
+}
+
+// Rewrite the match count in the file header
+static bool WriteMatchCount(ReplayWriter* writer)
+{
+    uint8_t count[4];
+    WriteU32(count, writer->matchesWritten);
+    return fseek(writer->file, FILE_MATCH_COUNT_OFFSET, SEEK_SET) == 0 &&
+           fwrite(count, sizeof(count), 1, writer->file) == 1 &&
+           fflush(writer->file) == 0;
+}
+
+bool ReplayWriter_Open(ReplayWriter* writer, const char* path)
+{
+    memset(writer, 0, sizeof(*writer));
+    // Not append mode: the match count in the header is rewritten in place
+    writer->file = fopen(path, "r+b");
+    if (!writer->file) {
+        writer->file = fopen(path, "w+b");
+    }
+    if (!writer->file) {
+        return false;
+    }
+
+    fseek(writer->file, 0, SEEK_END);
+    long size = ftell(writer->file);
+    uint8_t header[REPLAY_FILE_HEADER_SIZE] = { 0 };
+    if (size == 0) {
+        memcpy(header, FILE_MAGIC, sizeof(FILE_MAGIC));
+        WriteU32(header + 8, FILE_VERSION);
+        if (fwrite(header, sizeof(header), 1, writer->file) != 1) {
+            ReplayWriter_Close(writer);
+            return false;
+        }
+        return true;
+    }
+
+    fseek(writer->file, 0, SEEK_SET);
+    if (size < REPLAY_FILE_HEADER_SIZE || fread(header, sizeof(header), 1, writer->file) != 1 ||
+        memcmp(header, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || ReadU32(header + 8) != FILE_VERSION) {
+        ReplayWriter_Close(writer);
+        return false;
+    }
+
+    // Find the end of the last whole block. A torn block after it (a crash
+    // mid-append) is cut off: readers stop at it, so anything appended
+    // behind it could never be read back
+    size_t end = REPLAY_FILE_HEADER_SIZE;
+    uint8_t blockHeader[REPLAY_BLOCK_HEADER_SIZE];
+    while (end + REPLAY_BLOCK_HEADER_SIZE <= (size_t)size &&
+           fseek(writer->file, (long)end, SEEK_SET) == 0 &&
+           fread(blockHeader, sizeof(blockHeader), 1, writer->file) == 1) {
+        uint32_t blockSize = WholeBlockSize(blockHeader, (size_t)size - end);
+        if (blockSize == 0) {
+            break;
+        }
+        end += blockSize;
+        writer->matchesWritten++;
+    }
+    if (end < (size_t)size && ftruncate(fileno(writer->file), (off_t)end) != 0) {
+        ReplayWriter_Close(writer);
+        return false;
+    }
+    if (!WriteMatchCount(writer)) {
+        ReplayWriter_Close(writer);
+        return false;
+    }
+    return true;
+}
+
+void ReplayWriter_Close(ReplayWriter* writer)
+{
+    if (writer->file) {
+        fclose(writer->file);
+    }
+    free(writer->inputs);
+    free(writer->checksums);
+    free(writer->keyframes);
+    free(writer->keyframeOffsets);
+    memset(writer, 0, sizeof(*writer));
+}
+
+void ReplayWriter_BeginMatch(ReplayWriter* writer, uint32_t matchId, uint64_t seed,
+                             uint32_t keyframeInterval, const GameState* const players[REPLAY_PLAYERS])
+{
+    writer->matchId = matchId;
+    writer->seed = seed;
+    writer->keyframeInterval = keyframeInterval ? keyframeInterval : REPLAY_KEYFRAME_INTERVAL;
+    writer->tickCount = 0;
+    writer->keyframesSize = 0;
+    writer->keyframeCount = 0;
+    writer->inMatch = AddKeyframe(writer, players);
+}
+
+bool ReplayWriter_AddTick(ReplayWriter* writer, const GameInput inputs[REPLAY_PLAYERS],
+                          const GameState* const players[REPLAY_PLAYERS])
+{
+    if (!writer->inMatch) {
+        return false;
+    }
+
+    size_t tick = writer->tickCount;
+    if (!Reserve(&writer->inputs, &writer->inputsCapacity,
+                 (tick + 1) * REPLAY_PLAYERS * REPLAY_INPUT_SIZE) ||
+        !Reserve(&writer->checksums, &writer->checksumsCapacity, (tick + 1) * 4)) {
+        writer->inMatch = false;
+        return false;
+    }
+
+    uint8_t* p = writer->inputs + tick * REPLAY_PLAYERS * REPLAY_INPUT_SIZE;
+    for (int i = 0; i < REPLAY_PLAYERS; i++) {
+        *p++ = inputs[i].x;
+        *p++ = inputs[i].y;
+        *p++ = inputs[i].flags;
+    }
+    WriteU32(writer->checksums + tick * 4, StateChecksum(players));
+    writer->tickCount++;
+
+    if (writer->tickCount % writer->keyframeInterval == 0 && !AddKeyframe(writer, players)) {
+        writer->inMatch = false;
+        return false;
+    }
+    return true;
+}
+
+bool ReplayWriter_EndMatch(ReplayWriter* writer, const GameState* const players[REPLAY_PLAYERS])
+{
+    if (!writer->inMatch) {
+        return false;
+    }
+    writer->inMatch = false;
+
+    size_t inputsSize = (size_t)writer->tickCount * REPLAY_PLAYERS * REPLAY_INPUT_SIZE;
+    uint32_t inputsAt = REPLAY_BLOCK_HEADER_SIZE + writer->keyframeCount * 4;
+    uint32_t checksumsAt = inputsAt + (uint32_t)inputsSize;
+    uint32_t finalBoardsAt = checksumsAt + writer->tickCount * 4;
+    uint32_t keyframesAt = finalBoardsAt + REPLAY_PLAYERS * BOARD_KEYFRAME_SIZE;
+    uint32_t blockSize = keyframesAt + (uint32_t)writer->keyframesSize;
+
+    uint8_t header[REPLAY_BLOCK_HEADER_SIZE] = { 0 };
+    WriteU32(header + BLOCK_MAGIC_OFFSET, BLOCK_MAGIC);
+    WriteU32(header + BLOCK_SIZE_OFFSET, blockSize);
+    WriteU32(header + BLOCK_MATCH_ID_OFFSET, writer->matchId);
+    WriteU32(header + BLOCK_INTERVAL_OFFSET, writer->keyframeInterval);
+    WriteU64(header + BLOCK_SEED_OFFSET, writer->seed);
+    WriteU32(header + BLOCK_TICKS_OFFSET, writer->tickCount);
+    WriteU32(header + BLOCK_KEYFRAMES_OFFSET, writer->keyframeCount);
+    for (int p = 0; p < REPLAY_PLAYERS; p++) {
+        WriteU32(header + BLOCK_SCORES_OFFSET + p * 4, (uint32_t)players[p]->board.score);
+    }
+    WriteU32(header + BLOCK_INPUTS_AT, inputsAt);
+    WriteU32(header + BLOCK_CHECKSUMS_AT, checksumsAt);
+    WriteU32(header + BLOCK_FINAL_BOARDS_AT, finalBoardsAt);
+    WriteU32(header + BLOCK_KEYFRAME_DATA_AT, keyframesAt);
+
+    // Keyframe offsets become relative to the block
+    for (uint32_t k = 0; k < writer->keyframeCount; k++) {
+        uint8_t entry[4];
+        WriteU32(entry, keyframesAt + writer->keyframeOffsets[k]);
+        memcpy(&writer->keyframeOffsets[k], entry, 4);
+    }
+
+    uint8_t finalBoards[REPLAY_PLAYERS * BOARD_KEYFRAME_SIZE];
+    for (int p = 0; p < REPLAY_PLAYERS; p++) {
+        BoardCodec_WriteKeyframe(&players[p]->board, finalBoards + p * BOARD_KEYFRAME_SIZE);
+    }
+
+    bool ok = fseek(writer->file, 0, SEEK_END) == 0 &&
+              fwrite(header, sizeof(header), 1, writer->file) == 1 &&
+              fwrite(writer->keyframeOffsets, 4, writer->keyframeCount, writer->file) == writer->keyframeCount &&
+              fwrite(writer->inputs, 1, inputsSize, writer->file) == inputsSize &&
+              fwrite(writer->checksums, 4, writer->tickCount, writer->file) == writer->tickCount &&
+              fwrite(finalBoards, sizeof(finalBoards), 1, writer->file) == 1 &&
+              fwrite(writer->keyframes, 1, writer->keyframesSize, writer->file) == writer->keyframesSize;
+    if (!ok || fflush(writer->file) != 0) {
+        return false;
+    }
+
+    // Count the block only once it is on disk, so a crash mid-append leaves
+    // a torn tail and the previous count
+    writer->matchesWritten++;
+    return WriteMatchCount(writer);
+}
@@ -0,0 +1,197 @@
+#define _POSIX_C_SOURCE 200809L
+#include "row_queue.h"
+#include "board_mode.h"
+#include <string.h>
+#include <time.h>
+
+// How long the worker sleeps once both rings are full
+static const long WORKER_IDLE_NS = 2 * 1000 * 1000;
+
+// Colors in generation order; a mode uses the first colorCount
+static const BlockType ROW_COLORS[BLOCK_MAX_TYPE_COUNT] = {
+    BLOCK_RED,
+    BLOCK_BLUE,
+    BLOCK_GREEN,
+    BLOCK_YELLOW,
+    BLOCK_PURPLE,
+    BLOCK_CYAN
+};
+
+// Pick a color for cell x of a new row that matches neither the two cells
+// to its left nor the two cells above it. At most two colors are excluded,
+// so stepping to the next color always terminates without re-rolling.
+static BlockType PickRowColor(Rng* rng, int colorCount, const uint16_t* row, int x,
+                              const uint16_t above[2][BOARD_MAX_WIDTH])
+{
+    int index = (int)Rng_Range(rng, (uint32_t)colorCount);
+
+    BlockType left = (x >= 2 && BLOCK_TYPE(row[x - 1]) == BLOCK_TYPE(row[x - 2]))
+        ? BLOCK_TYPE(row[x - 1]) : BLOCK_EMPTY;
+    BlockType up = (BLOCK_TYPE(above[0][x]) == BLOCK_TYPE(above[1][x]))
+        ? BLOCK_TYPE(above[1][x]) : BLOCK_EMPTY;
+
+    while (ROW_COLORS[index] == left || ROW_COLORS[index] == up) {
+        index = (index + 1) % colorCount;
+    }
+    return ROW_COLORS[index];
+}
+
+static void GenerateRow(RowQueue* queue, QueuedRow* out)
+{
+    for (int x = 0; x < queue->width; x++) {
+        BlockType type = PickRowColor(&queue->rowRng, queue->colorCount, out->cells, x, queue->above);
+        out->cells[x] = MAKE_BLOCK(type, STATE_NORMAL);
+    }
+
+    // The new row sits below the previous ones once it rises in
+    memcpy(queue->above[0], queue->above[1], sizeof(queue->above[0]));
+    memcpy(queue->above[1], out->cells, sizeof(queue->above[1]));
+    queue->rowsGenerated++;
+}
+
+static void GenerateGarbage(RowQueue* queue, GarbageTemplate* out)
+{
+    static const uint16_t noneAbove[2][BOARD_MAX_WIDTH];
+
+    out->column = (uint8_t)Rng_Range(&queue->garbageRng, queue->width);
+    out->reserved = 0;
+    for (int x = 0; x < queue->width; x++) {
+        BlockType type = PickRowColor(&queue->garbageRng, queue->colorCount, out->reveal, x, noneAbove);
+        out->reveal[x] = MAKE_BLOCK(type, STATE_NORMAL);
+    }
+    queue->garbageGenerated++;
+}
+
+void RowQueue_Init(RowQueue* queue, uint64_t seed)
+{
+    RowQueue_InitMode(queue, seed, BOARD_MODE_CLASSIC);
+}
+
+void RowQueue_InitMode(RowQueue* queue, uint64_t seed, BoardModeId mode)
+{
+    const BoardMode* boardMode = BoardMode_Get(mode);
+    queue->seed = seed;
+    queue->width = boardMode->width;
+    queue->colorCount = boardMode->colorCount;
+    Rng_Seed(&queue->rowRng, seed, RNG_STREAM_ROWS);
+    Rng_Seed(&queue->garbageRng, seed, RNG_STREAM_GARBAGE);
+    queue->rowsGenerated = 0;
+    queue->garbageGenerated = 0;
+    memset(queue->above, 0, sizeof(queue->above));
+
+    atomic_init(&queue->rowHead, 0);
+    atomic_init(&queue->rowTail, 0);
+    atomic_init(&queue->garbageHead, 0);
+    atomic_init(&queue->garbageTail, 0);
+    atomic_init(&queue->workerRunning, false);
+    queue->hasWorker = false;
+
+    RowQueue_Refill(queue);
+}
+
+void RowQueue_Refill(RowQueue* queue)
+{
+    unsigned head = atomic_load_explicit(&queue->rowHead, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&queue->rowTail, memory_order_acquire);
+    while (head - tail < ROW_QUEUE_CAPACITY) {
+        GenerateRow(queue, &queue->rows[head & (ROW_QUEUE_CAPACITY - 1)]);
+        head++;
+        atomic_store_explicit(&queue->rowHead, head, memory_order_release);
+    }
+
+    head = atomic_load_explicit(&queue->garbageHead, memory_order_relaxed);
+    tail = atomic_load_explicit(&queue->garbageTail, memory_order_acquire);
+    while (head - tail < GARBAGE_QUEUE_CAPACITY) {
+        GenerateGarbage(queue, &queue->garbage[head & (GARBAGE_QUEUE_CAPACITY - 1)]);
+        head++;
+        atomic_store_explicit(&queue->garbageHead, head, memory_order_release);
+    }
+}
+
+static void* RowQueue_WorkerMain(void* arg)
+{
+    RowQueue* queue = (RowQueue*)arg;
+    struct timespec idle = { 0, WORKER_IDLE_NS };
+
+    while (atomic_load_explicit(&queue->workerRunning, memory_order_acquire)) {
+        RowQueue_Refill(queue);
+        nanosleep(&idle, NULL);
+    }
+    return NULL;
+}
+
+bool RowQueue_StartWorker(RowQueue* queue)
+{
+    if (queue->hasWorker) {
+        return true;
+    }
+
+    atomic_store(&queue->workerRunning, true);
+    if (pthread_create(&queue->worker, NULL, RowQueue_WorkerMain, queue) != 0) {
+        atomic_store(&queue->workerRunning, false);
+        return false;
+    }
+    queue->hasWorker = true;
+    return true;
+}
+
+void RowQueue_StopWorker(RowQueue* queue)
+{
+    if (!queue->hasWorker) {
+        return;
+    }
+
+    atomic_store(&queue->workerRunning, false);
+    pthread_join(queue->worker, NULL);
+    queue->hasWorker = false;
+}
+
+const QueuedRow* RowQueue_PeekRow(RowQueue* queue)
+{
+    unsigned tail = atomic_load_explicit(&queue->rowTail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&queue->rowHead, memory_order_acquire);
+
+    if (head == tail) {
+        if (queue->hasWorker) {
+            return NULL;
+        }
+        RowQueue_Refill(queue);
+    }
+    return &queue->rows[tail & (ROW_QUEUE_CAPACITY - 1)];
+}
+
+const GarbageTemplate* RowQueue_PeekGarbage(RowQueue* queue)
+{
+    unsigned tail = atomic_load_explicit(&queue->garbageTail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&queue->garbageHead, memory_order_acquire);
+
+    if (head == tail) {
+        if (queue->hasWorker) {
+            return NULL;
+        }
+        RowQueue_Refill(queue);
+    }
+    return &queue->garbage[tail & (GARBAGE_QUEUE_CAPACITY - 1)];
+}
+
+unsigned RowQueue_RowsConsumed(RowQueue* queue)
+{
+    return atomic_load_explicit(&queue->rowTail, memory_order_relaxed);
+}
+
+unsigned RowQueue_GarbageConsumed(RowQueue* queue)
+{
+    return atomic_load_explicit(&queue->garbageTail, memory_order_relaxed);
+}
+
+void RowQueue_Skip(RowQueue* queue, unsigned rows, unsigned garbage)
+{
+    for (unsigned i = 0; i < rows; i++) {
+        RowQueue_PeekRow(queue);
+        RowQueue_PopRow(queue);
+    }
+    for (unsigned i = 0; i < garbage; i++) {
+        RowQueue_PeekGarbage(queue);
+        RowQueue_PopGarbage(queue);
+    }
+}
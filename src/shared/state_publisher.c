@@ -0,0 +1,137 @@
+#define _POSIX_C_SOURCE 200809L
+#include "state_publisher.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool StatePublisher_Open(StatePublisher* publisher, const char* name, const char* source)
+{
+    memset(publisher, 0, sizeof(*publisher));
+    snprintf(publisher->name, sizeof(publisher->name), "%s", name);
+
+    // A stale segment from a crashed run may have another layout
+    shm_unlink(publisher->name);
+    int fd = shm_open(publisher->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, sizeof(StateSegment)) != 0) {
+        close(fd);
+        shm_unlink(publisher->name);
+        return false;
+    }
+    void* base = mmap(NULL, sizeof(StateSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(publisher->name);
+        return false;
+    }
+
+    // ftruncate zeroed the slots, so every sequence starts at 0 (unpublished)
+    StateSegment* segment = base;
+    segment->version = STATE_SHM_VERSION;
+    segment->slotSize = sizeof(StateSlot);
+    segment->slotCount = STATE_SHM_SLOTS;
+    segment->writerPid = (int32_t)getpid();
+    snprintf(segment->source, sizeof(segment->source), "%s", source);
+    atomic_thread_fence(memory_order_release);
+    segment->magic = STATE_SHM_MAGIC;
+
+    publisher->segment = segment;
+    return true;
+}
+
+void StatePublisher_Close(StatePublisher* publisher)
+{
+    if (publisher->segment) {
+        munmap(publisher->segment, sizeof(StateSegment));
+        shm_unlink(publisher->name);
+    }
+    memset(publisher, 0, sizeof(*publisher));
+}
+
+bool StateReader_Open(StateReader* reader, const char* name)
+{
+    memset(reader, 0, sizeof(*reader));
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size != sizeof(StateSegment)) {
+        close(fd);
+        return false;
+    }
+    void* base = mmap(NULL, sizeof(StateSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+
+    const StateSegment* segment = base;
+    if (segment->magic != STATE_SHM_MAGIC || segment->version != STATE_SHM_VERSION ||
+        segment->slotSize != sizeof(StateSlot) || segment->slotCount != STATE_SHM_SLOTS) {
+        munmap(base, sizeof(StateSegment));
+        return false;
+    }
+    reader->segment = segment;
+    reader->size = sizeof(StateSegment);
+    return true;
+}
+
+void StateReader_Close(StateReader* reader)
+{
+    if (reader->segment) {
+        munmap((void*)reader->segment, reader->size);
+    }
+    memset(reader, 0, sizeof(*reader));
+}
+
+// Whether the process that created the segment still exists (EPERM means
+// it does, under another user)
+static bool WriterAlive(const StateSegment* segment)
+{
+    return kill((pid_t)segment->writerPid, 0) == 0 || errno == EPERM;
+}
+
+StateReadResult StateReader_Read(const StateReader* reader, int slot, StateSlot* out)
+{
+    if (slot < 0 || slot >= STATE_SHM_SLOTS) {
+        return STATE_READ_EMPTY;
+    }
+    // The mapping is read-only; the atomic loads never write through it
+    StateSlot* source = (StateSlot*)&reader->segment->slots[slot];
+    for (int spins = 0;; spins++) {
+        if (spins >= STATE_READ_MAX_SPINS ||
+            (spins > 0 && spins % STATE_READ_PID_CHECK == 0 && !WriterAlive(reader->segment))) {
+            return STATE_READ_TORN;
+        }
+        uint32_t before = atomic_load_explicit(&source->sequence, memory_order_acquire);
+        if (before == 0) {
+            return STATE_READ_EMPTY;
+        }
+        if (before & 1) {
+            sched_yield();
+            continue;
+        }
+
+        out->matchId = source->matchId;
+        out->tick = source->tick;
+        out->player = source->player;
+        memcpy(&out->state, &source->state, sizeof(GameState));
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&source->sequence, memory_order_relaxed) == before) {
+            atomic_store_explicit(&out->sequence, before, memory_order_relaxed);
+            // The writer's pointers mean nothing in this process
+            out->state.mode = BoardMode_Of(&out->state.board);
+            out->state.rows = NULL;
+            return STATE_READ_OK;
+        }
+    }
+}
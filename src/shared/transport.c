@@ -0,0 +1,504 @@
+#define _POSIX_C_SOURCE 200809L
+#include "transport.h"
+#include "logger.h"
+#include "metrics.h"
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Header flags
+#define TRANSPORT_MAGIC     0x50    // 'P'
+#define HEADER_ACK_VALID    0x01    // Ack fields refer to packets we sent
+
+// Chunk types inside a datagram
+enum {
+    CHUNK_RELIABLE   = 1,   // sequence (2), fragment index (1), count (1), length (2), data
+    CHUNK_UNRELIABLE = 2    // channel (1), stamp (2), length (2), data
+};
+#define RELIABLE_CHUNK_HEADER   7
+#define UNRELIABLE_CHUNK_HEADER 6
+
+// Resend timeout bounds and the value used before any RTT sample (seconds)
+static const double MIN_RESEND_TIMEOUT = 0.02;
+static const double MAX_RESEND_TIMEOUT = 1.0;
+static const double INITIAL_RESEND_TIMEOUT = 0.2;
+
+// Little-endian helpers
+static void WriteU16(uint8_t* out, uint16_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t ReadU16(const uint8_t* in)
+{
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static void WriteU32(uint8_t* out, uint32_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t ReadU32(const uint8_t* in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// True if sequence a is newer than b, allowing for wrap-around
+static bool SequenceGreater(uint16_t a, uint16_t b)
+{
+    return (a > b && a - b <= 32768) || (a < b && b - a > 32768);
+}
+
+bool Transport_Init(Transport* transport, TransportSendFn send, void* sendContext,
+                    TransportMessageFn deliver, void* deliverContext)
+{
+    memset(transport, 0, sizeof(*transport));
+    // Both windows and the reassembly buffer share one allocation
+    TransportSlot* slots = calloc(1, 2 * TRANSPORT_WINDOW * sizeof(TransportSlot) + TRANSPORT_MAX_MESSAGE);
+    if (!slots) {
+        return false;
+    }
+    transport->sendSlots = slots;
+    transport->receiveSlots = slots + TRANSPORT_WINDOW;
+    transport->reassembly = (uint8_t*)(slots + 2 * TRANSPORT_WINDOW);
+    transport->send = send;
+    transport->sendContext = sendContext;
+    transport->deliver = deliver;
+    transport->deliverContext = deliverContext;
+    return true;
+}
+
+void Transport_Destroy(Transport* transport)
+{
+    free(transport->sendSlots);
+    transport->sendSlots = NULL;
+    transport->receiveSlots = NULL;
+    transport->reassembly = NULL;
+}
+
+int Transport_ReliableCapacity(const Transport* transport)
+{
+    // Acked fragments of a message the receiver cannot deliver yet still
+    // occupy its window, so the sender keeps one message's worth in reserve
+    return TRANSPORT_WINDOW - TRANSPORT_MAX_FRAGMENTS - (uint16_t)(transport->sendNext - transport->sendOldest);
+}
+
+bool Transport_SendReliable(Transport* transport, const void* data, size_t length)
+{
+    int fragments = length == 0 ? 1 : (int)((length + TRANSPORT_FRAGMENT_SIZE - 1) / TRANSPORT_FRAGMENT_SIZE);
+    if (length > TRANSPORT_MAX_MESSAGE || fragments > Transport_ReliableCapacity(transport)) {
+        return false;
+    }
+
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (int i = 0; i < fragments; i++) {
+        size_t offset = (size_t)i * TRANSPORT_FRAGMENT_SIZE;
+        size_t size = length - offset < TRANSPORT_FRAGMENT_SIZE ? length - offset : TRANSPORT_FRAGMENT_SIZE;
+
+        TransportSlot* slot = &transport->sendSlots[transport->sendNext & (TRANSPORT_WINDOW - 1)];
+        slot->sequence = transport->sendNext++;
+        slot->fragmentIndex = (uint8_t)i;
+        slot->fragmentCount = (uint8_t)fragments;
+        slot->length = (uint16_t)size;
+        slot->used = true;
+        slot->lastSent = -1.0;
+        if (size > 0) {
+            memcpy(slot->data, bytes + offset, size);
+        }
+    }
+    return true;
+}
+
+bool Transport_SendUnreliable(Transport* transport, int channel, const void* data, size_t length)
+{
+    if (channel < 0 || channel >= TRANSPORT_UNRELIABLE_CHANNELS || length > TRANSPORT_MAX_UNRELIABLE) {
+        return false;
+    }
+
+    // Latest wins: an unsent older message on the channel is simply overwritten
+    memcpy(transport->unreliableData[channel], data, length);
+    transport->unreliableLength[channel] = (uint16_t)length;
+    transport->unreliableStamp[channel]++;
+    transport->unreliablePending[channel] = true;
+    return true;
+}
+
+double Transport_ResendTimeout(const Transport* transport)
+{
+    if (!transport->rttValid) {
+        return INITIAL_RESEND_TIMEOUT;
+    }
+    double timeout = transport->rtt + 4.0 * transport->jitter;
+    if (timeout < MIN_RESEND_TIMEOUT) timeout = MIN_RESEND_TIMEOUT;
+    if (timeout > MAX_RESEND_TIMEOUT) timeout = MAX_RESEND_TIMEOUT;
+    return timeout;
+}
+
+static void UpdateRtt(Transport* transport, double sample)
+{
+    // Smoothed RTT and mean deviation, as in TCP's retransmission timer
+    if (!transport->rttValid) {
+        transport->rtt = sample;
+        transport->jitter = sample / 2.0;
+        transport->rttValid = true;
+    } else {
+        double deviation = sample > transport->rtt ? sample - transport->rtt : transport->rtt - sample;
+        transport->jitter += (deviation - transport->jitter) * 0.25;
+        transport->rtt += (sample - transport->rtt) * 0.125;
+    }
+}
+
+static void AckPacket(Transport* transport, uint16_t sequence, double now, bool newest)
+{
+    TransportPacketRecord* record = &transport->sentPackets[sequence & (TRANSPORT_PACKET_HISTORY - 1)];
+    if (!record->valid || record->sequence != sequence || record->acked) {
+        return;
+    }
+
+    record->acked = true;
+    transport->stats.packetsAcked++;
+    if (newest) {
+        UpdateRtt(transport, now - record->sentTime);
+    }
+
+    for (int i = 0; i < record->fragmentCount; i++) {
+        uint16_t fragment = record->fragments[i];
+        TransportSlot* slot = &transport->sendSlots[fragment & (TRANSPORT_WINDOW - 1)];
+        if (slot->used && slot->sequence == fragment) {
+            slot->used = false;
+        }
+    }
+
+    while (transport->sendOldest != transport->sendNext &&
+           !transport->sendSlots[transport->sendOldest & (TRANSPORT_WINDOW - 1)].used) {
+        transport->sendOldest++;
+    }
+}
+
+// Track the datagram sequence; returns false for duplicates and packets too
+// old to ack
+static bool AcceptSequence(Transport* transport, uint16_t sequence)
+{
+    if (!transport->receivedAny) {
+        transport->receivedAny = true;
+        transport->remoteSequence = sequence;
+        transport->remoteAckBits = 0;
+        return true;
+    }
+
+    if (SequenceGreater(sequence, transport->remoteSequence)) {
+        uint16_t shift = (uint16_t)(sequence - transport->remoteSequence);
+        if (shift > 32) {
+            transport->remoteAckBits = 0;
+        } else if (shift == 32) {
+            transport->remoteAckBits = 1u << 31;
+        } else {
+            transport->remoteAckBits = (transport->remoteAckBits << shift) | (1u << (shift - 1));
+        }
+        transport->remoteSequence = sequence;
+        return true;
+    }
+
+    uint16_t age = (uint16_t)(transport->remoteSequence - sequence);
+    if (age == 0 || age > 32 || (transport->remoteAckBits & (1u << (age - 1)))) {
+        return false;
+    }
+    transport->remoteAckBits |= 1u << (age - 1);
+    return true;
+}
+
+// Deliver reliable messages whose fragments have all arrived, in order
+static void DeliverReliable(Transport* transport)
+{
+    for (;;) {
+        TransportSlot* first = &transport->receiveSlots[transport->receiveNext & (TRANSPORT_WINDOW - 1)];
+        if (!first->used || first->sequence != transport->receiveNext) {
+            return;
+        }
+
+        int count = first->fragmentCount;
+        if (first->fragmentIndex != 0) {
+            // Cannot start a message; skip it rather than stall the stream
+            first->used = false;
+            transport->receiveNext++;
+            continue;
+        }
+
+        for (int i = 1; i < count; i++) {
+            uint16_t sequence = (uint16_t)(transport->receiveNext + i);
+            TransportSlot* slot = &transport->receiveSlots[sequence & (TRANSPORT_WINDOW - 1)];
+            if (!slot->used || slot->sequence != sequence) {
+                return;
+            }
+        }
+
+        if (count == 1) {
+            transport->deliver(transport->deliverContext, TRANSPORT_MESSAGE_RELIABLE, 0,
+                               first->data, first->length);
+            first->used = false;
+        } else {
+            size_t length = 0;
+            for (int i = 0; i < count; i++) {
+                uint16_t sequence = (uint16_t)(transport->receiveNext + i);
+                TransportSlot* slot = &transport->receiveSlots[sequence & (TRANSPORT_WINDOW - 1)];
+                memcpy(transport->reassembly + length, slot->data, slot->length);
+                length += slot->length;
+                slot->used = false;
+            }
+            transport->deliver(transport->deliverContext, TRANSPORT_MESSAGE_RELIABLE, 0,
+                               transport->reassembly, length);
+        }
+        transport->receiveNext = (uint16_t)(transport->receiveNext + count);
+        transport->stats.reliableDelivered++;
+    }
+}
+
+void Transport_Receive(Transport* transport, const uint8_t* data, size_t length, double now)
+{
+    if (length < TRANSPORT_HEADER_SIZE || data[0] != TRANSPORT_MAGIC) {
+        LOG_EVENT(DATAGRAM_REJECTED, length);
+        return;
+    }
+
+    uint8_t flags = data[1];
+    uint16_t sequence = ReadU16(data + 2);
+    uint16_t ack = ReadU16(data + 4);
+    uint32_t ackBits = ReadU32(data + 6);
+
+    if (!AcceptSequence(transport, sequence)) {
+        transport->stats.duplicates++;
+        return;
+    }
+    transport->ackPending = true;
+    transport->stats.packetsReceived++;
+    Metrics_Count(METRIC_PACKETS_IN, 1);
+    transport->stats.bytesReceived += length;
+
+    if (flags & HEADER_ACK_VALID) {
+        AckPacket(transport, ack, now, true);
+        for (int i = 0; i < 32; i++) {
+            if (ackBits & (1u << i)) {
+                AckPacket(transport, (uint16_t)(ack - 1 - i), now, false);
+            }
+        }
+    }
+
+    const uint8_t* p = data + TRANSPORT_HEADER_SIZE;
+    const uint8_t* end = data + length;
+    while (p < end) {
+        if (*p == CHUNK_RELIABLE && end - p >= RELIABLE_CHUNK_HEADER) {
+            uint16_t fragment = ReadU16(p + 1);
+            uint8_t index = p[3];
+            uint8_t count = p[4];
+            uint16_t size = ReadU16(p + 5);
+            p += RELIABLE_CHUNK_HEADER;
+            if (size > TRANSPORT_FRAGMENT_SIZE || end - p < size ||
+                count == 0 || count > TRANSPORT_MAX_FRAGMENTS || index >= count) {
+                return;
+            }
+
+            // Keep it if it falls in the window and has not arrived yet
+            if ((uint16_t)(fragment - transport->receiveNext) < TRANSPORT_WINDOW) {
+                TransportSlot* slot = &transport->receiveSlots[fragment & (TRANSPORT_WINDOW - 1)];
+                if (!slot->used) {
+                    slot->sequence = fragment;
+                    slot->fragmentIndex = index;
+                    slot->fragmentCount = count;
+                    slot->length = size;
+                    slot->used = true;
+                    memcpy(slot->data, p, size);
+                }
+            }
+            p += size;
+        } else if (*p == CHUNK_UNRELIABLE && end - p >= UNRELIABLE_CHUNK_HEADER) {
+            uint8_t channel = p[1];
+            uint16_t stamp = ReadU16(p + 2);
+            uint16_t size = ReadU16(p + 4);
+            p += UNRELIABLE_CHUNK_HEADER;
+            if (channel >= TRANSPORT_UNRELIABLE_CHANNELS || end - p < size) {
+                return;
+            }
+
+            if (!transport->receivedOnChannel[channel] ||
+                SequenceGreater(stamp, transport->receivedStamp[channel])) {
+                transport->receivedOnChannel[channel] = true;
+                transport->receivedStamp[channel] = stamp;
+                transport->stats.unreliableDelivered++;
+                transport->deliver(transport->deliverContext, TRANSPORT_MESSAGE_UNRELIABLE,
+                                   channel, p, size);
+            } else {
+                transport->stats.staleDropped++;
+            }
+            p += size;
+        } else {
+            break;
+        }
+    }
+
+    DeliverReliable(transport);
+}
+
+void Transport_Update(Transport* transport, double now)
+{
+    double timeout = Transport_ResendTimeout(transport);
+    uint8_t packet[TRANSPORT_MTU];
+
+    for (int d = 0; d < TRANSPORT_MAX_DATAGRAMS_PER_UPDATE; d++) {
+        uint16_t sequence = transport->localSequence;
+        TransportPacketRecord* record = &transport->sentPackets[sequence & (TRANSPORT_PACKET_HISTORY - 1)];
+        size_t size = TRANSPORT_HEADER_SIZE;
+        int fragmentCount = 0;
+
+        // Reliable fragments that were never sent or have timed out
+        for (uint16_t f = transport->sendOldest; f != transport->sendNext; f++) {
+            TransportSlot* slot = &transport->sendSlots[f & (TRANSPORT_WINDOW - 1)];
+            if (!slot->used || (slot->lastSent >= 0.0 && now - slot->lastSent < timeout)) {
+                continue;
+            }
+            if (size + RELIABLE_CHUNK_HEADER + slot->length > TRANSPORT_MTU ||
+                fragmentCount == TRANSPORT_MAX_PACKET_FRAGMENTS) {
+                break;
+            }
+
+            uint8_t* chunk = packet + size;
+            chunk[0] = CHUNK_RELIABLE;
+            WriteU16(chunk + 1, slot->sequence);
+            chunk[3] = slot->fragmentIndex;
+            chunk[4] = slot->fragmentCount;
+            WriteU16(chunk + 5, slot->length);
+            memcpy(chunk + RELIABLE_CHUNK_HEADER, slot->data, slot->length);
+            size += RELIABLE_CHUNK_HEADER + slot->length;
+
+            if (slot->lastSent >= 0.0) {
+                transport->stats.resends++;
+            }
+            slot->lastSent = now;
+            record->fragments[fragmentCount++] = slot->sequence;
+        }
+
+        // Latest unreliable message on each channel, if it fits
+        bool wroteUnreliable = false;
+        for (int c = 0; c < TRANSPORT_UNRELIABLE_CHANNELS; c++) {
+            uint16_t length = transport->unreliableLength[c];
+            if (!transport->unreliablePending[c] ||
+                size + UNRELIABLE_CHUNK_HEADER + length > TRANSPORT_MTU) {
+                continue;
+            }
+
+            uint8_t* chunk = packet + size;
+            chunk[0] = CHUNK_UNRELIABLE;
+            chunk[1] = (uint8_t)c;
+            WriteU16(chunk + 2, transport->unreliableStamp[c]);
+            WriteU16(chunk + 4, length);
+            memcpy(chunk + UNRELIABLE_CHUNK_HEADER, transport->unreliableData[c], length);
+            size += UNRELIABLE_CHUNK_HEADER + length;
+            transport->unreliablePending[c] = false;
+            wroteUnreliable = true;
+        }
+
+        // Send a bare ack if there is nothing else to say but the peer needs one
+        if (fragmentCount == 0 && !wroteUnreliable && !transport->ackPending) {
+            break;
+        }
+
+        packet[0] = TRANSPORT_MAGIC;
+        packet[1] = transport->receivedAny ? HEADER_ACK_VALID : 0;
+        WriteU16(packet + 2, sequence);
+        WriteU16(packet + 4, transport->remoteSequence);
+        WriteU32(packet + 6, transport->remoteAckBits);
+
+        if (record->valid && !record->acked) {
+            transport->stats.packetsLost++;
+            LOG_EVENT(PACKET_LOST, record->sequence, transport->rtt * 1000.0);
+        }
+        record->sequence = sequence;
+        record->valid = true;
+        record->acked = false;
+        record->sentTime = now;
+        record->fragmentCount = (uint8_t)fragmentCount;
+
+        transport->localSequence++;
+        transport->ackPending = false;
+        transport->stats.packetsSent++;
+        transport->stats.bytesSent += size;
+        transport->send(transport->sendContext, packet, size);
+        Metrics_Count(METRIC_PACKETS_OUT, 1);
+    }
+}
+
+int UdpLink_OpenSocket(const struct sockaddr* address, socklen_t addressLength)
+{
+    int fd = socket(address->sa_family, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (bind(fd, address, addressLength) != 0) {
+        close(fd);
+        return -1;
+    }
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    return fd;
+}
+
+void UdpLink_Init(UdpLink* link, int socket, const struct sockaddr* peer, socklen_t peerLength)
+{
+    memset(link, 0, sizeof(*link));
+    link->socket = socket;
+    memcpy(&link->peer, peer, peerLength);
+    link->peerLength = peerLength;
+}
+
+void UdpLink_Send(void* context, const uint8_t* data, size_t length)
+{
+    UdpLink* link = (UdpLink*)context;
+    // A full socket buffer is just another lost datagram to the transport
+    (void)sendto(link->socket, data, length, 0, (const struct sockaddr*)&link->peer, link->peerLength);
+}
+
+// Compare family, address and port only (padding may differ)
+static bool SameAddress(const struct sockaddr_storage* a, const struct sockaddr_storage* b)
+{
+    if (a->ss_family != b->ss_family) {
+        return false;
+    }
+    if (a->ss_family == AF_INET) {
+        const struct sockaddr_in* x = (const struct sockaddr_in*)a;
+        const struct sockaddr_in* y = (const struct sockaddr_in*)b;
+        return x->sin_port == y->sin_port && x->sin_addr.s_addr == y->sin_addr.s_addr;
+    }
+    if (a->ss_family == AF_INET6) {
+        const struct sockaddr_in6* x = (const struct sockaddr_in6*)a;
+        const struct sockaddr_in6* y = (const struct sockaddr_in6*)b;
+        return x->sin6_port == y->sin6_port &&
+               memcmp(&x->sin6_addr, &y->sin6_addr, sizeof(x->sin6_addr)) == 0;
+    }
+    return false;
+}
+
+int UdpLink_Poll(UdpLink* link, Transport* transport, double now)
+{
+    uint8_t buffer[TRANSPORT_MTU];
+    int count = 0;
+
+    for (;;) {
+        struct sockaddr_storage from;
+        socklen_t fromLength = sizeof(from);
+        ssize_t length = recvfrom(link->socket, buffer, sizeof(buffer), 0,
+                                  (struct sockaddr*)&from, &fromLength);
+        if (length < 0) {
+            return count;
+        }
+        if (SameAddress(&from, &link->peer)) {
+            Transport_Receive(transport, buffer, (size_t)length, now);
+            count++;
+        }
+    }
+}
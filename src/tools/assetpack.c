@@ -0,0 +1,438 @@
+#define _DEFAULT_SOURCE
+#include "asset_bundle.h"
+#include "game_board.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+// Sound files larger than this (or under music/) are streamed rather than held as one wave
+#define MUSIC_MIN_BYTES (1u << 20)
+
+// Most entries one bundle holds
+#define MAX_ENTRIES 1024
+
+// An entry being packed with its data
+typedef struct {
+    AssetEntry entry;
+    uint8_t* data;
+} PackItem;
+
+typedef struct {
+    PackItem items[MAX_ENTRIES];
+    int count;
+} PackList;
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static PackItem* AddItem(PackList* list, const char* name, AssetKind kind, uint8_t* data, size_t size)
+{
+    if (list->count == MAX_ENTRIES || strlen(name) >= ASSET_NAME_SIZE) {
+        fprintf(stderr, "Skipping %s: %s\n", name,
+                list->count == MAX_ENTRIES ? "too many assets" : "name too long");
+        free(data);
+        return NULL;
+    }
+    for (int i = 0; i < list->count; i++) {
+        if (strcmp(list->items[i].entry.name, name) == 0) {
+            fprintf(stderr, "Skipping %s: duplicate name\n", name);
+            free(data);
+            return NULL;
+        }
+    }
+
+    PackItem* item = &list->items[list->count++];
+    memset(item, 0, sizeof(*item));
+    strncpy(item->entry.name, name, ASSET_NAME_SIZE - 1);
+    item->entry.kind = (uint32_t)kind;
+    item->entry.size = size;
+    item->data = data;
+    return item;
+}
+
+// --- Baked block atlas ---
+
+// raylib's palette for each block color, in BlockType bit order
+static const uint8_t BLOCK_COLORS[BLOCK_MAX_TYPE_COUNT][3] = {
+    { 230, 41, 55 },    // RED
+    { 0, 121, 241 },    // BLUE
+    { 0, 228, 48 },     // GREEN
+    { 253, 249, 0 },    // YELLOW
+    { 200, 122, 255 },  // PURPLE
+    { 102, 191, 255 },  // SKYBLUE (cyan blocks)
+};
+
+static uint8_t Shade(int value, int percent)
+{
+    value = value * percent / 100;
+    return (uint8_t)(value > 255 ? 255 : value);
+}
+
+// One bevelled tile per color: lit top-left edge, shadowed bottom-right edge
+// and a body that darkens towards the bottom
+static void BakeBlockAtlas(PackList* list)
+{
+    const int tile = ASSET_BLOCK_TILE_SIZE;
+    const int bevel = 4;
+    const int width = tile * BLOCK_MAX_TYPE_COUNT;
+    size_t size = (size_t)width * tile * 4;
+    uint8_t* pixels = malloc(size);
+    if (!pixels) {
+        return;
+    }
+
+    for (int c = 0; c < BLOCK_MAX_TYPE_COUNT; c++) {
+        for (int y = 0; y < tile; y++) {
+            for (int x = 0; x < tile; x++) {
+                int percent = 112 - 24 * y / tile;
+                if (x < bevel || y < bevel) {
+                    percent = (x >= tile - bevel || y >= tile - bevel) ? 100 : 140;
+                } else if (x >= tile - bevel || y >= tile - bevel) {
+                    percent = 65;
+                }
+                uint8_t* pixel = pixels + ((size_t)y * width + (size_t)c * tile + x) * 4;
+                for (int k = 0; k < 3; k++) {
+                    pixel[k] = Shade(BLOCK_COLORS[c][k] + (percent > 100 ? 24 : 0), percent);
+                }
+                pixel[3] = 255;
+            }
+        }
+    }
+
+    PackItem* item = AddItem(list, ASSET_BLOCK_ATLAS, ASSET_KIND_IMAGE, pixels, size);
+    if (item) {
+        item->entry.image.width = (uint32_t)width;
+        item->entry.image.height = (uint32_t)tile;
+        item->entry.image.pixelFormat = ASSET_PIXEL_FORMAT_RGBA8;
+    }
+}
+
+// --- WAV decoding ---
+
+static uint32_t ReadLE(const uint8_t* in, int bytes)
+{
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+// Decode a RIFF WAV file to interleaved samples raylib plays directly:
+// 8/16-bit PCM and 32-bit float are kept, 24/32-bit PCM becomes 16-bit
+static uint8_t* DecodeWav(const uint8_t* file, size_t fileSize, AssetEntry* entry, size_t* outSize)
+{
+    if (fileSize < 12 || memcmp(file, "RIFF", 4) != 0 || memcmp(file + 8, "WAVE", 4) != 0) {
+        return NULL;
+    }
+
+    uint32_t format = 0, channels = 0, sampleRate = 0, bits = 0;
+    const uint8_t* data = NULL;
+    size_t dataSize = 0;
+    for (size_t offset = 12; offset + 8 <= fileSize;) {
+        const uint8_t* chunk = file + offset;
+        size_t chunkSize = ReadLE(chunk + 4, 4);
+        if (chunkSize > fileSize - offset - 8) {
+            chunkSize = fileSize - offset - 8;
+        }
+        if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+            format = ReadLE(chunk + 8, 2);
+            channels = ReadLE(chunk + 10, 2);
+            sampleRate = ReadLE(chunk + 12, 4);
+            bits = ReadLE(chunk + 22, 2);
+            if (format == 0xFFFE && chunkSize >= 26) {
+                format = ReadLE(chunk + 32, 2);     // WAVE_FORMAT_EXTENSIBLE sub-format
+            }
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            data = chunk + 8;
+            dataSize = chunkSize;
+        }
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    bool pcm = format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32);
+    bool pcmFloat = format == 3 && bits == 32;
+    if (!data || channels == 0 || sampleRate == 0 || (!pcm && !pcmFloat)) {
+        return NULL;
+    }
+
+    size_t inBytes = bits / 8;
+    size_t samples = dataSize / inBytes;
+    uint32_t outBits = (pcm && bits > 16) ? 16 : bits;
+    size_t size = samples * (outBits / 8);
+    uint8_t* out = malloc(size ? size : 1);
+    if (!out) {
+        return NULL;
+    }
+    if (outBits == bits) {
+        memcpy(out, data, size);
+    } else {
+        // Keep the top 16 bits of each sample
+        for (size_t i = 0; i < samples; i++) {
+            const uint8_t* sample = data + i * inBytes;
+            out[2 * i] = sample[inBytes - 2];
+            out[2 * i + 1] = sample[inBytes - 1];
+        }
+    }
+
+    entry->audio.sampleRate = sampleRate;
+    entry->audio.sampleSize = outBits;
+    entry->audio.channels = channels;
+    *outSize = size;
+    return out;
+}
+
+static uint8_t* ReadFile(const char* path, size_t* size)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    uint8_t* data = NULL;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long length = ftell(file);
+        if (length > 0 && fseek(file, 0, SEEK_SET) == 0 && (data = malloc((size_t)length)) != NULL) {
+            if (fread(data, 1, (size_t)length, file) != (size_t)length) {
+                free(data);
+                data = NULL;
+            }
+            *size = (size_t)length;
+        }
+    }
+    fclose(file);
+    return data;
+}
+
+// Pack a sound; its name is the path under the asset directory without ".wav"
+static void AddSound(PackList* list, const char* path, const char* name, bool music)
+{
+    size_t fileSize = 0;
+    uint8_t* file = ReadFile(path, &fileSize);
+    if (!file) {
+        fprintf(stderr, "Cannot read %s\n", path);
+        return;
+    }
+
+    AssetEntry decoded = { 0 };
+    size_t size = 0;
+    uint8_t* samples = DecodeWav(file, fileSize, &decoded, &size);
+    free(file);
+    if (!samples) {
+        fprintf(stderr, "Skipping %s: not a PCM or float WAV file\n", path);
+        return;
+    }
+
+    AssetKind kind = (music || size >= MUSIC_MIN_BYTES) ? ASSET_KIND_MUSIC : ASSET_KIND_WAVE;
+    PackItem* item = AddItem(list, name, kind, samples, size);
+    if (item) {
+        item->entry.audio = decoded.audio;
+    }
+}
+
+// Pack every WAV file in the directory and one level of subdirectories
+static void CollectSounds(PackList* list, const char* root, const char* subdir)
+{
+    char dirPath[4096];
+    snprintf(dirPath, sizeof(dirPath), "%s%s%s", root, subdir[0] ? "/" : "", subdir);
+    DIR* dir = opendir(dirPath);
+    if (!dir) {
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char path[8192];
+        snprintf(path, sizeof(path), "%s/%s", dirPath, entry->d_name);
+        struct stat info;
+        if (stat(path, &info) != 0) {
+            continue;
+        }
+        if (S_ISDIR(info.st_mode)) {
+            if (!subdir[0]) {
+                CollectSounds(list, root, entry->d_name);
+            }
+            continue;
+        }
+
+        size_t length = strlen(entry->d_name);
+        if (length <= 4 || strcmp(entry->d_name + length - 4, ".wav") != 0) {
+            fprintf(stderr, "Skipping %s: only WAV sounds are packed\n", path);
+            continue;
+        }
+        char name[ASSET_NAME_SIZE * 4];
+        snprintf(name, sizeof(name), "%s%s%.*s", subdir, subdir[0] ? "/" : "",
+                 (int)(length - 4), entry->d_name);
+        AddSound(list, path, name, strcmp(subdir, "music") == 0);
+    }
+    closedir(dir);
+}
+
+// --- Writing ---
+
+static int CompareItems(const void* a, const void* b)
+{
+    return strcmp(((const PackItem*)a)->entry.name, ((const PackItem*)b)->entry.name);
+}
+
+static size_t AlignUp(size_t value)
+{
+    return (value + ASSET_BUNDLE_ALIGN - 1) & ~(size_t)(ASSET_BUNDLE_ALIGN - 1);
+}
+
+static bool WriteBundle(PackList* list, const char* path)
+{
+    qsort(list->items, (size_t)list->count, sizeof(PackItem), CompareItems);
+
+    size_t offset = AlignUp(ASSET_BUNDLE_HEADER_SIZE + (size_t)list->count * sizeof(AssetEntry));
+    for (int i = 0; i < list->count; i++) {
+        list->items[i].entry.offset = offset;
+        offset = AlignUp(offset + list->items[i].entry.size);
+    }
+
+    AssetBundleHeader header = { 0 };
+    header.magic = ASSET_BUNDLE_MAGIC;
+    header.version = ASSET_BUNDLE_VERSION;
+    header.entryCount = (uint32_t)list->count;
+    header.fileSize = offset;
+
+    // Write to a temporary file and rename, so a running client never maps a half-written bundle
+    char temporary[4096];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    FILE* file = fopen(temporary, "wb");
+    if (!file) {
+        fprintf(stderr, "Cannot create %s\n", temporary);
+        return false;
+    }
+
+    static const uint8_t zeros[ASSET_BUNDLE_ALIGN] = { 0 };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    size_t written = sizeof(header);
+    for (int i = 0; ok && i < list->count; i++) {
+        ok = fwrite(&list->items[i].entry, sizeof(AssetEntry), 1, file) == 1;
+        written += sizeof(AssetEntry);
+    }
+    for (int i = 0; ok && i < list->count; i++) {
+        const AssetEntry* entry = &list->items[i].entry;
+        ok = fwrite(zeros, 1, entry->offset - written, file) == entry->offset - written &&
+             fwrite(list->items[i].data, 1, entry->size, file) == entry->size;
+        written = entry->offset + entry->size;
+    }
+    ok = ok && fwrite(zeros, 1, header.fileSize - written, file) == header.fileSize - written;
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok || rename(temporary, path) != 0) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        remove(temporary);
+        return false;
+    }
+    return true;
+}
+
+static const char* KindName(uint32_t kind)
+{
+    switch (kind) {
+        case ASSET_KIND_WAVE:  return "wave";
+        case ASSET_KIND_MUSIC: return "music";
+        case ASSET_KIND_IMAGE: return "image";
+        default:               return "?";
+    }
+}
+
+static int RunPack(const char* bundlePath, const char* assetDir)
+{
+    static PackList list;
+    BakeBlockAtlas(&list);
+    if (assetDir) {
+        CollectSounds(&list, assetDir, "");
+    }
+
+    bool ok = WriteBundle(&list, bundlePath);
+    size_t total = 0;
+    for (int i = 0; i < list.count; i++) {
+        total += list.items[i].entry.size;
+        free(list.items[i].data);
+    }
+    if (ok) {
+        printf("packed %d assets (%.1f KiB) into %s\n", list.count, (double)total / 1024.0, bundlePath);
+    }
+    return ok ? 0 : 1;
+}
+
+// List a bundle and time what startup does with it: open, look up every
+// entry, and touch the pages of the assets drawn on the first frame
+static int RunInfo(const char* bundlePath)
+{
+    double start = NowSeconds();
+    AssetBundle bundle;
+    if (!AssetBundle_Open(&bundle, bundlePath)) {
+        fprintf(stderr, "Cannot open %s as an asset bundle\n", bundlePath);
+        return 1;
+    }
+    double opened = NowSeconds();
+
+    int found = 0;
+    for (uint32_t i = 0; i < bundle.entryCount; i++) {
+        found += AssetBundle_Find(&bundle, bundle.entries[i].name) == &bundle.entries[i];
+    }
+    double looked = NowSeconds();
+
+    volatile unsigned checksum = 0;
+    const AssetEntry* atlas = AssetBundle_Find(&bundle, ASSET_BLOCK_ATLAS);
+    if (atlas) {
+        const volatile uint8_t* data = AssetBundle_Data(&bundle, atlas);
+        for (size_t i = 0; i < atlas->size; i += 4096) {
+            checksum += data[i];
+        }
+    }
+    double touched = NowSeconds();
+
+    for (uint32_t i = 0; i < bundle.entryCount; i++) {
+        const AssetEntry* entry = &bundle.entries[i];
+        printf("%-32s %-6s %10llu bytes  ", entry->name, KindName(entry->kind),
+               (unsigned long long)entry->size);
+        if (entry->kind == ASSET_KIND_IMAGE) {
+            printf("%ux%u\n", entry->image.width, entry->image.height);
+        } else {
+            unsigned frameBytes = entry->audio.sampleSize / 8 * entry->audio.channels;
+            printf("%u Hz %u-bit x%u, %.2f s\n", entry->audio.sampleRate, entry->audio.sampleSize,
+                   entry->audio.channels,
+                   frameBytes ? (double)entry->size / frameBytes / entry->audio.sampleRate : 0.0);
+        }
+    }
+    printf("%u entries, %zu bytes; open %.3f ms, %d lookups %.3f ms, first-frame pages %.3f ms\n",
+           bundle.entryCount, bundle.size, (opened - start) * 1e3, found, (looked - opened) * 1e3,
+           (touched - looked) * 1e3);
+
+    bool complete = found == (int)bundle.entryCount;
+    AssetBundle_Close(&bundle);
+    return complete ? 0 : 2;
+}
+
+static void PrintUsage(const char* program)
+{
+    printf("Usage: %s <command> [options]\n", program);
+    printf("  pack <bundle> [asset-dir]  Bake textures and pack the WAV sounds under asset-dir\n");
+    printf("                             (files in music/ or over 1 MiB are streamed)\n");
+    printf("  info <bundle>              List the bundle and time opening it\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "pack") == 0) {
+        return RunPack(argv[2], argc >= 4 ? argv[3] : NULL);
+    } else if (argc >= 3 && strcmp(argv[1], "info") == 0) {
+        return RunInfo(argv[2]);
+    }
+    PrintUsage(argv[0]);
+    return 1;
+}
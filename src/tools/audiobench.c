@@ -0,0 +1,292 @@
+#define _POSIX_C_SOURCE 200809L
+#include "audio_mixer.h"
+#include "rng.h"
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BLOCK_NANOS ((uint64_t)AUDIO_MIX_BLOCK_FRAMES * 1000000000ull / AUDIO_MIX_RATE)
+
+// Game frames per second the simulated event producer runs at
+#define FRAME_RATE 60
+
+// Synthetic sound effects in each format the bundle can hold
+#define SAMPLE_COUNT 4
+
+static int16_t swapData[22050 / 10];
+static uint8_t landData[11025 / 8];
+static float clearData[44100 * 2 * 2 / 5];
+static int16_t chainData[48000 * 2 / 2];
+
+typedef struct {
+    double seconds;
+    int eventsPerFrame;
+    uint32_t count;
+    uint64_t seed;
+} BenchOptions;
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Decaying tones: 16-bit mono, 8-bit mono, float stereo, 16-bit stereo
+static void AddSamples(AudioMixer* mixer)
+{
+    for (size_t i = 0; i < sizeof(swapData) / sizeof(swapData[0]); i++) {
+        swapData[i] = (int16_t)(12000.0 * sin(i * 0.12) * exp(-(double)i / 600.0));
+    }
+    for (size_t i = 0; i < sizeof(landData); i++) {
+        landData[i] = (uint8_t)(128.0 + 90.0 * sin(i * 0.05) * exp(-(double)i / 400.0));
+    }
+    for (size_t i = 0; i < sizeof(clearData) / sizeof(clearData[0]) / 2; i++) {
+        clearData[2 * i] = (float)(0.4 * sin(i * 0.03) * exp(-(double)i / 8000.0));
+        clearData[2 * i + 1] = (float)(0.4 * sin(i * 0.031) * exp(-(double)i / 8000.0));
+    }
+    for (size_t i = 0; i < sizeof(chainData) / sizeof(chainData[0]) / 2; i++) {
+        chainData[2 * i] = (int16_t)(9000.0 * sin(i * 0.02) * exp(-(double)i / 9000.0));
+        chainData[2 * i + 1] = chainData[2 * i];
+    }
+
+    AudioSample samples[SAMPLE_COUNT] = {
+        { swapData, sizeof(swapData) / sizeof(swapData[0]), 22050, 16, 1, 2 },
+        { landData, sizeof(landData), 11025, 8, 1, 4 },
+        { clearData, sizeof(clearData) / sizeof(clearData[0]) / 2, 44100, 32, 2, 4 },
+        { chainData, sizeof(chainData) / sizeof(chainData[0]) / 2, 48000, 16, 2, 4 },
+    };
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        AudioMixer_AddSample(mixer, &samples[i]);
+    }
+}
+
+static int CompareNanos(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Cascade load: every game frame pushes a burst of events with timestamps
+// spread over the frame, and blocks are mixed on a simulated device clock
+static int RunBench(const BenchOptions* options)
+{
+    static AudioMixer mixer;
+    static float block[AUDIO_MIX_BLOCK_FRAMES * AUDIO_MIX_CHANNELS];
+    AudioMixer_Init(&mixer);
+    AddSamples(&mixer);
+
+    Rng rng;
+    Rng_Seed(&rng, options->seed, 0);
+
+    uint64_t blocks = (uint64_t)(options->seconds * AUDIO_MIX_RATE / AUDIO_MIX_BLOCK_FRAMES);
+    uint64_t* costs = malloc(blocks * sizeof(uint64_t));
+    if (!costs) {
+        return 1;
+    }
+
+    const uint64_t frameNanos = 1000000000ull / FRAME_RATE;
+    uint64_t clock = 1000000000ull;
+    uint64_t nextFrame = clock;
+    uint32_t peakVoices = 0;
+    for (uint64_t b = 0; b < blocks; b++) {
+        // Game frames that ran while the previous block played
+        while (nextFrame < clock + BLOCK_NANOS) {
+            for (int e = 0; e < options->eventsPerFrame; e++) {
+                AudioEvent event = {
+                    .time = nextFrame + Rng_Range(&rng, (uint32_t)frameNanos),
+                    .sample = (uint8_t)Rng_Range(&rng, SAMPLE_COUNT),
+                    .volume = (uint8_t)(128 + Rng_Range(&rng, 128)),
+                    .pan = (int8_t)((int)Rng_Range(&rng, 255) - 127),
+                    .rate = AUDIO_RATE_ONE + Rng_Range(&rng, AUDIO_RATE_ONE),
+                };
+                AudioMixer_Play(&mixer, &event);
+            }
+            nextFrame += frameNanos;
+        }
+
+        AudioMixer_Mix(&mixer, block, AUDIO_MIX_BLOCK_FRAMES, clock);
+        costs[b] = atomic_load_explicit(&mixer.stats.lastMixNanos, memory_order_relaxed);
+        uint32_t voices = atomic_load_explicit(&mixer.stats.voicesActive, memory_order_relaxed);
+        peakVoices = voices > peakVoices ? voices : peakVoices;
+        clock += BLOCK_NANOS;
+    }
+
+    qsort(costs, blocks, sizeof(uint64_t), CompareNanos);
+    const AudioMixerStats* stats = &mixer.stats;
+    printf("%llu callbacks of %d frames (%.2f ms of audio each)\n",
+           (unsigned long long)blocks, AUDIO_MIX_BLOCK_FRAMES, BLOCK_NANOS / 1e6);
+    printf("mix cost per callback: avg %.2f us, p50 %.2f us, p99 %.2f us, max %.2f us (%.3f%% of the block)\n",
+           atomic_load_explicit(&stats->mixNanos, memory_order_relaxed) / 1000.0 / blocks,
+           costs[blocks / 2] / 1000.0, costs[blocks * 99 / 100] / 1000.0, costs[blocks - 1] / 1000.0,
+           100.0 * costs[blocks * 99 / 100] / BLOCK_NANOS);
+    printf("%llu sounds started, %llu late, %llu voices stolen, %u queue drops, peak %u voices\n",
+           (unsigned long long)atomic_load_explicit(&stats->eventsStarted, memory_order_relaxed),
+           (unsigned long long)atomic_load_explicit(&stats->eventsLate, memory_order_relaxed),
+           (unsigned long long)atomic_load_explicit(&stats->voicesStolen, memory_order_relaxed),
+           mixer.events.dropped, peakVoices);
+    free(costs);
+    return 0;
+}
+
+// Sample accuracy: one-frame impulses, each pushed a little before the block
+// it lands in, must come out exactly on the frame their timestamp maps to
+static int RunTiming(const BenchOptions* options)
+{
+    enum { BLOCKS = 2000, FRAMES = BLOCKS * AUDIO_MIX_BLOCK_FRAMES };
+    static AudioMixer mixer;
+    static float block[AUDIO_MIX_BLOCK_FRAMES * AUDIO_MIX_CHANNELS];
+    static uint8_t expected[FRAMES];
+    static const int16_t impulse[1] = { 16384 };
+    AudioMixer_Init(&mixer);
+    AudioSample sample = { impulse, 1, AUDIO_MIX_RATE, 16, 1, AUDIO_MAX_VOICES };
+    AudioMixer_AddSample(&mixer, &sample);
+
+    Rng rng;
+    Rng_Seed(&rng, options->seed, 0);
+
+    // Clock time of an output frame, rounded up so it maps back to the same frame
+    const uint64_t origin = 1000000000ull;
+#define FRAME_TIME(frame) (origin + ((uint64_t)(frame) * 1000000000ull + AUDIO_MIX_RATE - 1) / AUDIO_MIX_RATE)
+
+    int pushed = 0, heard = 0, misplaced = 0;
+    for (uint64_t b = 0; b < BLOCKS; b++) {
+        uint64_t blockStart = b * AUDIO_MIX_BLOCK_FRAMES;
+
+        // Targets in this block or the next: some timestamps already lie in
+        // the past of the device clock, as they do for a frame's events
+        uint64_t target = blockStart + Rng_Range(&rng, 2 * AUDIO_MIX_BLOCK_FRAMES);
+        if (target >= AUDIO_MIX_LATENCY_FRAMES && target < FRAMES) {
+            AudioEvent event = {
+                .time = FRAME_TIME(target - AUDIO_MIX_LATENCY_FRAMES),
+                .sample = 0,
+                .volume = 255,
+                .rate = AUDIO_RATE_ONE,
+            };
+            AudioMixer_Play(&mixer, &event);
+            pushed += !expected[target];
+            expected[target] = 1;
+        }
+
+        AudioMixer_Mix(&mixer, block, AUDIO_MIX_BLOCK_FRAMES, FRAME_TIME(blockStart));
+        for (uint32_t i = 0; i < AUDIO_MIX_BLOCK_FRAMES; i++) {
+            if (block[2 * i] != 0.0f) {
+                heard++;
+                misplaced += !expected[blockStart + i];
+            }
+        }
+    }
+#undef FRAME_TIME
+
+    printf("%d impulses scheduled, %d heard, %d off their frame, %llu late\n", pushed, heard, misplaced,
+           (unsigned long long)atomic_load_explicit(&mixer.stats.eventsLate, memory_order_relaxed));
+    return (heard == pushed && misplaced == 0) ? 0 : 2;
+}
+
+typedef struct {
+    AudioEventQueue* queue;
+    uint32_t count;
+} QueueProducer;
+
+static void* ProduceEvents(void* arg)
+{
+    QueueProducer* producer = (QueueProducer*)arg;
+    for (uint32_t i = 0; i < producer->count; i++) {
+        AudioEvent event = { .time = i };
+        while (!AudioEventQueue_Push(producer->queue, &event)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Ring throughput and ordering with the producer and consumer on two threads
+static int RunQueue(const BenchOptions* options)
+{
+    static AudioEventQueue queue;
+    AudioEventQueue_Init(&queue);
+    QueueProducer producer = { &queue, options->count };
+
+    double start = NowSeconds();
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, ProduceEvents, &producer) != 0) {
+        return 1;
+    }
+    uint32_t received = 0, outOfOrder = 0;
+    AudioEvent event;
+    while (received < producer.count) {
+        if (AudioEventQueue_Pop(&queue, &event)) {
+            outOfOrder += event.time != received;
+            received++;
+        } else {
+            sched_yield();
+        }
+    }
+    pthread_join(thread, NULL);
+    double seconds = NowSeconds() - start;
+
+    printf("%u events in %.3f s: %.1f M events/s, %.1f ns per event, %u out of order, %u pushes found the ring full\n",
+           received, seconds, received / seconds / 1e6, seconds * 1e9 / received, outOfOrder, queue.dropped);
+    return outOfOrder ? 2 : 0;
+}
+
+static void PrintUsage(const char* program)
+{
+    printf("Usage: %s <command> [options]\n", program);
+    printf("  bench             Mix a cascade-heavy event load and report per-callback cost\n");
+    printf("  timing            Check that sounds start on the exact frame of their timestamp\n");
+    printf("  queue             Event ring throughput between two threads\n");
+    printf("    --seconds N     Seconds of audio mixed in bench (default 60)\n");
+    printf("    --events N      Events pushed per game frame in bench (default 8)\n");
+    printf("    --count N       Events sent through the ring in queue (default 10000000)\n");
+    printf("    --seed N        Event stream seed (default 1)\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    BenchOptions options = {
+        .seconds = 60.0,
+        .eventsPerFrame = 8,
+        .count = 10000000,
+        .seed = 1,
+    };
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            options.seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+            options.eventsPerFrame = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            options.count = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.seconds <= 0.0) {
+        options.seconds = 1.0;
+    }
+    if (options.count == 0) {
+        options.count = 1;
+    }
+
+    if (strcmp(argv[1], "bench") == 0) {
+        return RunBench(&options);
+    } else if (strcmp(argv[1], "timing") == 0) {
+        return RunTiming(&options);
+    } else if (strcmp(argv[1], "queue") == 0) {
+        return RunQueue(&options);
+    }
+    PrintUsage(argv[0]);
+    return 1;
+}
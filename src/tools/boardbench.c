@@ -0,0 +1,353 @@
+#define _POSIX_C_SOURCE 200809L
+#include "board_codec.h"
+#include "board_mode.h"
+#include "game_state.h"
+#include "garbage.h"
+#include "rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Boards per mode in the benchmark set (cycled through so they stay in cache)
+#define BENCH_BOARDS 1024
+
+// Cleared runs punched into each full board
+#define BENCH_MIN_CLEARS 2
+#define BENCH_MAX_CLEARS 6
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// A full board with a few 3-5 block runs cleared out of it, as it looks
+// right after ClearMatches: dense, with gaps high and low in the stack
+static void MakePostClearBoard(GameBoard* board, const BoardMode* mode, Rng* rng)
+{
+    GameBoard_InitMode(board, (BoardModeId)mode->id);
+    GameBoard_FillSeeded(board, Rng_Next(rng));
+
+    int clears = BENCH_MIN_CLEARS + (int)Rng_Range(rng, BENCH_MAX_CLEARS - BENCH_MIN_CLEARS + 1);
+    for (int c = 0; c < clears; c++) {
+        int length = 3 + (int)Rng_Range(rng, 3);
+        bool vertical = Rng_Range(rng, 2) == 0;
+        int spanX = vertical ? 1 : length;
+        int spanY = vertical ? length : 1;
+        int x0 = (int)Rng_Range(rng, (uint32_t)(mode->width - spanX + 1));
+        int y0 = (int)Rng_Range(rng, (uint32_t)(mode->height - spanY + 1));
+        for (int i = 0; i < length; i++) {
+            GameBoard_SetCell(board, x0 + (vertical ? 0 : i), y0 + (vertical ? i : 0),
+                              MAKE_BLOCK(BLOCK_EMPTY, STATE_NORMAL));
+        }
+    }
+}
+
+// Run gravity on a copy of every board, rounds times; returns ns per call
+static double TimeGravity(ApplyGravityFn gravity, const GameBoard* boards, int rounds, uint64_t* moved)
+{
+    static GameBoard work;
+    static GravityAnimation anim;
+    GravityAnimation_Init(&anim);
+
+    double start = NowSeconds();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < BENCH_BOARDS; i++) {
+            work = boards[i];
+            gravity(&work, &anim);
+            *moved += anim.count;
+        }
+    }
+    return (NowSeconds() - start) * 1e9 / ((double)rounds * BENCH_BOARDS);
+}
+
+// Same for match detection, on the boards after gravity settled them
+static double TimeDetect(DetectMatchesFn detect, const GameBoard* boards, int rounds, uint64_t* found)
+{
+    static GameBoard work;
+    static MatchList matches;
+
+    double start = NowSeconds();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < BENCH_BOARDS; i++) {
+            work = boards[i];
+            *found += (uint64_t)detect(&work, &matches);
+        }
+    }
+    return (NowSeconds() - start) * 1e9 / ((double)rounds * BENCH_BOARDS);
+}
+
+// The kernel must leave the board and animation exactly as the scan does
+static bool CheckGravity(const BoardMode* mode, const GameBoard* boards)
+{
+    for (int i = 0; i < BENCH_BOARDS; i++) {
+        GameBoard expected = boards[i];
+        GameBoard actual = boards[i];
+        GravityAnimation expectedAnim, actualAnim;
+        GravityAnimation_Init(&expectedAnim);
+        GravityAnimation_Init(&actualAnim);
+
+        bool expectedMoved = ApplyGravity_Scan(&expected, &expectedAnim);
+        bool actualMoved = mode->applyGravity(&actual, &actualAnim);
+        if (expectedMoved != actualMoved ||
+            memcmp(expected.grid, actual.grid, sizeof(expected.grid)) != 0 ||
+            expectedAnim.count != actualAnim.count ||
+            expectedAnim.duration != actualAnim.duration ||
+            memcmp(expectedAnim.blocks, actualAnim.blocks,
+                   expectedAnim.count * sizeof(expectedAnim.blocks[0])) != 0) {
+            fprintf(stderr, "%s: board %d: gravity kernel differs from the scan\n", mode->name, i);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Slab counts for the garbage sweep (one full-width row each)
+static const int GARBAGE_SLAB_COUNTS[] = { 0, 1, 2, 4, 6, GARBAGE_MAX_SLABS };
+
+// A classic board with its top rows turned into garbage slabs resting on
+// the stack, and runs cleared out of the stack below them, so gravity has
+// to drop blocks and slabs alike
+static void MakeGarbageBoard(GameBoard* board, int slabs, Rng* rng)
+{
+    const BoardMode* mode = BoardMode_Get(BOARD_MODE_CLASSIC);
+    GameBoard_InitMode(board, BOARD_MODE_CLASSIC);
+    GameBoard_FillSeeded(board, Rng_Next(rng));
+    for (int i = 0; i < slabs * mode->width; i++) {
+        board->grid[i] = MAKE_BLOCK(BLOCK_EMPTY, STATE_NORMAL);
+    }
+
+    GarbageTemplate garbage = { 0 };
+    for (int x = 0; x < mode->width; x++) {
+        garbage.reveal[x] = MAKE_BLOCK(1u << Rng_Range(rng, (uint32_t)mode->colorCount), STATE_NORMAL);
+    }
+    GravityAnimation anim;
+    for (int s = 0; s < slabs; s++) {
+        Garbage_Spawn(board, &garbage, mode->width, 1);
+        ApplyGravity_Scan(board, &anim);
+    }
+    Garbage_Land(board);
+
+    int clears = BENCH_MIN_CLEARS + (int)Rng_Range(rng, BENCH_MAX_CLEARS - BENCH_MIN_CLEARS + 1);
+    for (int c = 0; c < clears; c++) {
+        int x0 = (int)Rng_Range(rng, (uint32_t)(mode->width - 2));
+        int y = slabs + (int)Rng_Range(rng, (uint32_t)(mode->height - slabs));
+        for (int x = x0; x < x0 + 3; x++) {
+            board->grid[y * mode->width + x] = MAKE_BLOCK(BLOCK_EMPTY, STATE_NORMAL);
+        }
+    }
+}
+
+// After gravity no block sits under a slab, no slabs overlap and every slab
+// rests on the floor, a block or another slab
+static bool CheckSlabs(const GameBoard* board)
+{
+    const BoardMode* mode = BoardMode_Of(board);
+    for (int s = 0; s < board->slabCount; s++) {
+        const GarbageSlab* slab = &board->slabs[s];
+        int below = slab->y + slab->height;
+        bool resting = below == mode->height;
+        for (int x = slab->x; x < slab->x + slab->width; x++) {
+            for (int y = slab->y; y < below; y++) {
+                if (BLOCK_TYPE(board->grid[y * mode->width + x]) != BLOCK_EMPTY ||
+                    Garbage_SlabAt(board, x, y) != s) {
+                    return false;
+                }
+            }
+            if (below < mode->height &&
+                (BLOCK_TYPE(board->grid[below * mode->width + x]) != BLOCK_EMPTY ||
+                 Garbage_SlabAt(board, x, below) >= 0)) {
+                resting = true;
+            }
+        }
+        if (!resting) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Step a state with no input until an event in mask fires; returns the
+// events of that tick, or 0 if none fired within limit ticks
+static int StepUntil(GameState* state, int mask, int limit)
+{
+    GameInput idle = { 0, 0, 0 };
+    for (int t = 0; t < limit; t++) {
+        int events = GameState_Update(state, &idle, GAME_TICK_SECONDS);
+        if (events & mask) {
+            return events;
+        }
+    }
+    return 0;
+}
+
+// An attack that arrives while a clear is pending waits in the queue and
+// drops once the board has settled, then lands on the stack
+static bool CheckQueuedGarbage(uint64_t seed)
+{
+    static RowQueue rows;
+    static GameState state;
+    RowQueue_Init(&rows, seed);
+    GameState_Init(&state, seed, &rows);
+
+    // An empty board but for a bottom row one swap away from a run of three
+    static const BlockType bottom[BOARD_WIDTH] = {
+        BLOCK_RED, BLOCK_RED, BLOCK_BLUE, BLOCK_RED, BLOCK_GREEN, BLOCK_YELLOW
+    };
+    GameBoard_Clear(&state.board);
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+        GameBoard_SetCell(&state.board, x, BOARD_HEIGHT - 1, MAKE_BLOCK(bottom[x], STATE_NORMAL));
+    }
+
+    GameInput swap = { 2, BOARD_HEIGHT - 1, GAME_INPUT_SWAP };
+    GameState_Update(&state, &swap, GAME_TICK_SECONDS);
+    if (!StepUntil(&state, GAME_EVENT_MATCH, 60)) {
+        fprintf(stderr, "garbage: queued check: swap made no match\n");
+        return false;
+    }
+
+    GameInput attack = { 2, 0, GAME_INPUT_GARBAGE };
+    int events = GameState_Update(&state, &attack, GAME_TICK_SECONDS);
+    if ((events & GAME_EVENT_GARBAGE) || state.board.slabCount != 0 || state.pendingGarbageCount != 1) {
+        fprintf(stderr, "garbage: queued check: attack did not wait for the clear\n");
+        return false;
+    }
+
+    events = StepUntil(&state, GAME_EVENT_CLEAR | GAME_EVENT_GARBAGE, 120);
+    if (!(events & GAME_EVENT_CLEAR) || (events & GAME_EVENT_GARBAGE)) {
+        fprintf(stderr, "garbage: queued check: attack dropped before the clear\n");
+        return false;
+    }
+    if (!StepUntil(&state, GAME_EVENT_GARBAGE, 120) || state.pendingGarbageCount != 0 ||
+        state.board.slabCount != 1) {
+        fprintf(stderr, "garbage: queued check: attack never dropped\n");
+        return false;
+    }
+    if (!StepUntil(&state, GAME_EVENT_LAND, 120) || !CheckSlabs(&state.board) ||
+        state.board.slabs[0].width != 3 || state.board.slabs[0].state != STATE_NORMAL) {
+        fprintf(stderr, "garbage: queued check: slab did not land\n");
+        return false;
+    }
+    return true;
+}
+
+// Gravity, detection and wire size as garbage piles up on a classic board
+static bool RunGarbageSweep(int rounds, uint64_t seed)
+{
+    const BoardMode* mode = BoardMode_Get(BOARD_MODE_CLASSIC);
+    static GameBoard boards[BENCH_BOARDS];
+    static GameBoard settled[BENCH_BOARDS];
+    uint8_t packet[BOARD_KEYFRAME_SIZE + BOARD_DELTA_MAX_SIZE];
+    bool ok = true;
+
+    printf("%-6s %6s %10s %10s %10s %10s %10s\n",
+           "slabs", "cells", "gravity ns", "moved/call", "detect ns", "keyframe B", "delta B");
+    for (size_t c = 0; c < sizeof(GARBAGE_SLAB_COUNTS) / sizeof(GARBAGE_SLAB_COUNTS[0]); c++) {
+        int slabs = GARBAGE_SLAB_COUNTS[c];
+        Rng rng;
+        Rng_Seed(&rng, seed, (uint64_t)c);
+
+        size_t keyframeBytes = 0, deltaBytes = 0;
+        for (int i = 0; i < BENCH_BOARDS; i++) {
+            MakeGarbageBoard(&boards[i], slabs, &rng);
+            GravityAnimation anim;
+            settled[i] = boards[i];
+            mode->applyGravity(&settled[i], &anim);
+            if (!CheckSlabs(&settled[i])) {
+                fprintf(stderr, "garbage: board %d: slabs not settled\n", i);
+                ok = false;
+            }
+            keyframeBytes += BoardCodec_WriteKeyframe(&settled[i], packet);
+            keyframeBytes += BoardCodec_WriteSlabs(&settled[i], packet);
+            deltaBytes += BoardCodec_WriteDelta(&boards[i], &settled[i], packet);
+        }
+
+        uint64_t moved = 0, found = 0;
+        double gravityNs = TimeGravity(mode->applyGravity, boards, rounds, &moved);
+        double detectNs = TimeDetect(mode->detectMatches, settled, rounds, &found);
+        printf("%-6d %6d %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+               slabs, slabs * mode->width, gravityNs, (double)moved / ((double)rounds * BENCH_BOARDS),
+               detectNs, (double)keyframeBytes / BENCH_BOARDS, (double)deltaBytes / BENCH_BOARDS);
+    }
+    return CheckQueuedGarbage(seed) && ok;
+}
+
+static void PrintUsage(const char* program)
+{
+    fprintf(stderr, "Usage: %s [--rounds N] [--seed S] [--garbage | mode]\n", program);
+    fprintf(stderr, "  Times the board kernels on dense post-clear boards of each mode\n");
+    fprintf(stderr, "  (or just the named one) and checks gravity against the plain scan\n");
+    fprintf(stderr, "  --garbage  sweep classic boards from no garbage slabs to a full table,\n");
+    fprintf(stderr, "             and check that an attack during a clear drops once it settles\n");
+}
+
+int main(int argc, char** argv)
+{
+    int rounds = 2000;
+    uint64_t seed = 1;
+    const BoardMode* only = NULL;
+    bool garbage = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+            if (rounds < 1) {
+                rounds = 1;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--garbage") == 0) {
+            garbage = true;
+        } else if ((only = BoardMode_Find(argv[i])) == NULL) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (garbage) {
+        return RunGarbageSweep(rounds, seed) ? 0 : 1;
+    }
+
+    static GameBoard boards[BENCH_BOARDS];
+    static GameBoard settled[BENCH_BOARDS];
+    bool ok = true;
+
+#if defined(__BMI2__)
+    printf("gravity kernel: pext/pdep\n");
+#else
+    printf("gravity kernel: lookup table\n");
+#endif
+    printf("%-8s %6s %10s %10s %8s %10s %10s\n",
+           "mode", "size", "scan ns", "kernel ns", "speedup", "moved/call", "detect ns");
+
+    for (int m = 0; m < BOARD_MODE_COUNT; m++) {
+        const BoardMode* mode = BoardMode_Get((BoardModeId)m);
+        if (only && only != mode) {
+            continue;
+        }
+
+        Rng rng;
+        Rng_Seed(&rng, seed, (uint64_t)m);
+        for (int i = 0; i < BENCH_BOARDS; i++) {
+            MakePostClearBoard(&boards[i], mode, &rng);
+            GravityAnimation anim;
+            settled[i] = boards[i];
+            ApplyGravity_Scan(&settled[i], &anim);
+        }
+        ok = CheckGravity(mode, boards) && ok;
+
+        uint64_t moved = 0, found = 0;
+        double scanNs = TimeGravity(ApplyGravity_Scan, boards, rounds, &moved);
+        double kernelNs = TimeGravity(mode->applyGravity, boards, rounds, &moved);
+        double detectNs = TimeDetect(mode->detectMatches, settled, rounds, &found);
+
+        char size[16];
+        snprintf(size, sizeof(size), "%dx%d", mode->width, mode->height);
+        printf("%-8s %6s %10.1f %10.1f %7.2fx %10.1f %10.1f\n",
+               mode->name, size, scanNs, kernelNs, scanNs / kernelNs,
+               (double)moved / (2.0 * rounds * BENCH_BOARDS), detectNs);
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,395 @@
+#define _POSIX_C_SOURCE 200809L
+#include "garbage.h"
+#include "state_publisher.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Attaches read-only to the live state segment published by the client or
+// server (--publish-state) and shows, records or compares boards
+
+#define RECORD_MAGIC "PASTREC1"
+
+static const char COLOR_LETTERS[BLOCK_MAX_TYPE_COUNT] = { 'R', 'B', 'G', 'Y', 'P', 'C' };
+
+// Mark after each cell, by BlockState
+static char StateMark(BlockState state)
+{
+    switch (state) {
+    case STATE_FALLING: return 'v';
+    case STATE_MATCHED: return '*';
+    case STATE_LOCKED:  return '#';
+    default:            return ' ';
+    }
+}
+
+typedef struct {
+    const char* name;
+    int slot;
+    bool follow;
+    double seconds;
+} InspectOptions;
+
+// Record file: magic, slot size, then one raw StateSlot per tick
+typedef struct {
+    char magic[8];
+    uint32_t slotSize;
+    uint32_t reserved;
+} RecordHeader;
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void SleepMs(int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static bool Attach(StateReader* reader, const char* name)
+{
+    if (!StateReader_Open(reader, name)) {
+        fprintf(stderr, "Cannot attach to %s (not published, or from another build)\n", name);
+        return false;
+    }
+    return true;
+}
+
+// Board rows, with an optional second board whose differing cells are flagged
+static void PrintBoard(const GameBoard* board, const GameBoard* other)
+{
+    const BoardMode* mode = BoardMode_Of(board);
+    for (int y = 0; y < mode->height; y++) {
+        printf("  %2d ", y);
+        for (int x = 0; x < mode->width; x++) {
+            uint16_t cell = board->grid[y * mode->width + x];
+            BlockType type = BLOCK_TYPE(cell);
+            if (type == BLOCK_EMPTY && Garbage_SlabAt(board, x, y) >= 0) {
+                putchar('=');
+            } else {
+                putchar(type == BLOCK_EMPTY ? '.' : COLOR_LETTERS[__builtin_ctz(type)]);
+            }
+            if (other && other->grid[y * mode->width + x] != cell) {
+                putchar('!');
+            } else {
+                putchar(StateMark(BLOCK_STATE(cell)));
+            }
+        }
+        putchar('\n');
+    }
+}
+
+static void PrintSlot(const StateSlot* slot)
+{
+    const GameState* state = &slot->state;
+    printf("match %u player %u tick %u  mode %s  score %d  combo %d\n",
+           slot->matchId, slot->player, slot->tick, state->mode->name, state->board.score,
+           state->board.combo);
+    printf("  swap %s", state->swapAnim.active ? "active" : "idle");
+    if (state->swapAnim.active) {
+        printf(" (%d,%d) %.0f%%", state->swapAnim.x, state->swapAnim.y, state->swapAnim.progress * 100.0f);
+    }
+    printf("  gravity %s", state->gravityAnim.active ? "active" : "idle");
+    if (state->gravityAnim.active) {
+        printf(" %u blocks %.0f%%", state->gravityAnim.count, state->gravityAnim.progress * 100.0f);
+    }
+    printf("  clear %s %.3f s  matched %d cleared %d  garbage queued %d\n",
+           state->waitingToClear ? "pending" : "idle", state->clearTimer,
+           state->lastMatchCount, state->lastClearCount, state->pendingGarbageCount);
+    PrintBoard(&state->board, NULL);
+}
+
+// Every published slot, one line each
+static int ListSlots(const StateReader* reader)
+{
+    printf("%s pid %d\n", reader->segment->source, reader->segment->writerPid);
+    printf("slot  match  player      tick   score  combo\n");
+    int published = 0, torn = 0;
+    for (int i = 0; i < STATE_SHM_SLOTS; i++) {
+        StateSlot slot;
+        StateReadResult result = StateReader_Read(reader, i, &slot);
+        if (result == STATE_READ_OK) {
+            printf("%4d  %5u  %6u  %8u  %6d  %5d\n", i, slot.matchId, slot.player, slot.tick,
+                   slot.state.board.score, slot.state.board.combo);
+            published++;
+        } else if (result == STATE_READ_TORN) {
+            printf("%4d  torn: the writer stopped mid-publish\n", i);
+            torn++;
+        }
+    }
+    if (published == 0 && torn == 0) {
+        printf("(nothing published yet)\n");
+    }
+    return torn ? 1 : 0;
+}
+
+static int RunShow(const InspectOptions* options)
+{
+    StateReader reader;
+    if (!Attach(&reader, options->name)) {
+        return 1;
+    }
+    if (options->slot < 0) {
+        int result = ListSlots(&reader);
+        StateReader_Close(&reader);
+        return result;
+    }
+
+    // Follow redraws on every new tick, polling well inside a tick period
+    double end = NowSeconds() + options->seconds;
+    uint32_t lastSequence = 0;
+    bool shown = false;
+    do {
+        StateSlot slot;
+        StateReadResult result = StateReader_Read(&reader, options->slot, &slot);
+        if (result == STATE_READ_TORN) {
+            fprintf(stderr, "Slot %d is torn: the writer (pid %d) stopped mid-publish\n",
+                    options->slot, reader.segment->writerPid);
+            StateReader_Close(&reader);
+            return 1;
+        }
+        if (result == STATE_READ_OK && slot.sequence != lastSequence) {
+            lastSequence = slot.sequence;
+            if (options->follow) {
+                printf("\033[H\033[J");
+            }
+            PrintSlot(&slot);
+            fflush(stdout);
+            shown = true;
+        }
+        if (options->follow) {
+            SleepMs(1);
+        }
+    } while (options->follow && (options->seconds <= 0.0 || NowSeconds() < end));
+
+    if (!shown) {
+        fprintf(stderr, "Slot %d has not been published\n", options->slot);
+    }
+    StateReader_Close(&reader);
+    return shown ? 0 : 1;
+}
+
+static int RunRecord(const InspectOptions* options, const char* path)
+{
+    StateReader reader;
+    if (!Attach(&reader, options->name)) {
+        return 1;
+    }
+    FILE* out = fopen(path, "wb");
+    if (!out) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        StateReader_Close(&reader);
+        return 1;
+    }
+    RecordHeader header = { RECORD_MAGIC, sizeof(StateSlot), 0 };
+    fwrite(&header, sizeof(header), 1, out);
+
+    int slotIndex = options->slot < 0 ? 0 : options->slot;
+    double start = NowSeconds();
+    unsigned long records = 0, missed = 0;
+    bool haveTick = false;
+    uint32_t lastTick = 0;
+    bool torn = false;
+    while (NowSeconds() - start < options->seconds) {
+        StateSlot slot;
+        StateReadResult result = StateReader_Read(&reader, slotIndex, &slot);
+        if (result == STATE_READ_TORN) {
+            fprintf(stderr, "Slot %d is torn: the writer (pid %d) stopped mid-publish\n",
+                    slotIndex, reader.segment->writerPid);
+            torn = true;
+            break;
+        }
+        if (result == STATE_READ_OK && (!haveTick || slot.tick != lastTick)) {
+            if (haveTick && slot.tick > lastTick + 1) {
+                missed += slot.tick - lastTick - 1;
+            }
+            fwrite(&slot, sizeof(slot), 1, out);
+            lastTick = slot.tick;
+            haveTick = true;
+            records++;
+        }
+        SleepMs(1);
+    }
+    fclose(out);
+    StateReader_Close(&reader);
+
+    printf("recorded %lu ticks of slot %d to %s (%lu missed)\n", records, slotIndex, path, missed);
+    return records > 0 && !torn ? 0 : 1;
+}
+
+// Read a whole recording; returns the record count or -1
+static long LoadRecording(const char* path, StateSlot** records)
+{
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return -1;
+    }
+    RecordHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.magic, RECORD_MAGIC, 8) != 0 ||
+        header.slotSize != sizeof(StateSlot)) {
+        fprintf(stderr, "%s is not a recording from this build\n", path);
+        fclose(in);
+        return -1;
+    }
+    long count = 0, capacity = 1024;
+    *records = malloc((size_t)capacity * sizeof(StateSlot));
+    while (*records && fread(&(*records)[count], sizeof(StateSlot), 1, in) == 1) {
+        if (++count == capacity) {
+            capacity *= 2;
+            StateSlot* grown = realloc(*records, (size_t)capacity * sizeof(StateSlot));
+            if (!grown) {
+                free(*records);
+                *records = NULL;
+            } else {
+                *records = grown;
+            }
+        }
+    }
+    fclose(in);
+    if (!*records) {
+        fprintf(stderr, "Out of memory reading %s\n", path);
+        return -1;
+    }
+    for (long i = 0; i < count; i++) {
+        (*records)[i].state.mode = BoardMode_Of(&(*records)[i].state.board);
+        (*records)[i].state.rows = NULL;
+    }
+    return count;
+}
+
+// Simulation fields that must agree (pointers and the match scratch list are skipped)
+static bool SameState(const GameState* a, const GameState* b)
+{
+    return memcmp(&a->board, &b->board, sizeof(GameBoard)) == 0 &&
+           a->swapAnim.active == b->swapAnim.active &&
+           a->swapAnim.x == b->swapAnim.x && a->swapAnim.y == b->swapAnim.y &&
+           a->swapAnim.progress == b->swapAnim.progress &&
+           a->gravityAnim.active == b->gravityAnim.active &&
+           a->gravityAnim.count == b->gravityAnim.count &&
+           a->gravityAnim.progress == b->gravityAnim.progress &&
+           memcmp(a->gravityAnim.blocks, b->gravityAnim.blocks,
+                  a->gravityAnim.count * sizeof(FallingBlock)) == 0 &&
+           a->clearTimer == b->clearTimer && a->waitingToClear == b->waitingToClear &&
+           a->lastMatchCount == b->lastMatchCount && a->lastClearCount == b->lastClearCount &&
+           a->pendingGarbageCount == b->pendingGarbageCount &&
+           memcmp(a->pendingGarbage, b->pendingGarbage,
+                  (size_t)a->pendingGarbageCount * sizeof(PendingGarbage)) == 0;
+}
+
+static int RunDiff(const char* pathA, const char* pathB)
+{
+    StateSlot* a = NULL;
+    StateSlot* b = NULL;
+    long countA = LoadRecording(pathA, &a);
+    long countB = countA < 0 ? -1 : LoadRecording(pathB, &b);
+    if (countA < 0 || countB < 0) {
+        free(a);
+        free(b);
+        return 1;
+    }
+
+    // Recordings are in tick order; compare the ticks both captured
+    long i = 0, j = 0, compared = 0;
+    int result = 0;
+    while (i < countA && j < countB) {
+        if (a[i].tick < b[j].tick) {
+            i++;
+        } else if (b[j].tick < a[i].tick) {
+            j++;
+        } else {
+            if (!SameState(&a[i].state, &b[j].state)) {
+                printf("first divergence at tick %u after %ld matching ticks ('!' marks differing cells)\n",
+                       a[i].tick, compared);
+                printf("%s:\n", pathA);
+                PrintSlot(&a[i]);
+                printf("%s:\n", pathB);
+                printf("match %u player %u tick %u  score %d  combo %d\n", b[j].matchId, b[j].player,
+                       b[j].tick, b[j].state.board.score, b[j].state.board.combo);
+                PrintBoard(&b[j].state.board, &a[i].state.board);
+                result = 2;
+                break;
+            }
+            compared++;
+            i++;
+            j++;
+        }
+    }
+    if (result == 0) {
+        printf("%ld common ticks identical (%ld and %ld recorded)\n", compared, countA, countB);
+        if (compared == 0) {
+            result = 1;
+        }
+    }
+    free(a);
+    free(b);
+    return result;
+}
+
+static void PrintUsage(const char* program)
+{
+    printf("Usage: %s <command> [options]\n", program);
+    printf("  show              List published slots, or print one with --slot\n");
+    printf("  record FILE       Save every tick of a slot to FILE\n");
+    printf("  diff FILE FILE    Report the first tick where two recordings differ\n");
+    printf("    --name N        Shared memory segment (default %s)\n", STATE_SHM_DEFAULT_NAME);
+    printf("    --slot N        Slot to show or record (server: room index * 2 + player)\n");
+    printf("    --follow        Keep redrawing the slot on every tick\n");
+    printf("    --seconds N     Duration of record or follow (default 10; follow 0 = forever)\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    InspectOptions options = {
+        .name = STATE_SHM_DEFAULT_NAME,
+        .slot = -1,
+        .follow = false,
+        .seconds = 10.0,
+    };
+    const char* files[2] = { NULL, NULL };
+    int fileCount = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+            options.name = argv[++i];
+        } else if (strcmp(argv[i], "--slot") == 0 && i + 1 < argc) {
+            options.slot = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--follow") == 0) {
+            options.follow = true;
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            options.seconds = atof(argv[++i]);
+        } else if (argv[i][0] != '-' && fileCount < 2) {
+            files[fileCount++] = argv[i];
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.slot >= STATE_SHM_SLOTS) {
+        fprintf(stderr, "Slots run from 0 to %d\n", STATE_SHM_SLOTS - 1);
+        return 1;
+    }
+    if (options.follow && options.slot < 0) {
+        options.slot = 0;
+    }
+
+    if (strcmp(argv[1], "show") == 0 && fileCount == 0) {
+        return RunShow(&options);
+    } else if (strcmp(argv[1], "record") == 0 && fileCount == 1) {
+        return RunRecord(&options, files[0]);
+    } else if (strcmp(argv[1], "diff") == 0 && fileCount == 2) {
+        return RunDiff(files[0], files[1]);
+    }
+    PrintUsage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,417 @@
+#define _POSIX_C_SOURCE 200809L
+#include "logger.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Decodes binary logs written by Logger_Start (the server's and client's
+// --log-file) and measures what a log call costs
+
+typedef struct {
+    const char* file;
+    int minLevel;
+    bool stats;
+    uint32_t count;
+} LogsOptions;
+
+typedef struct {
+    uint64_t ticks;
+    uint64_t monotonicNs;
+    uint64_t wallNs;
+} ClockPoint;
+
+typedef struct {
+    LogRecord* records;
+    long recordCount;
+    ClockPoint* clocks;
+    int clockCount;
+    char threads[UINT8_MAX + 1][LOGGER_MAX_ARGS * sizeof(uint64_t) + 1];
+    uint64_t dropped[UINT8_MAX + 1];
+} LogFile;
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool LoadLog(const char* path, LogFile* log)
+{
+    memset(log, 0, sizeof(*log));
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    LogFileHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 ||
+        memcmp(header.magic, LOGGER_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "%s is not a binary log\n", path);
+        fclose(in);
+        return false;
+    }
+    if (header.recordSize != sizeof(LogRecord) || header.messageCount != LOG_MSG_COUNT ||
+        header.tableHash != Logger_TableHash()) {
+        fprintf(stderr, "%s was written with a different message table; decode it with that build\n", path);
+        fclose(in);
+        return false;
+    }
+
+    long capacity = 4096;
+    log->records = malloc((size_t)capacity * sizeof(LogRecord));
+    log->clocks = malloc((size_t)capacity * sizeof(ClockPoint));
+    int clockCapacity = (int)capacity;
+    LogRecord record;
+    while (log->records && log->clocks && fread(&record, sizeof(record), 1, in) == 1) {
+        if (record.message == LOGGER_RECORD_THREAD) {
+            memcpy(log->threads[record.thread], record.args, sizeof(record.args));
+        } else if (record.message == LOGGER_RECORD_DROPPED) {
+            log->dropped[record.thread] += record.args[0];
+            log->records[log->recordCount++] = record;
+        } else if (record.message == LOGGER_RECORD_CLOCK) {
+            if (log->clockCount == clockCapacity) {
+                clockCapacity *= 2;
+                ClockPoint* grown = realloc(log->clocks, (size_t)clockCapacity * sizeof(ClockPoint));
+                if (!grown) {
+                    break;
+                }
+                log->clocks = grown;
+            }
+            log->clocks[log->clockCount++] = (ClockPoint){ record.ticks, record.args[0], record.args[1] };
+        } else {
+            log->records[log->recordCount++] = record;
+        }
+        if (log->recordCount == capacity) {
+            capacity *= 2;
+            LogRecord* grown = realloc(log->records, (size_t)capacity * sizeof(LogRecord));
+            if (!grown) {
+                break;
+            }
+            log->records = grown;
+        }
+    }
+    fclose(in);
+    if (!log->records || !log->clocks || log->clockCount == 0) {
+        fprintf(stderr, "%s is truncated or too large to load\n", path);
+        free(log->records);
+        free(log->clocks);
+        return false;
+    }
+    return true;
+}
+
+// Records from different threads interleave in drain order; sort by time
+static int CompareRecords(const void* a, const void* b)
+{
+    const LogRecord* left = a;
+    const LogRecord* right = b;
+    if (left->ticks != right->ticks) {
+        return left->ticks < right->ticks ? -1 : 1;
+    }
+    return (int)left->thread - (int)right->thread;
+}
+
+// Monotonic nanoseconds at a tick count, interpolated between clock records
+static uint64_t TicksToNs(const LogFile* log, uint64_t ticks)
+{
+    if (log->clockCount == 1) {
+        return log->clocks[0].monotonicNs + (ticks - log->clocks[0].ticks);
+    }
+    int low = 0, high = log->clockCount - 2;
+    while (low < high) {
+        int mid = (low + high + 1) / 2;
+        if (log->clocks[mid].ticks <= ticks) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    const ClockPoint* a = &log->clocks[low];
+    const ClockPoint* b = &log->clocks[low + 1];
+    double rate = (double)(b->monotonicNs - a->monotonicNs) / (double)(b->ticks - a->ticks);
+    return a->monotonicNs + (uint64_t)(int64_t)((double)(int64_t)(ticks - a->ticks) * rate);
+}
+
+// printf the record's arguments through its format, one conversion at a time
+static void PrintMessage(const LogRecord* record)
+{
+    const char* format = Logger_MessageFormat(record->message);
+    if (!format) {
+        printf("unknown message %u", record->message);
+        return;
+    }
+    int arg = 0;
+    for (const char* c = format; *c; c++) {
+        if (*c != '%') {
+            putchar(*c);
+            continue;
+        }
+        if (c[1] == '%') {
+            putchar('%');
+            c++;
+            continue;
+        }
+
+        // Keep flags, width and precision; lengths are replaced by the record's 64 bits
+        char spec[32] = "%";
+        size_t length = 1;
+        c++;
+        while (*c && strchr("-+ #0123456789.", *c) && length < sizeof(spec) - 4) {
+            spec[length++] = *c++;
+        }
+        while (*c && strchr("hlLqjzt", *c)) {
+            c++;
+        }
+        if (!*c) {
+            break;
+        }
+        if (arg >= record->argCount) {
+            printf("<missing>");
+            continue;
+        }
+        uint64_t value = record->args[arg++];
+        if (strchr("diouxX", *c)) {
+            spec[length++] = 'l';
+            spec[length++] = 'l';
+            spec[length++] = *c;
+            spec[length] = '\0';
+            if (*c == 'd' || *c == 'i') {
+                printf(spec, (long long)(int64_t)value);
+            } else {
+                printf(spec, (unsigned long long)value);
+            }
+        } else if (strchr("fFeEgGaA", *c)) {
+            spec[length++] = *c;
+            spec[length] = '\0';
+            double number;
+            memcpy(&number, &value, sizeof(number));
+            printf(spec, number);
+        } else if (*c == 'c') {
+            putchar((int)value);
+        } else {
+            printf("<%c?>", *c);
+        }
+    }
+}
+
+static int RunDecode(const LogsOptions* options)
+{
+    static LogFile log;
+    if (!LoadLog(options->file, &log)) {
+        return 1;
+    }
+    qsort(log.records, (size_t)log.recordCount, sizeof(LogRecord), CompareRecords);
+
+    uint64_t startNs = log.clocks[0].monotonicNs;
+    long counts[LOG_MSG_COUNT] = { 0 };
+    long threadCounts[UINT8_MAX + 1] = { 0 };
+    for (long i = 0; i < log.recordCount; i++) {
+        const LogRecord* record = &log.records[i];
+        double seconds = (double)(int64_t)(TicksToNs(&log, record->ticks) - startNs) / 1e9;
+        const char* thread = log.threads[record->thread][0] ? log.threads[record->thread] : "?";
+
+        if (record->message == LOGGER_RECORD_DROPPED) {
+            if (!options->stats) {
+                printf("%12.6f %-10s WARN  %llu records dropped (ring full)\n", seconds, thread,
+                       (unsigned long long)record->args[0]);
+            }
+            continue;
+        }
+        int level = Logger_MessageLevel(record->message);
+        if (level < options->minLevel) {
+            continue;
+        }
+        if (record->message < LOG_MSG_COUNT) {
+            counts[record->message]++;
+        }
+        threadCounts[record->thread]++;
+        if (!options->stats) {
+            printf("%12.6f %-10s %-5s ", seconds, thread, Logger_LevelName(level));
+            PrintMessage(record);
+            putchar('\n');
+        }
+    }
+
+    if (options->stats) {
+        const ClockPoint* last = &log.clocks[log.clockCount - 1];
+        time_t wall = (time_t)(log.clocks[0].wallNs / 1000000000ull);
+        char started[64];
+        strftime(started, sizeof(started), "%Y-%m-%d %H:%M:%S", localtime(&wall));
+        printf("%ld records over %.3f s, started %s\n", log.recordCount,
+               (double)(last->monotonicNs - startNs) / 1e9, started);
+        for (int m = 0; m < LOG_MSG_COUNT; m++) {
+            if (counts[m]) {
+                printf("  %-20s %-5s %10ld\n", Logger_MessageName(m),
+                       Logger_LevelName(Logger_MessageLevel(m)), counts[m]);
+            }
+        }
+        for (int t = 0; t <= UINT8_MAX; t++) {
+            if (threadCounts[t] || log.dropped[t]) {
+                printf("  thread %-12s %10ld records, %llu dropped\n", log.threads[t][0] ? log.threads[t] : "?",
+                       threadCounts[t], (unsigned long long)log.dropped[t]);
+            }
+        }
+    }
+    free(log.records);
+    free(log.clocks);
+    return 0;
+}
+
+// Time count log calls in bursts the drain thread keeps up with
+static double TimeBursts(uint32_t count, uint32_t burst, bool pause)
+{
+    struct timespec gap = { 0, 1000000L };
+    double busy = 0.0;
+    for (uint32_t done = 0; done < count; done += burst) {
+        double start = NowSeconds();
+        for (uint32_t i = 0; i < burst; i++) {
+            LOG_EVENT(BENCH_SAMPLE, done + i, (int)count, (double)i * 0.5);
+        }
+        busy += NowSeconds() - start;
+        if (pause) {
+            nanosleep(&gap, NULL);
+        }
+    }
+    return busy * 1e9 / (double)count;
+}
+
+static int RunBench(const LogsOptions* options)
+{
+    uint32_t count = options->count;
+    uint32_t burst = 512;
+    count = (count + burst - 1) / burst * burst;
+
+    // Before Logger_Start this thread has no ring: the disabled cost
+    double disabled = TimeBursts(count, burst, false);
+
+    // The timestamp is usually most of an enabled call
+    volatile uint64_t ticks = 0;
+    double start = NowSeconds();
+    for (uint32_t i = 0; i < count; i++) {
+        ticks += Logger_Ticks();
+    }
+    double timestamp = (NowSeconds() - start) * 1e9 / (double)count;
+    (void)ticks;
+
+    // Formatting the same text, which the hot path avoids
+    char text[128];
+    volatile size_t sink = 0;
+    start = NowSeconds();
+    for (uint32_t i = 0; i < count; i++) {
+        sink += (size_t)snprintf(text, sizeof(text), "bench sample %u of %d, value %.3f",
+                                 i, (int)count, (double)i * 0.5);
+    }
+    double formatting = (NowSeconds() - start) * 1e9 / (double)count;
+    (void)sink;
+
+    if (!Logger_Start(options->file)) {
+        fprintf(stderr, "Cannot write %s\n", options->file);
+        return 1;
+    }
+    uint64_t droppedBefore = atomic_load(&loggerRing->dropped);
+    double drained = TimeBursts(count, burst, true);
+    uint64_t droppedPaced = atomic_load(&loggerRing->dropped) - droppedBefore;
+
+    // Flat out, far faster than a 5 ms drain: most calls find the ring full
+    double flooded = TimeBursts(count, count, false);
+    uint64_t droppedFlood = atomic_load(&loggerRing->dropped) - droppedBefore - droppedPaced;
+
+    // Below LOGGER_MIN_LEVEL the call is compiled out entirely
+    start = NowSeconds();
+    for (uint32_t i = 0; i < count; i++) {
+        LOG_EVENT(BLOCKS_CLEARED, (int)i, 0, 0);
+    }
+    double filtered = (NowSeconds() - start) * 1e9 / (double)count;
+    Logger_Stop();
+
+    printf("%u calls of a 3-argument message\n", count);
+    printf("  unregistered thread   %6.2f ns/call\n", disabled);
+    printf("  logged, ring drained  %6.2f ns/call (%llu dropped)\n", drained, (unsigned long long)droppedPaced);
+    printf("  logged, ring full     %6.2f ns/call (%llu of %u dropped)\n", flooded,
+           (unsigned long long)droppedFlood, count);
+    printf("  %-21s %6.2f ns/call\n", LOG_LEVEL_OF_BLOCKS_CLEARED >= LOGGER_MIN_LEVEL ?
+           "debug, enabled" : "debug, compiled out", filtered);
+    printf("  timestamp alone       %6.2f ns/call\n", timestamp);
+    printf("  snprintf of the text  %6.2f ns/call\n", formatting);
+    return 0;
+}
+
+// Case-insensitive match against an upper-case level name
+static bool SameLevelName(const char* name, const char* levelName)
+{
+    while (*name && toupper((unsigned char)*name) == *levelName) {
+        name++;
+        levelName++;
+    }
+    return *name == '\0' && *levelName == '\0';
+}
+
+static void PrintUsage(const char* program)
+{
+    printf("Usage: %s <command> [options]\n", program);
+    printf("  decode FILE       Print a binary log as text, in time order\n");
+    printf("    --level L       Lowest level shown: debug, info, warn, error (default debug)\n");
+    printf("    --stats         Counts per message and thread instead of the text\n");
+    printf("  bench             Cost of a log call, enabled, full, filtered and disabled\n");
+    printf("    --count N       Calls per case (default 1000000)\n");
+    printf("    --file F        Log written during the bench (default /dev/null)\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    LogsOptions options = {
+        .file = NULL,
+        .minLevel = LOGGER_DEBUG,
+        .stats = false,
+        .count = 1000000,
+    };
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            options.minLevel = -1;
+            for (int level = LOGGER_DEBUG; level <= LOGGER_ERROR; level++) {
+                const char* levelName = Logger_LevelName(level);
+                if (SameLevelName(name, levelName)) {
+                    options.minLevel = level;
+                }
+            }
+            if (options.minLevel < 0) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            options.stats = true;
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            options.count = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+            options.file = argv[++i];
+        } else if (argv[i][0] != '-' && !options.file) {
+            options.file = argv[i];
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.count == 0) {
+        options.count = 1;
+    }
+
+    if (strcmp(argv[1], "decode") == 0 && options.file) {
+        return RunDecode(&options);
+    } else if (strcmp(argv[1], "bench") == 0) {
+        if (!options.file) {
+            options.file = "/dev/null";
+        }
+        return RunBench(&options);
+    }
+    PrintUsage(argv[0]);
+    return 1;
+}
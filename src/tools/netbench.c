@@ -0,0 +1,706 @@
+#define _POSIX_C_SOURCE 200809L
+#include "link_emulator.h"
+#include "metrics.h"
+#include "replay_archive.h"
+#include "transport.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Size of the large reliable message sent now and then (fragmented)
+#define KEYFRAME_BYTES 4096
+
+// Stand-in for a player input message
+typedef struct {
+    uint32_t index;
+    uint8_t payload[12];
+} InputMessage;
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Receiving side bookkeeping
+typedef struct {
+    uint32_t nextInput;             // Expected index of the next reliable input
+    uint64_t inputs;
+    uint64_t keyframes;
+    uint64_t deltas;
+    uint64_t outOfOrder;
+} Receiver;
+
+static void OnMessage(void* context, TransportMessageKind kind, int channel,
+                      const uint8_t* data, size_t length)
+{
+    Receiver* receiver = (Receiver*)context;
+    (void)channel;
+
+    if (kind == TRANSPORT_MESSAGE_UNRELIABLE) {
+        receiver->deltas++;
+    } else if (length == KEYFRAME_BYTES) {
+        receiver->keyframes++;
+    } else if (length == sizeof(InputMessage)) {
+        InputMessage input;
+        memcpy(&input, data, sizeof(input));
+        if (input.index != receiver->nextInput) {
+            receiver->outOfOrder++;
+        }
+        receiver->nextInput = input.index + 1;
+        receiver->inputs++;
+    }
+}
+
+static void IgnoreMessage(void* context, TransportMessageKind kind, int channel,
+                          const uint8_t* data, size_t length)
+{
+    (void)context; (void)kind; (void)channel; (void)data; (void)length;
+}
+
+static int OpenLoopback(struct sockaddr_in* address)
+{
+    memset(address, 0, sizeof(*address));
+    address->sin_family = AF_INET;
+    address->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int fd = UdpLink_OpenSocket((struct sockaddr*)address, sizeof(*address));
+    socklen_t length = sizeof(*address);
+    if (fd >= 0) {
+        getsockname(fd, (struct sockaddr*)address, &length);
+    }
+    return fd;
+}
+
+// Push reliable inputs, latest-wins deltas and periodic fragmented keyframes
+// from one transport to another over loopback UDP
+static int RunLoopback(int seconds)
+{
+    static Transport sender, receiver;
+    static uint8_t keyframe[KEYFRAME_BYTES];
+    Receiver stats = { 0 };
+
+    struct sockaddr_in senderAddress, receiverAddress;
+    int senderSocket = OpenLoopback(&senderAddress);
+    int receiverSocket = OpenLoopback(&receiverAddress);
+    if (senderSocket < 0 || receiverSocket < 0) {
+        perror("loopback socket");
+        return 1;
+    }
+
+    UdpLink senderLink, receiverLink;
+    UdpLink_Init(&senderLink, senderSocket, (struct sockaddr*)&receiverAddress, sizeof(receiverAddress));
+    UdpLink_Init(&receiverLink, receiverSocket, (struct sockaddr*)&senderAddress, sizeof(senderAddress));
+    if (!Transport_Init(&sender, UdpLink_Send, &senderLink, IgnoreMessage, NULL) ||
+        !Transport_Init(&receiver, UdpLink_Send, &receiverLink, OnMessage, &stats)) {
+        fprintf(stderr, "Out of memory\n");
+        Transport_Destroy(&sender);
+        close(senderSocket);
+        close(receiverSocket);
+        return 1;
+    }
+
+    InputMessage input = { 0, { 0 } };
+    uint8_t delta[200] = { 0 };
+    uint64_t iterations = 0, keyframesQueued = 0;
+    double start = NowSeconds();
+    double now = start;
+
+    while (now - start < seconds) {
+        // Keep a keyframe in flight every few hundred iterations, inputs otherwise
+        if (iterations % 256 == 0 && Transport_SendReliable(&sender, keyframe, sizeof(keyframe))) {
+            keyframesQueued++;
+        }
+        while (Transport_ReliableCapacity(&sender) > 0 &&
+               Transport_SendReliable(&sender, &input, sizeof(input))) {
+            input.index++;
+        }
+        Transport_SendUnreliable(&sender, 0, delta, sizeof(delta));
+
+        Transport_Update(&sender, now);
+        UdpLink_Poll(&receiverLink, &receiver, NowSeconds());
+        Transport_Update(&receiver, NowSeconds());
+        UdpLink_Poll(&senderLink, &sender, NowSeconds());
+
+        iterations++;
+        now = NowSeconds();
+    }
+    double elapsed = now - start;
+
+    const TransportStats* sent = &sender.stats;
+    uint64_t messages = stats.inputs + stats.keyframes + stats.deltas;
+    printf("loopback %.2f s\n", elapsed);
+    printf("delivered:  %.0f msgs/s (%.0f reliable inputs/s, %.0f unreliable/s, %.1f keyframes/s)\n",
+           (double)messages / elapsed, (double)stats.inputs / elapsed,
+           (double)stats.deltas / elapsed, (double)stats.keyframes / elapsed);
+    printf("datagrams:  %.0f/s, %.1f messages per datagram, %.1f MB/s\n",
+           (double)sent->packetsSent / elapsed,
+           sent->packetsSent ? (double)messages / (double)sent->packetsSent : 0.0,
+           (double)sent->bytesSent / elapsed / 1e6);
+    printf("reliable:   %lu resends, %lu out of order, %lu of %lu keyframes delivered\n",
+           (unsigned long)sent->resends, (unsigned long)stats.outOfOrder,
+           (unsigned long)stats.keyframes, (unsigned long)keyframesQueued);
+    printf("rtt:        %.1f us (jitter %.1f us), %lu lost, %lu stale dropped\n",
+           sender.rtt * 1e6, sender.jitter * 1e6,
+           (unsigned long)sent->packetsLost, (unsigned long)receiver.stats.staleDropped);
+
+    Transport_Destroy(&sender);
+    Transport_Destroy(&receiver);
+    close(senderSocket);
+    close(receiverSocket);
+    return stats.outOfOrder ? 1 : 0;
+}
+
+// --- Emulated network scenarios ---
+
+#define MAX_SCENARIO_PHASES 3
+
+// Link conditions that switch at given times (applied to both directions)
+typedef struct {
+    double start;
+    LinkConditions conditions;
+} ScenarioPhase;
+
+typedef struct {
+    const char* name;
+    const char* description;
+    int phaseCount;
+    ScenarioPhase phases[MAX_SCENARIO_PHASES];
+} Scenario;
+
+// One-way conditions: latency, jitter, loss, duplicate, reorder, reorderDelay, bandwidth, queueLimit
+static const Scenario SCENARIOS[] = {
+    { "lan", "1 ms RTT", 1,
+      { { 0.0, { 0.0005, 0.0001, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 } } } },
+    { "broadband", "30 ms RTT, 0.5% loss", 1,
+      { { 0.0, { 0.015, 0.002, 0.005, 0.0, 0.0, 0.0, 0.0, 0.0 } } } },
+    { "wan-150-5", "150 ms RTT, 5% loss", 1,
+      { { 0.0, { 0.075, 0.005, 0.05, 0.0, 0.0, 0.0, 0.0, 0.0 } } } },
+    { "mobile", "120 ms RTT, 25 ms jitter, 3% loss, dup/reorder, 64 KB/s", 1,
+      { { 0.0, { 0.060, 0.025, 0.03, 0.01, 0.03, 0.040, 65536.0, 0.2 } } } },
+    { "congested", "80 ms RTT, 2% loss, 8 KB/s bottleneck", 1,
+      { { 0.0, { 0.040, 0.010, 0.02, 0.0, 0.0, 0.0, 8192.0, 0.25 } } } },
+    { "spike", "broadband with a 5 s 500 ms / 15% loss spike at 20 s", 3,
+      { { 0.0,  { 0.015, 0.002, 0.005, 0.0, 0.0, 0.0, 0.0, 0.0 } },
+        { 20.0, { 0.250, 0.030, 0.15, 0.0, 0.0, 0.0, 0.0, 0.0 } },
+        { 25.0, { 0.015, 0.002, 0.005, 0.0, 0.0, 0.0, 0.0, 0.0 } } } }
+};
+#define SCENARIO_COUNT ((int)(sizeof(SCENARIOS) / sizeof(SCENARIOS[0])))
+
+static const Scenario* FindScenario(const char* name)
+{
+    for (int i = 0; i < SCENARIO_COUNT; i++) {
+        if (strcmp(SCENARIOS[i].name, name) == 0) {
+            return &SCENARIOS[i];
+        }
+    }
+    return NULL;
+}
+
+static const LinkConditions* ScenarioConditions(const Scenario* scenario, double now)
+{
+    const LinkConditions* conditions = &scenario->phases[0].conditions;
+    for (int i = 1; i < scenario->phaseCount; i++) {
+        if (now >= scenario->phases[i].start) {
+            conditions = &scenario->phases[i].conditions;
+        }
+    }
+    return conditions;
+}
+
+// Snapshots kept for rollback (ticks); bounds the prediction window
+#define ROLLBACK_WINDOW 128
+
+// Input latency histogram buckets (frames)
+#define LATENCY_BUCKETS 256
+
+// Give up on a match that takes this many times its length to finish
+#define MATCH_TIME_LIMIT 4
+
+// Reliable input message: tick (4), frame sampled (4), x, y, flags
+#define INPUT_MESSAGE_SIZE 11
+
+// Scripted stand-in for a player: a swap every few ticks, an occasional raise
+// or incoming garbage
+static GameInput BotInput(uint64_t seed, uint32_t tick, int player)
+{
+    GameInput input = { 0, 0, 0 };
+    Rng rng;
+    Rng_Seed(&rng, seed ^ ((uint64_t)tick << 1), (uint64_t)player);
+    if (Rng_Range(&rng, 8) == 0) {
+        input.x = (uint8_t)Rng_Range(&rng, BOARD_WIDTH - 1);
+        input.y = (uint8_t)Rng_Range(&rng, BOARD_HEIGHT);
+        uint32_t action = Rng_Range(&rng, 100);
+        if (action < 2) {
+            input.flags = GAME_INPUT_RAISE;
+        } else if (action < 3) {
+            // An attack from the other side: a slab two to six wide, one or two tall
+            input.x = (uint8_t)(1 + Rng_Range(&rng, BOARD_WIDTH - 1));
+            input.y = (uint8_t)Rng_Range(&rng, 2);
+            input.flags = GAME_INPUT_GARBAGE;
+        } else {
+            input.flags = GAME_INPUT_SWAP;
+        }
+    }
+    return input;
+}
+
+// One side of a rollback match: simulates both boards, predicting that the
+// remote player does nothing until their input arrives, and stalling when
+// the prediction would run more than maxPrediction ticks ahead
+typedef struct {
+    int index;                      // Player this peer controls
+    uint64_t seed;
+    uint32_t inputDelay;            // Ticks between sampling and applying local input
+    uint32_t maxPrediction;
+    uint32_t matchTicks;
+    uint32_t frame;                 // Wall-clock frames so far (both peers share the clock)
+    Transport transport;
+    ReplaySim sim;
+    ReplaySim* snapshots;           // State before each of the last ROLLBACK_WINDOW ticks
+    GameInput* localInputs;
+    uint32_t* sampledFrame;         // Frame each local input was sampled on
+    GameInput* remoteInputs;
+    bool* remoteKnown;
+    uint32_t nextLocal;             // Next tick to sample local input for
+    uint32_t nextSend;              // Next local input to hand to the transport
+    uint32_t confirmed;             // Remote input known for every tick before this
+    uint32_t rollbackFrom;          // Earliest mispredicted tick (UINT32_MAX = none)
+
+    // Experience
+    uint64_t rollbacks;
+    uint64_t rollbackTicks;
+    uint32_t maxRollback;
+    uint64_t stalls;                // Frames the simulation waited for the remote
+    uint64_t inputsReceived;
+    uint64_t lateInputs;            // Arrived after their tick was simulated
+    uint64_t latency[LATENCY_BUCKETS];  // Frames from sampling to arrival
+} Peer;
+
+static void Peer_OnMessage(void* context, TransportMessageKind kind, int channel,
+                           const uint8_t* data, size_t length)
+{
+    Peer* peer = (Peer*)context;
+    (void)channel;
+    if (kind != TRANSPORT_MESSAGE_RELIABLE || length != INPUT_MESSAGE_SIZE) {
+        return;
+    }
+
+    uint32_t tick, sampled;
+    memcpy(&tick, data, sizeof(tick));
+    memcpy(&sampled, data + 4, sizeof(sampled));
+    if (tick >= peer->matchTicks || peer->remoteKnown[tick]) {
+        return;
+    }
+    GameInput input = { data[8], data[9], data[10] };
+    peer->remoteInputs[tick] = input;
+    peer->remoteKnown[tick] = true;
+    peer->inputsReceived++;
+    while (peer->confirmed < peer->matchTicks && peer->remoteKnown[peer->confirmed]) {
+        peer->confirmed++;
+    }
+
+    uint32_t frames = peer->frame - sampled;
+    peer->latency[frames < LATENCY_BUCKETS ? frames : LATENCY_BUCKETS - 1]++;
+
+    if (tick < peer->sim.tick) {
+        peer->lateInputs++;
+        // Predicted "no input"; only an actual action needs a rollback
+        if (input.flags != 0 && tick < peer->rollbackFrom) {
+            peer->rollbackFrom = tick;
+        }
+    }
+}
+
+static void Peer_StepTick(Peer* peer)
+{
+    uint32_t tick = peer->sim.tick;
+    GameInput inputs[REPLAY_PLAYERS];
+    GameInput none = { 0, 0, 0 };
+
+    inputs[peer->index] = peer->localInputs[tick];
+    inputs[1 - peer->index] = peer->remoteKnown[tick] ? peer->remoteInputs[tick] : none;
+
+    memcpy(&peer->snapshots[tick % ROLLBACK_WINDOW], &peer->sim, sizeof(ReplaySim));
+    ReplaySim_Step(&peer->sim, inputs);
+}
+
+static bool Peer_Finished(const Peer* peer)
+{
+    return peer->sim.tick == peer->matchTicks && peer->confirmed == peer->matchTicks &&
+           peer->rollbackFrom == UINT32_MAX;
+}
+
+static void Peer_Frame(Peer* peer, double now)
+{
+    // Re-simulate from the first mispredicted tick with the inputs now known
+    if (peer->rollbackFrom != UINT32_MAX) {
+        uint32_t current = peer->sim.tick;
+        uint32_t depth = current - peer->rollbackFrom;
+        memcpy(&peer->sim, &peer->snapshots[peer->rollbackFrom % ROLLBACK_WINDOW], sizeof(ReplaySim));
+        while (peer->sim.tick < current) {
+            Peer_StepTick(peer);
+        }
+        peer->rollbacks++;
+        Metrics_Count(METRIC_ROLLBACKS, 1);
+        peer->rollbackTicks += depth;
+        if (depth > peer->maxRollback) {
+            peer->maxRollback = depth;
+        }
+        peer->rollbackFrom = UINT32_MAX;
+    }
+
+    if (peer->sim.tick < peer->matchTicks) {
+        if (peer->sim.tick >= peer->confirmed + peer->maxPrediction) {
+            peer->stalls++;
+        } else {
+            // Sample local input for a later tick and send it
+            if (peer->nextLocal < peer->matchTicks) {
+                uint32_t target = peer->nextLocal++;
+                peer->localInputs[target] = BotInput(peer->seed, target, peer->index);
+                peer->sampledFrame[target] = peer->frame;
+            }
+            Peer_StepTick(peer);
+        }
+    }
+
+    // Send sampled inputs; a full reliable window holds the rest for later frames
+    while (peer->nextSend < peer->nextLocal) {
+        uint32_t tick = peer->nextSend;
+        GameInput input = peer->localInputs[tick];
+        uint8_t message[INPUT_MESSAGE_SIZE];
+        memcpy(message, &tick, 4);
+        memcpy(message + 4, &peer->sampledFrame[tick], 4);
+        message[8] = input.x;
+        message[9] = input.y;
+        message[10] = input.flags;
+        if (!Transport_SendReliable(&peer->transport, message, sizeof(message))) {
+            break;
+        }
+        peer->nextSend++;
+    }
+
+    // Latest checksum as a latest-wins message, standing in for desync checks
+    uint8_t status[8];
+    uint32_t checksum = ReplaySim_Checksum(&peer->sim);
+    memcpy(status, &peer->sim.tick, 4);
+    memcpy(status + 4, &checksum, 4);
+    Transport_SendUnreliable(&peer->transport, 0, status, sizeof(status));
+
+    Transport_Update(&peer->transport, now);
+    peer->frame++;
+}
+
+static void DeliverToTransport(void* context, const uint8_t* data, size_t length, double now)
+{
+    Transport_Receive((Transport*)context, data, length, now);
+}
+
+static uint32_t LatencyPercentile(const Peer* a, const Peer* b, double fraction)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        total += a->latency[i] + b->latency[i];
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += a->latency[i] + b->latency[i];
+        if (seen > 0 && (double)seen >= fraction * (double)total) {
+            return (uint32_t)i;
+        }
+    }
+    return LATENCY_BUCKETS - 1;
+}
+
+// Play one bot match between two rollback peers over emulated links, in
+// virtual time, and report what the players would have experienced
+static int RunScenario(const Scenario* scenario, int seconds, uint32_t inputDelay,
+                       uint32_t maxPrediction, uint64_t seed)
+{
+    static Peer peers[REPLAY_PLAYERS];
+    static LinkEmulator links[REPLAY_PLAYERS];   // links[i] carries peer i's datagrams
+    uint32_t matchTicks = (uint32_t)seconds * GAME_TICK_RATE;
+    uint32_t frameLimit = matchTicks * MATCH_TIME_LIMIT;
+
+    for (int i = 0; i < REPLAY_PLAYERS; i++) {
+        Peer* peer = &peers[i];
+        free(peer->snapshots);
+        free(peer->localInputs);
+        free(peer->sampledFrame);
+        free(peer->remoteInputs);
+        free(peer->remoteKnown);
+        memset(peer, 0, sizeof(*peer));
+
+        peer->index = i;
+        peer->seed = seed;
+        peer->inputDelay = inputDelay;
+        peer->maxPrediction = maxPrediction;
+        peer->matchTicks = matchTicks;
+        peer->rollbackFrom = UINT32_MAX;
+        peer->snapshots = malloc(ROLLBACK_WINDOW * sizeof(ReplaySim));
+        peer->localInputs = calloc(matchTicks, sizeof(GameInput));
+        peer->sampledFrame = calloc(matchTicks, sizeof(uint32_t));
+        peer->remoteInputs = calloc(matchTicks, sizeof(GameInput));
+        peer->remoteKnown = calloc(matchTicks, sizeof(bool));
+        if (!peer->snapshots || !peer->localInputs || !peer->sampledFrame || !peer->remoteInputs || !peer->remoteKnown) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        // The first inputDelay ticks have no input on either side
+        for (uint32_t t = 0; t < inputDelay && t < matchTicks; t++) {
+            peer->remoteKnown[t] = true;
+        }
+        peer->confirmed = inputDelay < matchTicks ? inputDelay : matchTicks;
+        peer->nextLocal = peer->confirmed;
+        peer->nextSend = peer->confirmed;
+        ReplaySim_Init(&peer->sim, seed);
+
+        LinkEmulator_Init(&links[i], ScenarioConditions(scenario, 0.0), seed * 2 + (uint64_t)i,
+                          DeliverToTransport, &peers[1 - i].transport);
+    }
+    for (int i = 0; i < REPLAY_PLAYERS; i++) {
+        if (!Transport_Init(&peers[i].transport, LinkEmulator_Send, &links[i], Peer_OnMessage, &peers[i])) {
+            fprintf(stderr, "Out of memory\n");
+            Transport_Destroy(&peers[0].transport);
+            return 1;
+        }
+    }
+
+    uint32_t frame = 0;
+    for (; frame < frameLimit; frame++) {
+        double now = (double)frame / GAME_TICK_RATE;
+        for (int i = 0; i < REPLAY_PLAYERS; i++) {
+            LinkEmulator_SetConditions(&links[i], ScenarioConditions(scenario, now));
+            LinkEmulator_Advance(&links[i], now);
+        }
+        if (Peer_Finished(&peers[0]) && Peer_Finished(&peers[1])) {
+            break;
+        }
+        for (int i = 0; i < REPLAY_PLAYERS; i++) {
+            Peer_Frame(&peers[i], now);
+        }
+    }
+    for (int i = 0; i < REPLAY_PLAYERS; i++) {
+        Transport_Destroy(&peers[i].transport);
+    }
+
+    const Peer* a = &peers[0];
+    const Peer* b = &peers[1];
+    bool finished = Peer_Finished(a) && Peer_Finished(b);
+    bool inSync = finished && ReplaySim_Checksum(&a->sim) == ReplaySim_Checksum(&b->sim);
+    double frameMs = 1000.0 / GAME_TICK_RATE;
+    double wallSeconds = (double)frame / GAME_TICK_RATE;
+    uint64_t rollbacks = a->rollbacks + b->rollbacks;
+    uint64_t inputs = a->inputsReceived + b->inputsReceived;
+    // Transport bytes plus IPv4/UDP headers
+    uint64_t datagrams = a->transport.stats.packetsSent + b->transport.stats.packetsSent;
+    double bytes = (double)(a->transport.stats.bytesSent + b->transport.stats.bytesSent + datagrams * 28) /
+                   REPLAY_PLAYERS;
+
+    printf("%-10s %4.0f-%-4.0f ms %6.1f%% %7.2f/s %5.1f %4u %7.1f%% %7.1f KB %6.1f kbps  %s\n",
+           scenario->name,
+           LatencyPercentile(a, b, 0.5) * frameMs,
+           LatencyPercentile(a, b, 0.95) * frameMs,
+           inputs ? 100.0 * (double)(a->lateInputs + b->lateInputs) / (double)inputs : 0.0,
+           (double)rollbacks / REPLAY_PLAYERS / seconds,
+           rollbacks ? (double)(a->rollbackTicks + b->rollbackTicks) / (double)rollbacks : 0.0,
+           a->maxRollback > b->maxRollback ? a->maxRollback : b->maxRollback,
+           100.0 * (double)(a->stalls + b->stalls) / REPLAY_PLAYERS / matchTicks,
+           bytes / 1024.0,
+           bytes * 8.0 / wallSeconds / 1000.0,
+           !finished ? "unfinished" : inSync ? "ok" : "DESYNC");
+    return inSync ? 0 : 1;
+}
+
+static int RunScenarios(const char* name, int seconds, uint32_t inputDelay,
+                        uint32_t maxPrediction, uint64_t seed)
+{
+    printf("%d s bot match per scenario, input delay %u, max prediction %u ticks, seed %llu\n",
+           seconds, inputDelay, maxPrediction, (unsigned long long)seed);
+    printf("scenario   input p50-p95  late    rollbacks  avg  max   stalled  per player   bandwidth   sync\n");
+
+    int failures = 0;
+    for (int i = 0; i < SCENARIO_COUNT; i++) {
+        if (name && strcmp(name, SCENARIOS[i].name) != 0) {
+            continue;
+        }
+        failures += RunScenario(&SCENARIOS[i], seconds, inputDelay, maxPrediction, seed);
+    }
+    return failures ? 1 : 0;
+}
+
+// Relay datagrams between a local client port and a target port through two
+// emulated links, so separate processes can be tested under a scenario
+typedef struct {
+    int socket;
+    struct sockaddr_in to;
+} RelayTarget;
+
+static void RelayDeliver(void* context, const uint8_t* data, size_t length, double now)
+{
+    RelayTarget* target = (RelayTarget*)context;
+    (void)now;
+    (void)sendto(target->socket, data, length, 0, (struct sockaddr*)&target->to, sizeof(target->to));
+}
+
+static int RunRelay(const Scenario* scenario, int listenPort, int targetPort, uint64_t seed)
+{
+    static LinkEmulator upstream, downstream;
+    struct sockaddr_in listenAddress, upstreamAddress;
+    memset(&listenAddress, 0, sizeof(listenAddress));
+    listenAddress.sin_family = AF_INET;
+    listenAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    listenAddress.sin_port = htons((uint16_t)listenPort);
+    upstreamAddress = listenAddress;
+    upstreamAddress.sin_port = 0;
+
+    int clientSocket = UdpLink_OpenSocket((struct sockaddr*)&listenAddress, sizeof(listenAddress));
+    int serverSocket = UdpLink_OpenSocket((struct sockaddr*)&upstreamAddress, sizeof(upstreamAddress));
+    if (clientSocket < 0 || serverSocket < 0) {
+        perror("relay socket");
+        return 1;
+    }
+
+    // Client -> relay -> target, and replies back to whichever client spoke last
+    RelayTarget toServer = { serverSocket, listenAddress };
+    toServer.to.sin_port = htons((uint16_t)targetPort);
+    RelayTarget toClient = { clientSocket, listenAddress };
+    bool haveClient = false;
+
+    double start = NowSeconds();
+    LinkEmulator_Init(&upstream, ScenarioConditions(scenario, 0.0), seed * 2, RelayDeliver, &toServer);
+    LinkEmulator_Init(&downstream, ScenarioConditions(scenario, 0.0), seed * 2 + 1, RelayDeliver, &toClient);
+    printf("relaying 127.0.0.1:%d -> 127.0.0.1:%d as '%s' (%s)\n",
+           listenPort, targetPort, scenario->name, scenario->description);
+    fflush(stdout);
+
+    uint8_t buffer[TRANSPORT_MTU];
+    struct timespec tick = { 0, 500 * 1000 };
+    for (;;) {
+        double now = NowSeconds() - start;
+        LinkEmulator_SetConditions(&upstream, ScenarioConditions(scenario, now));
+        LinkEmulator_SetConditions(&downstream, ScenarioConditions(scenario, now));
+        upstream.now = now;
+        downstream.now = now;
+
+        struct sockaddr_in from;
+        socklen_t fromLength = sizeof(from);
+        ssize_t length;
+        while ((length = recvfrom(clientSocket, buffer, sizeof(buffer), 0,
+                                  (struct sockaddr*)&from, &fromLength)) > 0) {
+            toClient.to = from;
+            haveClient = true;
+            LinkEmulator_Send(&upstream, buffer, (size_t)length);
+            fromLength = sizeof(from);
+        }
+        while ((length = recv(serverSocket, buffer, sizeof(buffer), 0)) > 0) {
+            if (haveClient) {
+                LinkEmulator_Send(&downstream, buffer, (size_t)length);
+            }
+        }
+
+        LinkEmulator_Advance(&upstream, now);
+        LinkEmulator_Advance(&downstream, now);
+        nanosleep(&tick, NULL);
+    }
+    return 0;
+}
+
+static void PrintUsage(const char* program)
+{
+    printf("Usage: %s <command> [options]\n", program);
+    printf("  loopback          Transport throughput over loopback UDP\n");
+    printf("    --seconds N     Duration (default 3)\n");
+    printf("  scenarios [name]  Rollback bot match over each emulated network scenario\n");
+    printf("    --seconds N     Match length (default 60)\n");
+    printf("    --delay N       Input delay in ticks (default 2)\n");
+    printf("    --prediction N  Ticks a peer may predict ahead before stalling (default 8)\n");
+    printf("    --seed N        Seed for the match and the links (default 1)\n");
+    printf("  relay <name> <listen-port> <target-port>\n");
+    printf("                    Forward loopback UDP through a scenario's links\n");
+    printf("  --metrics-file F  Write packet and rollback counters to F in Prometheus format\n");
+    printf("Scenarios:\n");
+    for (int i = 0; i < SCENARIO_COUNT; i++) {
+        printf("  %-10s  %s\n", SCENARIOS[i].name, SCENARIOS[i].description);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    int seconds = 0;
+    uint32_t inputDelay = 2;
+    uint32_t maxPrediction = 8;
+    uint64_t seed = 1;
+    const char* metricsFile = NULL;
+    const char* positional[3] = { NULL, NULL, NULL };
+    int positionalCount = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--delay") == 0 && i + 1 < argc) {
+            inputDelay = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--prediction") == 0 && i + 1 < argc) {
+            maxPrediction = (uint32_t)atoi(argv[++i]);
+            if (maxPrediction < 1) {
+                maxPrediction = 1;
+            } else if (maxPrediction >= ROLLBACK_WINDOW) {
+                maxPrediction = ROLLBACK_WINDOW - 1;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--metrics-file") == 0 && i + 1 < argc) {
+            metricsFile = argv[++i];
+        } else if (positionalCount < 3) {
+            positional[positionalCount++] = argv[i];
+        }
+    }
+
+    // Counters are recorded by this thread (the peers and transports run on
+    // it); the exporter writes them out when it stops
+    static MetricsExporter exporter;
+    if (metricsFile) {
+        if (!MetricsExporter_Start(&exporter, 0, metricsFile, 1.0)) {
+            fprintf(stderr, "Cannot start the metrics exporter\n");
+            return 1;
+        }
+        Metrics_RegisterThread();
+    }
+
+    int result = -1;
+    if (strcmp(argv[1], "loopback") == 0) {
+        result = RunLoopback(seconds > 0 ? seconds : 3);
+    } else if (strcmp(argv[1], "scenarios") == 0) {
+        if (positional[0] && !FindScenario(positional[0])) {
+            fprintf(stderr, "Unknown scenario '%s'\n", positional[0]);
+            result = 1;
+        } else {
+            result = RunScenarios(positional[0], seconds > 0 ? seconds : 60, inputDelay, maxPrediction, seed);
+        }
+    } else if (strcmp(argv[1], "relay") == 0 && positionalCount == 3) {
+        const Scenario* scenario = FindScenario(positional[0]);
+        if (!scenario) {
+            fprintf(stderr, "Unknown scenario '%s'\n", positional[0]);
+            result = 1;
+        } else {
+            result = RunRelay(scenario, atoi(positional[1]), atoi(positional[2]), seed);
+        }
+    }
+
+    if (metricsFile) {
+        MetricsExporter_Stop(&exporter);
+    }
+    if (result < 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    return result;
+}
@@ -0,0 +1,216 @@
+#define _POSIX_C_SOURCE 200809L
+#include "board_mode.h"
+#include "puzzle_solver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// One letter per color, in BlockType bit order
+static const char COLOR_LETTERS[BLOCK_MAX_TYPE_COUNT] = { 'R', 'B', 'G', 'Y', 'P', 'C' };
+
+typedef struct {
+    const BoardMode* mode;
+    int moves;
+    int maxMoves;
+    int count;
+    int threads;
+    int tableBits;
+    uint64_t seed;
+} PuzzleOptions;
+
+static void PrintBoard(const GameBoard* board)
+{
+    const BoardMode* mode = BoardMode_Of(board);
+    for (int y = 0; y < mode->height; y++) {
+        printf("  %2d ", y);
+        for (int x = 0; x < mode->width; x++) {
+            BlockType type = BLOCK_TYPE(board->grid[y * mode->width + x]);
+            putchar(type == BLOCK_EMPTY ? '.' : COLOR_LETTERS[__builtin_ctz(type)]);
+        }
+        putchar('\n');
+    }
+}
+
+// Play the solution on a copy of the board; it must end empty
+static bool CheckSolution(const GameBoard* board, const PuzzleSolution* solution)
+{
+    GameBoard work = *board;
+    for (int i = 0; i < solution->moveCount; i++) {
+        if (!Puzzle_ApplyMove(&work, solution->moves[i])) {
+            return false;
+        }
+    }
+    for (int i = 0; i < BOARD_MAX_SIZE; i++) {
+        if (BLOCK_TYPE(work.grid[i]) != BLOCK_EMPTY) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static double HitRate(const PuzzleSolution* solution)
+{
+    return solution->tableProbes ? 100.0 * (double)solution->tableHits / (double)solution->tableProbes : 0.0;
+}
+
+static int RunShow(PuzzleSolver* solver, const PuzzleOptions* options)
+{
+    GameBoard board;
+    Puzzle_Generate(&board, (BoardModeId)options->mode->id, options->moves, options->seed);
+    printf("%s puzzle, seed %llu, %d moves:\n", options->mode->name,
+           (unsigned long long)options->seed, options->moves);
+    PrintBoard(&board);
+
+    PuzzleSolution solution;
+    if (!PuzzleSolver_Solve(solver, &board, options->maxMoves, &solution)) {
+        printf("no solution in %d moves (%llu nodes, %.3f s)\n", options->maxMoves,
+               (unsigned long long)solution.nodes, solution.seconds);
+        return 1;
+    }
+
+    printf("solved in %d moves:", solution.moveCount);
+    for (int i = 0; i < solution.moveCount; i++) {
+        printf(" (%d,%d)", solution.moves[i].x, solution.moves[i].y);
+    }
+    printf("\n%llu nodes in %.3f s (%.2f M nodes/s), table hit rate %.1f%%\n",
+           (unsigned long long)solution.nodes, solution.seconds,
+           (double)solution.nodes / solution.seconds / 1e6, HitRate(&solution));
+    if (!CheckSolution(&board, &solution)) {
+        printf("solution does not clear the board\n");
+        return 2;
+    }
+    return 0;
+}
+
+static int RunBench(PuzzleSolver* solver, const PuzzleOptions* options)
+{
+    uint64_t nodes = 0, probes = 0, hits = 0;
+    double seconds = 0.0, slowest = 0.0;
+    int solved = 0, failed = 0;
+    int lengths[PUZZLE_MAX_MOVES + 1] = { 0 };
+
+    printf("%d %s puzzles of %d moves on %d threads\n", options->count, options->mode->name,
+           options->moves, solver->threads);
+    for (int i = 0; i < options->count; i++) {
+        GameBoard board;
+        uint64_t seed = options->seed + (uint64_t)i;
+        Puzzle_Generate(&board, (BoardModeId)options->mode->id, options->moves, seed);
+
+        PuzzleSolution solution;
+        bool ok = PuzzleSolver_Solve(solver, &board, options->maxMoves, &solution);
+        if (ok && !CheckSolution(&board, &solution)) {
+            printf("seed %llu: solution does not clear the board\n", (unsigned long long)seed);
+            ok = false;
+        }
+        if (ok) {
+            solved++;
+            lengths[solution.moveCount]++;
+        } else {
+            failed++;
+        }
+
+        nodes += solution.nodes;
+        probes += solution.tableProbes;
+        hits += solution.tableHits;
+        seconds += solution.seconds;
+        if (solution.seconds > slowest) {
+            slowest = solution.seconds;
+        }
+    }
+
+    printf("solved %d, failed %d; solution lengths:", solved, failed);
+    for (int m = 1; m <= options->maxMoves; m++) {
+        if (lengths[m]) {
+            printf(" %d:%d", m, lengths[m]);
+        }
+    }
+    printf("\n%.2f ms per puzzle (slowest %.2f ms), %.2f M nodes/s, table hit rate %.1f%%\n",
+           seconds * 1e3 / options->count, slowest * 1e3, (double)nodes / seconds / 1e6,
+           probes ? 100.0 * (double)hits / (double)probes : 0.0);
+    return failed ? 2 : 0;
+}
+
+static void PrintUsage(const char* program)
+{
+    printf("Usage: %s <command> [options]\n", program);
+    printf("  show              Generate a puzzle, print it and its shortest solution\n");
+    printf("  bench             Generate and solve a batch of puzzles\n");
+    printf("    --mode NAME     Board mode (default classic)\n");
+    printf("    --moves N       Moves the generated puzzles take (default 5)\n");
+    printf("    --max-moves N   Longest solution searched for (default --moves)\n");
+    printf("    --count N       Puzzles to solve in bench (default 100)\n");
+    printf("    --threads N     Solver threads (default: online cores)\n");
+    printf("    --table-bits N  log2 of transposition table entries (default %d)\n", PUZZLE_TABLE_BITS);
+    printf("    --seed N        Seed of the (first) puzzle (default 1)\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    PuzzleOptions options = {
+        .mode = BoardMode_Get(BOARD_MODE_CLASSIC),
+        .moves = 5,
+        .maxMoves = 0,
+        .count = 100,
+        .threads = (int)sysconf(_SC_NPROCESSORS_ONLN),
+        .tableBits = PUZZLE_TABLE_BITS,
+        .seed = 1,
+    };
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+            options.mode = BoardMode_Find(argv[++i]);
+            if (!options.mode) {
+                fprintf(stderr, "Unknown mode '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--moves") == 0 && i + 1 < argc) {
+            options.moves = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-moves") == 0 && i + 1 < argc) {
+            options.maxMoves = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            options.count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--table-bits") == 0 && i + 1 < argc) {
+            options.tableBits = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.moves < 1 || options.moves > PUZZLE_MAX_MOVES) {
+        options.moves = options.moves < 1 ? 1 : PUZZLE_MAX_MOVES;
+    }
+    if (options.maxMoves < 1 || options.maxMoves > PUZZLE_MAX_MOVES) {
+        options.maxMoves = options.moves;
+    }
+    if (options.count < 1) {
+        options.count = 1;
+    }
+
+    PuzzleSolver solver;
+    if (!PuzzleSolver_Init(&solver, options.tableBits, options.threads)) {
+        fprintf(stderr, "Cannot allocate the transposition table\n");
+        return 1;
+    }
+
+    int result;
+    if (strcmp(argv[1], "show") == 0) {
+        result = RunShow(&solver, &options);
+    } else if (strcmp(argv[1], "bench") == 0) {
+        result = RunBench(&solver, &options);
+    } else {
+        PrintUsage(argv[0]);
+        result = 1;
+    }
+
+    PuzzleSolver_Free(&solver);
+    return result;
+}
@@ -0,0 +1,215 @@
+#define _POSIX_C_SOURCE 200809L
+#include "replay_archive.h"
+#include "rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Scripted stand-in for players: a swap every few ticks, an occasional raise
+// or incoming garbage
+static void BotInputs(uint64_t seed, uint32_t tick, GameInput inputs[REPLAY_PLAYERS])
+{
+    for (int p = 0; p < REPLAY_PLAYERS; p++) {
+        Rng rng;
+        Rng_Seed(&rng, seed ^ ((uint64_t)tick << 1), (uint64_t)p);
+        inputs[p].x = 0;
+        inputs[p].y = 0;
+        inputs[p].flags = 0;
+        if (Rng_Range(&rng, 8) != 0) {
+            continue;
+        }
+        inputs[p].x = (uint8_t)Rng_Range(&rng, BOARD_WIDTH - 1);
+        inputs[p].y = (uint8_t)Rng_Range(&rng, BOARD_HEIGHT);
+        uint32_t action = Rng_Range(&rng, 100);
+        if (action < 2) {
+            inputs[p].flags = GAME_INPUT_RAISE;
+        } else if (action < 3) {
+            // An attack from the other side: a slab two to six wide, one or two tall
+            inputs[p].x = (uint8_t)(1 + Rng_Range(&rng, BOARD_WIDTH - 1));
+            inputs[p].y = (uint8_t)Rng_Range(&rng, 2);
+            inputs[p].flags = GAME_INPUT_GARBAGE;
+        } else {
+            inputs[p].flags = GAME_INPUT_SWAP;
+        }
+    }
+}
+
+// Simulate bot matches and append them to an archive
+static int Record(const char* path, int matches, int minutes, uint32_t interval)
+{
+    ReplayWriter writer;
+    if (!ReplayWriter_Open(&writer, path)) {
+        fprintf(stderr, "Cannot open %s for writing\n", path);
+        return 1;
+    }
+
+    static ReplaySim sim;
+    uint32_t ticks = (uint32_t)minutes * 60u * GAME_TICK_RATE;
+    double start = NowSeconds();
+
+    for (int m = 0; m < matches; m++) {
+        uint64_t seed = (uint64_t)time(NULL) * 7919u + (uint64_t)m;
+        ReplaySim_Init(&sim, seed);
+        const GameState* players[REPLAY_PLAYERS] = { &sim.players[0], &sim.players[1] };
+
+        ReplayWriter_BeginMatch(&writer, (uint32_t)m, seed, interval, players);
+        for (uint32_t t = 0; t < ticks; t++) {
+            GameInput inputs[REPLAY_PLAYERS];
+            BotInputs(seed, t, inputs);
+            ReplaySim_Step(&sim, inputs);
+            ReplayWriter_AddTick(&writer, inputs, players);
+        }
+        if (!ReplayWriter_EndMatch(&writer, players)) {
+            fprintf(stderr, "Failed to write match %d\n", m);
+            ReplayWriter_Close(&writer);
+            return 1;
+        }
+    }
+
+    printf("Recorded %d matches of %u ticks in %.2f s\n", matches, ticks, NowSeconds() - start);
+    ReplayWriter_Close(&writer);
+    return 0;
+}
+
+static int Info(const char* path)
+{
+    ReplayArchive archive;
+    if (!ReplayArchive_Open(&archive, path)) {
+        fprintf(stderr, "Cannot open archive %s\n", path);
+        return 1;
+    }
+
+    printf("%d matches, %zu bytes\n", archive.matchCount, archive.size);
+    if (ReplayArchive_IsTruncated(&archive)) {
+        printf("truncated: header lists %d matches, %zu bytes after the last whole block\n",
+               archive.indexedCount, archive.tailBytes);
+    }
+    printf("   match              seed     ticks  keyframes  interval  scores\n");
+    for (int i = 0; i < archive.matchCount; i++) {
+        ReplayView view;
+        if (!ReplayArchive_GetMatch(&archive, i, &view)) {
+            printf("%8d  (malformed)\n", i);
+            continue;
+        }
+        printf("%8u  %16llx  %8u  %9u  %8u  %d / %d\n",
+               view.matchId, (unsigned long long)view.seed, view.tickCount,
+               view.keyframeCount, view.keyframeInterval, view.finalScores[0], view.finalScores[1]);
+    }
+    ReplayArchive_Close(&archive);
+    return 0;
+}
+
+static int CompareDoubles(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Random seeks across every match; each result is checked against the
+// recorded checksum for that tick
+static int SeekBench(const char* path, int seeks)
+{
+    double openStart = NowSeconds();
+    ReplayArchive archive;
+    if (!ReplayArchive_Open(&archive, path) || archive.matchCount == 0) {
+        fprintf(stderr, "Cannot open archive %s (or it is empty)\n", path);
+        return 1;
+    }
+    double openTime = NowSeconds() - openStart;
+
+    static ReplaySim sim;
+    ReplaySim_Init(&sim, 0);
+    double* latencies = malloc((size_t)seeks * sizeof(double));
+    Rng rng;
+    Rng_Seed(&rng, (uint64_t)time(NULL), 0);
+    int mismatches = 0;
+
+    for (int i = 0; i < seeks; i++) {
+        ReplayView view;
+        int index = (int)Rng_Range(&rng, (uint32_t)archive.matchCount);
+        if (!ReplayArchive_GetMatch(&archive, index, &view) || view.tickCount == 0) {
+            latencies[i] = 0.0;
+            continue;
+        }
+        uint32_t tick = 1 + Rng_Range(&rng, view.tickCount);
+
+        double start = NowSeconds();
+        bool ok = ReplaySim_Seek(&sim, &view, tick);
+        latencies[i] = NowSeconds() - start;
+
+        if (!ok || ReplaySim_Checksum(&sim) != ReplayView_GetChecksum(&view, tick - 1)) {
+            mismatches++;
+        }
+    }
+
+    qsort(latencies, (size_t)seeks, sizeof(double), CompareDoubles);
+    double total = 0.0;
+    for (int i = 0; i < seeks; i++) {
+        total += latencies[i];
+    }
+    printf("open:  %.3f ms (%d matches, %.1f MiB mapped)\n",
+           openTime * 1e3, archive.matchCount, (double)archive.size / (1024.0 * 1024.0));
+    printf("seeks: %d, mean %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us\n",
+           seeks, total / seeks * 1e6, latencies[seeks / 2] * 1e6,
+           latencies[(int)(seeks * 0.99)] * 1e6, latencies[seeks - 1] * 1e6);
+    printf("checksum mismatches: %d\n", mismatches);
+
+    free(latencies);
+    ReplayArchive_Close(&archive);
+    return mismatches ? 1 : 0;
+}
+
+static void PrintUsage(const char* program)
+{
+    printf("Usage: %s <command> <archive> [options]\n", program);
+    printf("  record <archive>  Append simulated bot matches\n");
+    printf("    --matches N     Matches to record (default 4)\n");
+    printf("    --minutes N     Length of each match (default 60)\n");
+    printf("    --interval N    Ticks between keyframes (default %d)\n", REPLAY_KEYFRAME_INTERVAL);
+    printf("  info <archive>    List the matches in an archive\n");
+    printf("  seek <archive>    Time random seeks and check them against recorded checksums\n");
+    printf("    --seeks N       Number of seeks (default 10000)\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    int matches = 4;
+    int minutes = 60;
+    int seeks = 10000;
+    uint32_t interval = REPLAY_KEYFRAME_INTERVAL;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--matches") == 0 && i + 1 < argc) {
+            matches = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--minutes") == 0 && i + 1 < argc) {
+            minutes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            interval = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seeks") == 0 && i + 1 < argc) {
+            seeks = atoi(argv[++i]);
+        }
+    }
+
+    if (strcmp(argv[1], "record") == 0) {
+        return Record(argv[2], matches, minutes, interval);
+    } else if (strcmp(argv[1], "info") == 0) {
+        return Info(argv[2]);
+    } else if (strcmp(argv[1], "seek") == 0) {
+        return SeekBench(argv[2], seeks > 0 ? seeks : 1);
+    }
+
+    PrintUsage(argv[0]);
+    return 1;
+}
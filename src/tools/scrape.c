@@ -0,0 +1,182 @@
+#define _POSIX_C_SOURCE 200809L
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// Largest response kept (the server's text is a few KiB)
+#define RESPONSE_SIZE (1 << 20)
+
+// Stand-in for a Prometheus scraper: fetches /metrics from the server's
+// local endpoint, checks the exposition text and prints it or a summary
+
+typedef struct {
+    const char* host;
+    int port;
+    const char* path;
+    int count;
+    double interval;
+    bool summary;
+} ScrapeOptions;
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// GET the path; returns the body (inside response) or NULL on failure
+static const char* Fetch(const ScrapeOptions* options, char* response, size_t capacity)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)options->port);
+    if (inet_pton(AF_INET, options->host, &address.sin_addr) != 1 ||
+        connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    char request[512];
+    int length = snprintf(request, sizeof(request), "GET %s HTTP/1.0\r\nHost: %s\r\n\r\n",
+                          options->path, options->host);
+    if (send(fd, request, (size_t)length, 0) != length) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t received = 0;
+    ssize_t got;
+    while (received < capacity - 1 && (got = recv(fd, response + received, capacity - 1 - received, 0)) > 0) {
+        received += (size_t)got;
+    }
+    close(fd);
+    response[received] = '\0';
+
+    const char* body = strstr(response, "\r\n\r\n");
+    if (strncmp(response, "HTTP/1.0 200", 12) != 0 && strncmp(response, "HTTP/1.1 200", 12) != 0) {
+        fprintf(stderr, "%.*s\n", (int)strcspn(response, "\r\n"), response);
+        return NULL;
+    }
+    return body ? body + 4 : NULL;
+}
+
+// Every sample line must be "name[{labels}] value"; returns the bad line count
+static int CheckExposition(const char* body, int* samples)
+{
+    int bad = 0;
+    *samples = 0;
+    for (const char* line = body; *line; ) {
+        size_t length = strcspn(line, "\n");
+        if (length > 0 && line[0] != '#') {
+            char name[256];
+            double value;
+            if (sscanf(line, "%255[a-zA-Z0-9_:{}=\".+e-] %lf", name, &value) != 2) {
+                fprintf(stderr, "bad sample line: %.*s\n", (int)length, line);
+                bad++;
+            } else {
+                (*samples)++;
+            }
+        }
+        line += length + (line[length] == '\n');
+    }
+    return bad;
+}
+
+// Counters, gauges and histogram counts on one line
+static void PrintSummary(const char* body, double latency)
+{
+    printf("scrape %.2f ms:", latency * 1e3);
+    for (const char* line = body; *line; ) {
+        size_t length = strcspn(line, "\n");
+        size_t nameLength = strcspn(line, " \n");
+        bool isSum = nameLength > 4 && memcmp(line + nameLength - 4, "_sum", 4) == 0;
+        if (length > 0 && line[0] != '#' && !memchr(line, '{', length) && !isSum) {
+            printf(" %.*s", (int)length, line);
+        }
+        line += length + (line[length] == '\n');
+    }
+    printf("\n");
+}
+
+static void PrintUsage(const char* program)
+{
+    printf("Usage: %s [options]\n", program);
+    printf("  --host ADDR       Server address (default 127.0.0.1)\n");
+    printf("  --port N          Metrics port (default 9100)\n");
+    printf("  --path P          Request path (default /metrics)\n");
+    printf("  --count N         Scrapes to make (default 1)\n");
+    printf("  --interval S      Seconds between scrapes (default 1)\n");
+    printf("  --summary         One line per scrape instead of the full text\n");
+}
+
+int main(int argc, char** argv)
+{
+    ScrapeOptions options = {
+        .host = "127.0.0.1",
+        .port = 9100,
+        .path = "/metrics",
+        .count = 1,
+        .interval = 1.0,
+        .summary = false,
+    };
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            options.host = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            options.port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--path") == 0 && i + 1 < argc) {
+            options.path = argv[++i];
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            options.count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            options.interval = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--summary") == 0) {
+            options.summary = true;
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    static char response[RESPONSE_SIZE];
+    for (int n = 0; n < options.count; n++) {
+        if (n > 0) {
+            struct timespec ts = { (time_t)options.interval,
+                                   (long)((options.interval - (double)(time_t)options.interval) * 1e9) };
+            nanosleep(&ts, NULL);
+        }
+
+        double start = NowSeconds();
+        const char* body = Fetch(&options, response, sizeof(response));
+        double latency = NowSeconds() - start;
+        if (!body) {
+            fprintf(stderr, "scrape of %s:%d%s failed\n", options.host, options.port, options.path);
+            return 1;
+        }
+
+        int samples;
+        int bad = CheckExposition(body, &samples);
+        if (options.summary) {
+            PrintSummary(body, latency);
+        } else {
+            fputs(body, stdout);
+            printf("# %d samples, %zu bytes, %.2f ms\n", samples, strlen(body), latency * 1e3);
+        }
+        if (bad) {
+            return 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,279 @@
+#define _DEFAULT_SOURCE
+#include "board_codec.h"
+#include "replay_archive.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Reasons a replay fails verification (bitmask)
+#define VERIFY_CHECKSUM 0x01    // A per-tick checksum diverged
+#define VERIFY_SCORE    0x02    // Claimed final score differs
+#define VERIFY_BOARD    0x04    // Claimed final board differs
+#define VERIFY_CORRUPT  0x08    // Block could not be parsed
+
+// One replay to check: a match inside one of the opened archives
+typedef struct {
+    uint32_t archive;
+    uint32_t match;
+} VerifyJob;
+
+typedef struct {
+    ReplayArchive* archives;
+    const char** paths;
+    VerifyJob* jobs;
+    size_t jobCount;
+    bool quiet;
+
+    atomic_size_t nextJob;
+    atomic_size_t verified;
+    atomic_size_t failed;
+    atomic_ullong ticks;
+} VerifyContext;
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Re-simulate a replay from its seed and compare everything it claims
+// Returns VERIFY_* bits (0 = clean); divergentTick is the first bad tick
+static int VerifyReplay(ReplaySim* sim, const ReplayView* view, uint32_t* divergentTick)
+{
+    int result = 0;
+    GameInput inputs[REPLAY_PLAYERS];
+
+    ReplaySim_Init(sim, view->seed);
+    for (uint32_t t = 0; t < view->tickCount; t++) {
+        ReplayView_GetInputs(view, t, inputs);
+        ReplaySim_Step(sim, inputs);
+        if (ReplaySim_Checksum(sim) != ReplayView_GetChecksum(view, t)) {
+            // Everything after the first divergence is meaningless; stop here
+            *divergentTick = t;
+            result |= VERIFY_CHECKSUM;
+            break;
+        }
+    }
+
+    uint8_t board[BOARD_KEYFRAME_SIZE];
+    for (int p = 0; p < REPLAY_PLAYERS; p++) {
+        if (sim->players[p].board.score != view->finalScores[p]) {
+            result |= VERIFY_SCORE;
+        }
+        BoardCodec_WriteKeyframe(&sim->players[p].board, board);
+        if (memcmp(board, view->finalBoards + p * BOARD_KEYFRAME_SIZE, BOARD_KEYFRAME_SIZE) != 0) {
+            result |= VERIFY_BOARD;
+        }
+    }
+    return result;
+}
+
+static void* VerifyWorker(void* arg)
+{
+    VerifyContext* context = (VerifyContext*)arg;
+    // The row queues inside are cache-line aligned, beyond what malloc promises
+    ReplaySim* sim = aligned_alloc(64, (sizeof(ReplaySim) + 63) & ~(size_t)63);
+    if (!sim) {
+        return NULL;
+    }
+
+    for (;;) {
+        size_t index = atomic_fetch_add_explicit(&context->nextJob, 1, memory_order_relaxed);
+        if (index >= context->jobCount) {
+            break;
+        }
+        const VerifyJob* job = &context->jobs[index];
+
+        ReplayView view;
+        uint32_t divergentTick = 0;
+        int result = VERIFY_CORRUPT;
+        if (ReplayArchive_GetMatch(&context->archives[job->archive], (int)job->match, &view)) {
+            result = VerifyReplay(sim, &view, &divergentTick);
+            atomic_fetch_add_explicit(&context->ticks, view.tickCount, memory_order_relaxed);
+        }
+
+        atomic_fetch_add_explicit(&context->verified, 1, memory_order_relaxed);
+        if (result) {
+            atomic_fetch_add_explicit(&context->failed, 1, memory_order_relaxed);
+        }
+
+        // Stream results as they finish; one locked write per line keeps lines whole
+        if (result || !context->quiet) {
+            flockfile(stdout);
+            printf("%s:%u match %u %s", context->paths[job->archive], job->match,
+                   (result & VERIFY_CORRUPT) ? 0 : view.matchId, result ? "FAIL" : "ok");
+            if (result & VERIFY_CORRUPT)  printf(" corrupt");
+            if (result & VERIFY_CHECKSUM) printf(" checksum@%u", divergentTick);
+            if (result & VERIFY_SCORE)    printf(" score");
+            if (result & VERIFY_BOARD)    printf(" board");
+            printf("\n");
+            funlockfile(stdout);
+        }
+    }
+
+    free(sim);
+    return NULL;
+}
+
+// Paths given on the command line, with directories expanded one level
+typedef struct {
+    char** items;
+    size_t count, capacity;
+} PathList;
+
+static void PathList_Add(PathList* list, const char* path)
+{
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 16;
+        list->items = realloc(list->items, list->capacity * sizeof(char*));
+    }
+    list->items[list->count++] = strdup(path);
+}
+
+// Add an archive, or every .par file in a directory
+// Returns false if the path or directory could not be read
+static bool CollectPaths(PathList* list, const char* path)
+{
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        fprintf(stderr, "%s: FAIL cannot stat\n", path);
+        return false;
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        PathList_Add(list, path);
+        return true;
+    }
+
+    DIR* dir = opendir(path);
+    if (!dir) {
+        fprintf(stderr, "%s: FAIL cannot open directory\n", path);
+        return false;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        if (length > 4 && strcmp(entry->d_name + length - 4, ".par") == 0) {
+            char full[4096];
+            snprintf(full, sizeof(full), "%s/%s", path, entry->d_name);
+            PathList_Add(list, full);
+        }
+    }
+    closedir(dir);
+    return true;
+}
+
+static void PrintUsage(const char* program)
+{
+    printf("Usage: %s [options] <archive|directory>...\n", program);
+    printf("  Re-simulates every replay and flags diverging checksums, scores or final boards\n");
+    printf("  --threads N   Worker threads (default: online cores)\n");
+    printf("  --quiet       Only print failures and the summary\n");
+}
+
+int main(int argc, char** argv)
+{
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    bool quiet = false;
+    PathList paths = { 0 };
+    // Unreadable paths and archives, and truncated archives, fail the run:
+    // for an anti-cheat batch, a missing replay must not look like a clean one
+    size_t badArchives = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if (argv[i][0] == '-') {
+            PrintUsage(argv[0]);
+            return 1;
+        } else if (!CollectPaths(&paths, argv[i])) {
+            badArchives++;
+        }
+    }
+    if (paths.count == 0) {
+        if (badArchives) {
+            return 2;
+        }
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    // Map every archive and flatten their matches into one job list
+    VerifyContext context = { 0 };
+    context.archives = calloc(paths.count, sizeof(ReplayArchive));
+    context.paths = (const char**)paths.items;
+    context.quiet = quiet;
+    size_t jobCapacity = 0;
+    for (size_t a = 0; a < paths.count; a++) {
+        if (!ReplayArchive_Open(&context.archives[a], paths.items[a])) {
+            fprintf(stderr, "%s: FAIL not a replay archive\n", paths.items[a]);
+            badArchives++;
+            continue;
+        }
+        const ReplayArchive* archive = &context.archives[a];
+        if (ReplayArchive_IsTruncated(archive)) {
+            fprintf(stderr, "%s: FAIL truncated: %d of %d indexed matches readable, %zu bytes of cut block\n",
+                    paths.items[a], archive->matchCount, archive->indexedCount, archive->tailBytes);
+            badArchives++;
+        } else if (!quiet) {
+            printf("%s: %d matches\n", paths.items[a], archive->matchCount);
+        }
+        for (int m = 0; m < context.archives[a].matchCount; m++) {
+            if (context.jobCount == jobCapacity) {
+                jobCapacity = jobCapacity ? jobCapacity * 2 : 1024;
+                context.jobs = realloc(context.jobs, jobCapacity * sizeof(VerifyJob));
+            }
+            context.jobs[context.jobCount].archive = (uint32_t)a;
+            context.jobs[context.jobCount].match = (uint32_t)m;
+            context.jobCount++;
+        }
+    }
+    atomic_init(&context.nextJob, 0);
+    atomic_init(&context.verified, 0);
+    atomic_init(&context.failed, 0);
+    atomic_init(&context.ticks, 0);
+
+    double start = NowSeconds();
+    pthread_t* workers = calloc((size_t)threads, sizeof(pthread_t));
+    for (int i = 0; i < threads; i++) {
+        pthread_create(&workers[i], NULL, VerifyWorker, &context);
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    double elapsed = NowSeconds() - start;
+
+    size_t verified = atomic_load(&context.verified);
+    size_t failed = atomic_load(&context.failed);
+    double rate = elapsed > 0.0 ? (double)verified / elapsed : 0.0;
+    printf("verified %zu replays (%zu failed) on %d threads in %.2f s\n",
+           verified, failed, threads, elapsed);
+    if (badArchives) {
+        printf("%zu paths or archives unreadable or truncated\n", badArchives);
+    }
+    printf("%.1f replays/s, %.1f replays/s per core, %.2f M ticks/s\n",
+           rate, rate / threads, (double)atomic_load(&context.ticks) / elapsed / 1e6);
+
+    for (size_t a = 0; a < paths.count; a++) {
+        if (context.archives[a].base) {
+            ReplayArchive_Close(&context.archives[a]);
+        }
+        free(paths.items[a]);
+    }
+    free(paths.items);
+    free(context.archives);
+    free(context.jobs);
+    free(workers);
+    return (failed || badArchives) ? 2 : 0;
+}